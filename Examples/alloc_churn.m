@@ -0,0 +1,175 @@
+/* Benchmark of allocation heavy Foundation workloads.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: alloc_churn [-Count N] [-Threads T]
+
+   Runs each of several workloads which create and destroy many small
+   objects N times (default 100000) in each of T threads (default 1)
+   and reports the rate: allocating and releasing plain objects, numbers
+   and short strings, building strings from pieces, and parsing a small
+   JSON document.  To compare allocators, run once as it is and once with
+   GNUSTEP_OBJECT_MAGAZINES=YES in the environment, which also makes the
+   statistics of the magazine allocator be reported.
+*/
+#include <stdio.h>
+#include <Foundation/Foundation.h>
+
+static NSInteger	count;
+static NSData		*json;
+
+@interface Worker : NSObject
+{
+@public
+  NSInteger	workload;
+  NSCondition	*cond;
+  NSInteger	*running;
+}
+- (void) run;
+@end
+
+static void
+work(NSInteger workload)
+{
+  NSInteger	i;
+
+  for (i = 0; i < count; i++)
+    {
+      ENTER_POOL
+      switch (workload)
+	{
+	  case 0:
+	    {
+	      NSInteger	j;
+
+	      for (j = 0; j < 16; j++)
+		{
+		  RELEASE([NSObject new]);
+		}
+	    }
+	    break;
+
+	  case 1:
+	    {
+	      NSInteger	j;
+
+	      for (j = 0; j < 16; j++)
+		{
+		  [NSNumber numberWithDouble: i * 16.5 + j];
+		  [NSString stringWithFormat: @"%ld", (long)(i + j)];
+		}
+	    }
+	    break;
+
+	  case 2:
+	    {
+	      NSMutableString	*m = [NSMutableString string];
+	      NSInteger		j;
+
+	      for (j = 0; j < 16; j++)
+		{
+		  [m appendString: [NSString stringWithFormat: @"<%ld>",
+		    (long)j]];
+		}
+	      [m componentsSeparatedByString: @">"];
+	    }
+	    break;
+
+	  default:
+	    [NSJSONSerialization JSONObjectWithData: json
+					    options: 0
+					      error: NULL];
+	    break;
+	}
+      LEAVE_POOL
+    }
+}
+
+@implementation Worker
+- (void) run
+{
+  ENTER_POOL
+  work(workload);
+  [cond lock];
+  (*running)--;
+  [cond signal];
+  [cond unlock];
+  LEAVE_POOL
+}
+@end
+
+int
+main()
+{
+  static const char	*names[] = {"objects", "numbers/strings",
+    "string building", "JSON parse"};
+  NSUserDefaults	*defs;
+  NSCondition		*cond;
+  NSInteger		threads;
+  NSInteger		running;
+  NSInteger		w;
+  NSInteger		t;
+
+  ENTER_POOL
+  defs = [NSUserDefaults standardUserDefaults];
+  count = [defs integerForKey: @"Count"];
+  if (count <= 0)
+    {
+      count = 100000;
+    }
+  threads = [defs integerForKey: @"Threads"];
+  if (threads <= 0)
+    {
+      threads = 1;
+    }
+  json = RETAIN([@"{\"id\": 12345, \"name\": \"widget\", \"tags\":"
+    @" [\"a\", \"b\", \"c\"], \"price\": 9.99, \"stock\": [{\"store\": 1,"
+    @" \"count\": 3}, {\"store\": 2, \"count\": 0}], \"active\": true}"
+    dataUsingEncoding: NSUTF8StringEncoding]);
+  cond = AUTORELEASE([NSCondition new]);
+
+  for (w = 0; w < 4; w++)
+    {
+      NSDate		*start = [NSDate date];
+      NSTimeInterval	ti;
+
+      running = threads;
+      for (t = 0; t < threads; t++)
+	{
+	  Worker	*worker = AUTORELEASE([Worker new]);
+
+	  worker->workload = w;
+	  worker->cond = cond;
+	  worker->running = &running;
+	  [NSThread detachNewThreadSelector: @selector(run)
+				   toTarget: worker
+				 withObject: nil];
+	}
+      [cond lock];
+      while (running > 0)
+	{
+	  [cond wait];
+	}
+      [cond unlock];
+      ti = -[start timeIntervalSinceNow];
+      printf("%-16s %12.0f per second\n", names[w], count * threads / ti);
+    }
+
+  if (GSObjectMagazineZone() != NULL)
+    {
+      struct NSZoneStats	stats = NSZoneStats(GSObjectMagazineZone());
+
+      printf("magazines: %lu objects (%lu bytes) in use, %lu blocks"
+	" (%lu bytes) cached\n", (unsigned long)stats.chunks_used,
+	(unsigned long)stats.bytes_used, (unsigned long)stats.chunks_free,
+	(unsigned long)stats.bytes_free);
+    }
+  LEAVE_POOL
+  return 0;
+}
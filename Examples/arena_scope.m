@@ -0,0 +1,133 @@
+/* Benchmark of allocating short lived objects in an arena zone.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: arena_scope [-Requests N] [-Objects M]
+
+   Simulates N (default 100000) requests, each creating M (default 1000)
+   small objects which are collected in arrays and dictionaries and all
+   released at the end of the request, and reports the rate of requests
+   with objects allocated as usual and with them allocated in an arena
+   zone pushed for the request and reset after it.
+*/
+#include <stdio.h>
+#include <Foundation/Foundation.h>
+
+@interface Field : NSObject
+{
+@public
+  NSInteger	number;
+  double	value;
+  id		next;
+}
+@end
+
+@implementation Field
+- (void) dealloc
+{
+  DESTROY(next);
+  DEALLOC
+}
+@end
+
+static NSInteger	objects;
+
+static NSUInteger
+request(NSInteger n)
+{
+  NSMutableArray	*list;
+  NSMutableDictionary	*index;
+  NSUInteger		result;
+  NSInteger		i;
+
+  ENTER_POOL
+  list = [NSMutableArray arrayWithCapacity: objects / 2];
+  index = [NSMutableDictionary dictionaryWithCapacity: objects / 2];
+  for (i = 0; i < objects / 2; i++)
+    {
+      Field	*f = [Field new];
+
+      f->number = n + i;
+      f->value = i * 0.5;
+      f->next = [Field new];
+      [list addObject: f];
+      [index setObject: f forKey: [NSNumber numberWithInteger: f->number]];
+      RELEASE(f);
+    }
+  result = [list count] + [index count];
+  LEAVE_POOL
+  return result;
+}
+
+static void
+report(const char *what, NSDate *start, NSInteger n)
+{
+  NSTimeInterval	ti = -[start timeIntervalSinceNow];
+
+  printf("%-8s %12.0f requests per second\n", what, n / ti);
+}
+
+int
+main()
+{
+  NSUserDefaults	*defs;
+  NSZone		*arena;
+  struct NSZoneStats	stats;
+  NSDate		*start;
+  NSInteger		requests;
+  NSInteger		i;
+  NSUInteger		check = 0;
+
+  ENTER_POOL
+  defs = [NSUserDefaults standardUserDefaults];
+  requests = [defs integerForKey: @"Requests"];
+  if (requests <= 0)
+    {
+      requests = 100000;
+    }
+  objects = [defs integerForKey: @"Objects"];
+  if (objects <= 0)
+    {
+      objects = 1000;
+    }
+
+  /* Make sure classes are initialised (and any objects they keep are
+   * created) outside the arena.
+   */
+  check += request(0);
+
+  start = [NSDate date];
+  for (i = 0; i < requests; i++)
+    {
+      check += request(i);
+    }
+  report("malloc", start, requests);
+
+  arena = GSCreateArenaZone(256 * 1024);
+  start = [NSDate date];
+  for (i = 0; i < requests; i++)
+    {
+      GSPushAllocationZone(arena);
+      check += request(i);
+      GSPopAllocationZone();
+      GSResetArenaZone(arena);
+    }
+  report("arena", start, requests);
+
+  GSPushAllocationZone(arena);
+  check += request(0);
+  GSPopAllocationZone();
+  stats = NSZoneStats(arena);
+  printf("arena holds %lu bytes for a request of %lu objects (%lu)\n",
+    (unsigned long)stats.bytes_total, (unsigned long)stats.chunks_used,
+    (unsigned long)check);
+  NSRecycleZone(arena);
+  LEAVE_POOL
+  return 0;
+}
@@ -0,0 +1,155 @@
+/* Benchmark of building and editing large attributed strings.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: attributed_edit [-Size MB] [-Edits N] [-Threads T]
+
+   Each of T threads (default 1) builds a mutable attributed string of
+   the given size (default 1MB) by appending short runs with varying
+   attributes, then makes N (default 100000) random edits to it, mixing
+   attribute changes, insertions, deletions and lookups.  The time taken
+   for the appends and for the edits is reported.  Running with several
+   threads shows contention on the shared cache of attribute dictionaries.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <Foundation/Foundation.h>
+
+static NSUInteger	size;
+static NSUInteger	edits;
+static NSArray		*attrs;
+
+@interface Worker : NSObject
+{
+@public
+  NSTimeInterval	appendTime;
+  NSTimeInterval	editTime;
+  NSConditionLock	*done;
+}
+- (void) run: (id)arg;
+@end
+
+@implementation Worker
+- (void) run: (id)arg
+{
+  ENTER_POOL
+  NSMutableAttributedString	*s;
+  NSDate			*start;
+  NSUInteger			count = [attrs count];
+  NSUInteger			i;
+  unsigned			seed = (unsigned)(uintptr_t)self;
+
+  s = AUTORELEASE([NSMutableAttributedString new]);
+  start = [NSDate date];
+  for (i = 0; [s length] < size; i++)
+    {
+      NSAttributedString	*a;
+
+      a = [[NSAttributedString alloc]
+	initWithString: @"some text "
+	    attributes: [attrs objectAtIndex: i % count]];
+      [s appendAttributedString: a];
+      RELEASE(a);
+    }
+  appendTime = -[start timeIntervalSinceNow];
+
+  start = [NSDate date];
+  for (i = 0; i < edits; i++)
+    {
+      NSUInteger	len = [s length];
+      NSUInteger	loc = rand_r(&seed) % (len - 100);
+
+      switch (i % 4)
+	{
+	  case 0:
+	    [s setAttributes: [attrs objectAtIndex: rand_r(&seed) % count]
+		       range: NSMakeRange(loc, 1 + rand_r(&seed) % 50)];
+	    break;
+	  case 1:
+	    [s replaceCharactersInRange: NSMakeRange(loc, 0)
+			     withString: @"inserted"];
+	    break;
+	  case 2:
+	    [s deleteCharactersInRange: NSMakeRange(loc, 8)];
+	    break;
+	  default:
+	    [s attributesAtIndex: loc effectiveRange: NULL];
+	    break;
+	}
+    }
+  editTime = -[start timeIntervalSinceNow];
+  [done lock];
+  [done unlockWithCondition: [done condition] + 1];
+  LEAVE_POOL
+}
+@end
+
+int
+main()
+{
+  ENTER_POOL
+  NSUserDefaults	*defs = [NSUserDefaults standardUserDefaults];
+  NSMutableArray	*a = [NSMutableArray array];
+  NSMutableArray	*workers = [NSMutableArray array];
+  NSConditionLock	*done;
+  NSInteger		threads;
+  NSDate		*start;
+  NSInteger		i;
+
+  size = [defs integerForKey: @"Size"];
+  if (size == 0)
+    {
+      size = 1;
+    }
+  size *= 1024 * 1024;
+  edits = [defs integerForKey: @"Edits"];
+  if (edits == 0)
+    {
+      edits = 100000;
+    }
+  threads = [defs integerForKey: @"Threads"];
+  if (threads <= 0)
+    {
+      threads = 1;
+    }
+  for (i = 0; i < 64; i++)
+    {
+      [a addObject: [NSDictionary dictionaryWithObjectsAndKeys:
+	[NSNumber numberWithInteger: i % 8], @"Font",
+	[NSNumber numberWithInteger: i / 8], @"Color",
+	nil]];
+    }
+  attrs = [a copy];
+
+  done = AUTORELEASE([[NSConditionLock alloc] initWithCondition: 0]);
+  start = [NSDate date];
+  for (i = 0; i < threads; i++)
+    {
+      Worker	*w = AUTORELEASE([Worker new]);
+
+      w->done = done;
+      [workers addObject: w];
+      [NSThread detachNewThreadSelector: @selector(run:)
+			       toTarget: w
+			     withObject: nil];
+    }
+  [done lockWhenCondition: threads];
+  [done unlock];
+  for (i = 0; i < threads; i++)
+    {
+      Worker	*w = [workers objectAtIndex: i];
+
+      printf("thread %ld: %.3fs appending %luMB, %.3fs for %lu edits\n",
+	(long)i, w->appendTime, (unsigned long)(size / (1024 * 1024)),
+	w->editTime, (unsigned long)edits);
+    }
+  printf("total %.3fs\n", -[start timeIntervalSinceNow]);
+  LEAVE_POOL
+  return 0;
+}
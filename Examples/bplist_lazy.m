@@ -0,0 +1,113 @@
+/* Benchmark of eager and lazy decoding of binary property lists.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: bplist_lazy [-Count N] [-Lazy YES] [-File path]
+
+   Writes a binary property list holding a dictionary of N entries (each
+   a dictionary with a few strings, numbers and a data object) to the
+   file, maps the file into memory and reports the time taken to read
+   the property list and look up one key, and the growth of the maximum
+   resident set size of the process.  Run the program once with and once
+   without -Lazy YES to compare the two decoders, since the maximum
+   resident set size never shrinks.
+*/
+#include <stdio.h>
+#include <sys/resource.h>
+#include <Foundation/Foundation.h>
+
+static long
+maxRSS(void)
+{
+  struct rusage	u;
+
+  getrusage(RUSAGE_SELF, &u);
+  return u.ru_maxrss;
+}
+
+int
+main()
+{
+  NSUserDefaults	*defs;
+  NSString		*file;
+  NSData		*data;
+  NSDate		*start;
+  NSTimeInterval	ti;
+  NSError		*err = nil;
+  NSUInteger		count;
+  BOOL			lazy;
+  id			plist;
+  id			value;
+  long			rss;
+
+  ENTER_POOL
+  defs = [NSUserDefaults standardUserDefaults];
+  count = [defs integerForKey: @"Count"];
+  if (count == 0)
+    {
+      count = 200000;
+    }
+  lazy = [defs boolForKey: @"Lazy"];
+  file = [defs stringForKey: @"File"];
+  if (nil == file)
+    {
+      file = [NSTemporaryDirectory()
+	stringByAppendingPathComponent: @"bplist_lazy.plist"];
+    }
+
+  if (NO == [[NSFileManager defaultManager] fileExistsAtPath: file])
+    {
+      ENTER_POOL
+      NSMutableDictionary	*d;
+      NSData			*blob;
+      NSUInteger		i;
+
+      blob = [NSMutableData dataWithLength: 256];
+      d = [NSMutableDictionary dictionaryWithCapacity: count];
+      for (i = 0; i < count; i++)
+	{
+	  NSDictionary	*entry;
+
+	  entry = [NSDictionary dictionaryWithObjectsAndKeys:
+	    [NSString stringWithFormat: @"name of entry number %lu",
+	      (unsigned long)i], @"name",
+	    [NSNumber numberWithUnsignedLong: i], @"index",
+	    [NSNumber numberWithDouble: i * 1.5], @"value",
+	    blob, @"blob",
+	    nil];
+	  [d setObject: entry
+		forKey: [NSString stringWithFormat: @"key%lu",
+		  (unsigned long)i]];
+	}
+      data = [NSPropertyListSerialization dataWithPropertyList: d
+	format: NSPropertyListBinaryFormat_v1_0 options: 0 error: &err];
+      [data writeToFile: file atomically: YES];
+      printf("Wrote %lu bytes to %s\n",
+	(unsigned long)[data length], [file fileSystemRepresentation]);
+      LEAVE_POOL
+    }
+
+  rss = maxRSS();
+  start = [NSDate date];
+  data = [NSData dataWithContentsOfMappedFile: file];
+  plist = [NSPropertyListSerialization propertyListWithData: data
+    options: NSPropertyListImmutable
+      | (lazy ? GSPropertyListLazyDecoding : 0)
+    format: NULL
+    error: &err];
+  value = [[plist objectForKey: @"key42"] objectForKey: @"name"];
+  ti = -[start timeIntervalSinceNow];
+
+  printf("%s decoding of %lu entries: first key after %.3f ms"
+    " (found '%s'), max RSS grew by %ld KB\n",
+    lazy ? "Lazy" : "Eager", (unsigned long)[plist count], ti * 1000.0,
+    [value UTF8String], maxRSS() - rss);
+  LEAVE_POOL
+  return 0;
+}
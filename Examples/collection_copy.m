@@ -0,0 +1,106 @@
+/* Benchmark of taking immutable copies of mutable collections.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: collection_copy [-Count N] [-Repeat R]
+
+   Fills a mutable array, dictionary and set with N (default 10000)
+   objects and reports the rate (copies per second) of taking R (default
+   100000) immutable copies of each, first with no changes between the
+   copies (as when a getter returns a copy of an ivar) and then with one
+   object replaced before each copy.
+*/
+#include <stdio.h>
+#include <Foundation/Foundation.h>
+
+static NSInteger	repeat;
+
+static void
+report(const char *what, NSDate *start)
+{
+  NSTimeInterval	ti = -[start timeIntervalSinceNow];
+
+  printf("%-24s %12.0f copies per second\n", what, repeat / ti);
+}
+
+static void
+copies(const char *what, id m, BOOL change)
+{
+  NSDate	*start = [NSDate date];
+  NSInteger	r;
+
+  for (r = 0; r < repeat; r++)
+    {
+      ENTER_POOL
+      if (YES == change)
+	{
+	  if ([m isKindOfClass: [NSArray class]])
+	    {
+	      [m replaceObjectAtIndex: 0 withObject: @"x"];
+	    }
+	  else if ([m isKindOfClass: [NSDictionary class]])
+	    {
+	      [m setObject: @"x" forKey: @"x"];
+	    }
+	  else
+	    {
+	      [m removeObject: @"x"];
+	      [m addObject: @"x"];
+	    }
+	}
+      [AUTORELEASE([m copy]) count];
+      LEAVE_POOL
+    }
+  report(what, start);
+}
+
+int
+main()
+{
+  NSUserDefaults	*defs;
+  NSMutableArray	*a;
+  NSMutableDictionary	*d;
+  NSMutableSet		*s;
+  NSInteger		count;
+  NSInteger		i;
+
+  ENTER_POOL
+  defs = [NSUserDefaults standardUserDefaults];
+  count = [defs integerForKey: @"Count"];
+  if (count <= 0)
+    {
+      count = 10000;
+    }
+  repeat = [defs integerForKey: @"Repeat"];
+  if (repeat <= 0)
+    {
+      repeat = 100000;
+    }
+
+  a = [NSMutableArray arrayWithCapacity: count];
+  d = [NSMutableDictionary dictionaryWithCapacity: count];
+  s = [NSMutableSet setWithCapacity: count];
+  for (i = 0; i < count; i++)
+    {
+      NSString	*o = [NSString stringWithFormat: @"%ld", (long)i];
+
+      [a addObject: o];
+      [d setObject: o forKey: o];
+      [s addObject: o];
+    }
+
+  copies("array", a, NO);
+  copies("dictionary", d, NO);
+  copies("set", s, NO);
+  copies("changed array", a, YES);
+  copies("changed dictionary", d, YES);
+  copies("changed set", s, YES);
+  LEAVE_POOL
+  return 0;
+}
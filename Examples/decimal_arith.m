@@ -0,0 +1,170 @@
+/* Benchmark of NSDecimal arithmetic.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: decimal_arith [-Count N] [-Oracle file]
+
+   Generates N (default 1000000) pairs of amounts and prices like those
+   in billing (two to four fractional digits, from a fixed seed) and
+   reports the rate of adding, subtracting, multiplying and dividing them
+   and of the NSDecimalSum() and NSDecimalDotProduct() batch functions.
+
+   With -Oracle the results are checked against those in the file, or
+   written to it if it does not exist.  To compare the binary arithmetic
+   with the digit by digit code, first run with GNUSTEP_DECIMAL_DIGITS=YES
+   in the environment to record the results of the digit code, then run
+   again without it.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <Foundation/Foundation.h>
+#include <Foundation/NSDecimal.h>
+
+static NSInteger	count;
+
+/* Append the significant part of a number (digits beyond the length may
+ * be anything) as a fixed size record.
+ */
+#define	RECORD	(4 + NSDecimalMaxDigit)
+static void
+record(NSMutableData *results, NSDecimal *d)
+{
+  unsigned char	buf[RECORD];
+
+  memset(buf, 0, sizeof(buf));
+  buf[0] = d->exponent;
+  buf[1] = d->isNegative;
+  buf[2] = d->validNumber;
+  buf[3] = d->length;
+  memcpy(buf + 4, d->cMantissa, d->length);
+  [results appendBytes: buf length: sizeof(buf)];
+}
+
+static void
+report(const char *what, NSDate *start, NSInteger n)
+{
+  NSTimeInterval	ti = -[start timeIntervalSinceNow];
+
+  printf("%-14s %12.0f per second\n", what, n / ti);
+}
+
+int
+main()
+{
+  NSUserDefaults	*defs;
+  NSString		*oracle;
+  NSDecimal		*a;
+  NSDecimal		*b;
+  NSDecimal		*r;
+  NSDecimal		sum;
+  NSDecimal		dot;
+  NSMutableData		*results;
+  NSData		*expected;
+  NSDate		*start;
+  NSInteger		i;
+  NSInteger		op;
+  int			status = 0;
+
+  ENTER_POOL
+  defs = [NSUserDefaults standardUserDefaults];
+  count = [defs integerForKey: @"Count"];
+  if (count <= 0)
+    {
+      count = 1000000;
+    }
+  oracle = [defs stringForKey: @"Oracle"];
+
+  a = malloc(count * sizeof(NSDecimal));
+  b = malloc(count * sizeof(NSDecimal));
+  r = malloc(count * sizeof(NSDecimal));
+  srandom(42);
+  for (i = 0; i < count; i++)
+    {
+      NSDecimalFromComponents(&a[i], random() % 10000000, -2,
+	random() % 10 == 0);
+      NSDecimalFromComponents(&b[i], random() % 1000000 + 1,
+	-(short)(random() % 3 + 2), NO);
+    }
+
+  /* Results of each operation are kept in r and appended to results so
+   * the complete output can be compared.
+   */
+  results = [NSMutableData data];
+  for (op = 0; op < 4; op++)
+    {
+      static const char	*names[] = {"add", "subtract", "multiply", "divide"};
+
+      start = [NSDate date];
+      for (i = 0; i < count; i++)
+	{
+	  switch (op)
+	    {
+	      case 0: NSDecimalAdd(&r[i], &a[i], &b[i], NSRoundBankers); break;
+	      case 1: NSDecimalSubtract(&r[i], &a[i], &b[i], NSRoundBankers); break;
+	      case 2: NSDecimalMultiply(&r[i], &a[i], &b[i], NSRoundBankers); break;
+	      default: NSDecimalDivide(&r[i], &a[i], &b[i], NSRoundBankers); break;
+	    }
+	}
+      report(names[op], start, count);
+      for (i = 0; i < count; i++)
+	{
+	  record(results, &r[i]);
+	}
+    }
+
+  start = [NSDate date];
+  NSDecimalSum(&sum, a, count, NSRoundBankers);
+  report("sum", start, count);
+  start = [NSDate date];
+  NSDecimalDotProduct(&dot, a, b, count, NSRoundBankers);
+  report("dot product", start, count);
+  record(results, &sum);
+  record(results, &dot);
+  printf("sum %s\ndot product %s\n",
+    [NSDecimalString(&sum, nil) UTF8String],
+    [NSDecimalString(&dot, nil) UTF8String]);
+
+  if (oracle != nil)
+    {
+      expected = [NSData dataWithContentsOfFile: oracle];
+      if (nil == expected)
+	{
+	  [results writeToFile: oracle atomically: YES];
+	  printf("results written to %s\n", [oracle UTF8String]);
+	}
+      else if ([expected isEqual: results])
+	{
+	  printf("results match %s\n", [oracle UTF8String]);
+	}
+      else
+	{
+	  NSUInteger	len = MIN([expected length], [results length]);
+	  const char	*e = [expected bytes];
+	  const char	*o = [results bytes];
+
+	  for (i = 0; i < len; i += RECORD)
+	    {
+	      if (memcmp(e + i, o + i, RECORD) != 0)
+		{
+		  break;
+		}
+	    }
+	  printf("results differ from %s at result %ld\n",
+	    [oracle UTF8String], (long)(i / RECORD));
+	  status = 1;
+	}
+    }
+
+  free(a);
+  free(b);
+  free(r);
+  LEAVE_POOL
+  return status;
+}
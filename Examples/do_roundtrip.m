@@ -0,0 +1,186 @@
+/* Benchmark of distributed objects round trips from several threads.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: do_roundtrip [-Count N] [-Threads T] [-Window W]
+
+   Vends an object from a server thread of this process and has T client
+   threads (default 4) share one connection to it (with multiple threads
+   enabled), each making N (default 2000) synchronous calls.  The mean
+   round trip latency and the total throughput are reported.  When one
+   thread reads a reply meant for another, the time taken for the waiting
+   thread to notice shows up as added latency.
+   Then the main thread makes the same total number of calls, sending
+   them asynchronously with up to W (default 100) replies outstanding,
+   to show the throughput of pipelined calls.
+*/
+#include <stdio.h>
+#include <Foundation/Foundation.h>
+
+@protocol Echo
+- (int) echo: (int)i;
+@end
+
+@interface Server : NSObject <Echo>
++ (void) serveWithPorts: (NSArray*)ports;
+@end
+
+@implementation Server
++ (void) serveWithPorts: (NSArray*)ports
+{
+  ENTER_POOL
+  NSConnection	*c;
+
+  c = [[NSConnection alloc] initWithReceivePort: [ports objectAtIndex: 0]
+				       sendPort: [ports objectAtIndex: 1]];
+  [c setRootObject: AUTORELEASE([self new])];
+  [[NSRunLoop currentRunLoop] run];
+  RELEASE(c);
+  LEAVE_POOL
+}
+- (int) echo: (int)i
+{
+  return i;
+}
+@end
+
+static NSInteger	count;
+static id<Echo>		proxy;
+
+@interface Client : NSObject
+{
+@public
+  NSTimeInterval	total;
+  NSConditionLock	*done;
+}
+- (void) run: (id)arg;
+@end
+
+@implementation Client
+- (void) run: (id)arg
+{
+  ENTER_POOL
+  NSInteger	i;
+
+  for (i = 0; i < count; i++)
+    {
+      NSTimeInterval	t = [NSDate timeIntervalSinceReferenceDate];
+
+      if ([proxy echo: (int)i] != (int)i)
+	{
+	  fprintf(stderr, "bad reply\n");
+	}
+      total += [NSDate timeIntervalSinceReferenceDate] - t;
+    }
+  [done lock];
+  [done unlockWithCondition: [done condition] + 1];
+  LEAVE_POOL
+}
+@end
+
+int
+main()
+{
+  NSUserDefaults	*defs;
+  NSConnection		*conn;
+  NSConditionLock	*done;
+  NSMutableArray	*clients;
+  NSPort		*port1;
+  NSPort		*port2;
+  NSDate		*start;
+  NSTimeInterval	ti;
+  NSTimeInterval	latency = 0.0;
+  NSInteger		threads;
+  NSInteger		window;
+  NSInteger		i;
+
+  ENTER_POOL
+  defs = [NSUserDefaults standardUserDefaults];
+  count = [defs integerForKey: @"Count"];
+  if (count <= 0)
+    {
+      count = 2000;
+    }
+  threads = [defs integerForKey: @"Threads"];
+  if (threads <= 0)
+    {
+      threads = 4;
+    }
+  window = [defs integerForKey: @"Window"];
+  if (window <= 0)
+    {
+      window = 100;
+    }
+
+  port1 = [NSPort port];
+  port2 = [NSPort port];
+  [NSThread detachNewThreadSelector: @selector(serveWithPorts:)
+			   toTarget: [Server class]
+			 withObject: [NSArray arrayWithObjects: port1, port2, nil]];
+  conn = AUTORELEASE([[NSConnection alloc] initWithReceivePort: port2
+						      sendPort: port1]);
+  [conn enableMultipleThreads];
+  proxy = (id<Echo>)[conn rootProxy];
+  [(id)proxy setProtocolForProxy: @protocol(Echo)];
+
+  done = AUTORELEASE([[NSConditionLock alloc] initWithCondition: 0]);
+  clients = [NSMutableArray array];
+  start = [NSDate date];
+  for (i = 0; i < threads; i++)
+    {
+      Client	*c = AUTORELEASE([Client new]);
+
+      c->done = done;
+      [clients addObject: c];
+      [NSThread detachNewThreadSelector: @selector(run:)
+			       toTarget: c
+			     withObject: nil];
+    }
+  [done lockWhenCondition: threads];
+  [done unlock];
+  ti = -[start timeIntervalSinceNow];
+
+  for (i = 0; i < threads; i++)
+    {
+      latency += ((Client*)[clients objectAtIndex: i])->total;
+    }
+  printf("%ld threads: mean latency %.1f us, %.0f calls/s\n", (long)threads,
+    latency / (count * threads) * 1000000.0, count * threads / ti);
+
+  start = [NSDate date];
+  {
+    NSMutableArray	*inFlight = [NSMutableArray array];
+    NSMethodSignature	*sig;
+
+    sig = [(id)proxy methodSignatureForSelector: @selector(echo:)];
+    for (i = 0; i < count * threads; i++)
+      {
+	NSInvocation	*inv;
+	int		v = (int)i;
+
+	if ([inFlight count] >= window)
+	  {
+	    [[inFlight objectAtIndex: 0] waitUntilDone];
+	    [inFlight removeObjectAtIndex: 0];
+	  }
+	inv = [NSInvocation invocationWithMethodSignature: sig];
+	[inv setSelector: @selector(echo:)];
+	[inv setArgument: &v atIndex: 2];
+	[inFlight addObject: [(NSDistantObject*)proxy sendInvocation: inv]];
+      }
+    GS_FOR_IN(GSDistantFuture*, f, inFlight)
+      [f waitUntilDone];
+    GS_END_FOR(inFlight)
+  }
+  ti = -[start timeIntervalSinceNow];
+  printf("pipelined (window %ld): %.0f calls/s\n", (long)window,
+    count * threads / ti);
+  LEAVE_POOL
+  return 0;
+}
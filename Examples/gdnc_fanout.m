@@ -0,0 +1,170 @@
+/* Benchmark of distributed notification throughput.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: gdnc_fanout [-Publishers N] [-Subscribers M] [-Count C]
+
+   Starts M (default 4) subscriber processes observing a distributed
+   notification, waits for them to register, then starts N (default 4)
+   publisher processes each posting the notification C (default 10000)
+   times.  Each subscriber exits once it has seen every notification, and
+   the rate of delivery (N * M * C notifications in all) is reported.
+   The gdnc server must be running (or be able to start) as usual.
+*/
+#include <stdio.h>
+#include <Foundation/Foundation.h>
+
+static NSString	*benchName = @"GSFanoutBenchmark";
+static NSString	*readyName = @"GSFanoutBenchmarkReady";
+
+@interface Subscriber : NSObject
+{
+@public
+  NSInteger	seen;
+  NSInteger	ready;
+}
+- (void) note: (NSNotification*)n;
+- (void) ready: (NSNotification*)n;
+@end
+
+@implementation Subscriber
+- (void) note: (NSNotification*)n
+{
+  seen++;
+}
+- (void) ready: (NSNotification*)n
+{
+  ready++;
+}
+@end
+
+static void
+runUntil(NSInteger *counter, NSInteger target)
+{
+  NSRunLoop	*loop = [NSRunLoop currentRunLoop];
+  NSDate	*limit = [NSDate dateWithTimeIntervalSinceNow: 120.0];
+
+  while (*counter < target && [limit timeIntervalSinceNow] > 0)
+    {
+      ENTER_POOL
+      [loop runMode: NSDefaultRunLoopMode
+	 beforeDate: [NSDate dateWithTimeIntervalSinceNow: 0.1]];
+      LEAVE_POOL
+    }
+}
+
+int
+main()
+{
+  NSUserDefaults			*defs;
+  NSDistributedNotificationCenter	*dnc;
+  NSString				*role;
+  NSString				*path;
+  NSMutableArray			*tasks;
+  Subscriber				*sub;
+  NSDate				*start;
+  NSTimeInterval			ti;
+  NSInteger				publishers;
+  NSInteger				subscribers;
+  NSInteger				count;
+  NSInteger				i;
+
+  ENTER_POOL
+  defs = [NSUserDefaults standardUserDefaults];
+  publishers = [defs integerForKey: @"Publishers"];
+  if (publishers <= 0)
+    {
+      publishers = 4;
+    }
+  subscribers = [defs integerForKey: @"Subscribers"];
+  if (subscribers <= 0)
+    {
+      subscribers = 4;
+    }
+  count = [defs integerForKey: @"Count"];
+  if (count <= 0)
+    {
+      count = 10000;
+    }
+  role = [defs stringForKey: @"Role"];
+  dnc = [NSDistributedNotificationCenter defaultCenter];
+
+  if ([role isEqual: @"publisher"])
+    {
+      for (i = 0; i < count; i++)
+	{
+	  [dnc postNotificationName: benchName
+			     object: nil
+			   userInfo: nil
+		 deliverImmediately: YES];
+	}
+      /* Let the messages drain before the connection is closed.
+       */
+      [[NSRunLoop currentRunLoop] runUntilDate:
+	[NSDate dateWithTimeIntervalSinceNow: 1.0]];
+    }
+  else if ([role isEqual: @"subscriber"])
+    {
+      sub = AUTORELEASE([Subscriber new]);
+      [dnc addObserver: sub
+	      selector: @selector(note:)
+		  name: benchName
+		object: nil
+    suspensionBehavior: NSNotificationSuspensionBehaviorDeliverImmediately];
+      [dnc postNotificationName: readyName object: nil];
+      runUntil(&sub->seen, publishers * count);
+      if (sub->seen < publishers * count)
+	{
+	  fprintf(stderr, "subscriber saw only %ld notifications\n",
+	    (long)sub->seen);
+	}
+    }
+  else
+    {
+      NSArray	*common;
+
+      path = [[NSBundle mainBundle] executablePath];
+      common = [NSArray arrayWithObjects:
+	@"-Publishers", [NSString stringWithFormat: @"%ld", (long)publishers],
+	@"-Count", [NSString stringWithFormat: @"%ld", (long)count],
+	@"-Role", nil];
+      tasks = [NSMutableArray array];
+
+      sub = AUTORELEASE([Subscriber new]);
+      [dnc addObserver: sub
+	      selector: @selector(ready:)
+		  name: readyName
+		object: nil];
+      for (i = 0; i < subscribers; i++)
+	{
+	  [tasks addObject: [NSTask launchedTaskWithLaunchPath: path
+	    arguments: [common arrayByAddingObject: @"subscriber"]]];
+	}
+      runUntil(&sub->ready, subscribers);
+      [dnc removeObserver: sub name: readyName object: nil];
+
+      start = [NSDate date];
+      for (i = 0; i < publishers; i++)
+	{
+	  [NSTask launchedTaskWithLaunchPath: path
+	    arguments: [common arrayByAddingObject: @"publisher"]];
+	}
+      for (i = 0; i < subscribers; i++)
+	{
+	  [[tasks objectAtIndex: i] waitUntilExit];
+	}
+      ti = -[start timeIntervalSinceNow];
+      printf("%ld publishers, %ld subscribers: %ld notifications in %.2fs,"
+	" %.0f per second\n", (long)publishers, (long)subscribers,
+	(long)(publishers * subscribers * count), ti,
+	publishers * subscribers * count / ti);
+    }
+  LEAVE_POOL
+  return 0;
+}
@@ -0,0 +1,114 @@
+/* Benchmark of ISO 8601 date formatting and parsing.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: iso8601_format [-Count N] [-TimeZone name]
+
+   Formats and parses N (default 100000) internet date-time strings with
+   NSISO8601DateFormatter, one at a time and in batches, and with an
+   NSDateFormatter using the equivalent format for comparison.  The zone
+   is UTC unless another is named.
+*/
+#include <stdio.h>
+#include <Foundation/Foundation.h>
+
+static void
+report(const char *what, NSDate *start, NSInteger count)
+{
+  NSTimeInterval	ti = -[start timeIntervalSinceNow];
+
+  printf("%-28s %10.0f per second\n", what, count / ti);
+}
+
+int
+main()
+{
+  NSUserDefaults		*defs;
+  NSISO8601DateFormatter	*iso;
+  NSDateFormatter		*ref;
+  NSTimeZone			*tz;
+  NSMutableArray		*dates;
+  NSMutableArray		*strings;
+  NSString			*name;
+  NSDate			*start;
+  NSInteger			count;
+  NSInteger			i;
+
+  ENTER_POOL
+  defs = [NSUserDefaults standardUserDefaults];
+  count = [defs integerForKey: @"Count"];
+  if (count <= 0)
+    {
+      count = 100000;
+    }
+  name = [defs stringForKey: @"TimeZone"];
+  tz = (nil == name) ? [NSTimeZone timeZoneForSecondsFromGMT: 0]
+    : [NSTimeZone timeZoneWithName: name];
+
+  iso = AUTORELEASE([NSISO8601DateFormatter new]);
+  [iso setTimeZone: tz];
+  ref = AUTORELEASE([NSDateFormatter new]);
+  [ref setTimeZone: tz];
+  [ref setDateFormat: @"yyyy-MM-dd'T'HH:mm:ssZZZZZ"];
+
+  /* Dates a few seconds apart, as in a log file.
+   */
+  dates = [NSMutableArray arrayWithCapacity: count];
+  for (i = 0; i < count; i++)
+    {
+      [dates addObject: [NSDate dateWithTimeIntervalSinceNow: i * 3.7]];
+    }
+  strings = [NSMutableArray arrayWithCapacity: count];
+
+  start = [NSDate date];
+  for (i = 0; i < count; i++)
+    {
+      ENTER_POOL
+      [ref stringFromDate: [dates objectAtIndex: i]];
+      LEAVE_POOL
+    }
+  report("NSDateFormatter format", start, count);
+
+  start = [NSDate date];
+  for (i = 0; i < count; i++)
+    {
+      ENTER_POOL
+      [strings addObject: [iso stringFromDate: [dates objectAtIndex: i]]];
+      LEAVE_POOL
+    }
+  report("ISO 8601 format", start, count);
+
+  start = [NSDate date];
+  [iso stringsFromDates: dates];
+  report("ISO 8601 format (batch)", start, count);
+
+  start = [NSDate date];
+  for (i = 0; i < count; i++)
+    {
+      ENTER_POOL
+      [ref dateFromString: [strings objectAtIndex: i]];
+      LEAVE_POOL
+    }
+  report("NSDateFormatter parse", start, count);
+
+  start = [NSDate date];
+  for (i = 0; i < count; i++)
+    {
+      ENTER_POOL
+      [iso dateFromString: [strings objectAtIndex: i]];
+      LEAVE_POOL
+    }
+  report("ISO 8601 parse", start, count);
+
+  start = [NSDate date];
+  [iso datesFromStrings: strings];
+  report("ISO 8601 parse (batch)", start, count);
+  LEAVE_POOL
+  return 0;
+}
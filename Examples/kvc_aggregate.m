@@ -0,0 +1,135 @@
+/* Benchmark of the key-value coding collection operators.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: kvc_aggregate [-Count N] [-Repeat R]
+
+   Builds an array of N (default 1000000) objects with an integer
+   instance variable, a double getter and a string property, and reports
+   the rate (elements per second, over R repeats, default 10) at which
+   @sum, @avg, @max and @min over each of them and -valueForKey: on the
+   array and on a set of the same objects run.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <Foundation/Foundation.h>
+
+@interface Order : NSObject
+{
+@public
+  int		quantity;
+  double	price;
+  NSString	*customer;
+}
+- (double) price;
+@end
+
+@implementation Order
+- (void) dealloc
+{
+  DESTROY(customer);
+  DEALLOC
+}
+- (double) price
+{
+  return price;
+}
+@end
+
+static void
+report(const char *what, NSDate *start, NSInteger n)
+{
+  NSTimeInterval	ti = -[start timeIntervalSinceNow];
+
+  printf("%-24s %12.0f per second\n", what, n / ti);
+}
+
+int
+main()
+{
+  NSUserDefaults	*defs;
+  NSMutableArray	*orders;
+  NSSet			*set;
+  NSArray		*paths;
+  NSDate		*start;
+  NSInteger		count;
+  NSInteger		repeat;
+  NSInteger		i;
+  NSInteger		j;
+  NSInteger		r;
+
+  ENTER_POOL
+  defs = [NSUserDefaults standardUserDefaults];
+  count = [defs integerForKey: @"Count"];
+  if (count <= 0)
+    {
+      count = 1000000;
+    }
+  repeat = [defs integerForKey: @"Repeat"];
+  if (repeat <= 0)
+    {
+      repeat = 10;
+    }
+
+  orders = [NSMutableArray arrayWithCapacity: count];
+  srandom(42);
+  for (i = 0; i < count; i++)
+    {
+      Order	*o = AUTORELEASE([Order new]);
+
+      o->quantity = random() % 1000;
+      o->price = (random() % 100000) / 100.0;
+      o->customer = [[NSString alloc] initWithFormat: @"customer%ld",
+	(long)(random() % 10000)];
+      [orders addObject: o];
+    }
+  set = [NSSet setWithArray: orders];
+
+  paths = [NSArray arrayWithObjects:
+    @"@sum.quantity", @"@avg.quantity", @"@max.quantity", @"@min.quantity",
+    @"@sum.price", @"@avg.price", @"@max.price", @"@min.price",
+    @"@max.customer", @"@min.customer", nil];
+  for (j = 0; j < [paths count]; j++)
+    {
+      NSString	*path = [paths objectAtIndex: j];
+      id	result = nil;
+
+      start = [NSDate date];
+      for (r = 0; r < repeat; r++)
+	{
+	  ENTER_POOL
+	  result = RETAIN([orders valueForKeyPath: path]);
+	  LEAVE_POOL
+	  AUTORELEASE(result);
+	}
+      report([path UTF8String], start, count * repeat);
+      printf("%-24s %s\n", "", [[result description] UTF8String]);
+    }
+
+  start = [NSDate date];
+  for (r = 0; r < repeat; r++)
+    {
+      ENTER_POOL
+      [orders valueForKey: @"quantity"];
+      LEAVE_POOL
+    }
+  report("array valueForKey:", start, count * repeat);
+
+  start = [NSDate date];
+  for (r = 0; r < repeat; r++)
+    {
+      ENTER_POOL
+      [set valueForKey: @"customer"];
+      LEAVE_POOL
+    }
+  report("set valueForKey:", start, count * repeat);
+
+  LEAVE_POOL
+  return 0;
+}
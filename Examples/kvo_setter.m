@@ -0,0 +1,154 @@
+/* Benchmark of setter throughput on key-value observed classes.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: kvo_setter [-Count N] [-Threads T]
+
+   Makes N (default 1000000) calls to a setter on instances of a class
+   with 0, 1 and 10 observers, and on an unobserved instance of the same
+   class while another instance is observed (the common case in a model
+   layer where few objects have observers).  With T threads (default 1)
+   each thread uses its own instances, showing whether notifications for
+   different objects contend with each other.
+*/
+#include <stdio.h>
+#include <Foundation/Foundation.h>
+
+static NSInteger	count;
+static NSInteger	threads;
+
+@interface Model : NSObject
+{
+  NSInteger	value;
+}
+- (void) setValue: (NSInteger)v;
+@end
+
+@implementation Model
+- (void) setValue: (NSInteger)v
+{
+  value = v;
+}
+@end
+
+@interface Watcher : NSObject
+@end
+
+@implementation Watcher
+- (void) observeValueForKeyPath: (NSString*)path
+		       ofObject: (id)object
+			 change: (NSDictionary*)change
+			context: (void*)context
+{
+}
+@end
+
+@interface Worker : NSObject
+{
+@public
+  NSInteger		observers;
+  BOOL			observeOther;
+  NSConditionLock	*done;
+}
+- (void) run: (id)arg;
+@end
+
+@implementation Worker
+- (void) run: (id)arg
+{
+  ENTER_POOL
+  Model		*m = AUTORELEASE([Model new]);
+  Model		*other = AUTORELEASE([Model new]);
+  NSMutableArray	*watchers = [NSMutableArray array];
+  NSInteger	i;
+
+  for (i = 0; i < observers; i++)
+    {
+      Watcher	*w = AUTORELEASE([Watcher new]);
+
+      [watchers addObject: w];
+      [m addObserver: w forKeyPath: @"value" options: 0 context: 0];
+    }
+  if (observeOther)
+    {
+      Watcher	*w = AUTORELEASE([Watcher new]);
+
+      [watchers addObject: w];
+      [other addObserver: w forKeyPath: @"value" options: 0 context: 0];
+    }
+  for (i = 0; i < count; i++)
+    {
+      [m setValue: i];
+    }
+  for (i = 0; i < observers; i++)
+    {
+      [m removeObserver: [watchers objectAtIndex: i] forKeyPath: @"value"];
+    }
+  if (observeOther)
+    {
+      [other removeObserver: [watchers lastObject] forKeyPath: @"value"];
+    }
+  [done lock];
+  [done unlockWithCondition: [done condition] + 1];
+  LEAVE_POOL
+}
+@end
+
+static void
+measure(const char *what, NSInteger observers, BOOL observeOther)
+{
+  NSConditionLock	*done;
+  NSDate		*start;
+  NSTimeInterval	ti;
+  NSInteger		i;
+
+  done = AUTORELEASE([[NSConditionLock alloc] initWithCondition: 0]);
+  start = [NSDate date];
+  for (i = 0; i < threads; i++)
+    {
+      Worker	*w = AUTORELEASE([Worker new]);
+
+      w->observers = observers;
+      w->observeOther = observeOther;
+      w->done = done;
+      [NSThread detachNewThreadSelector: @selector(run:)
+			       toTarget: w
+			     withObject: nil];
+    }
+  [done lockWhenCondition: threads];
+  [done unlock];
+  ti = -[start timeIntervalSinceNow];
+  printf("%-24s %10.0f sets/s\n", what, count * threads / ti);
+}
+
+int
+main()
+{
+  NSUserDefaults	*defs;
+
+  ENTER_POOL
+  defs = [NSUserDefaults standardUserDefaults];
+  count = [defs integerForKey: @"Count"];
+  if (count <= 0)
+    {
+      count = 1000000;
+    }
+  threads = [defs integerForKey: @"Threads"];
+  if (threads <= 0)
+    {
+      threads = 1;
+    }
+
+  measure("no observers", 0, NO);
+  measure("unobserved (class is)", 0, YES);
+  measure("1 observer", 1, NO);
+  measure("10 observers", 10, NO);
+  LEAVE_POOL
+  return 0;
+}
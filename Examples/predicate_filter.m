@@ -0,0 +1,97 @@
+/* Benchmark of filtering arrays with predicates.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: predicate_filter [-Count N]
+
+   Filters an array of N (default 1000000) model objects with predicates
+   using a comparison, a key path, LIKE and MATCHES, first on the calling
+   thread and then concurrently, reporting the time taken for each.
+*/
+#include <stdio.h>
+#include <Foundation/Foundation.h>
+
+@interface Model : NSObject
+{
+  NSString	*name;
+  NSInteger	size;
+  Model		*owner;
+}
+- (id) initWithIndex: (NSInteger)i owner: (Model*)o;
+@end
+
+@implementation Model
+- (void) dealloc
+{
+  RELEASE(name);
+  RELEASE(owner);
+  [super dealloc];
+}
+
+- (id) initWithIndex: (NSInteger)i owner: (Model*)o
+{
+  if ((self = [super init]) != nil)
+    {
+      name = [[NSString alloc] initWithFormat: @"item-%ld", (long)i];
+      size = i % 1000;
+      owner = RETAIN(o);
+    }
+  return self;
+}
+@end
+
+static void
+measure(const char *what, NSArray *objects, NSString *format)
+{
+  NSPredicate	*p = [NSPredicate predicateWithFormat: format];
+  NSDate	*start;
+  NSUInteger	n;
+
+  ENTER_POOL
+  start = [NSDate date];
+  n = [[objects filteredArrayUsingPredicate: p] count];
+  printf("%-10s %8.3f seconds", what, -[start timeIntervalSinceNow]);
+  start = [NSDate date];
+  [objects filteredArrayUsingPredicate: p options: NSEnumerationConcurrent];
+  printf("  concurrent %8.3f seconds  (%lu matches)\n",
+    -[start timeIntervalSinceNow], (unsigned long)n);
+  LEAVE_POOL
+}
+
+int
+main()
+{
+  NSUserDefaults	*defs;
+  NSMutableArray	*objects;
+  Model			*owner;
+  NSInteger		count;
+  NSInteger		i;
+
+  ENTER_POOL
+  defs = [NSUserDefaults standardUserDefaults];
+  count = [defs integerForKey: @"Count"];
+  if (count <= 0)
+    {
+      count = 1000000;
+    }
+  owner = AUTORELEASE([[Model alloc] initWithIndex: 7 owner: nil]);
+  objects = [NSMutableArray arrayWithCapacity: count];
+  for (i = 0; i < count; i++)
+    {
+      [objects addObject:
+	AUTORELEASE([[Model alloc] initWithIndex: i owner: owner])];
+    }
+
+  measure("compare", objects, @"size < 100");
+  measure("key path", objects, @"owner.size == 7");
+  measure("LIKE", objects, @"name LIKE 'item-1*'");
+  measure("MATCHES", objects, @"name MATCHES 'item-[0-9]*5'");
+  LEAVE_POOL
+  return 0;
+}
@@ -0,0 +1,97 @@
+/* Benchmark of sorting with sort descriptors.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: sort_descriptors [-Count N]
+
+   Sorts N (default 1000000) model objects by an integer property, by a
+   string property, by a date property, and by an integer property then
+   a string property, reporting the time taken for each.
+*/
+#include <stdio.h>
+#include <Foundation/Foundation.h>
+
+@interface Model : NSObject
+{
+  int		rank;
+  NSString	*name;
+  NSDate	*when;
+}
+- (id) initWithIndex: (NSInteger)i;
+@end
+
+@implementation Model
+- (void) dealloc
+{
+  RELEASE(name);
+  RELEASE(when);
+  [super dealloc];
+}
+
+- (id) initWithIndex: (NSInteger)i
+{
+  if ((self = [super init]) != nil)
+    {
+      rank = (int)((i * 7919) % 1000);
+      name = [[NSString alloc] initWithFormat: @"name %ld",
+	(long)((i * 104729) % 100000)];
+      when = [[NSDate alloc] initWithTimeIntervalSinceReferenceDate:
+	(i * 15485863) % 10000000];
+    }
+  return self;
+}
+@end
+
+static void
+measure(const char *what, NSArray *objects, NSArray *descriptors)
+{
+  NSDate	*start;
+
+  ENTER_POOL
+  start = [NSDate date];
+  [objects sortedArrayUsingDescriptors: descriptors];
+  printf("%-20s %8.3f seconds\n", what, -[start timeIntervalSinceNow]);
+  LEAVE_POOL
+}
+
+int
+main()
+{
+  NSUserDefaults	*defs;
+  NSMutableArray	*objects;
+  NSSortDescriptor	*byRank;
+  NSSortDescriptor	*byName;
+  NSSortDescriptor	*byDate;
+  NSInteger		count;
+  NSInteger		i;
+
+  ENTER_POOL
+  defs = [NSUserDefaults standardUserDefaults];
+  count = [defs integerForKey: @"Count"];
+  if (count <= 0)
+    {
+      count = 1000000;
+    }
+  objects = [NSMutableArray arrayWithCapacity: count];
+  for (i = 0; i < count; i++)
+    {
+      [objects addObject: AUTORELEASE([[Model alloc] initWithIndex: i])];
+    }
+  byRank = [NSSortDescriptor sortDescriptorWithKey: @"rank" ascending: YES];
+  byName = [NSSortDescriptor sortDescriptorWithKey: @"name" ascending: YES];
+  byDate = [NSSortDescriptor sortDescriptorWithKey: @"when" ascending: NO];
+
+  measure("integer", objects, [NSArray arrayWithObject: byRank]);
+  measure("string", objects, [NSArray arrayWithObject: byName]);
+  measure("date", objects, [NSArray arrayWithObject: byDate]);
+  measure("integer, string", objects,
+    [NSArray arrayWithObjects: byRank, byName, nil]);
+  LEAVE_POOL
+  return 0;
+}
@@ -0,0 +1,133 @@
+/* Benchmark of building large strings and data by appending small pieces.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: string_build [-Pieces N] [-Repeat R]
+
+   Builds a response of N (default 1000000) short pieces, some of which
+   contain non-Latin-1 characters, R times (default 10) and writes it to
+   /dev/null through an NSFileHandle, and reports the rate (pieces per
+   second) with an ordinary NSMutableString and NSMutableData and with
+   those made by +chunkedStringWithCapacity: and +chunkedDataWithCapacity:
+*/
+#include <stdio.h>
+#include <Foundation/Foundation.h>
+
+static NSInteger	pieces;
+
+static NSUInteger
+buildString(NSMutableString *m, NSFileHandle *out)
+{
+  NSString	*euro = [NSString stringWithFormat: @"%C", (unichar)0x20ac];
+  NSData	*d;
+  NSInteger	i;
+
+  for (i = 0; i < pieces; i++)
+    {
+      [m appendString: @"<td>"];
+      if (i % 100 == 99)
+	{
+	  [m appendString: euro];
+	}
+      [m appendString: @"cell"];
+      [m appendString: @"</td>"];
+    }
+  d = [m dataUsingEncoding: NSUTF8StringEncoding];
+  [out writeData: d];
+  return [d length];
+}
+
+static NSUInteger
+buildData(NSMutableData *m, NSFileHandle *out)
+{
+  NSInteger	i;
+
+  for (i = 0; i < pieces; i++)
+    {
+      [m appendBytes: "<td>" length: 4];
+      [m appendBytes: &i length: sizeof(i)];
+      [m appendBytes: "</td>" length: 5];
+    }
+  [out writeData: m];
+  return [m length];
+}
+
+static void
+report(const char *what, NSDate *start, NSInteger n)
+{
+  NSTimeInterval	ti = -[start timeIntervalSinceNow];
+
+  printf("%-16s %12.0f pieces per second\n", what, n / ti);
+}
+
+int
+main()
+{
+  NSUserDefaults	*defs;
+  NSFileHandle		*out;
+  NSDate		*start;
+  NSInteger		repeat;
+  NSInteger		r;
+  NSUInteger		check = 0;
+
+  ENTER_POOL
+  defs = [NSUserDefaults standardUserDefaults];
+  pieces = [defs integerForKey: @"Pieces"];
+  if (pieces <= 0)
+    {
+      pieces = 1000000;
+    }
+  repeat = [defs integerForKey: @"Repeat"];
+  if (repeat <= 0)
+    {
+      repeat = 10;
+    }
+  out = [NSFileHandle fileHandleForWritingAtPath: @"/dev/null"];
+
+  start = [NSDate date];
+  for (r = 0; r < repeat; r++)
+    {
+      ENTER_POOL
+      check += buildString([NSMutableString stringWithCapacity: 0], out);
+      LEAVE_POOL
+    }
+  report("string", start, pieces * repeat);
+
+  start = [NSDate date];
+  for (r = 0; r < repeat; r++)
+    {
+      ENTER_POOL
+      check += buildString([NSMutableString chunkedStringWithCapacity: 0],
+	out);
+      LEAVE_POOL
+    }
+  report("chunked string", start, pieces * repeat);
+
+  start = [NSDate date];
+  for (r = 0; r < repeat; r++)
+    {
+      ENTER_POOL
+      check += buildData([NSMutableData dataWithCapacity: 0], out);
+      LEAVE_POOL
+    }
+  report("data", start, pieces * repeat);
+
+  start = [NSDate date];
+  for (r = 0; r < repeat; r++)
+    {
+      ENTER_POOL
+      check += buildData([NSMutableData chunkedDataWithCapacity: 0], out);
+      LEAVE_POOL
+    }
+  report("chunked data", start, pieces * repeat);
+
+  printf("%lu bytes written\n", (unsigned long)check);
+  LEAVE_POOL
+  return 0;
+}
@@ -0,0 +1,81 @@
+/* Benchmark of building strings with formats.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: string_format [-Count N]
+
+   Formats N (default 1000000) strings with each of a few common patterns
+   (%@, %d, %f, %s and a mixture) using a constant format, then with an
+   equal format which is not a constant string, and finally appends to a
+   mutable string, reporting the rate for each.
+*/
+#include <stdio.h>
+#include <Foundation/Foundation.h>
+
+static NSInteger	count;
+
+static void
+report(const char *what, NSDate *start)
+{
+  NSTimeInterval	ti = -[start timeIntervalSinceNow];
+
+  printf("%-22s %10.0f per second\n", what, count / ti);
+}
+
+int
+main()
+{
+  NSUserDefaults	*defs;
+  NSString		*obj = @"an object";
+  NSString		*fmt;
+  NSMutableString	*m;
+  NSDate		*start;
+  NSInteger		i;
+
+  ENTER_POOL
+  defs = [NSUserDefaults standardUserDefaults];
+  count = [defs integerForKey: @"Count"];
+  if (count <= 0)
+    {
+      count = 1000000;
+    }
+
+#define	RUN(name, format, args...) \
+  start = [NSDate date]; \
+  for (i = 0; i < count; i++) \
+    { \
+      ENTER_POOL \
+      [NSString stringWithFormat: format, args]; \
+      LEAVE_POOL \
+    } \
+  report(name, start);
+
+  RUN("%@", @"value %@", obj)
+  RUN("%d", @"value %d", (int)i)
+  RUN("%f", @"value %f", (double)i)
+  RUN("%s", @"value %s", "a C string")
+  RUN("mixed", @"%@ [%d] %s: %.3f", obj, (int)i, "name", 1.5)
+
+  fmt = [NSString stringWithFormat: @"%@", @"%@ [%d] %s: %.3f"];
+  RUN("mixed, not constant", fmt, obj, (int)i, "name", 1.5)
+
+  m = [NSMutableString string];
+  start = [NSDate date];
+  for (i = 0; i < count; i++)
+    {
+      [m appendFormat: @"%d,", (int)i];
+      if ([m length] > 65536)
+	{
+	  [m setString: @""];
+	}
+    }
+  report("appendFormat:", start);
+  LEAVE_POOL
+  return 0;
+}
@@ -0,0 +1,143 @@
+/* Benchmark of TLS handshakes with and without session resumption.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: tls_handshake [-Count N]
+
+   Performs N (default 500) TLS handshakes between a client and a server
+   thread over a loopback socket pair, first with full handshakes and then
+   with the client resuming sessions from the session cache (by giving the
+   GSTLSSessionCacheKey option), and reports the handshake rate of each.
+   The server uses a self signed certificate generated on first use.
+*/
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <Foundation/Foundation.h>
+#include <GNUstepBase/GSTLS.h>
+
+#if GS_USE_GNUTLS
+
+static ssize_t
+pullFunc(gnutls_transport_ptr_t t, void *buf, size_t len)
+{
+  return read((int)(intptr_t)t, buf, len);
+}
+
+static ssize_t
+pushFunc(gnutls_transport_ptr_t t, const void *buf, size_t len)
+{
+  return write((int)(intptr_t)t, buf, len);
+}
+
+@interface Server : NSObject
+- (void) serve: (NSNumber*)fd;
+@end
+
+@implementation Server
+- (void) serve: (NSNumber*)fd
+{
+  ENTER_POOL
+  GSTLSSession	*s;
+  char		c = 'x';
+
+  s = [GSTLSSession sessionWithOptions:
+    [NSDictionary dictionaryWithObject: @"NO" forKey: GSTLSVerify]
+			     direction: NO
+			     transport: (void*)(intptr_t)[fd intValue]
+				  push: pushFunc
+				  pull: pullFunc];
+  while (NO == [s handshake])
+    ;
+  [s write: &c length: 1];
+  [s read: &c length: 1];
+  [s disconnect: NO];
+  close([fd intValue]);
+  LEAVE_POOL
+}
+@end
+
+static void
+run(NSUInteger count, NSString *cacheKey)
+{
+  NSMutableDictionary	*opts;
+  NSDate		*start;
+  NSUInteger		resumed = 0;
+  NSUInteger		i;
+
+  opts = [NSMutableDictionary dictionaryWithObject: @"NO" forKey: GSTLSVerify];
+  if (nil != cacheKey)
+    {
+      [opts setObject: cacheKey forKey: GSTLSSessionCacheKey];
+    }
+  start = [NSDate date];
+  for (i = 0; i < count; i++)
+    {
+      ENTER_POOL
+      GSTLSSession	*s;
+      int		sv[2];
+      char		c = 'y';
+
+      socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+      [NSThread detachNewThreadSelector: @selector(serve:)
+			       toTarget: AUTORELEASE([Server new])
+			     withObject: [NSNumber numberWithInt: sv[1]]];
+      s = [GSTLSSession sessionWithOptions: opts
+				 direction: YES
+				 transport: (void*)(intptr_t)sv[0]
+				      push: pushFunc
+				      pull: pullFunc];
+      while (NO == [s handshake])
+	;
+      if ([s resumed])
+	{
+	  resumed++;
+	}
+      [s read: &c length: 1];
+      [s write: &c length: 1];
+      [s disconnect: NO];
+      close(sv[0]);
+      LEAVE_POOL
+    }
+  printf("%-10s %8.1f handshakes/s (%lu of %lu resumed)\n",
+    (nil == cacheKey) ? "full" : "resumed",
+    count / -[start timeIntervalSinceNow],
+    (unsigned long)resumed, (unsigned long)count);
+}
+
+int
+main()
+{
+  NSInteger	count;
+
+  ENTER_POOL
+  signal(SIGPIPE, SIG_IGN);
+  count = [[NSUserDefaults standardUserDefaults] integerForKey: @"Count"];
+  if (count <= 0)
+    {
+      count = 500;
+    }
+  run(1, nil);			// Generate the server certificate.
+  run(count, nil);
+  run(count, @"loopback:0");
+  LEAVE_POOL
+  return 0;
+}
+
+#else
+
+int
+main()
+{
+  printf("This benchmark needs the library to be built with GNUTLS.\n");
+  return 0;
+}
+
+#endif
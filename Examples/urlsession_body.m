@@ -0,0 +1,214 @@
+/* Benchmark of receiving large response bodies with NSURLSession.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: urlsession_body [-Size MB] [-Count N]
+
+   Starts an HTTP server on a thread of this process which answers every
+   request with a body of the given size (default 256MB), then fetches
+   it N times (default 3) with a data task (body stored in memory) and
+   with a download task (body written to a temporary file), reporting
+   the throughput of each and the growth of the maximum resident set
+   size of the process.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <Foundation/Foundation.h>
+
+#if GS_HAVE_NSURLSESSION && defined(__BLOCKS__)
+
+static unsigned long long	bodySize;
+
+static long
+maxRSS(void)
+{
+  struct rusage	u;
+
+  getrusage(RUSAGE_SELF, &u);
+  return u.ru_maxrss;
+}
+
+@interface Server : NSObject
+{
+@public
+  int	sock;
+}
+- (void) run;
+@end
+
+@implementation Server
+- (void) run
+{
+  static char	chunk[65536];
+  int		c;
+
+  memset(chunk, 'x', sizeof(chunk));
+  while ((c = accept(sock, 0, 0)) >= 0)
+    {
+      char			req[4096];
+      char			hdr[256];
+      unsigned long long	left = bodySize;
+      ssize_t			n;
+
+      /* Requests are small, so one read gets the headers. */
+      n = read(c, req, sizeof(req));
+      if (n > 0)
+	{
+	  snprintf(hdr, sizeof(hdr), "HTTP/1.1 200 OK\r\n"
+	    "Content-Type: application/octet-stream\r\n"
+	    "Content-Length: %llu\r\n"
+	    "Connection: close\r\n\r\n", bodySize);
+	  write(c, hdr, strlen(hdr));
+	  while (left > 0)
+	    {
+	      size_t	len = left > sizeof(chunk) ? sizeof(chunk) : left;
+
+	      if ((n = write(c, chunk, len)) <= 0)
+		{
+		  break;
+		}
+	      left -= n;
+	    }
+	}
+      close(c);
+    }
+}
+@end
+
+static void
+report(const char *what, NSDate *start, unsigned long long bytes, long rss)
+{
+  NSTimeInterval	ti = -[start timeIntervalSinceNow];
+
+  printf("%-14s %8.1f MB/s  max RSS grew by %ld KB\n", what,
+    bytes / ti / (1024.0 * 1024.0), maxRSS() - rss);
+}
+
+int
+main()
+{
+  NSUserDefaults	*defs;
+  NSURLSession		*session;
+  Server		*server;
+  NSURL			*url;
+  NSCondition		*cond;
+  struct sockaddr_in	addr;
+  socklen_t		len = sizeof(addr);
+  NSInteger		count;
+  NSInteger		i;
+  NSDate		*start;
+  long			rss;
+  __block NSInteger	done;
+  __block unsigned long long	received;
+
+  ENTER_POOL
+  defs = [NSUserDefaults standardUserDefaults];
+  bodySize = [defs integerForKey: @"Size"];
+  if (0 == bodySize)
+    {
+      bodySize = 256;
+    }
+  bodySize *= 1024 * 1024;
+  count = [defs integerForKey: @"Count"];
+  if (count <= 0)
+    {
+      count = 3;
+    }
+
+  server = AUTORELEASE([Server new]);
+  server->sock = socket(AF_INET, SOCK_STREAM, 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(server->sock, (struct sockaddr*)&addr, sizeof(addr)) < 0
+    || listen(server->sock, 8) < 0
+    || getsockname(server->sock, (struct sockaddr*)&addr, &len) < 0)
+    {
+      perror("server socket");
+      return 1;
+    }
+  [NSThread detachNewThreadSelector: @selector(run)
+			   toTarget: server
+			 withObject: nil];
+  url = [NSURL URLWithString: [NSString stringWithFormat:
+    @"http://127.0.0.1:%d/body", ntohs(addr.sin_port)]];
+
+  session = [NSURLSession sessionWithConfiguration:
+    [NSURLSessionConfiguration defaultSessionConfiguration]];
+  cond = AUTORELEASE([NSCondition new]);
+
+  rss = maxRSS();
+  start = [NSDate date];
+  done = 0;
+  received = 0;
+  for (i = 0; i < count; i++)
+    {
+      [[session dataTaskWithURL: url completionHandler:
+	^(NSData *data, NSURLResponse *response, NSError *error) {
+	  [cond lock];
+	  received += [data length];
+	  done++;
+	  [cond signal];
+	  [cond unlock];
+	}] resume];
+      [cond lock];
+      while (done <= i)
+	{
+	  [cond wait];
+	}
+      [cond unlock];
+    }
+  report("data task", start, received, rss);
+
+  rss = maxRSS();
+  start = [NSDate date];
+  done = 0;
+  received = 0;
+  for (i = 0; i < count; i++)
+    {
+      [[session downloadTaskWithURL: url completionHandler:
+	^(NSURL *location, NSURLResponse *response, NSError *error) {
+	  NSFileManager	*mgr = [NSFileManager defaultManager];
+
+	  [cond lock];
+	  received += [[mgr attributesOfItemAtPath: [location path]
+					     error: NULL] fileSize];
+	  [mgr removeItemAtPath: [location path] error: NULL];
+	  done++;
+	  [cond signal];
+	  [cond unlock];
+	}] resume];
+      [cond lock];
+      while (done <= i)
+	{
+	  [cond wait];
+	}
+      [cond unlock];
+    }
+  report("download task", start, received, rss);
+
+  [session invalidateAndCancel];
+  LEAVE_POOL
+  return 0;
+}
+
+#else
+
+int
+main()
+{
+  printf("This benchmark needs NSURLSession and a compiler with blocks.\n");
+  return 0;
+}
+
+#endif
@@ -0,0 +1,110 @@
+/* Benchmark of UUID and random data generation.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+  Copying and distribution of this file, with or without modification,
+  are permitted in any medium without royalty provided the copyright
+  notice and this notice are preserved.
+
+   This file is part of the GNUstep Base Library.
+
+   Usage: uuid_gen [-Count N] [-Threads T]
+
+   Makes N (default 1000000) random (version 4) UUIDs, N time-ordered
+   (version 7) UUIDs and N 16 byte blocks of random data in each of T
+   threads (default 1), reporting the rate at which each is produced.
+*/
+#include <stdio.h>
+#include <Foundation/Foundation.h>
+#include <GNUstepBase/NSData+GNUstepBase.h>
+
+static NSInteger	count;
+static NSInteger	threads;
+
+@interface Worker : NSObject
+{
+@public
+  int			kind;
+  NSConditionLock	*done;
+}
+- (void) run: (id)arg;
+@end
+
+@implementation Worker
+- (void) run: (id)arg
+{
+  NSInteger	i;
+  uint8_t	buf[16];
+
+  for (i = 0; i < count; i++)
+    {
+      ENTER_POOL
+      if (0 == kind)
+	{
+	  [NSUUID UUID];
+	}
+      else if (1 == kind)
+	{
+	  [NSUUID timeOrderedUUID];
+	}
+      else
+	{
+	  [NSData randomBytes: buf ofLength: sizeof(buf)];
+	}
+      LEAVE_POOL
+    }
+  [done lock];
+  [done unlockWithCondition: [done condition] + 1];
+}
+@end
+
+static void
+measure(const char *what, int kind)
+{
+  NSConditionLock	*done;
+  NSDate		*start;
+  NSTimeInterval	ti;
+  NSInteger		i;
+
+  done = AUTORELEASE([[NSConditionLock alloc] initWithCondition: 0]);
+  start = [NSDate date];
+  for (i = 0; i < threads; i++)
+    {
+      Worker	*w = AUTORELEASE([Worker new]);
+
+      w->kind = kind;
+      w->done = done;
+      [NSThread detachNewThreadSelector: @selector(run:)
+			       toTarget: w
+			     withObject: nil];
+    }
+  [done lockWhenCondition: threads];
+  [done unlock];
+  ti = -[start timeIntervalSinceNow];
+  printf("%-20s %10.0f per second\n", what, count * threads / ti);
+}
+
+int
+main()
+{
+  NSUserDefaults	*defs;
+
+  ENTER_POOL
+  defs = [NSUserDefaults standardUserDefaults];
+  count = [defs integerForKey: @"Count"];
+  if (count <= 0)
+    {
+      count = 1000000;
+    }
+  threads = [defs integerForKey: @"Threads"];
+  if (threads <= 0)
+    {
+      threads = 1;
+    }
+
+  measure("+UUID", 0);
+  measure("+timeOrderedUUID", 1);
+  measure("+randomBytes:", 2);
+  LEAVE_POOL
+  return 0;
+}
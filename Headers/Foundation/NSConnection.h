@@ -32,6 +32,7 @@
 #import	<Foundation/NSTimer.h>
 #import	<Foundation/NSRunLoop.h>
 #import	<Foundation/NSMapTable.h>
+#import	<GNUstepBase/GSBlocks.h>
 
 #if	defined(__cplusplus)
 extern "C" {
@@ -161,6 +162,78 @@ GS_NSConnection_IVARS;
 - (NSDictionary*) statistics;
 @end
 
+#if	!NO_GNUSTEP
+@class	GSDistantFuture;
+@class	NSException;
+
+DEFINE_BLOCK_TYPE(GSDistantFutureHandler, void, GSDistantFuture*);
+
+/**
+ * A GSDistantFuture represents a message sent to a remote object whose
+ * reply has not necessarily arrived yet.  Sending messages this way lets
+ * a client keep many requests in flight on one connection instead of
+ * waiting for a full round trip per message.<br />
+ * The reply is decoded into the invocation (return value and any values
+ * passed by reference) as soon as it is read from the connection, so
+ * pointers passed by reference must remain valid until the future is done.
+ */
+GS_EXPORT_CLASS
+@interface GSDistantFuture : NSObject
+{
+#if	GS_EXPOSE(GSDistantFuture)
+@public
+  NSConnection		*_connection;
+  NSInvocation		*_invocation;
+  char			*_types;
+  unsigned		_sequence;
+  BOOL			_outParams;
+  BOOL			_done;
+  BOOL			_waiting;
+  BOOL			_claimed;
+  BOOL			_blocked;
+  NSException		*_exception;
+  GSDistantFutureHandler	_handler;
+#endif
+}
+/** Returns the exception raised by the remote end (or raised locally
+ * because no reply could be obtained) or nil if there was none or the
+ * receiver is not yet done.
+ */
+- (NSException*) exception;
+
+/** Returns the invocation sent, into which the reply is decoded.
+ */
+- (NSInvocation*) invocation;
+
+/** Returns YES once the reply has arrived (or no reply is expected, or
+ * the connection has failed).
+ */
+- (BOOL) isDone;
+
+/** Sets a handler to be called (once) when the receiver is done.  If the
+ * receiver is already done the handler is called immediately.  Otherwise
+ * it is called in whichever thread reads the reply from the connection.
+ */
+- (void) setCompletionHandler: (GSDistantFutureHandler)handler;
+
+/** Waits (running the current thread's run loop in NSConnectionReplyMode)
+ * until the reply arrives, then raises the exception from the remote end
+ * if there was one, just as a synchronous message would.  Only one thread
+ * may wait for a future at a time.
+ */
+- (void) waitUntilDone;
+@end
+
+@interface NSConnection (GSDistantFuture)
+/** Encodes and sends inv to the remote object represented by proxy
+ * without waiting for a reply, and returns a future through which the
+ * reply may be obtained.
+ */
+- (GSDistantFuture*) sendInvocation: (NSInvocation*)inv
+			   forProxy: (NSDistantObject*)proxy;
+@end
+#endif
+
 
 /**
  * This category represents an informal protocol to which NSConnection
@@ -399,6 +399,11 @@ NS_ASSUME_NONNULL_END
 #if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
 
 @interface NSMutableData (GNUstepExtensions)
+/*
+ *	Returns data optimised for building up by appending many pieces.
+ */
++ (id) chunkedDataWithCapacity: (NSUInteger)capacity;
+
 /*
  *	Capacity management - GNUstep gives you control over the size of
  *	the data buffer as well as the 'length' of valid data in it.
@@ -254,6 +254,29 @@ GS_EXPORT void
 NSDecimalFromString(NSDecimal *result, NSString *numberValue, 
 		    NSDictionary *locale);
 
+#if	!NO_GNUSTEP
+/**
+ *  Adds the count decimals in values and returns the sum in (preallocated)
+ *  result, exactly as adding them one after another with NSDecimalAdd()
+ *  would, but without the intermediate conversions where the partial sums
+ *  are exact.  The return value is the first error reported by any of the
+ *  additions.
+ */
+GS_EXPORT NSCalculationError
+NSDecimalSum(NSDecimal *result, const NSDecimal *values, NSUInteger count,
+  NSRoundingMode mode);
+
+/**
+ *  Returns in (preallocated) result the sum of the products of the count
+ *  pairs of decimals in a and b, exactly as NSDecimalMultiply() and
+ *  NSDecimalAdd() would.  The return value is the first error reported by
+ *  any of the operations.
+ */
+GS_EXPORT NSCalculationError
+NSDecimalDotProduct(NSDecimal *result, const NSDecimal *a, const NSDecimal *b,
+  NSUInteger count, NSRoundingMode mode);
+#endif
+
 #if	defined(__cplusplus)
 }
 #endif
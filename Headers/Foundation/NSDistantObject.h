@@ -68,6 +68,17 @@ GS_EXPORT_CLASS
 
 @end
 
+#if	!NO_GNUSTEP
+@class	GSDistantFuture;
+
+@interface NSDistantObject (GSDistantFuture)
+/** Sends inv to the remote object without waiting for the reply,
+ * returning a future which receives the reply.  See GSDistantFuture.
+ */
+- (GSDistantFuture*) sendInvocation: (NSInvocation*)inv;
+@end
+#endif
+
 #if	defined(__cplusplus)
 }
 #endif
@@ -410,6 +410,16 @@ GS_EXPORT_CLASS
  *   Some web servers require SNI in order to tell what hostname an HTTPS
  *   request is for and decide which certificate to present to the client.
  *   </desc>
+ *   <term>GSTLSSessionCacheKey</term>
+ *   <desc>A string identifying the remote end of an outgoing connection
+ *   (normally its address and port in the form host:port).  When this is
+ *   set, the data of a session established with the remote end is cached
+ *   (in a bounded cache shared by the process) and offered to the server
+ *   for resumption when another connection is made with the same key and
+ *   TLS settings, so that an abbreviated handshake can be used.<br />
+ *   File handles and streams set this for outgoing connections if it
+ *   is not already set.
+ *   </desc>
  *   <term>GSTLSVerify</term>
  *   <desc>A boolean specifying whether we should require the remote end to
  *   supply a valid certificate in order to establish an encrypted connection.
@@ -479,6 +489,11 @@ GS_EXPORT NSString * const GSTLSRevokeFile;
  */
 GS_EXPORT NSString * const GSTLSServerName;
 
+/** Dictionary key for a string identifying the remote end of a connection,
+ * used to cache sessions so that they may be resumed.
+ */
+GS_EXPORT NSString * const GSTLSSessionCacheKey;
+
 /** Dictionary key for a boolean to enable certificate verification.
  */
 GS_EXPORT NSString * const GSTLSVerify;
@@ -57,7 +57,7 @@ enum
 };
 typedef NSUInteger NSISO8601DateFormatOptions;
 
-@class NSTimeZone, NSString, NSDate, NSDateFormatter;
+@class NSArray, NSTimeZone, NSString, NSDate, NSDateFormatter;
 
 GS_EXPORT_CLASS
 @interface NSISO8601DateFormatter : NSFormatter <NSCoding>
@@ -80,6 +80,20 @@ GS_EXPORT_CLASS
                      timeZone: (NSTimeZone *)timeZone
                 formatOptions: (NSISO8601DateFormatOptions)formatOptions;
 
+#if	!NO_GNUSTEP
+/** Returns an array containing the result of -stringFromDate: for each
+ * of the dates (or NSNull where a date could not be formatted).<br />
+ * This is a GNUstep extension.
+ */
+- (NSArray *) stringsFromDates: (NSArray *)dates;
+
+/** Returns an array containing the result of -dateFromString: for each
+ * of the strings (or NSNull where a string could not be parsed).<br />
+ * This is a GNUstep extension.
+ */
+- (NSArray *) datesFromStrings: (NSArray *)strings;
+#endif
+
 @end
 
 #if	defined(__cplusplus)
@@ -69,6 +69,19 @@ GS_EXPORT_CLASS
  * return an array containing all the objects which evaluate to YES.
  */
 - (GS_GENERIC_CLASS(NSArray, ElementT) *) filteredArrayUsingPredicate: (NSPredicate *)predicate;
+
+#if	!NO_GNUSTEP
+/** Evaluate each object in the array using the specified predicate and
+ * return an array containing all the objects which evaluate to YES (in
+ * their original order).<br />
+ * If opts contains NSEnumerationConcurrent, the objects may be evaluated
+ * concurrently on several threads, so the predicate must be safe to
+ * evaluate that way.<br />
+ * This is a GNUstep extension.
+ */
+- (GS_GENERIC_CLASS(NSArray, ElementT) *) filteredArrayUsingPredicate: (NSPredicate *)predicate
+  options: (NSEnumerationOptions)opts;
+#endif
 @end
 
 @interface NSMutableArray (NSPredicate)
@@ -55,6 +55,26 @@ enum {
  */
 typedef NSUInteger NSPropertyListMutabilityOptions;
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+/**
+ * GNUstep extension which may be added (or-ed) to NSPropertyListImmutable
+ * in the options used to read a property list.<br />
+ * When a binary property list is read with this option, the arrays and
+ * dictionaries returned are read-only proxies which decode each of their
+ * members from the data only when it is first accessed, data objects
+ * use the bytes of the property list data rather than copies, and so do
+ * strings of ASCII characters.  The property list data is retained for
+ * as long as any object decoded from it exists, so this works best with
+ * memory mapped data (eg from +dataWithContentsOfMappedFile:) where only
+ * a few of the objects in the property list will be looked at.<br />
+ * The option is ignored for other formats and for mutable containers
+ * or leaves.
+ */
+enum {
+  GSPropertyListLazyDecoding = 0x100
+};
+#endif
+
 enum {
   NSPropertyListOpenStepFormat = 1,
   NSPropertyListXMLFormat_v1_0 = 100,
@@ -103,6 +103,10 @@ GS_EXPORT_CLASS
   NSRegularExpressionOptions options;
 #endif
 #if     GS_NONFRAGILE
+#  if	defined(GS_NSRegularExpression_IVARS)
+@public
+GS_NSRegularExpression_IVARS;
+#  endif
 #else
   /* Pointer to private additional data used to avoid breaking ABI
    * when we don't have the non-fragile ABI available.
@@ -1146,6 +1146,24 @@ GS_EXPORT_CLASS
 
 @end
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+@interface NSMutableString (GNUstepExtensions)
+/**
+ * Returns a new autoreleased string intended for building up large
+ * contents by appending many (possibly small) pieces.<br />
+ * The contents are kept as UTF-8 in chunks (see
+ * [NSMutableData+chunkedDataWithCapacity:]), so an append never copies
+ * what is already stored and non-ASCII characters never cause the whole
+ * string to be converted to 16-bit characters.  Other operations work
+ * on a flat copy of the string made when first needed, so they are
+ * slower than with an ordinary mutable string.<br />
+ * Getting the UTF-8 representation (with -UTF8String or by calling
+ * -dataUsingEncoding: with NSUTF8StringEncoding) needs no conversion.
+ */
++ (NSMutableString*) chunkedStringWithCapacity: (NSUInteger)capacity;
+@end
+#endif
+
 NS_ASSUME_NONNULL_END
 
 #ifdef __OBJC_GNUSTEP_RUNTIME_ABI__
@@ -240,6 +240,28 @@ GS_NSURLSession_IVARS;
  */
 - (NSOperationQueue *) delegateQueue;
 
+#if !NO_GNUSTEP
+/**
+ * Returns statistics about the transfers made by all sessions in the
+ * process, as a dictionary keyed by host name.  The value for each host
+ * is a dictionary containing:<br />
+ * <code>Transfers</code> the number of transfers completed,<br />
+ * <code>NewConnections</code> the number of those which needed a new
+ * connection,<br />
+ * <code>ReuseRate</code> the proportion (0.0 to 1.0) of transfers which
+ * reused an existing connection,<br />
+ * <code>NameLookupTime</code>, <code>ConnectTime</code> and
+ * <code>HandshakeTime</code> the mean time in seconds spent resolving
+ * the host name, establishing the TCP connection and performing the TLS
+ * handshake for each new connection.
+ */
++ (NSDictionary *) connectionStatistics;
+
+/** Discards the statistics returned by +connectionStatistics.
+ */
++ (void) resetConnectionStatistics;
+#endif
+
 /**
  * The delegate for the session. This is the object to which delegate messages
  * will be sent.
@@ -589,6 +611,36 @@ GS_EXPORT_CLASS
  */
 - (NSInteger) HTTPMaximumConnectionLifetime;
 - (void) setHTTPMaximumConnectionLifetime: (NSInteger)n;
+
+/** Returns YES if sessions using this configuration share the process-wide
+ * DNS cache and TLS session cache (see -setSharesConnectionPool:).
+ */
+- (BOOL) sharesConnectionPool;
+
+/** Sets whether sessions using this configuration share a process-wide
+ * cache of host name lookups and of TLS sessions, so that a short lived
+ * session need not repeat the DNS lookup and can resume a TLS session
+ * established by an earlier one (an abbreviated handshake) rather than
+ * performing a full handshake.<br />
+ * Each session keeps its own connections, since libcurl does not support
+ * sharing live connections between the threads which run sessions.<br />
+ * The default is NO.
+ */
+- (void) setSharesConnectionPool: (BOOL)flag;
+
+/** Returns YES if HTTP/2 is negotiated where possible and multiple requests
+ * to the same host are multiplexed over a single connection.
+ */
+- (BOOL) HTTPShouldUseMultiplexing;
+
+/** Sets whether HTTP/2 should be negotiated (over TLS) and requests to the
+ * same host multiplexed over one connection, with a new request waiting
+ * for an existing connection to show whether it can be multiplexed rather
+ * than opening a connection of its own.  If NO, requests use HTTP/1.1 and
+ * a connection carries one request at a time.<br />
+ * The default is YES.
+ */
+- (void) setHTTPShouldUseMultiplexing: (BOOL)flag;
 #endif
 
 @end
@@ -56,6 +56,16 @@ GS_EXPORT_CLASS
 - (NSString *) UUIDString;
 - (void) getUUIDBytes: (gsuuid_t)bytes;
 
+#if	!NO_GNUSTEP
+/** Returns a new time-ordered (version 7, RFC 9562) UUID.  These begin
+ * with the time in milliseconds, so successive UUIDs sort in the order
+ * they were made, which keeps insertions into indexes local.  UUIDs
+ * returned by this method within a process are strictly increasing.
+ * This is a GNUstep extension.
+ */
++ (instancetype) timeOrderedUUID;
+#endif
+
 @end
 
 #if     defined(__cplusplus)
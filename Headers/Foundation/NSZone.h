@@ -163,6 +163,74 @@ struct NSZoneStats
 struct NSZoneStats
 NSZoneStats (NSZone *zone);
 
+/**
+ * Returns the zone representing the per-thread size class allocator which
+ * NSAllocateObject() uses for small objects when the
+ * GNUSTEP_OBJECT_MAGAZINES environment variable is set to YES, or NULL
+ * if that allocator is not in use.<br />
+ * The zone may be passed to NSZoneStats() to find how many objects it
+ * holds and how much memory it has cached, but not used to allocate
+ * memory.
+ */
+NSZone*
+GSObjectMagazineZone (void);
+
+/**
+ * Creates an arena zone, which allocates memory by advancing a pointer
+ * through chunks of chunkSize bytes (or a default size if chunkSize is
+ * zero).  NSZoneFree() does nothing in an arena zone; instead all the
+ * memory allocated in it is made available again at once, and very
+ * quickly, by GSResetArenaZone().  NSRecycleZone() returns all the memory
+ * to the system and destroys the zone.<br />
+ * An arena zone does no locking, so it must only be used by one thread
+ * at a time.  NSZoneFromPointer() does not find memory in arena zones.
+ */
+NSZone*
+GSCreateArenaZone (NSUInteger chunkSize);
+
+/**
+ * Makes all the memory allocated in an arena zone (created by
+ * GSCreateArenaZone()) available for reuse, keeping the chunks it was
+ * allocated from.  Any objects still using the memory must not be used
+ * after this (they are not deallocated).
+ */
+void
+GSResetArenaZone (NSZone *zone);
+
+/**
+ * Makes +alloc and +new (and NSAllocateObject() with a NULL zone) in the
+ * current thread allocate objects in zone instead of the default zone,
+ * until a matching call to GSPopAllocationZone().  Objects explicitly
+ * allocated in NSDefaultMallocZone(), and autorelease pools, still come
+ * from the default zone.  Calls may be nested.  Pushing a NULL zone makes
+ * objects come from the default zone again.  This has no effect with
+ * runtimes which allocate objects themselves (those providing ARC).<br />
+ * This is meant for use with an arena zone around code which creates many
+ * short lived objects, resetting the zone afterwards:
+ * <example>
+ * ENTER_POOL
+ * GSPushAllocationZone(arena);
+ * ... handle a request ...
+ * GSPopAllocationZone();
+ * LEAVE_POOL
+ * GSResetArenaZone(arena);
+ * </example>
+ * Every object created while the zone is pushed must have been
+ * deallocated (or be discarded) by the time the zone is reset, so the
+ * code must not create objects which are kept beyond that, such as
+ * singletons and other objects which classes create on first use and
+ * cache.  Make sure those exist before pushing the zone.
+ */
+void
+GSPushAllocationZone (NSZone *zone);
+
+/**
+ * Ends the effect of the most recent call to GSPushAllocationZone() in the
+ * current thread.
+ */
+void
+GSPopAllocationZone (void);
+
 /**
  * Try to get more memory - the normal process has failed.
  * If we can't do anything, just return a null pointer.
@@ -64,9 +64,46 @@ GS_EXPORT_CLASS
 - (BOOL) decodeData: (const void*)sData
              length: (NSUInteger)length
 	   intoData: (NSMutableData*)dData;
+- (BOOL) decodeStream: (NSInputStream*)input
+	     toStream: (NSOutputStream*)output;
 - (void) setAtEnd: (BOOL)flag;
 @end
 
+/*
+ * Context for decoding base64 data a chunk at a time.
+ */
+GS_EXPORT_CLASS
+@interface	GSMimeBase64DecoderContext : GSMimeCodingContext
+{
+@public
+  unsigned char	buf[4];
+  NSUInteger	pos;
+}
+@end
+
+/*
+ * Context for encoding data to base64 a chunk at a time, producing the
+ * same output as -[NSData base64EncodedDataWithOptions:] would for the
+ * data as a whole.
+ */
+GS_EXPORT_CLASS
+@interface	GSMimeBase64EncoderContext : GSMimeCodingContext
+{
+@public
+  unsigned char	buf[3];
+  NSUInteger	pos;
+  NSUInteger	options;
+  NSUInteger	lineLength;
+  NSUInteger	column;
+}
+- (BOOL) encodeData: (const void*)sData
+             length: (NSUInteger)length
+	   intoData: (NSMutableData*)dData;
+- (BOOL) encodeStream: (NSInputStream*)input
+	     toStream: (NSOutputStream*)output;
+- (id) initWithOptions: (NSDataBase64EncodingOptions)options;
+@end
+
 GS_EXPORT_CLASS
 @interface      GSMimeHeader : NSObject <NSCopying>
 {
@@ -38,6 +38,7 @@ GS_EXPORT NSString * const GSTLSPriority;
 GS_EXPORT NSString * const GSTLSRemoteHosts;
 GS_EXPORT NSString * const GSTLSRevokeFile;
 GS_EXPORT NSString * const GSTLSServerName;
+GS_EXPORT NSString * const GSTLSSessionCacheKey;
 GS_EXPORT NSString * const GSTLSVerify;
 
 #if GS_USE_GNUTLS
@@ -231,6 +232,12 @@ GS_EXPORT_CLASS
                   push: (GSTLSIOW)pushFunc
                   pull: (GSTLSIOR)pullFunc;
 
+/** Discards all the session data cached (for outgoing connections using
+ * the GSTLSSessionCacheKey option) to resume sessions, so that subsequent
+ * connections perform a full handshake.
+ */
++ (void) flushSessionCache;
+
 /* Return YES if the session is active (handshake has succeeded and the
  * session has not been disconnected), NO otherwise.
  */
@@ -298,6 +305,11 @@ GS_EXPORT_CLASS
  */
 - (NSInteger) read: (void*)buf length: (NSUInteger)len;
 
+/** Returns YES if the session is active and was established by resuming
+ * an earlier session (an abbreviated handshake), NO otherwise.
+ */
+- (BOOL) resumed;
+
 /** Get a report of the SSL/TLS status of the current session.
  */
 - (NSString*) sessionInfo;
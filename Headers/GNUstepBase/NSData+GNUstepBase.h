@@ -85,6 +85,16 @@ extern "C" {
  */
 - (NSData*) gzipped: (int)level;
 
+/** Returns data formed by gzipping the contents of the receiver in the
+ * same way as -gzipped: but compressing blocks of the data on up to
+ * threads threads in parallel (use 0 for one thread per processor).<br />
+ * Each block is primed with the data preceding it, so the result is
+ * almost as small as that from -gzipped: and may be decompressed by
+ * any gzip implementation.  Small data is simply passed to -gzipped:.<br />
+ * Returns nil on failure.
+ */
+- (NSData*) gzipped: (int)level threads: (NSUInteger)threads;
+
 /** Returns YES if the receiver is a non-empty data object with a gzip
  * header, NO otherwise.
  */
@@ -110,6 +110,104 @@ GS_EXPORT_CLASS
 
 @end
 
+/**
+ * GSInflateInputStream reads zlib, gzip or raw deflate compressed data
+ * from another input stream and returns it decompressed.  Data is
+ * inflated as it is read, so memory use is bounded (a fixed size input
+ * buffer plus the zlib window) however large the compressed data is.<br />
+ * The underlying stream is opened, closed and scheduled along with the
+ * receiver, and its events are passed on to the receiver's delegate,
+ * so an inflating stream may be stacked on a file, memory or socket
+ * stream and used in the same way.<br />
+ * Multiple concatenated gzip members are decompressed as a single
+ * stream.<br />
+ * Requires the library to have been built with zlib.
+ */
+GS_EXPORT_CLASS
+@interface GSInflateInputStream : NSInputStream
+{
+#if	GS_EXPOSE(GSInflateInputStream)
+@private
+  NSInputStream		*_source;
+  id			_delegate;
+  NSError		*_error;
+  NSStreamStatus	_status;
+  void			*_zstream;
+  uint8_t		*_buffer;
+  int			_windowBits;
+  BOOL			_sourceEnded;
+#endif
+}
+
+/** Returns an autoreleased stream to inflate gzip or zlib data from source.
+ */
++ (id) inputStreamWithStream: (NSInputStream*)source;
+
+/** Initialises the receiver to inflate gzip or zlib data (detected
+ * automatically) from source.
+ */
+- (id) initWithStream: (NSInputStream*)source;
+
+/** <init />
+ * Initialises the receiver to inflate data from source, using windowBits
+ * as in the zlib inflateInit2() function (8 to 15 for zlib data, add 16
+ * for gzip only, 32 to detect either, or use -8 to -15 for raw deflate
+ * data).
+ */
+- (id) initWithStream: (NSInputStream*)source windowBits: (int)windowBits;
+@end
+
+/**
+ * GSDeflateOutputStream compresses the data written to it and writes the
+ * result to another output stream.  Output is buffered in a fixed size
+ * buffer and passed on to the underlying stream as it fills, so memory
+ * use is bounded.  Closing the receiver writes out the remaining
+ * compressed data (and any gzip trailer) before closing the underlying
+ * stream.<br />
+ * As with GSInflateInputStream, the underlying stream is opened and
+ * scheduled along with the receiver, and its events are passed on to
+ * the receiver's delegate.<br />
+ * Requires the library to have been built with zlib.
+ */
+GS_EXPORT_CLASS
+@interface GSDeflateOutputStream : NSOutputStream
+{
+#if	GS_EXPOSE(GSDeflateOutputStream)
+@private
+  NSOutputStream	*_sink;
+  id			_delegate;
+  NSError		*_error;
+  NSStreamStatus	_status;
+  void			*_zstream;
+  uint8_t		*_buffer;
+  NSUInteger		_pending;
+  NSUInteger		_offset;
+  int			_level;
+  int			_windowBits;
+#endif
+}
+
+/** Returns an autoreleased stream to gzip data to sink using the default
+ * compression level.
+ */
++ (id) outputStreamToStream: (NSOutputStream*)sink;
+
+/** Initialises the receiver to gzip data to sink at the specified
+ * compression level (0 to 9, or -1 for the default).
+ */
+- (id) initToStream: (NSOutputStream*)sink level: (int)level;
+
+/** <init />
+ * Initialises the receiver to compress data to sink at the specified
+ * compression level, using windowBits as in the zlib deflateInit2()
+ * function (8 to 15 for zlib format, add 16 for gzip format, or use
+ * -8 to -15 for raw deflate data).
+ */
+- (id) initToStream: (NSOutputStream*)sink
+	      level: (int)level
+	 windowBits: (int)windowBits;
+@end
+
 /** May be used to read the local IP address of a tcp/ip network stream. */
 GS_EXPORT NSString * const GSStreamLocalAddressKey;
 /** May be used to read the local port of a tcp/ip network stream. */
@@ -161,42 +161,6 @@ decodebase64(unsigned char *dst, const unsigned char *src)
   dst[2] = ((src[2] & 0x03) << 6) |  (src[3] & 0x3F);
 }
 
-void
-GSPrivateEncodeBase64(const uint8_t *src, NSUInteger length, uint8_t *dst)
-{
-  int	dIndex = 0;
-  int	sIndex;
-
-  for (sIndex = 0; sIndex < length; sIndex += 3)
-    {
-      static char b64[]
-        = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-      int	c0 = src[sIndex];
-      int	c1 = (sIndex+1 < length) ? src[sIndex+1] : 0;
-      int	c2 = (sIndex+2 < length) ? src[sIndex+2] : 0;
-
-      dst[dIndex++] = b64[(c0 >> 2) & 077];
-      dst[dIndex++] = b64[((c0 << 4) & 060) | ((c1 >> 4) & 017)];
-      dst[dIndex++] = b64[((c1 << 2) & 074) | ((c2 >> 6) & 03)];
-      dst[dIndex++] = b64[c2 & 077];
-    }
-
-   /* If len was not a multiple of 3, then we have encoded too
-    * many characters.  Adjust appropriately.
-    */
-   if (sIndex == length + 1)
-     {
-       /* There were only 2 bytes in that last group */
-       dst[dIndex - 1] = '=';
-     }
-   else if (sIndex == length + 2)
-     {
-       /* There was only 1 byte in that last group */
-       dst[dIndex - 1] = '=';
-       dst[dIndex - 2] = '=';
-     }
-}
-
 static void
 encodeQuotedPrintable(NSMutableData *result,
   const unsigned char *src, unsigned length)
@@ -519,6 +483,69 @@ wordData(NSString *word, BOOL *encoded)
     }
 }
 
+/* Write the whole of the data to the stream and empty it.
+ */
+static BOOL
+writeAll(NSOutputStream *output, NSMutableData *data)
+{
+  const uint8_t	*bytes = [data bytes];
+  NSUInteger	length = [data length];
+
+  while (length > 0)
+    {
+      NSInteger	n = [output write: bytes maxLength: length];
+
+      if (n <= 0)
+	{
+	  return NO;
+	}
+      bytes += n;
+      length -= n;
+    }
+  [data setLength: 0];
+  return YES;
+}
+
+/* Pass data read from input through the coding method of the context
+ * and write the results to output.
+ */
+static BOOL
+codeStream(GSMimeCodingContext *ctx, SEL sel,
+  NSInputStream *input, NSOutputStream *output)
+{
+  BOOL		(*imp)(id, SEL, const void*, NSUInteger, NSMutableData*);
+  NSMutableData	*data;
+  uint8_t	*buf;
+  BOOL		ok = YES;
+
+  imp = (BOOL (*)(id, SEL, const void*, NSUInteger, NSMutableData*))
+    [ctx methodForSelector: sel];
+  buf = NSZoneMalloc(NSDefaultMallocZone(), 65536);
+  data = [[NSMutableData alloc] initWithCapacity: 90000];
+  while (YES == ok)
+    {
+      NSInteger	n = [input read: buf maxLength: 65536];
+
+      if (n < 0)
+	{
+	  ok = NO;
+	}
+      else if (0 == n)
+	{
+	  [ctx setAtEnd: YES];
+	  ok = (*imp)(ctx, sel, buf, 0, data) && writeAll(output, data);
+	  break;
+	}
+      else
+	{
+	  ok = (*imp)(ctx, sel, buf, n, data) && writeAll(output, data);
+	}
+    }
+  RELEASE(data);
+  NSZoneFree(NSDefaultMallocZone(), buf);
+  return ok;
+}
+
 /**
  * Coding contexts are objects used by the parser to store the state of
  * decoding incoming data while it is being incrementally parsed.<br />
@@ -558,6 +585,22 @@ wordData(NSString *word, BOOL *encoded)
   return YES;
 }
 
+/**
+ * Reads data from input until the end of the stream is reached, decoding
+ * it a chunk at a time with -decodeData:length:intoData: and writing the
+ * results to output, so that the data as a whole is never held in memory.
+ * At the end of input the 'atEnd' flag is set before a final call to
+ * flush out any partially decoded data.<br />
+ * Both streams must already be open.<br />
+ * Return YES on success, NO if there is a stream or decoding error.
+ */
+- (BOOL) decodeStream: (NSInputStream*)input
+	     toStream: (NSOutputStream*)output
+{
+  return codeStream(self, @selector(decodeData:length:intoData:),
+    input, output);
+}
+
 /**
  * Sets the current value of the 'atEnd' flag.
  */
@@ -567,13 +610,6 @@ wordData(NSString *word, BOOL *encoded)
 }
 @end
 
-@interface	GSMimeBase64DecoderContext : GSMimeCodingContext
-{
-@public
-  unsigned char	buf[4];
-  NSUInteger	pos;
-}
-@end
 @implementation	GSMimeBase64DecoderContext
 - (BOOL) decodeData: (const void*)sData
 	     length: (NSUInteger)length
@@ -598,8 +634,21 @@ wordData(NSString *word, BOOL *encoded)
    */
   while (src < end)
     {
-      int	cc = *src++;
+      int	cc;
+
+      if (0 == pos)
+	{
+	  NSUInteger	used;
 
+	  used = GSPrivateDecodeBase64Groups(src, end - src, dst);
+	  src += used;
+	  dst += (used / 4) * 3;
+	  if (src == end)
+	    {
+	      break;
+	    }
+	}
+      cc = *src++;
       if (isupper(cc))
 	{
 	  cc -= 'A';
@@ -667,6 +716,154 @@ wordData(NSString *word, BOOL *encoded)
 }
 @end
 
+@implementation	GSMimeBase64EncoderContext
+
+- (id) init
+{
+  return [self initWithOptions: 0];
+}
+
+/**
+ * Initialises the receiver to encode data using the line length and
+ * line ending options used by -[NSData base64EncodedDataWithOptions:].
+ */
+- (id) initWithOptions: (NSDataBase64EncodingOptions)opts
+{
+  if ((self = [super init]) != nil)
+    {
+      int	crlf = NSDataBase64EncodingEndLineWithCarriageReturn
+	| NSDataBase64EncodingEndLineWithLineFeed;
+
+      if (opts & NSDataBase64Encoding64CharacterLineLength)
+	lineLength = 64;
+      else if (opts & NSDataBase64Encoding76CharacterLineLength)
+	lineLength = 76;
+      if (lineLength > 0 && 0 == (opts & crlf))
+	{
+	  opts |= crlf;		// CR+LF is implied
+	}
+      options = opts;
+    }
+  return self;
+}
+
+/* Encode groups of three bytes, adding line breaks as needed.
+ */
+static uint8_t *
+encodeLines(GSMimeBase64EncoderContext *ctx, const uint8_t *src,
+  NSUInteger groups, uint8_t *dst)
+{
+  while (groups > 0)
+    {
+      NSUInteger	n = groups;
+
+      if (ctx->lineLength > 0)
+	{
+	  if (ctx->column == ctx->lineLength)
+	    {
+	      if (ctx->options & NSDataBase64EncodingEndLineWithCarriageReturn)
+		*dst++ = '\r';
+	      if (ctx->options & NSDataBase64EncodingEndLineWithLineFeed)
+		*dst++ = '\n';
+	      ctx->column = 0;
+	    }
+	  if (n > (ctx->lineLength - ctx->column) / 4)
+	    {
+	      n = (ctx->lineLength - ctx->column) / 4;
+	    }
+	  ctx->column += n * 4;
+	}
+      GSPrivateEncodeBase64Groups(src, n, dst);
+      src += n * 3;
+      dst += n * 4;
+      groups -= n;
+    }
+  return dst;
+}
+
+/**
+ * Encode length bytes of data from sData and append the results to dData.
+ * Any bytes which do not make up a complete group of three are kept until
+ * the next call, unless the 'atEnd' flag is set, in which case they are
+ * written out with padding.<br />
+ * Return YES on success, NO if there is an error.
+ */
+- (BOOL) encodeData: (const void*)sData
+             length: (NSUInteger)length
+	   intoData: (NSMutableData*)dData
+{
+  const uint8_t	*src = (const uint8_t*)sData;
+  NSUInteger	size = [dData length];
+  NSUInteger	max;
+  uint8_t	*start;
+  uint8_t	*dst;
+
+  /* Allow for every group (including a padded final one) and a line
+   * break before each of them.
+   */
+  max = (pos + length) / 3 + 1;
+  max *= (lineLength > 0) ? 6 : 4;
+  [dData setLength: size + max];
+  start = (uint8_t*)[dData mutableBytes] + size;
+  dst = start;
+
+  if (pos > 0)
+    {
+      while (pos < 3 && length > 0)
+	{
+	  buf[pos++] = *src++;
+	  length--;
+	}
+      if (3 == pos)
+	{
+	  dst = encodeLines(self, buf, 1, dst);
+	  pos = 0;
+	}
+    }
+  if (length >= 3)
+    {
+      NSUInteger	groups = length / 3;
+
+      dst = encodeLines(self, src, groups, dst);
+      src += groups * 3;
+      length -= groups * 3;
+    }
+  while (length > 0)
+    {
+      buf[pos++] = *src++;
+      length--;
+    }
+  if (pos > 0 && [self atEnd] == YES)
+    {
+      uint8_t	tail[4];
+
+      /* Encode the final partial group through encodeLines() so that
+       * any line break is handled, then apply the padding.
+       */
+      memset(buf + pos, 0, 3 - pos);
+      dst = encodeLines(self, buf, 1, dst);
+      GSPrivateEncodeBase64(buf, pos, tail);
+      memcpy(dst - 4, tail, 4);
+      pos = 0;
+    }
+  [dData setLength: size + (dst - start)];
+  return YES;
+}
+
+/**
+ * Reads data from input until the end of the stream is reached, encoding
+ * it a chunk at a time and writing the results to output.  Both streams
+ * must already be open.<br />
+ * Return YES on success, NO if there is a stream error.
+ */
+- (BOOL) encodeStream: (NSInputStream*)input
+	     toStream: (NSOutputStream*)output
+{
+  return codeStream(self, @selector(encodeData:length:intoData:),
+    input, output);
+}
+@end
+
 @interface	GSMimeQuotedDecoderContext : GSMimeCodingContext
 {
 @public
@@ -5052,8 +5249,23 @@ appendString(NSMutableData *m, NSUInteger offset, NSUInteger fold,
 
   while ((src != end) && *src != '\0')
     {
-      int	c = *src++;
+      int	c;
 
+      if (0 == pos)
+	{
+	  NSUInteger	used;
+
+	  /* Decode a run of complete groups in one go.
+	   */
+	  used = GSPrivateDecodeBase64Groups(src, end - src, dst);
+	  src += used;
+	  dst += (used / 4) * 3;
+	  if (src == end || *src == '\0')
+	    {
+	      break;
+	    }
+	}
+      c = *src++;
       if (isupper(c))
 	{
 	  c -= 'A';
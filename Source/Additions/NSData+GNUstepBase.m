@@ -25,6 +25,8 @@
 #import "Foundation/NSAutoreleasePool.h"
 #import "Foundation/NSByteOrder.h"
 #import "Foundation/NSException.h"
+#import "Foundation/NSOperation.h"
+#import "Foundation/NSProcessInfo.h"
 #import "GNUstepBase/NSData+GNUstepBase.h"
 #import "GNUstepBase/NSString+GNUstepBase.h"
 
@@ -32,16 +34,99 @@
 
 #if     USE_ZLIB
 #include <zlib.h>
+
+/* Size of the blocks compressed in parallel by -gzipped:threads:
+ */
+#define GZBLOCK (128 * 1024)
+
+/* Operation to deflate one block of data for -gzipped:threads:
+ * The block is primed with the 32KB of data preceding it (so references
+ * back into that data can be used) and all but the last block end with
+ * a sync flush, so that the compressed blocks may simply be joined.
+ */
+@interface GSGzipBlock : NSOperation
+{
+@public
+  const uint8_t *bytes;
+  NSUInteger    length;
+  NSUInteger    dictLength;
+  int           level;
+  BOOL          last;
+  uint8_t       *out;
+  NSUInteger    outLength;
+  uLong         crc;
+  BOOL          failed;
+}
+@end
+
+@implementation GSGzipBlock
+
+- (void) dealloc
+{
+  if (out != 0)
+    {
+      NSZoneFree(NSDefaultMallocZone(), out);
+    }
+  [super dealloc];
+}
+
+- (void) main
+{
+  z_stream      z;
+  uLong         capacity;
+  int           code;
+
+  memset(&z, 0, sizeof(z));
+  crc = crc32(crc32(0L, Z_NULL, 0), bytes, (uInt)length);
+  if (deflateInit2(&z, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+      failed = YES;
+      return;
+    }
+  if (dictLength > 0)
+    {
+      deflateSetDictionary(&z, bytes - dictLength, (uInt)dictLength);
+    }
+  capacity = deflateBound(&z, length) + 64;
+  out = NSZoneMalloc(NSDefaultMallocZone(), capacity);
+  z.next_in = (Bytef*)bytes;
+  z.avail_in = (uInt)length;
+  z.next_out = out;
+  z.avail_out = (uInt)capacity;
+  code = deflate(&z, (YES == last) ? Z_FINISH : Z_SYNC_FLUSH);
+  if (YES == last)
+    {
+      failed = (Z_STREAM_END == code) ? NO : YES;
+    }
+  else
+    {
+      failed = (Z_OK == code && 0 == z.avail_in && z.avail_out > 0) ? NO : YES;
+    }
+  outLength = capacity - z.avail_out;
+  deflateEnd(&z);
+}
+@end
 #endif
 
 #if	defined(_WIN32)
 #include <wincrypt.h>
 #else
 #include <fcntl.h>
+#if	defined(__has_include)
+#if	__has_include(<sys/random.h>)
+#include <sys/random.h>
+#define	HAVE_GETRANDOM_FUNC	1
+#endif
+#endif
 #endif
 
+#import "GSPThread.h"
+
+/* Fill buf with len bytes of entropy from the operating system.
+ * This is only used to seed the generator below, so it need not be fast.
+ */
 static int
-randombytes(uint8_t *buf, unsigned len)
+systemrandom(uint8_t *buf, unsigned len)
 {
 #if	defined(_WIN32)
 
@@ -63,22 +148,278 @@ randombytes(uint8_t *buf, unsigned len)
 
 #else
 
-  int		devUrandom;
-  ssize_t	bytesRead;
+  while (len > 0)
+    {
+      ssize_t	bytesRead = -1;
+
+#if	defined(HAVE_GETRANDOM_FUNC)
+      bytesRead = getrandom(buf, len, 0);
+      if (bytesRead < 0 && EINTR == errno)
+	{
+	  continue;
+	}
+#endif
+      if (bytesRead < 0)
+	{
+	  int	devUrandom;
 
-  devUrandom = open("/dev/urandom", O_RDONLY);
-  if (devUrandom == -1)
+	  devUrandom = open("/dev/urandom", O_RDONLY);
+	  if (devUrandom == -1)
+	    {
+	      return -1;
+	    }
+	  bytesRead = read(devUrandom, buf, len);
+	  close(devUrandom);
+	  if (bytesRead <= 0)
+	    {
+	      return -1;
+	    }
+	}
+      buf += bytesRead;
+      len -= (unsigned)bytesRead;
+    }
+
+#endif
+  return 0;
+}
+
+/* Random bytes are produced by a ChaCha20 keystream generator held per
+ * thread, so that most requests are served from a buffer without any
+ * system call or lock.  Each refill of the buffer rekeys the generator
+ * from its own output (so earlier output cannot be recovered from the
+ * state) and the generator is reseeded from the system every RNG_RESEED
+ * bytes and in the child after a fork().
+ */
+#define	RNG_KEY		32
+#define	RNG_BLOCKS	16
+#define	RNG_BUFSIZE	(RNG_BLOCKS * 64)
+#define	RNG_RESEED	(1024 * 1024)
+
+typedef struct {
+  uint32_t	input[16];
+  uint8_t	buf[RNG_BUFSIZE];
+  unsigned	avail;
+  unsigned	generation;
+  NSUInteger	sinceSeed;
+} GSRandomState;
+
+static gs_thread_key_t	rngKey;
+static BOOL		rngKeyReady = NO;
+static unsigned		rngGeneration = 1;
+
+#define	ROTL32(v, n)	(((v) << (n)) | ((v) >> (32 - (n))))
+#define	QROUND(a, b, c, d) \
+  a += b; d ^= a; d = ROTL32(d, 16); \
+  c += d; b ^= c; b = ROTL32(b, 12); \
+  a += b; d ^= a; d = ROTL32(d, 8); \
+  c += d; b ^= c; b = ROTL32(b, 7);
+
+static void
+chachaBlock(uint32_t *input, uint8_t *out)
+{
+  uint32_t	x[16];
+  int		i;
+
+  memcpy(x, input, sizeof(x));
+  for (i = 0; i < 10; i++)
     {
-      return -1;
+      QROUND(x[0], x[4], x[8], x[12])
+      QROUND(x[1], x[5], x[9], x[13])
+      QROUND(x[2], x[6], x[10], x[14])
+      QROUND(x[3], x[7], x[11], x[15])
+      QROUND(x[0], x[5], x[10], x[15])
+      QROUND(x[1], x[6], x[11], x[12])
+      QROUND(x[2], x[7], x[8], x[13])
+      QROUND(x[3], x[4], x[9], x[14])
+    }
+  for (i = 0; i < 16; i++)
+    {
+      uint32_t	v = x[i] + input[i];
+
+      out[4*i] = (uint8_t)v;
+      out[4*i+1] = (uint8_t)(v >> 8);
+      out[4*i+2] = (uint8_t)(v >> 16);
+      out[4*i+3] = (uint8_t)(v >> 24);
+    }
+  /* 64 bit block counter in words 12 and 13 */
+  if (0 == ++input[12])
+    {
+      input[13]++;
+    }
+}
+
+/* Set the key (and nonce) of the generator from 40 bytes of seed material
+ * and reset its block counter.
+ */
+static void
+chachaKey(GSRandomState *s, const uint8_t *seed)
+{
+  int	i;
+
+  s->input[0] = 0x61707865;
+  s->input[1] = 0x3320646e;
+  s->input[2] = 0x79622d32;
+  s->input[3] = 0x6b206574;
+  for (i = 0; i < 10; i++)
+    {
+      const uint8_t	*p = seed + 4*i;
+      uint32_t		w = p[0] | (p[1] << 8) | (p[2] << 16)
+	| ((uint32_t)p[3] << 24);
+
+      if (i < 8)
+	{
+	  s->input[4 + i] = w;
+	}
+      else
+	{
+	  s->input[6 + i] = w;	/* nonce in words 14 and 15 */
+	}
+    }
+  s->input[12] = 0;
+  s->input[13] = 0;
+}
+
+static void
+rngRefill(GSRandomState *s)
+{
+  unsigned	i;
+
+  for (i = 0; i < RNG_BLOCKS; i++)
+    {
+      chachaBlock(s->input, s->buf + 64 * i);
     }
-  bytesRead = read(devUrandom, buf, len);
-  close(devUrandom);
-  if (bytesRead != len)
+  /* Rekey from the start of the output, and discard it.
+   */
+  chachaKey(s, s->buf);
+  memset(s->buf, 0, RNG_KEY + 8);
+  s->avail = RNG_BUFSIZE - RNG_KEY - 8;
+}
+
+static int
+rngSeed(GSRandomState *s)
+{
+  uint8_t	seed[RNG_KEY + 8];
+  unsigned	i;
+
+  if (systemrandom(seed, sizeof(seed)) < 0)
     {
       return -1;
     }
+  if (s->generation != 0)
+    {
+      /* Mix the new seed with output of the existing generator, so a
+       * weak reseed cannot make things worse.
+       */
+      for (i = 0; i < sizeof(seed); i++)
+	{
+	  seed[i] ^= s->buf[RNG_BUFSIZE - 1 - i];
+	}
+    }
+  chachaKey(s, seed);
+  memset(seed, 0, sizeof(seed));
+  rngRefill(s);
+  s->generation = __atomic_load_n(&rngGeneration, __ATOMIC_ACQUIRE);
+  s->sinceSeed = 0;
+  return 0;
+}
 
+static void
+rngFree(void *state)
+{
+  memset(state, 0, sizeof(GSRandomState));
+  free(state);
+}
+
+#if	!defined(_WIN32)
+/* After a fork the parent and child would share the generator state and
+ * produce the same bytes, so make each thread in the child reseed.
+ */
+static void
+rngAfterFork(void)
+{
+  __atomic_fetch_add(&rngGeneration, 1, __ATOMIC_RELEASE);
+}
 #endif
+
+static GSRandomState *
+rngState(void)
+{
+  GSRandomState	*s;
+
+  if (NO == __atomic_load_n(&rngKeyReady, __ATOMIC_ACQUIRE))
+    {
+      static gs_mutex_t	rngLock = GS_MUTEX_INIT_STATIC;
+
+      GS_MUTEX_LOCK(rngLock);
+      if (NO == __atomic_load_n(&rngKeyReady, __ATOMIC_RELAXED))
+	{
+	  if (GS_THREAD_KEY_INIT(rngKey, rngFree))
+	    {
+#if	!defined(_WIN32)
+	      pthread_atfork(NULL, NULL, rngAfterFork);
+#endif
+	      __atomic_store_n(&rngKeyReady, YES, __ATOMIC_RELEASE);
+	    }
+	}
+      GS_MUTEX_UNLOCK(rngLock);
+      if (NO == __atomic_load_n(&rngKeyReady, __ATOMIC_ACQUIRE))
+	{
+	  return NULL;
+	}
+    }
+  s = GS_THREAD_KEY_GET(rngKey);
+  if (NULL == s)
+    {
+      s = calloc(1, sizeof(GSRandomState));
+      if (NULL == s)
+	{
+	  return NULL;
+	}
+      if (rngSeed(s) < 0)
+	{
+	  rngFree(s);
+	  return NULL;
+	}
+      GS_THREAD_KEY_SET(rngKey, s);
+    }
+  else if (s->generation != __atomic_load_n(&rngGeneration, __ATOMIC_ACQUIRE)
+    || s->sinceSeed >= RNG_RESEED)
+    {
+      if (rngSeed(s) < 0)
+	{
+	  return NULL;
+	}
+    }
+  return s;
+}
+
+static int
+randombytes(uint8_t *buf, unsigned len)
+{
+  GSRandomState	*s = rngState();
+
+  if (NULL == s)
+    {
+      return systemrandom(buf, len);
+    }
+  s->sinceSeed += len;
+  while (len > 0)
+    {
+      unsigned	n;
+      uint8_t	*p;
+
+      if (0 == s->avail)
+	{
+	  rngRefill(s);
+	}
+      n = (len < s->avail) ? len : s->avail;
+      p = s->buf + RNG_BUFSIZE - s->avail;
+      memcpy(buf, p, n);
+      memset(p, 0, n);		/* Bytes given out are not kept. */
+      s->avail -= n;
+      buf += n;
+      len -= n;
+    }
   return 0;
 }
 
@@ -360,6 +701,86 @@ randombytes(uint8_t *buf, unsigned len)
   return nil;
 }
 
+- (NSData*) gzipped: (int)compressionLevel threads: (NSUInteger)threads
+{
+#if     USE_ZLIB
+  NSUInteger            length = [self length];
+  const uint8_t         *bytes = [self bytes];
+  NSOperationQueue      *q;
+  NSMutableArray        *blocks;
+  NSMutableData         *result;
+  NSUInteger            count;
+  NSUInteger            i;
+  uLong                 crc;
+  uint8_t               buf[10];
+
+  if (0 == threads)
+    {
+      threads = [[NSProcessInfo processInfo] activeProcessorCount];
+    }
+  if (threads < 2 || length <= 2 * GZBLOCK)
+    {
+      return [self gzipped: compressionLevel];
+    }
+  if (compressionLevel < 0 || compressionLevel > 9)
+    {
+      compressionLevel = Z_DEFAULT_COMPRESSION;
+    }
+
+  count = (length + GZBLOCK - 1) / GZBLOCK;
+  blocks = [NSMutableArray arrayWithCapacity: count];
+  q = AUTORELEASE([NSOperationQueue new]);
+  [q setMaxConcurrentOperationCount: threads];
+  for (i = 0; i < count; i++)
+    {
+      GSGzipBlock       *b = AUTORELEASE([GSGzipBlock new]);
+
+      b->bytes = bytes + i * GZBLOCK;
+      b->length = (i == count - 1) ? length - i * GZBLOCK : GZBLOCK;
+      b->dictLength = (i > 0) ? 32768 : 0;
+      b->level = compressionLevel;
+      b->last = (i == count - 1) ? YES : NO;
+      [blocks addObject: b];
+      [q addOperation: b];
+    }
+  [q waitUntilAllOperationsAreFinished];
+
+  /* Assemble the gzip header, the blocks and the trailer (crc and
+   * length, both little-endian).
+   */
+  result = [NSMutableData dataWithCapacity: length / 2];
+  memset(buf, 0, sizeof(buf));
+  buf[0] = 0x1f;
+  buf[1] = 0x8b;
+  buf[2] = Z_DEFLATED;
+  buf[9] = 0xff;        // Unknown OS
+  [result appendBytes: buf length: 10];
+  crc = crc32(0L, Z_NULL, 0);
+  for (i = 0; i < count; i++)
+    {
+      GSGzipBlock       *b = [blocks objectAtIndex: i];
+
+      if (YES == b->failed)
+        {
+          return nil;
+        }
+      [result appendBytes: b->out length: b->outLength];
+      crc = crc32_combine(crc, b->crc, (z_off_t)b->length);
+    }
+  for (i = 0; i < 4; i++)
+    {
+      buf[i] = (uint8_t)(crc >> (8 * i));
+      buf[i + 4] = (uint8_t)((uint32_t)length >> (8 * i));
+    }
+  [result appendBytes: buf length: 8];
+  return result;
+#else
+  [NSException raise: NSGenericException
+              format: @"library was configured without zlib support"];
+  return nil;
+#endif
+}
+
 /**
  * Initialises the receiver with the supplied string data which contains
  * a hexadecimal coding of the bytes.  The parsing of the string is
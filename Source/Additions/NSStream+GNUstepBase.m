@@ -23,9 +23,17 @@
 */
 
 #import "common.h"
+#define	EXPOSE_GSInflateInputStream_IVARS	1
+#define	EXPOSE_GSDeflateOutputStream_IVARS	1
+#import "Foundation/NSError.h"
+#import "Foundation/NSException.h"
 #import "GNUstepBase/NSObject+GNUstepBase.h"
 #import "GNUstepBase/NSStream+GNUstepBase.h"
 
+#if     USE_ZLIB
+#include <zlib.h>
+#endif
+
 /* The remaining code is specific to the Apple Foundation
  */
 #if	!defined(GNUSTEP)
@@ -83,3 +91,620 @@
 @end
 #endif
 
+/* Size of the buffers used between the zlib streams and the streams they
+ * are stacked on.
+ */
+#define	ZBUFSIZE	65536
+
+#if	USE_ZLIB
+static NSError*
+zlibError(z_stream *z, int code)
+{
+  NSString	*desc;
+
+  desc = (z->msg == 0) ? @"zlib error" : [NSString stringWithUTF8String: z->msg];
+  return [NSError errorWithDomain: @"GSZlibErrorDomain"
+			     code: code
+			 userInfo: [NSDictionary dictionaryWithObject: desc
+			   forKey: NSLocalizedDescriptionKey]];
+}
+#endif
+
+@implementation GSInflateInputStream
+
++ (id) inputStreamWithStream: (NSInputStream*)source
+{
+  return AUTORELEASE([[self alloc] initWithStream: source]);
+}
+
+- (void) close
+{
+#if	USE_ZLIB
+  if (_buffer != 0)
+    {
+      inflateEnd((z_stream*)_zstream);
+      NSZoneFree(NSDefaultMallocZone(), _buffer);
+      _buffer = 0;
+    }
+#endif
+  if (_status != NSStreamStatusClosed)
+    {
+      [_source close];
+      _status = NSStreamStatusClosed;
+    }
+}
+
+- (void) dealloc
+{
+  if (_status != NSStreamStatusNotOpen)
+    {
+      [self close];
+    }
+  if ([_source delegate] == self)
+    {
+      [_source setDelegate: nil];
+    }
+  DESTROY(_source);
+  DESTROY(_error);
+  if (_zstream != 0)
+    {
+      NSZoneFree(NSDefaultMallocZone(), _zstream);
+    }
+  [super dealloc];
+}
+
+- (id) delegate
+{
+  return _delegate;
+}
+
+- (BOOL) getBuffer: (uint8_t **)buffer length: (NSUInteger *)len
+{
+  return NO;
+}
+
+- (BOOL) hasBytesAvailable
+{
+#if	USE_ZLIB
+  if (NSStreamStatusOpen == _status || NSStreamStatusReading == _status)
+    {
+      if (((z_stream*)_zstream)->avail_in > 0 || YES == _sourceEnded)
+	{
+	  return YES;
+	}
+      return [_source hasBytesAvailable];
+    }
+#endif
+  return NO;
+}
+
+- (id) init
+{
+  return [self initWithStream: nil windowBits: 15 + 32];
+}
+
+- (id) initWithStream: (NSInputStream*)source
+{
+  return [self initWithStream: source windowBits: 15 + 32];
+}
+
+- (id) initWithStream: (NSInputStream*)source windowBits: (int)windowBits
+{
+#if	USE_ZLIB
+  if (nil == source)
+    {
+      DESTROY(self);
+      [NSException raise: NSInvalidArgumentException
+		  format: @"[GSInflateInputStream-initWithStream:] nil source"];
+    }
+  if ((self = [super init]) != nil)
+    {
+      ASSIGN(_source, source);
+      _windowBits = windowBits;
+      _zstream = NSZoneCalloc(NSDefaultMallocZone(), 1, sizeof(z_stream));
+      _status = NSStreamStatusNotOpen;
+    }
+#else
+  DESTROY(self);
+  [NSException raise: NSGenericException
+	      format: @"library was configured without zlib support"];
+#endif
+  return self;
+}
+
+- (void) open
+{
+#if	USE_ZLIB
+  z_stream	*z = (z_stream*)_zstream;
+  int		code;
+
+  if (_status != NSStreamStatusNotOpen)
+    {
+      return;
+    }
+  code = inflateInit2(z, _windowBits);
+  if (code != Z_OK)
+    {
+      ASSIGN(_error, zlibError(z, code));
+      _status = NSStreamStatusError;
+      return;
+    }
+  _buffer = NSZoneMalloc(NSDefaultMallocZone(), ZBUFSIZE);
+  z->next_in = _buffer;
+  z->avail_in = 0;
+  _status = NSStreamStatusOpen;
+  if ([_source streamStatus] == NSStreamStatusNotOpen)
+    {
+      [_source open];
+    }
+#endif
+}
+
+- (id) propertyForKey: (NSString *)key
+{
+  return [_source propertyForKey: key];
+}
+
+- (NSInteger) read: (uint8_t *)buffer maxLength: (NSUInteger)len
+{
+#if	USE_ZLIB
+  z_stream	*z = (z_stream*)_zstream;
+
+  if (NSStreamStatusAtEnd == _status)
+    {
+      return 0;
+    }
+  if (_status != NSStreamStatusOpen && _status != NSStreamStatusReading)
+    {
+      return -1;
+    }
+  if (len > UINT_MAX)
+    {
+      len = UINT_MAX;
+    }
+  z->next_out = buffer;
+  z->avail_out = (unsigned)len;
+  while (z->avail_out == len)
+    {
+      int	code;
+
+      if (0 == z->avail_in && NO == _sourceEnded)
+	{
+	  NSInteger	n = [_source read: _buffer maxLength: ZBUFSIZE];
+
+	  if (n < 0)
+	    {
+	      ASSIGN(_error, [_source streamError]);
+	      _status = NSStreamStatusError;
+	      return -1;
+	    }
+	  if (0 == n)
+	    {
+	      if ([_source streamStatus] != NSStreamStatusAtEnd
+		&& [_source streamStatus] != NSStreamStatusClosed
+		&& NO == [_source hasBytesAvailable])
+		{
+		  /* A non-blocking source with nothing available yet
+		   * will tell the delegate when there is more.
+		   */
+		  break;
+		}
+	      _sourceEnded = YES;
+	    }
+	  z->next_in = _buffer;
+	  z->avail_in = (unsigned)n;
+	}
+
+      code = inflate(z, Z_NO_FLUSH);
+      if (Z_STREAM_END == code)
+	{
+	  /* Another gzip member may follow the end of this one.
+	   */
+	  if (_windowBits > 15 && (z->avail_in > 0 || NO == _sourceEnded))
+	    {
+	      if (z->avail_in == 0)
+		{
+		  NSInteger	n = [_source read: _buffer maxLength: ZBUFSIZE];
+
+		  if (n > 0)
+		    {
+		      z->next_in = _buffer;
+		      z->avail_in = (unsigned)n;
+		    }
+		  else
+		    {
+		      _sourceEnded = YES;
+		    }
+		}
+	      if (z->avail_in > 0 && 0x1f == *z->next_in)
+		{
+		  inflateReset(z);
+		  continue;
+		}
+	    }
+	  _status = NSStreamStatusAtEnd;
+	  break;
+	}
+      else if (Z_BUF_ERROR == code && z->avail_in == 0)
+	{
+	  if (YES == _sourceEnded)
+	    {
+	      /* The compressed data was truncated.
+	       */
+	      ASSIGN(_error, zlibError(z, code));
+	      _status = NSStreamStatusError;
+	      return -1;
+	    }
+	}
+      else if (code != Z_OK)
+	{
+	  ASSIGN(_error, zlibError(z, code));
+	  _status = NSStreamStatusError;
+	  return -1;
+	}
+    }
+  return len - z->avail_out;
+#else
+  return -1;
+#endif
+}
+
+- (void) removeFromRunLoop: (NSRunLoop *)aRunLoop forMode: (NSString *)mode
+{
+  [_source removeFromRunLoop: aRunLoop forMode: mode];
+}
+
+- (void) scheduleInRunLoop: (NSRunLoop *)aRunLoop forMode: (NSString *)mode
+{
+  [_source scheduleInRunLoop: aRunLoop forMode: mode];
+}
+
+- (void) setDelegate: (id)delegate
+{
+  _delegate = delegate;
+  [_source setDelegate: (nil == delegate) ? nil : self];
+}
+
+- (BOOL) setProperty: (id)property forKey: (NSString *)key
+{
+  return [_source setProperty: property forKey: key];
+}
+
+/* Pass events from the underlying stream on to our delegate.  When the
+ * underlying stream ends there may still be data for us to return, so
+ * the delegate is told there are bytes available before the end.
+ */
+- (void) stream: (NSStream*)aStream handleEvent: (NSStreamEvent)anEvent
+{
+  if (NSStreamEventErrorOccurred == anEvent)
+    {
+      ASSIGN(_error, [aStream streamError]);
+      _status = NSStreamStatusError;
+    }
+  else if (NSStreamEventEndEncountered == anEvent)
+    {
+      if (_status != NSStreamStatusAtEnd && _status != NSStreamStatusError)
+	{
+	  [_delegate stream: self handleEvent: NSStreamEventHasBytesAvailable];
+	}
+      if (_status != NSStreamStatusAtEnd)
+	{
+	  return;	// Not yet read to the end of the inflated data.
+	}
+    }
+  [_delegate stream: self handleEvent: anEvent];
+}
+
+- (NSError *) streamError
+{
+  return _error;
+}
+
+- (NSStreamStatus) streamStatus
+{
+  return _status;
+}
+
+@end
+
+@implementation GSDeflateOutputStream
+
++ (id) outputStreamToStream: (NSOutputStream*)sink
+{
+  return AUTORELEASE([[self alloc] initToStream: sink level: -1]);
+}
+
+/* Write as much pending output as the sink will take.  If block is YES
+ * we keep trying until it is all written or there is an error.
+ * Returns NO on error.
+ */
+- (BOOL) _flush: (BOOL)block
+{
+  while (_pending > 0)
+    {
+      NSInteger	n;
+
+      if (NO == block && NO == [_sink hasSpaceAvailable])
+	{
+	  break;
+	}
+      n = [_sink write: _buffer + _offset maxLength: _pending];
+      if (n < 0 || (0 == n && YES == block
+	&& [_sink streamStatus] != NSStreamStatusOpen
+	&& [_sink streamStatus] != NSStreamStatusWriting))
+	{
+	  ASSIGN(_error, [_sink streamError]);
+	  _status = NSStreamStatusError;
+	  return NO;
+	}
+      if (0 == n && NO == block)
+	{
+	  break;
+	}
+      _offset += n;
+      _pending -= n;
+    }
+  if (0 == _pending)
+    {
+      _offset = 0;
+    }
+  return YES;
+}
+
+#if	USE_ZLIB
+/* Run the compressor with the specified flush mode, writing output to
+ * the sink whenever our buffer fills.
+ */
+- (BOOL) _deflate: (int)flush block: (BOOL)block
+{
+  z_stream	*z = (z_stream*)_zstream;
+
+  for (;;)
+    {
+      int	code;
+
+      if (_pending > 0 && NO == [self _flush: block])
+	{
+	  return NO;
+	}
+      if (_pending > 0)
+	{
+	  return YES;	// Sink is full ... try again later.
+	}
+      z->next_out = _buffer;
+      z->avail_out = ZBUFSIZE;
+      code = deflate(z, flush);
+      _pending = ZBUFSIZE - z->avail_out;
+      if (code != Z_OK && code != Z_STREAM_END && code != Z_BUF_ERROR)
+	{
+	  ASSIGN(_error, zlibError(z, code));
+	  _status = NSStreamStatusError;
+	  return NO;
+	}
+      if (z->avail_out > 0 && (Z_NO_FLUSH == flush ? z->avail_in == 0 : YES))
+	{
+	  /* Output buffer not filled, so deflate has nothing more for us.
+	   */
+	  return [self _flush: block];
+	}
+    }
+}
+#endif
+
+- (void) close
+{
+#if	USE_ZLIB
+  if (_buffer != 0)
+    {
+      if (NSStreamStatusOpen == _status || NSStreamStatusWriting == _status)
+	{
+	  [self _deflate: Z_FINISH block: YES];
+	}
+      deflateEnd((z_stream*)_zstream);
+      NSZoneFree(NSDefaultMallocZone(), _buffer);
+      _buffer = 0;
+    }
+#endif
+  if (_status != NSStreamStatusClosed)
+    {
+      [_sink close];
+      if (_status != NSStreamStatusError)
+	{
+	  _status = NSStreamStatusClosed;
+	}
+    }
+}
+
+- (void) dealloc
+{
+  if (_status != NSStreamStatusNotOpen && _status != NSStreamStatusClosed)
+    {
+      [self close];
+    }
+  if ([_sink delegate] == self)
+    {
+      [_sink setDelegate: nil];
+    }
+  DESTROY(_sink);
+  DESTROY(_error);
+  if (_zstream != 0)
+    {
+      NSZoneFree(NSDefaultMallocZone(), _zstream);
+    }
+  [super dealloc];
+}
+
+- (id) delegate
+{
+  return _delegate;
+}
+
+- (BOOL) hasSpaceAvailable
+{
+  if (NSStreamStatusOpen == _status || NSStreamStatusWriting == _status)
+    {
+      return (0 == _pending) ? YES : [_sink hasSpaceAvailable];
+    }
+  return NO;
+}
+
+- (id) init
+{
+  return [self initToStream: nil level: -1 windowBits: 15 + 16];
+}
+
+- (id) initToStream: (NSOutputStream*)sink level: (int)level
+{
+  return [self initToStream: sink level: level windowBits: 15 + 16];
+}
+
+- (id) initToStream: (NSOutputStream*)sink
+	      level: (int)level
+	 windowBits: (int)windowBits
+{
+#if	USE_ZLIB
+  if (nil == sink)
+    {
+      DESTROY(self);
+      [NSException raise: NSInvalidArgumentException
+		  format: @"[GSDeflateOutputStream-initToStream:] nil sink"];
+    }
+  if ((self = [super init]) != nil)
+    {
+      ASSIGN(_sink, sink);
+      if (level < 0 || level > 9)
+	{
+	  level = Z_DEFAULT_COMPRESSION;
+	}
+      _level = level;
+      _windowBits = windowBits;
+      _zstream = NSZoneCalloc(NSDefaultMallocZone(), 1, sizeof(z_stream));
+      _status = NSStreamStatusNotOpen;
+    }
+#else
+  DESTROY(self);
+  [NSException raise: NSGenericException
+	      format: @"library was configured without zlib support"];
+#endif
+  return self;
+}
+
+- (void) open
+{
+#if	USE_ZLIB
+  z_stream	*z = (z_stream*)_zstream;
+  int		code;
+
+  if (_status != NSStreamStatusNotOpen)
+    {
+      return;
+    }
+  code = deflateInit2(z, _level, Z_DEFLATED, _windowBits, 8,
+    Z_DEFAULT_STRATEGY);
+  if (code != Z_OK)
+    {
+      ASSIGN(_error, zlibError(z, code));
+      _status = NSStreamStatusError;
+      return;
+    }
+  _buffer = NSZoneMalloc(NSDefaultMallocZone(), ZBUFSIZE);
+  _status = NSStreamStatusOpen;
+  if ([_sink streamStatus] == NSStreamStatusNotOpen)
+    {
+      [_sink open];
+    }
+#endif
+}
+
+- (id) propertyForKey: (NSString *)key
+{
+  return [_sink propertyForKey: key];
+}
+
+- (void) removeFromRunLoop: (NSRunLoop *)aRunLoop forMode: (NSString *)mode
+{
+  [_sink removeFromRunLoop: aRunLoop forMode: mode];
+}
+
+- (void) scheduleInRunLoop: (NSRunLoop *)aRunLoop forMode: (NSString *)mode
+{
+  [_sink scheduleInRunLoop: aRunLoop forMode: mode];
+}
+
+- (void) setDelegate: (id)delegate
+{
+  _delegate = delegate;
+  [_sink setDelegate: (nil == delegate) ? nil : self];
+}
+
+- (BOOL) setProperty: (id)property forKey: (NSString *)key
+{
+  return [_sink setProperty: property forKey: key];
+}
+
+/* Pass events from the underlying stream on to our delegate, first
+ * writing out any compressed data waiting for space in the sink.
+ */
+- (void) stream: (NSStream*)aStream handleEvent: (NSStreamEvent)anEvent
+{
+  if (NSStreamEventHasSpaceAvailable == anEvent)
+    {
+      if (NO == [self _flush: NO] || _pending > 0)
+	{
+	  return;
+	}
+    }
+  else if (NSStreamEventErrorOccurred == anEvent)
+    {
+      ASSIGN(_error, [aStream streamError]);
+      _status = NSStreamStatusError;
+    }
+  [_delegate stream: self handleEvent: anEvent];
+}
+
+- (NSError *) streamError
+{
+  return _error;
+}
+
+- (NSStreamStatus) streamStatus
+{
+  return _status;
+}
+
+- (NSInteger) write: (const uint8_t *)buffer maxLength: (NSUInteger)len
+{
+#if	USE_ZLIB
+  z_stream	*z = (z_stream*)_zstream;
+  BOOL		block;
+
+  if (_status != NSStreamStatusOpen && _status != NSStreamStatusWriting)
+    {
+      return -1;
+    }
+  if (len > UINT_MAX)
+    {
+      len = UINT_MAX;
+    }
+  /* Only wait for the sink if nobody is going to tell us it has space.
+   */
+  block = (nil == _delegate) ? YES : NO;
+  if (_pending > 0 && (NO == [self _flush: block] || _pending > 0))
+    {
+      return (NSStreamStatusError == _status) ? -1 : 0;
+    }
+  z->next_in = (Bytef*)buffer;
+  z->avail_in = (unsigned)len;
+  if (NO == [self _deflate: Z_NO_FLUSH block: block])
+    {
+      return -1;
+    }
+  len -= z->avail_in;
+  z->avail_in = 0;
+  return len;
+#else
+  return -1;
+#endif
+}
+
+@end
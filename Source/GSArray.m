@@ -49,6 +49,13 @@ static SEL	eqSel;
 static SEL	oaiSel;
 
 static Class	GSArrayClass;
+static IMP	arrayDealloc;	// -[GSArray dealloc]
+
+/* A copy of a mutable array with more than this many objects shares its
+ * buffer (see -[GSMutableArray copyWithZone:]).  Smaller arrays are
+ * copied into an inline array, which is about as cheap.
+ */
+#define	SHARE_MIN	8
 
 /* Normally for immutable arrays we can use an array class where the buffer
  * memory is allocated as part of the instance in a single allocation rather
@@ -475,6 +482,7 @@ static int (*lsanCheck)(void) = __lsan_do_recoverable_leak_check;
     {
       [self setVersion: 1];
       GSObjCAddClassBehavior(self, [GSArray class]);
+      arrayDealloc = [GSArray instanceMethodForSelector: @selector(dealloc)];
     }
 }
 
@@ -486,6 +494,10 @@ static int (*lsanCheck)(void) = __lsan_do_recoverable_leak_check;
       [NSException raise: NSInvalidArgumentException
 		  format: @"Tried to add nil to array"];
     }
+  if (nil != _shared)
+    {
+      [self _unshare];
+    }
   if (_count >= _capacity)
     {
       id	*ptr;
@@ -513,6 +525,39 @@ static int (*lsanCheck)(void) = __lsan_do_recoverable_leak_check;
 {
   NSArray       *copy;
 
+  copy = __atomic_load_n(&_shared, __ATOMIC_ACQUIRE);
+  if (nil != copy)
+    {
+      return RETAIN(copy);	// Unchanged since the last copy.
+    }
+  if (_count > SHARE_MIN)
+    {
+      GSArray	*a;
+      GSArray	*expected = nil;
+
+      /* The copy takes over our buffer, and we keep using it until the
+       * next change (see -_unshare), so a copy costs O(1) and repeated
+       * copies of an unchanged array are the same object.  The copy is
+       * made in our zone because it will free the buffer.
+       * Copying is a read-only operation which may happen in several
+       * threads at once, so only one copy may take the buffer.  If
+       * another thread got there first we discard ours and use its copy.
+       */
+      a = (GSArray*)NSAllocateObject(GSArrayClass, 0, [self zone]);
+      a->_contents_array = _contents_array;
+      a->_count = _count;
+      RETAIN(a);
+      if (NO == __atomic_compare_exchange_n(&_shared, &expected, a, NO,
+	__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+	{
+	  a->_contents_array = 0;
+	  a->_count = 0;
+	  RELEASE(a);
+	  RELEASE(a);
+	  return RETAIN(expected);
+	}
+      return a;
+    }
 #if     GNUSTEP_WITH_ASAN         
   copy = (GSArray*)NSAllocateObject(GSArrayClass, 0, zone);
 #else
@@ -528,10 +573,25 @@ else
   return [copy initWithObjects: _contents_array count: _count];
 }
 
+- (void) dealloc
+{
+  if (nil != _shared)
+    {
+      _contents_array = 0;	// Belongs to the immutable copy.
+      _count = 0;
+      DESTROY(_shared);
+    }
+  (*arrayDealloc)(self, _cmd);
+}
+
 - (void) exchangeObjectAtIndex: (NSUInteger)i1
              withObjectAtIndex: (NSUInteger)i2
 {
   _version++;
+  if (nil != _shared)
+    {
+      [self _unshare];
+    }
   if (i1 >= _count)
     {
       [self _raiseRangeExceptionWithIndex: i1 from: _cmd];
@@ -641,6 +701,10 @@ else
     {
       [self _raiseRangeExceptionWithIndex: index from: _cmd];
     }
+  if (nil != _shared)
+    {
+      [self _unshare];
+    }
   if (_count == _capacity)
     {
       id	*ptr;
@@ -671,12 +735,20 @@ else
 
 - (BOOL) makeImmutable
 {
+  if (nil != _shared)
+    {
+      [self _unshare];
+    }
   GSClassSwizzle(self, [GSArray class]);
   return YES;
 }
 
 - (id) makeImmutableCopyOnFail: (BOOL)force
 {
+  if (nil != _shared)
+    {
+      [self _unshare];
+    }
   GSClassSwizzle(self, [GSArray class]);
   return self;
 }
@@ -691,6 +763,24 @@ else
       Class    last = Nil;
 
       _version++;
+      if (nil != _shared)
+	{
+	  id	*ptr;
+
+	  /* Nothing to keep, so just leave the buffer with the copy.
+	   */
+	  ptr = NSZoneMalloc([self zone], _capacity * sizeof(id));
+	  if (ptr == 0)
+	    {
+	      [NSException raise: NSMallocException
+			  format: @"Unable to copy array"];
+	    }
+	  _contents_array = ptr;
+	  _count = 0;
+	  DESTROY(_shared);
+	  _version++;
+	  return;
+	}
       _count = 0;
       while (pos-- > 0)
         {
@@ -719,6 +809,10 @@ else
     {
       return;
     }
+  if (nil != _shared)
+    {
+      [self _unshare];
+    }
   _count--;
   RELEASE(_contents_array[_count]);
   _contents_array[_count] = 0;
@@ -746,14 +840,20 @@ else
 	{
 	  if ((*imp)(anObject, eqSel, _contents_array[index]) == YES)
 	    {
-	      NSUInteger	pos = index;
-	      id	        obj = _contents_array[index];
+	      NSUInteger	pos;
+	      id	        obj;
 
 	      if (retained == NO)
 		{
 		  RETAIN(anObject);
 		  retained = YES;
 		}
+	      if (nil != _shared)
+		{
+		  [self _unshare];
+		}
+	      pos = index;
+	      obj = _contents_array[index];
 
 	      while (++pos < _count)
 		{
@@ -781,6 +881,10 @@ else
     {
       [self _raiseRangeExceptionWithIndex: index from: _cmd];
     }
+  if (nil != _shared)
+    {
+      [self _unshare];
+    }
   obj = _contents_array[index];
   _count--;
   while (index < _count)
@@ -811,6 +915,11 @@ else
 	  id		obj = _contents_array[index];
 	  NSUInteger	pos = index;
 
+	  if (nil != _shared)
+	    {
+	      [self _unshare];
+	    }
+
 	  while (++pos < _count)
 	    {
 	      _contents_array[pos-1] = _contents_array[pos];
@@ -836,6 +945,10 @@ else
       Class    last = Nil;
 
       _version++;
+      if (nil != _shared)
+	{
+	  [self _unshare];
+	}
       index = aRange.location;
 
       /* Release all the objects we are removing.
@@ -901,6 +1014,10 @@ else
 	userInfo: info];
       [exception raise];
     }
+  if (nil != _shared)
+    {
+      [self _unshare];
+    }
   /*
    *	Swap objects in order so that there is always a valid object in the
    *	array in case a retain or release causes an exception.
@@ -918,6 +1035,10 @@ else
   _version++;
   if ((1 < _count) && (NULL != compare))
     {
+      if (nil != _shared)
+	{
+	  [self _unshare];
+	}
       GSSortUnstable(_contents_array, NSMakeRange(0,_count), (id)compare,
         GSComparisonTypeFunction, context);
     }
@@ -930,6 +1051,10 @@ else
   _version++;
   if ((1 < _count) && (NULL != comparator))
     {
+      if (nil != _shared)
+	{
+	  [self _unshare];
+	}
       if (options & NSSortStable)
         {
           if (options & NSSortConcurrent)
@@ -960,6 +1085,30 @@ else
   _version++;
 }
 
+- (void) _unshare
+{
+  if (nil != _shared)
+    {
+      id		*ptr;
+      NSUInteger	i;
+
+      /* Leave the buffer with the immutable copy and make our own.
+       */
+      ptr = NSZoneMalloc([self zone], _capacity * sizeof(id));
+      if (ptr == 0)
+	{
+	  [NSException raise: NSMallocException
+		      format: @"Unable to copy array"];
+	}
+      for (i = 0; i < _count; i++)
+	{
+	  ptr[i] = RETAIN(_contents_array[i]);
+	}
+      _contents_array = ptr;
+      DESTROY(_shared);
+    }
+}
+
 - (NSEnumerator*) objectEnumerator
 {
   GSArrayEnumerator	*enumerator;
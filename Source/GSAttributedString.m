@@ -50,18 +50,19 @@
 #import "Foundation/NSRange.h"
 #import "Foundation/NSArray.h"
 #import "Foundation/NSInvocation.h"
-#import "Foundation/NSLock.h"
 #import "Foundation/NSProxy.h"
 #import "Foundation/NSThread.h"
 #import "Foundation/NSNotification.h"
+#import "GSPThread.h"
 
 #define		SANITY_CHECKS	0
 
+struct GSAttrRun;
 
 @interface GSAttributedString : NSAttributedString
 {
   NSString		*_textChars;
-  NSMutableArray	*_infoArray;
+  struct GSAttrRun	*_runs;
 }
 
 - (id) initWithString: (NSString*)aString
@@ -75,7 +76,7 @@
 @interface GSMutableAttributedString : NSMutableAttributedString
 {
   NSMutableString	*_textChars;
-  NSMutableArray	*_infoArray;
+  struct GSAttrRun	*_runs;
   NSString		*_textProxy;
 }
 
@@ -91,55 +92,90 @@
 
 @end
 
-
 
-static BOOL     adding;
 
-/* When caching attributes we make a shallow copy of the dictionary cached,
- * so that it is immutable and safe to cache.
- * However, we have a potential problem if the objects within the attributes
- * dictionary are themselves mutable, and something mutates them while they
- * are in the cache.  In this case we could items added while different and
- * then mutated to have the same contents, so we would not know which of
- * the equal dictionaries to remove.
- * The solution is to require dictionaries to be identical for removal.
+@class  GSCachedDictionary;
+@interface GSCachedDictionary : NSDictionary    // Help the compiler
+@end
+@protocol       GSCachedDictionary
+- (NSUInteger) _cacheHash;
+- (void) _setCacheHash: (NSUInteger)h;
+- (void) _uncache;
+@end
+
+static Class	cachedClass = 0;
+
+/* The hash of a dictionary in the cache is computed from its contents when
+ * it is added and then stored with it, so that it stays the same (and the
+ * dictionary stays in the same place) if the objects within it mutate.
+ * The -hash of NSDictionary is just its count, which would put most
+ * attributes in the same shard and bucket.
  */
-static inline BOOL
-cacheEqual(id A, id B)
+static NSUInteger
+attrHash(NSDictionary *d)
 {
-  if (YES == adding)
-    return [A isEqualToDictionary: B];
-  else
-    return A == B;
+  NSUInteger	h;
+
+  if (object_getClass(d) == cachedClass)
+    {
+      return [(id<GSCachedDictionary>)d _cacheHash];
+    }
+  h = [d count];
+  GS_FOR_IN(id, key, d)
+    h += [key hash] ^ ([[d objectForKey: key] hash] * 31);
+  GS_END_FOR(d)
+  return h;
 }
 
+static BOOL	cacheEqual(void *m, id A, id B);
+
 #define	GSI_MAP_RETAIN_KEY(M, X)	
 #define	GSI_MAP_RELEASE_KEY(M, X)	
 #define	GSI_MAP_RETAIN_VAL(M, X)	
 #define	GSI_MAP_RELEASE_VAL(M, X)	
-#define	GSI_MAP_EQUAL(M, X,Y)	cacheEqual((X).obj, (Y).obj)
+#define	GSI_MAP_HASH(M, X)	attrHash((X).obj)
+#define	GSI_MAP_EQUAL(M, X,Y)	cacheEqual((M), (X).obj, (Y).obj)
 #define GSI_MAP_KTYPES	GSUNION_OBJ
 #define GSI_MAP_VTYPES	GSUNION_NSINT
 #define	GSI_MAP_NOCLEAN	1
 
 #include "GNUstepBase/GSIMap.h"
 
-static NSLock		*attrLock = nil;
-static GSIMapTable_t	attrMap;
-static SEL		lockSel;
-static SEL		unlockSel;
-static IMP		lockImp;
-static IMP		unlockImp;
+/* The cache of attribute dictionaries is divided into shards, each with
+ * its own lock, and a dictionary is found in the shard chosen by a hash of
+ * its contents.  Threads building or editing different attributed strings
+ * then rarely contend for the same lock.
+ */
+#define	ATTR_SHARDS	16
+
+typedef struct {
+  GSIMapTable_t	map;		// Must be first (see cacheEqual())
+  BOOL		adding;
+  gs_mutex_t	lock;
+} GSAttrShard;
 
-#define	ALOCK()	if (attrLock != nil) (*lockImp)(attrLock, lockSel)
-#define	AUNLOCK() if (attrLock != nil) (*unlockImp)(attrLock, unlockSel)
+static GSAttrShard	attrShards[ATTR_SHARDS];
 
-@class  GSCachedDictionary;
-@interface GSCachedDictionary : NSDictionary    // Help the compiler
-@end
-@protocol       GSCachedDictionary
-- (void) _uncache;
-@end
+#define	ATTR_SHARD(H)	(&attrShards[((H) ^ ((H) >> 7)) % ATTR_SHARDS])
+
+/* When caching attributes we make a shallow copy of the dictionary cached,
+ * so that it is immutable and safe to cache.
+ * However, we have a potential problem if the objects within the attributes
+ * dictionary are themselves mutable, and something mutates them while they
+ * are in the cache.  In this case we could items added while different and
+ * then mutated to have the same contents, so we would not know which of
+ * the equal dictionaries to remove.
+ * The solution is to require dictionaries to be identical for removal.
+ * The map passed in is the first field of the shard holding the flag.
+ */
+static BOOL
+cacheEqual(void *m, id A, id B)
+{
+  if (YES == ((GSAttrShard*)m)->adding)
+    return [A isEqualToDictionary: B];
+  else
+    return A == B;
+}
 
 /* Add a dictionary to the cache - if it was not already there, return
  * the copy added to the cache, if it was, count it and return retained
@@ -150,11 +186,13 @@ cacheAttributes(NSDictionary *attrs)
 {
   if (nil != attrs)
     {
+      NSUInteger	h = attrHash(attrs);
+      GSAttrShard	*shard = ATTR_SHARD(h);
       GSIMapNode	node;
 
-      ALOCK();
-      adding = YES;
-      node = GSIMapNodeForKey(&attrMap, (GSIMapKey)((id)attrs));
+      GS_MUTEX_LOCK(shard->lock);
+      shard->adding = YES;
+      node = GSIMapNodeForKey(&shard->map, (GSIMapKey)((id)attrs));
       if (node == 0)
         {
           /* Shallow copy of dictionary, without copying objects ....
@@ -162,7 +200,8 @@ cacheAttributes(NSDictionary *attrs)
            */
           attrs = [(NSDictionary*)[GSCachedDictionary alloc]
             initWithDictionary: attrs copyItems: NO];
-          GSIMapAddPair(&attrMap,
+          [(id<GSCachedDictionary>)attrs _setCacheHash: h];
+          GSIMapAddPair(&shard->map,
             (GSIMapKey)((id)attrs), (GSIMapVal)(NSUInteger)1);
         }
       else
@@ -170,8 +209,30 @@ cacheAttributes(NSDictionary *attrs)
           node->value.nsu++;
           attrs = node->key.obj;
         }
-      AUNLOCK();
+      GS_MUTEX_UNLOCK(shard->lock);
+    }
+  return attrs;
+}
+
+/* Count another use of a dictionary which is already in the cache.
+ */
+static NSDictionary*
+reCacheAttributes(NSDictionary *attrs)
+{
+  GSAttrShard	*shard;
+  GSIMapNode	node;
+
+  if (nil == attrs)
+    {
+      return nil;
     }
+  shard = ATTR_SHARD(attrHash(attrs));
+  GS_MUTEX_LOCK(shard->lock);
+  shard->adding = NO;
+  node = GSIMapNodeForKey(&shard->map, (GSIMapKey)((id)attrs));
+  NSCAssert(node != 0, NSInternalInconsistencyException);
+  node->value.nsu++;
+  GS_MUTEX_UNLOCK(shard->lock);
   return attrs;
 }
 
@@ -183,29 +244,30 @@ unCacheAttributes(NSDictionary *attrs)
 {
   if (nil != attrs)
     {
+      GSAttrShard	*shard = ATTR_SHARD(attrHash(attrs));
       GSIMapBucket  bucket;
       id<GSCachedDictionary> removed = nil;
 
-      ALOCK();
-      adding = NO;
-      bucket = GSIMapBucketForKey(&attrMap, (GSIMapKey)((id)attrs));
+      GS_MUTEX_LOCK(shard->lock);
+      shard->adding = NO;
+      bucket = GSIMapBucketForKey(&shard->map, (GSIMapKey)((id)attrs));
       if (bucket != 0)
         {
           GSIMapNode     node;
 
-          node = GSIMapNodeForKeyInBucket(&attrMap,
+          node = GSIMapNodeForKeyInBucket(&shard->map,
             bucket, (GSIMapKey)((id)attrs));
           if (node != 0)
             {
               if (--node->value.nsu == 0)
                 {
                   removed = node->key.obj;
-                  GSIMapRemoveNodeFromMap(&attrMap, bucket, node);
-                  GSIMapFreeNode(&attrMap, node);
+                  GSIMapRemoveNodeFromMap(&shard->map, bucket, node);
+                  GSIMapFreeNode(&shard->map, node);
                 }
             }
         }
-      AUNLOCK();
+      GS_MUTEX_UNLOCK(shard->lock);
       if (nil != removed)
         {
           [removed _uncache];
@@ -213,186 +275,322 @@ unCacheAttributes(NSDictionary *attrs)
     }
 }
 
-
 
-@interface	GSAttrInfo : NSObject
-{
-@public
-  unsigned	loc;
-  NSDictionary	*attrs;
-}
 
-+ (GSAttrInfo*) newWithZone: (NSZone*)z value: (NSDictionary*)a at: (unsigned)l;
-
-@end
+/* Attribute runs are held in a treap (a binary tree balanced by heap
+ * priorities) ordered by position in the string.  Each node is a run of
+ * characters with the same attributes and records the total length of the
+ * runs in its subtree, so finding the run at an index, and splitting or
+ * joining the runs at a position, take O(log n) time for n runs where the
+ * array formerly used needed O(n) to shift runs and update the locations
+ * of all the runs after an edit.
+ * Adjacent runs always have different attributes, and no run is empty
+ * except the single run of an empty string.
+ */
+typedef struct GSAttrRun {
+  struct GSAttrRun	*left;
+  struct GSAttrRun	*right;
+  NSUInteger		len;	// Characters in this run
+  NSUInteger		sum;	// Characters in this subtree
+  NSDictionary		*attrs;	// Cached attributes of this run
+} GSAttrRun;
 
-@implementation	GSAttrInfo
+#define	RUNSUM(R)	((R) == 0 ? 0 : (R)->sum)
 
-+ (void) initialize
+static inline void
+runUpdate(GSAttrRun *r)
 {
-  if (nil == attrLock)
-    {
-      attrLock = [NSLock new];
-      lockSel = @selector(lock);
-      unlockSel = @selector(unlock);
-      lockImp = [attrLock methodForSelector: lockSel];
-      unlockImp = [attrLock methodForSelector: unlockSel];
-      GSIMapInitWithZoneAndCapacity(&attrMap, NSDefaultMallocZone(), 32);
-    }
+  r->sum = r->len + RUNSUM(r->left) + RUNSUM(r->right);
 }
 
-/*
- * Called to record attributes at a particular location - the given attributes
- * dictionary must have been produced by 'cacheAttributes()' so that it is
- * already copied/retained and this method doesn't need to do it.
+/* The heap priority of a run is a hash of its address, which serves as
+ * well as a random number for balancing and needs no storage.
  */
-+ (GSAttrInfo*) newWithZone: (NSZone*)z value: (NSDictionary*)a at: (unsigned)l;
+static inline uintptr_t
+runPriority(GSAttrRun *r)
 {
-  GSAttrInfo	*info = (GSAttrInfo*)NSAllocateObject(self, 0, z);
+  uint64_t	h = (uint64_t)(uintptr_t)r;
 
-  info->loc = l;
-  info->attrs = cacheAttributes(a);
-  return info;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return (uintptr_t)h;
 }
 
-- (void) dealloc
+/* Makes a run using an attributes dictionary already cached by the caller.
+ */
+static GSAttrRun *
+runNew(NSZone *z, NSUInteger len, NSDictionary *attrs)
 {
-  [self finalize];
-  [super dealloc];
+  GSAttrRun	*r = NSZoneMalloc(z, sizeof(GSAttrRun));
+
+  r->left = r->right = 0;
+  r->len = r->sum = len;
+  r->attrs = attrs;
+  return r;
 }
 
-- (NSString*) description
+static void
+runFree(NSZone *z, GSAttrRun *r)
 {
-  return [NSString stringWithFormat: @"Attributes at %u are - %@",
-    loc, attrs];
+  while (r != 0)
+    {
+      GSAttrRun	*next = r->right;
+
+      runFree(z, r->left);
+      unCacheAttributes(r->attrs);
+      NSZoneFree(z, r);
+      r = next;
+    }
 }
 
-- (void) encodeWithCoder: (NSCoder*)aCoder
+/* Joins two trees, where all the runs in a come before those in b.
+ */
+static GSAttrRun *
+runMerge(GSAttrRun *a, GSAttrRun *b)
 {
-  [aCoder encodeValueOfObjCType: @encode(unsigned) at: &loc];
-  [aCoder encodeValueOfObjCType: @encode(id) at: &attrs];
+  if (a == 0)
+    {
+      return b;
+    }
+  if (b == 0)
+    {
+      return a;
+    }
+  if (runPriority(a) > runPriority(b))
+    {
+      a->right = runMerge(a->right, b);
+      runUpdate(a);
+      return a;
+    }
+  b->left = runMerge(a, b->left);
+  runUpdate(b);
+  return b;
 }
 
-- (void) finalize
+/* Splits a tree into the runs before the character position pos and those
+ * from it onwards.  A run which spans the position is shortened to end at
+ * it, and *n is set to a new run for the remainder (or to 0 if there is no
+ * such run), to be put at the start of the second tree by the caller since
+ * its priority may place it above any of the runs visited here.
+ */
+static void
+runDivide(NSZone *z, GSAttrRun *t, NSUInteger pos,
+  GSAttrRun **l, GSAttrRun **r, GSAttrRun **n)
 {
-  unCacheAttributes(attrs);
-  attrs = nil;
+  NSUInteger	ls;
+
+  if (t == 0)
+    {
+      *l = *r = 0;
+      return;
+    }
+  ls = RUNSUM(t->left);
+  if (pos <= ls)
+    {
+      runDivide(z, t->left, pos, l, &t->left, n);
+      runUpdate(t);
+      *r = t;
+    }
+  else if (pos >= ls + t->len)
+    {
+      runDivide(z, t->right, pos - ls - t->len, &t->right, r, n);
+      runUpdate(t);
+      *l = t;
+    }
+  else
+    {
+      NSUInteger	offset = pos - ls;
+
+      *n = runNew(z, t->len - offset, reCacheAttributes(t->attrs));
+      *r = t->right;
+      t->len = offset;
+      t->right = 0;
+      runUpdate(t);
+      *l = t;
+    }
 }
 
-- (id) initWithCoder: (NSCoder*)aCoder
+/* Splits a tree into the runs before the character position pos and those
+ * from it onwards, dividing any run which spans the position in two.
+ */
+static void
+runSplit(NSZone *z, GSAttrRun *t, NSUInteger pos,
+  GSAttrRun **l, GSAttrRun **r)
 {
-  NSDictionary  *a;
+  GSAttrRun	*n = 0;
 
-  [aCoder decodeValueOfObjCType: @encode(unsigned) at: &loc];
-  a = [aCoder decodeObject];
-  attrs = cacheAttributes(a);
-  return self;
+  runDivide(z, t, pos, l, r, &n);
+  if (n != 0)
+    {
+      *r = runMerge(n, *r);
+    }
 }
 
-- (id) replacementObjectForPortCoder: (NSPortCoder*)aCoder
+/* Returns the run containing the character at index (which must be less
+ * than the length of the tree), setting *loc to the start of the run.
+ */
+static GSAttrRun *
+runFind(GSAttrRun *t, NSUInteger index, NSUInteger *loc)
 {
-  return self;
+  NSUInteger	start = 0;
+
+  while (t != 0)
+    {
+      NSUInteger	ls = RUNSUM(t->left);
+
+      if (index < ls)
+	{
+	  t = t->left;
+	}
+      else if (index < ls + t->len)
+	{
+	  *loc = start + ls;
+	  break;
+	}
+      else
+	{
+	  start += ls + t->len;
+	  index -= ls + t->len;
+	  t = t->right;
+	}
+    }
+  return t;
 }
 
-@end
+static GSAttrRun *
+runFirst(GSAttrRun *t)
+{
+  while (t->left != 0)
+    {
+      t = t->left;
+    }
+  return t;
+}
 
-
+static GSAttrRun *
+runLast(GSAttrRun *t)
+{
+  while (t->right != 0)
+    {
+      t = t->right;
+    }
+  return t;
+}
 
-@implementation GSAttributedString
+/* Lengthens the last run of a tree by delta characters.
+ */
+static void
+runGrowLast(GSAttrRun *t, NSUInteger delta)
+{
+  while (t != 0)
+    {
+      t->sum += delta;
+      if (t->right == 0)
+	{
+	  t->len += delta;
+	}
+      t = t->right;
+    }
+}
 
-static	GSAttrInfo	*blank;
+/* Removes the first run from a tree, returning the tree and setting *first
+ * to the removed run.
+ */
+static GSAttrRun *
+runRemoveFirst(GSAttrRun *t, GSAttrRun **first)
+{
+  if (t->left == 0)
+    {
+      GSAttrRun	*r = t->right;
 
-static Class	infCls = 0;
+      t->right = 0;
+      runUpdate(t);
+      *first = t;
+      return r;
+    }
+  t->left = runRemoveFirst(t->left, first);
+  runUpdate(t);
+  return t;
+}
 
-static SEL	infSel;
-static SEL	addSel;
-static SEL	cntSel;
-static SEL	insSel;
-static SEL	oatSel;
-static SEL	remSel;
+/* Joins two trees like runMerge(), but combines the last run of a with the
+ * first run of b if their attributes are the same.
+ */
+static GSAttrRun *
+runJoin(NSZone *z, GSAttrRun *a, GSAttrRun *b)
+{
+  if (a != 0 && b != 0 && runLast(a)->attrs == runFirst(b)->attrs)
+    {
+      GSAttrRun	*first;
 
-static IMP	infImp;
-static void	(*addImp)(NSMutableArray*,SEL,id);
-static unsigned (*cntImp)(NSArray*,SEL);
-static void	(*insImp)(NSMutableArray*,SEL,id,unsigned);
-static IMP	oatImp;
-static void	(*remImp)(NSMutableArray*,SEL,unsigned);
+      b = runRemoveFirst(b, &first);
+      runGrowLast(a, first->len);
+      runFree(z, first);
+    }
+  return runMerge(a, b);
+}
 
-#define	NEWINFO(Z,O,L)	((*infImp)(infCls, infSel, (Z), (O), (L)))
-#define	ADDOBJECT(O)	((*addImp)(_infoArray, addSel, (O)))
-#define	INSOBJECT(O,I)	((*insImp)(_infoArray, insSel, (O), (I)))
-#define	OBJECTAT(I)	((*oatImp)(_infoArray, oatSel, (I)))
-#define	REMOVEAT(I)	((*remImp)(_infoArray, remSel, (I)))
+static NSDictionary	*blank = nil;
 
-static void
-_setAttributesFrom(
-  NSAttributedString *attributedString,
-  NSRange aRange,
-  NSMutableArray *_infoArray)
+/* Returns a tree of runs copying the attributes of the given range of an
+ * attributed string.
+ */
+static GSAttrRun *
+_runsFrom(NSAttributedString *attributedString, NSRange aRange, NSZone *z)
 {
-  NSZone	*z = [_infoArray zone];
+  GSAttrRun	*runs;
   NSRange	range;
   NSDictionary	*attr;
-  GSAttrInfo	*info;
-  unsigned	loc;
-
-  /*
-   * remove any old attributes of the string.
-   */
-  [_infoArray removeAllObjects];
+  NSUInteger	end = NSMaxRange(aRange);
+  NSUInteger	loc;
 
   if (aRange.length == 0)
     {
-      attr = blank->attrs;
-      range = aRange; /* Set to satisfy the loop condition below. */
+      return runNew(z, 0, reCacheAttributes(blank));
     }
-  else
+  attr = [attributedString attributesAtIndex: aRange.location
+			      effectiveRange: &range];
+  loc = aRange.location;
+  runs = 0;
+  for (;;)
     {
-      attr = [attributedString attributesAtIndex: aRange.location
-				  effectiveRange: &range];
-    }
-  info = NEWINFO(z, attr, 0);
-  ADDOBJECT(info);
-  RELEASE(info);
+      NSUInteger	max = NSMaxRange(range);
 
-  while ((loc = NSMaxRange(range)) < NSMaxRange(aRange))
-    {
+      if (max > end)
+	{
+	  max = end;
+	}
+      runs = runJoin(z, runs, runNew(z, max - loc, cacheAttributes(attr)));
+      if ((loc = max) >= end)
+	{
+	  break;
+	}
       attr = [attributedString attributesAtIndex: loc
 				  effectiveRange: &range];
-      info = NEWINFO(z, attr, loc - aRange.location);
-      ADDOBJECT(info);
-      RELEASE(info);
     }
+  return runs;
 }
 
 inline static NSDictionary*
 _attributesAtIndexEffectiveRange(
-  unsigned int index,
+  NSUInteger index,
   NSRange *aRange,
-  unsigned int tmpLength,
-  NSMutableArray *_infoArray,
-  unsigned int *foundIndex)
+  NSUInteger tmpLength,
+  GSAttrRun *runs)
 {
-  unsigned	low, high, used, cnt, nextLoc;
-  GSAttrInfo	*found = nil;
-
-  used = (*cntImp)(_infoArray, cntSel);
-  NSCAssert(used > 0, NSInternalInconsistencyException);
-  high = used - 1;
+  GSAttrRun	*found;
+  NSUInteger	loc;
 
   if (index >= tmpLength)
     {
       if (index == tmpLength)
 	{
-	  found = OBJECTAT(high);
-	  if (foundIndex != 0)
-	    {
-	      *foundIndex = high;
-	    }
+	  found = runLast(runs);
 	  if (aRange != 0)
 	    {
-	      aRange->location = found->loc;
-	      aRange->length = tmpLength - found->loc;
+	      aRange->location = tmpLength - found->len;
+	      aRange->length = found->len;
 	    }
 	  return found->attrs;
 	}
@@ -400,89 +598,64 @@ _attributesAtIndexEffectiveRange(
 		  format: @"index is out of range in function "
 			  @"_attributesAtIndexEffectiveRange()"];
     }
-
-  /*
-   * Binary search for efficiency in huge attributed strings
-   */
-  low = 0;
-  while (low <= high)
+  found = runFind(runs, index, &loc);
+  NSCAssert(found != 0, NSInternalInconsistencyException);
+  if (aRange != 0)
     {
-      cnt = (low + high) / 2;
-      found = OBJECTAT(cnt);
-      if (found->loc > index)
-	{
-	  high = cnt - 1;
-	}
-      else
-	{
-	  if (cnt >= used - 1)
-	    {
-	      nextLoc = tmpLength;
-	    }
-	  else
-	    {
-	      GSAttrInfo	*inf = OBJECTAT(cnt + 1);
+      aRange->location = loc;
+      aRange->length = found->len;
+    }
+  return found->attrs;
+}
 
-	      nextLoc = inf->loc;
-	    }
-	  if (found->loc == index || index < nextLoc)
-	    {
-	      //Found
-	      if (aRange != 0)
-		{
-		  aRange->location = found->loc;
-		  aRange->length = nextLoc - found->loc;
-		}
-	      if (foundIndex != 0)
-		{
-		  *foundIndex = cnt;
-		}
-	      return found->attrs;
-	    }
-	  else
-	    {
-	      low = cnt + 1;
-	    }
-	}
+/* Checks the structure of a tree of runs, returning the number of
+ * characters in it.
+ */
+static NSUInteger
+_runsCheck(GSAttrRun *t, NSDictionary **last)
+{
+  NSUInteger	len;
+
+  if (t == 0)
+    {
+      return 0;
     }
-  NSCAssert(NO,@"Error in binary search algorithm");
-  return nil;
+  NSCAssert(t->left == 0 || runPriority(t->left) <= runPriority(t),
+    NSInternalInconsistencyException);
+  NSCAssert(t->right == 0 || runPriority(t->right) <= runPriority(t),
+    NSInternalInconsistencyException);
+  len = _runsCheck(t->left, last);
+  NSCAssert(t->attrs != *last, NSInternalInconsistencyException);
+  *last = t->attrs;
+  len += t->len;
+  len += _runsCheck(t->right, last);
+  NSCAssert(len == t->sum, NSInternalInconsistencyException);
+  return len;
 }
 
+@implementation GSAttributedString
+
 + (void) initialize
 {
-  if (infCls == 0)
+  if (cachedClass == 0)
     {
-      NSMutableArray	*a;
       NSDictionary	*d;
+      unsigned		i;
 
-      infSel = @selector(newWithZone:value:at:);
-      addSel = @selector(addObject:);
-      cntSel = @selector(count);
-      insSel = @selector(insertObject:atIndex:);
-      oatSel = @selector(objectAtIndex:);
-      remSel = @selector(removeObjectAtIndex:);
-
-      infCls = [GSAttrInfo class];
-      infImp = [infCls methodForSelector: infSel];
+      cachedClass = [GSCachedDictionary class];
+      for (i = 0; i < ATTR_SHARDS; i++)
+	{
+	  GS_MUTEX_INIT(attrShards[i].lock);
+	  GSIMapInitWithZoneAndCapacity(&attrShards[i].map,
+	    NSDefaultMallocZone(), 32);
+	}
 
+      /* The empty attributes dictionary stays in the cache for good.
+       */
       d = [NSDictionary new];
-      blank = NEWINFO(NSDefaultMallocZone(), d, 0);
-      [[NSObject leakAt: &blank] release];
+      blank = cacheAttributes(d);
       RELEASE(d);
-
-      a = [NSMutableArray allocWithZone: NSDefaultMallocZone()];
-      a = [a initWithCapacity: 1];
-      addImp = (void (*)(NSMutableArray*,SEL,id))[a methodForSelector: addSel];
-      cntImp = (unsigned (*)(NSArray*,SEL))[a methodForSelector: cntSel];
-      insImp = (void (*)(NSMutableArray*,SEL,id,unsigned))
-	[a methodForSelector: insSel];
-      oatImp = [a methodForSelector: oatSel];
-      remImp = (void (*)(NSMutableArray*,SEL,unsigned))
-	[a methodForSelector: remSel];
-      RELEASE(a);
     }
-  [[NSObject leakAt: &attrLock] release];
 }
 
 - (id) initWithString: (NSString*)aString
@@ -506,7 +679,6 @@ _attributesAtIndexEffectiveRange(
     {
       return nil;
     }
-  _infoArray = [[NSMutableArray allocWithZone: z] initWithCapacity: 1];
   if (aString != nil && [aString isKindOfClass: [NSAttributedString class]])
     {
       NSAttributedString	*as = (NSAttributedString*)aString;
@@ -514,19 +686,15 @@ _attributesAtIndexEffectiveRange(
 
       aString = [as string];
       len = [aString length];
-      _setAttributesFrom(as, NSMakeRange(0, len), _infoArray);
+      _runs = _runsFrom(as, NSMakeRange(0, len), z);
     }
   else
     {
-      GSAttrInfo	*info;
-
       if (attributes == nil)
 	{
-	  attributes = blank->attrs;
+	  attributes = blank;
 	}
-      info = NEWINFO(z, attributes, 0);
-      ADDOBJECT(info);
-      RELEASE(info);
+      _runs = runNew(z, [aString length], cacheAttributes(attributes));
     }
   if (aString == nil)
     _textChars = @"";
@@ -544,13 +712,13 @@ _attributesAtIndexEffectiveRange(
 		     effectiveRange: (NSRange*)aRange
 {
   return _attributesAtIndexEffectiveRange(
-    index, aRange, [_textChars length], _infoArray, NULL);
+    index, aRange, [_textChars length], _runs);
 }
 
 - (void) dealloc
 {
   RELEASE(_textChars);
-  RELEASE(_infoArray);
+  runFree([self zone], _runs);
   [super dealloc];
 }
 
@@ -578,22 +746,13 @@ _attributesAtIndexEffectiveRange(
  * regression test cases.  */
 - (void) _sanity
 {
-  GSAttrInfo	*info;
-  unsigned	i;
-  unsigned	l = 0;
-  unsigned	len = [_textChars length];
-  unsigned	c = (*cntImp)(_infoArray, cntSel);
+  NSDictionary	*last = nil;
+  NSUInteger	len = [_textChars length];
 
-  NSAssert(c > 0, NSInternalInconsistencyException);
-  info = OBJECTAT(0);
-  NSAssert(info->loc == 0, NSInternalInconsistencyException);
-  for (i = 1; i < c; i++)
-    {
-      info = OBJECTAT(i);
-      NSAssert(info->loc > l, NSInternalInconsistencyException);
-      NSAssert(info->loc < len, NSInternalInconsistencyException);
-      l = info->loc;
-    }
+  NSAssert(_runs != 0, NSInternalInconsistencyException);
+  NSAssert(_runsCheck(_runs, &last) == len, NSInternalInconsistencyException);
+  NSAssert(len > 0 || (_runs->left == 0 && _runs->right == 0),
+    NSInternalInconsistencyException);
 }
 
 + (void) initialize
@@ -623,25 +782,20 @@ _attributesAtIndexEffectiveRange(
       return nil;
     }
 
-  _infoArray = [[NSMutableArray allocWithZone: z] initWithCapacity: 1];
   if (aString != nil && [aString isKindOfClass: [NSAttributedString class]])
     {
       NSAttributedString	*as = (NSAttributedString*)aString;
 
       aString = [as string];
-      _setAttributesFrom(as, NSMakeRange(0, [aString length]), _infoArray);
+      _runs = _runsFrom(as, NSMakeRange(0, [aString length]), z);
     }
   else
     {
-      GSAttrInfo	*info;
-
       if (attributes == nil)
         {
-          attributes = blank->attrs;
+          attributes = blank;
         }
-      info = NEWINFO(z, attributes, 0);
-      ADDOBJECT(info);
-      RELEASE(info);
+      _runs = runNew(z, [aString length], cacheAttributes(attributes));
     }
 /* WARNING ... NSLayoutManager depends on the fact that we create the
  * _textChars instance variable by copying the aString argument to get
@@ -670,9 +824,8 @@ SANITY();
 - (NSDictionary*) attributesAtIndex: (NSUInteger)index
 		     effectiveRange: (NSRange*)aRange
 {
-  unsigned	dummy;
   return _attributesAtIndexEffectiveRange(
-    index, aRange, [_textChars length], _infoArray, &dummy);
+    index, aRange, [_textChars length], _runs);
 }
 
 /*
@@ -689,15 +842,10 @@ SANITY();
 - (void) setAttributes: (NSDictionary*)attributes
 		 range: (NSRange)range
 {
-  unsigned	tmpLength;
-  unsigned	arrayIndex = 0;
-  unsigned	arraySize;
-  // Initial value unused; set by _attributesAtIndexEffectiveRange
-  NSRange	effectiveRange = NSMakeRange(NSNotFound, 0);
-  unsigned	afterRangeLoc, beginRangeLoc;
-  NSDictionary	*attrs;
   NSZone	*z = [self zone];
-  GSAttrInfo	*info;
+  GSAttrRun	*before;
+  GSAttrRun	*runs;
+  GSAttrRun	*after;
 
   if (range.length == 0)
     {
@@ -706,106 +854,30 @@ SANITY();
     }
   if (attributes == nil)
     {
-      attributes = blank->attrs;
+      attributes = blank;
     }
 SANITY();
-  tmpLength = [_textChars length];
-  GS_RANGE_CHECK(range, tmpLength);
-  arraySize = (*cntImp)(_infoArray, cntSel);
-  beginRangeLoc = range.location;
-  afterRangeLoc = NSMaxRange(range);
-  if (afterRangeLoc < tmpLength)
-    {
-      /*
-       * Locate the first range that extends beyond our range.
-       */
-      attrs = _attributesAtIndexEffectiveRange(
-	afterRangeLoc, &effectiveRange, tmpLength, _infoArray, &arrayIndex);
-      if (attrs == attributes)
-        {
-          /* The located range has the same attributes as us - so we can
-           * extend our range to include it.
-           */
-          if (effectiveRange.location < beginRangeLoc)
-            {
-              beginRangeLoc = effectiveRange.location;
-            }
-        }
-      else if (effectiveRange.location > beginRangeLoc)
-	{
-	  /*
-	   * The located range also starts at or after our range.
-	   */
-	  info = OBJECTAT(arrayIndex);
-	  info->loc = afterRangeLoc;
-	  arrayIndex--;
-	}
-      else if (NSMaxRange(effectiveRange) > afterRangeLoc)
-	{
-	  /*
-	   * The located range ends after our range.
-	   * Create a subrange to go from our end to the end of the old range.
-	   */
-	  info = NEWINFO(z, attrs, afterRangeLoc);
-	  arrayIndex++;
-	  INSOBJECT(info, arrayIndex);
-	  RELEASE(info);
-	  arrayIndex--;
-	}
-    }
-  else
-    {
-      arrayIndex = arraySize - 1;
-    }
+  GS_RANGE_CHECK(range, [_textChars length]);
 
-  /*
-   * Remove any ranges completely within ours
+  /* Cache the new attributes before discarding the old ones, so that if
+   * they are the same the cached dictionary is kept rather than removed
+   * and made again.
    */
-  while (arrayIndex > 0)
-    {
-      info = OBJECTAT(arrayIndex-1);
-      if (info->loc < beginRangeLoc)
-	break;
-      REMOVEAT(arrayIndex);
-      arrayIndex--;
-    }
-
-  /*
-   * Use the location/attribute info in the current slot if possible,
-   * otherwise, add a new slot and use that.
-   */
-  info = OBJECTAT(arrayIndex);
-  if (info->loc >= beginRangeLoc)
-    {
-      info->loc = beginRangeLoc;
-      if (info->attrs != attributes)
-	{
-	  unCacheAttributes(info->attrs);
-	  info->attrs = cacheAttributes(attributes);
-	}
-    }
-  else if (info->attrs != attributes)
-    {
-      arrayIndex++;
-      info = NEWINFO(z, attributes, beginRangeLoc);
-      INSOBJECT(info, arrayIndex);
-      RELEASE(info);
-    }
-
+  attributes = cacheAttributes(attributes);
+  runSplit(z, _runs, range.location, &before, &after);
+  runSplit(z, after, range.length, &runs, &after);
+  runFree(z, runs);
+  runs = runNew(z, range.length, attributes);
+  _runs = runJoin(z, runJoin(z, before, runs), after);
 SANITY();
 }
 
 - (void) replaceCharactersInRange: (NSRange)range
 		       withString: (NSString*)aString
 {
-  unsigned	tmpLength;
-  unsigned	arrayIndex = 0;
-  unsigned	arraySize;
-  // Initial value unused; set by _attributesAtIndexEffectiveRange
-  NSRange	effectiveRange = NSMakeRange(NSNotFound, 0);
-  GSAttrInfo	*info;
-  int		moveLocations;
-  unsigned	start;
+  NSZone	*z = [self zone];
+  NSUInteger	tmpLength;
+  NSUInteger	newLength;
 
 SANITY();
   if (aString == nil)
@@ -814,123 +886,62 @@ SANITY();
     }
   tmpLength = [_textChars length];
   GS_RANGE_CHECK(range, tmpLength);
-  if (range.location == tmpLength)
+  newLength = [aString length];
+  if (_runs->left == 0 && _runs->right == 0)
     {
       /*
-       * Special case - replacing a zero length string at the end
-       * simply appends the new string and attributes are inherited.
+       * Special case - if the string has only one set of attributes
+       * then the replacement characters will get them too.
        */
-      [_textChars appendString: aString];
-      goto finish;
+      _runs->len = _runs->sum = tmpLength - range.length + newLength;
     }
-
-  arraySize = (*cntImp)(_infoArray, cntSel);
-  if (arraySize == 1)
+  else if (range.location == tmpLength)
     {
       /*
-       * Special case - if the string has only one set of attributes
-       * then the replacement characters will get them too.
+       * Special case - replacing a zero length string at the end
+       * simply appends the new string and attributes are inherited.
        */
-      [_textChars replaceCharactersInRange: range withString: aString];
-      goto finish;
+      runGrowLast(_runs, newLength);
     }
-
-  /*
-   * Get the attributes to associate with our replacement string.
-   * Should be those of the first character replaced.
-   * If the range replaced is empty, we use the attributes of the
-   * previous character (if possible).
-   */
-  if (range.length == 0 && range.location > 0)
-    start = range.location - 1;
   else
-    start = range.location;
-  _attributesAtIndexEffectiveRange(start, &effectiveRange,
-    tmpLength, _infoArray, &arrayIndex);
-
-  moveLocations = [aString length] - range.length;
-
-  arrayIndex++;
-  if (NSMaxRange(effectiveRange) < NSMaxRange(range))
     {
+      NSDictionary	*attrs;
+      GSAttrRun		*before;
+      GSAttrRun		*runs;
+      GSAttrRun		*after;
+      NSUInteger	start;
+      NSUInteger	loc;
+
       /*
-       * Remove all range info for ranges enclosed within the one
-       * we are replacing.  Adjust the start point of a range that
-       * extends beyond ours.
+       * Get the attributes to associate with our replacement string.
+       * Should be those of the first character replaced.
+       * If the range replaced is empty, we use the attributes of the
+       * previous character (if possible).
        */
-      info = OBJECTAT(arrayIndex);
-      if (info->loc < NSMaxRange(range))
-	{
-	  unsigned int	next = arrayIndex + 1;
+      if (range.length == 0 && range.location > 0)
+	start = range.location - 1;
+      else
+	start = range.location;
+      attrs = reCacheAttributes(runFind(_runs, start, &loc)->attrs);
 
-	  while (next < arraySize)
-	    {
-	      GSAttrInfo	*n = OBJECTAT(next);
-
-	      if (n->loc <= NSMaxRange(range))
-		{
-		  REMOVEAT(arrayIndex);
-		  arraySize--;
-		  info = n;
-		}
-	      else
-		{
-		  break;
-		}
-	    }
-	}
-      if (NSMaxRange(range) < [_textChars length])
+      runSplit(z, _runs, range.location, &before, &after);
+      runSplit(z, after, range.length, &runs, &after);
+      runFree(z, runs);
+      if (newLength > 0 || (before == 0 && after == 0))
 	{
-	  info->loc = NSMaxRange(range);
+	  /* The replacement characters (or, if all the characters were
+	   * deleted, the empty string) take the attributes.
+	   */
+	  runs = runNew(z, newLength, attrs);
 	}
       else
 	{
-	  REMOVEAT(arrayIndex);
-	  arraySize--;
+	  runs = 0;
+	  unCacheAttributes(attrs);
 	}
-    }
-
-  /*
-   * If we are replacing a range with a zero length string and the
-   * range we are using matches the range replaced, then we must
-   * remove it from the array to avoid getting a zero length range.
-   */
-  if ((moveLocations + range.length) == 0)
-    {
-      _attributesAtIndexEffectiveRange(start, &effectiveRange,
-        tmpLength, _infoArray, &arrayIndex);
-      arrayIndex++;
-
-      if (effectiveRange.location == range.location
-	&& effectiveRange.length == range.length)
-	{
-	  arrayIndex--;
-	  if (arrayIndex != 0 || arraySize > 1)
-	    {
-	      REMOVEAT(arrayIndex);
-	      arraySize--;
-	    }
-	  else
-	    {
-	      info = OBJECTAT(0);
-	      unCacheAttributes(info->attrs);
-	      info->attrs = cacheAttributes(blank->attrs);
-	      info->loc = NSMaxRange(range);
-	    }
-	}
-    }
-
-  /*
-   * Now adjust the positions of the ranges following the one we are using.
-   */
-  while (arrayIndex < arraySize)
-    {
-      info = OBJECTAT(arrayIndex);
-      info->loc += moveLocations;
-      arrayIndex++;
+      _runs = runJoin(z, runJoin(z, before, runs), after);
     }
   [_textChars replaceCharactersInRange: range withString: aString];
-finish:
 SANITY();
 }
 
@@ -938,7 +949,7 @@ SANITY();
 {
   [_textProxy release];
   RELEASE(_textChars);
-  RELEASE(_infoArray);
+  runFree([self zone], _runs);
   [super dealloc];
 }
 
@@ -950,7 +961,7 @@ SANITY();
 
 @end
 
-
+
 
 @interface	NSGAttributedString : NSAttributedString
 @end
@@ -60,7 +60,9 @@
 @public
   GSIMapTable_t	map;
   unsigned long	_version;
+  GSDictionary	*_shared;	// Immutable copy using our map
 }
+- (void) _unshare;
 @end
 
 @interface GSDictionaryKeyEnumerator : NSEnumerator
@@ -78,6 +80,7 @@
 
 static SEL	nxtSel;
 static SEL	objSel;
+static IMP	dictDealloc;	// -[GSDictionary dealloc]
 
 - (NSUInteger) sizeOfContentExcluding: (NSHashTable*)exclude
 {
@@ -385,14 +388,57 @@ static SEL	objSel;
   if (self == [GSMutableDictionary class])
     {
       GSObjCAddClassBehavior(self, [GSDictionary class]);
+      dictDealloc
+	= [GSDictionary instanceMethodForSelector: @selector(dealloc)];
     }
 }
 
 - (id) copyWithZone: (NSZone*)zone
 {
-  NSDictionary	*copy = [GSDictionary allocWithZone: zone];
+  GSDictionary	*copy;
+  GSDictionary	*expected = nil;
 
-  return [copy initWithDictionary: self copyItems: NO];
+  copy = __atomic_load_n(&_shared, __ATOMIC_ACQUIRE);
+  if (nil != copy)
+    {
+      return RETAIN(copy);	// Unchanged since the last copy.
+    }
+  if (0 == map.nodeCount)
+    {
+      copy = [GSDictionary allocWithZone: zone];
+      return [copy initWithDictionary: self copyItems: NO];
+    }
+  /* The copy takes over our map, and we keep using it until the next
+   * change (see -_unshare), so a copy costs O(1) and repeated copies of
+   * an unchanged dictionary are the same object.
+   * Two threads may copy an unchanged dictionary at once, so the map is
+   * handed over by whichever sets _shared first, and the other thread
+   * throws its copy away.
+   */
+  copy = (GSDictionary*)NSAllocateObject([GSDictionary class], 0, zone);
+  copy->map = map;
+  RETAIN(copy);
+  if (NO == __atomic_compare_exchange_n(&_shared, &expected, copy, NO,
+    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+      memset(&copy->map, '\0', sizeof(copy->map));
+      RELEASE(copy);
+      RELEASE(copy);
+      return RETAIN(expected);
+    }
+  return copy;
+}
+
+- (void) dealloc
+{
+  if (nil != _shared)
+    {
+      /* The copy owns the map, so forget it before anything can empty it.
+       */
+      memset(&map, '\0', sizeof(map));
+      DESTROY(_shared);
+    }
+  (*dictDealloc)(self, _cmd);
 }
 
 - (id) init
@@ -410,18 +456,42 @@ static SEL	objSel;
   return self;
 }
 
+- (NSEnumerator*) keyEnumerator
+{
+  NSDictionary	*d = (nil == _shared) ? (NSDictionary*)self : _shared;
+
+  return AUTORELEASE([[GSDictionaryKeyEnumerator allocWithZone:
+    NSDefaultMallocZone()] initWithDictionary: d]);
+}
+
 - (BOOL) makeImmutable
 {
+  if (nil != _shared)
+    {
+      [self _unshare];
+    }
   GSClassSwizzle(self, [GSDictionary class]);
   return YES;
 }
 
 - (id) makeImmutableCopyOnFail: (BOOL)force
 {
+  if (nil != _shared)
+    {
+      [self _unshare];
+    }
   GSClassSwizzle(self, [GSDictionary class]);
   return self;
 }
 
+- (NSEnumerator*) objectEnumerator
+{
+  NSDictionary	*d = (nil == _shared) ? (NSDictionary*)self : _shared;
+
+  return AUTORELEASE([[GSDictionaryObjectEnumerator allocWithZone:
+    NSDefaultMallocZone()] initWithDictionary: d]);
+}
+
 - (void) setObject: (id)anObject forKey: (id)aKey
 {
   GSIMapNode	node;
@@ -448,6 +518,10 @@ static SEL	objSel;
       [e raise];
     }
   _version++;
+  if (nil != _shared)
+    {
+      [self _unshare];
+    }
   node = GSIMapNodeForKey(&map, (GSIMapKey)aKey);
   if (node)
     {
@@ -465,7 +539,19 @@ static SEL	objSel;
 - (void) removeAllObjects
 {
   _version++;
-  GSIMapCleanMap(&map);
+  if (nil != _shared)
+    {
+      NSZone	*z = map.zone;
+
+      /* Nothing to keep, so just leave the map with the copy.
+       */
+      DESTROY(_shared);
+      GSIMapInitWithZoneAndCapacity(&map, z, 0);
+    }
+  else
+    {
+      GSIMapCleanMap(&map);
+    }
   _version++;
 }
 
@@ -477,6 +563,10 @@ static SEL	objSel;
       return;
     }
   _version++;
+  if (nil != _shared)
+    {
+      [self _unshare];
+    }
   GSIMapRemoveKey(&map, (GSIMapKey)aKey);
   _version++;
 }
@@ -489,6 +579,29 @@ static SEL	objSel;
   return GSIMapCountByEnumeratingWithStateObjectsCount
     (&map, state, stackbuf, len);
 }
+
+- (void) _unshare
+{
+  if (nil != _shared)
+    {
+      GSIMapEnumerator_t	enumerator;
+      GSIMapNode		node;
+
+      /* Leave the map with the immutable copy and build our own.
+       */
+      GSIMapInitWithZoneAndCapacity(&map, _shared->map.zone,
+	_shared->map.nodeCount);
+      enumerator = GSIMapEnumeratorForMap(&_shared->map);
+      while ((node = GSIMapEnumeratorNextNode(&enumerator)) != 0)
+	{
+	  IF_NO_ARC(RETAIN(node->key.obj);)
+	  IF_NO_ARC(RETAIN(node->value.obj);)
+	  GSIMapAddPairNoRetain(&map, node->key, node->value);
+	}
+      GSIMapEndEnumerator(&enumerator);
+      DESTROY(_shared);
+    }
+}
 @end
 
 @implementation GSDictionaryKeyEnumerator
@@ -568,10 +681,19 @@ static SEL	objSel;
 
 @interface	GSCachedDictionary : GSDictionary
 {
-  BOOL  _uncached;
+  BOOL  	_uncached;
+  NSUInteger	_cacheHash;
 }
 @end
 @implementation	GSCachedDictionary
+- (NSUInteger) _cacheHash
+{
+  return _cacheHash;
+}
+- (void) _setCacheHash: (NSUInteger)h
+{
+  _cacheHash = h;
+}
 - (void) dealloc
 {
   if (NO == _uncached)
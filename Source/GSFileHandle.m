@@ -48,6 +48,7 @@
 #include <sys/time.h>
 #include <sys/param.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
@@ -96,6 +97,7 @@
 
 // Maximum data in single I/O operation
 #define	NETBUF_SIZE	(1024 * 16)
+#define	IOV_BATCH	64
 #define	READ_SIZE	NETBUF_SIZE*10
 
 // Convienience Macro for Error Handling
@@ -122,6 +124,12 @@ static GSFileHandle     *fh_stderr = nil;
 // Key to info dictionary for operation mode.
 static NSString*	NotificationKey = @"NSFileHandleNotificationKey";
 
+/* Our own -write:length: implementation.  Chunked data is written straight
+ * to the descriptor only by handles which do not override it (a TLS handle
+ * must encrypt everything it writes).
+ */
+static IMP		plainWrite = 0;
+
 @interface GSFileHandle(private)
 - (void) receivedEventRead;
 - (void) receivedEventWrite;
@@ -143,6 +151,8 @@ static NSString*	NotificationKey = @"NSFileHandleNotificationKey";
   if (NO == beenHere)
     {
       beenHere = YES;
+      plainWrite = [GSFileHandle instanceMethodForSelector:
+	@selector(write:length:)];
       [self registerAtExit];
     }
 }
@@ -1526,12 +1536,92 @@ NSString * const GSSOCKSRecvAddr = @"GSSOCKSRecvAddr";
   return data;
 }
 
+/* Writes data held in several chunks with writev() so that the chunks do
+ * not have to be copied into a single buffer first.
+ */
+- (NSInteger) writeChunks: (NSData*)item count: (NSUInteger)count
+{
+  const void	*ptrs[IOV_BATCH];
+  NSUInteger	lens[IOV_BATCH];
+  struct iovec	iov[IOV_BATCH];
+  NSUInteger	chunk = 0;
+  NSUInteger	offset = 0;
+  NSInteger	rval = 0;
+
+  while (chunk < count)
+    {
+      NSUInteger	n = count - chunk;
+      NSUInteger	total = 0;
+      NSUInteger	done;
+      NSUInteger	i;
+
+      if (n > IOV_BATCH)
+	{
+	  n = IOV_BATCH;
+	}
+      GSPrivateDataChunks(item, chunk, ptrs, lens, n);
+      for (i = 0; i < n; i++)
+	{
+	  iov[i].iov_base = (char*)ptrs[i] + (i == 0 ? offset : 0);
+	  iov[i].iov_len = lens[i] - (i == 0 ? offset : 0);
+	  total += iov[i].iov_len;
+	}
+      if (NO == isStandardFile)
+	{
+	  NSUInteger	allowed = [GSTcpTune sendSize: total];
+
+	  if (allowed > 0 && allowed < total)
+	    {
+	      for (i = 0; allowed > iov[i].iov_len; i++)
+		{
+		  allowed -= iov[i].iov_len;
+		}
+	      iov[i].iov_len = allowed;
+	      n = i + 1;
+	    }
+	}
+      do
+	{
+	  rval = writev(descriptor, iov, (int)n);
+	}
+      while (rval < 0 && EINTR == errno);
+      if (rval < 0)
+	{
+	  if (errno != EAGAIN)
+	    {
+	      return rval;
+	    }
+	  rval = 0;
+	}
+
+      /* Step past the chunks which were written completely, and note how
+       * much of a partly written chunk was done.
+       */
+      done = rval;
+      for (i = 0; i < n; i++)
+	{
+	  NSUInteger	left = lens[i] - offset;
+
+	  if (done < left)
+	    {
+	      offset += done;
+	      break;
+	    }
+	  done -= left;
+	  offset = 0;
+	  chunk++;
+	}
+    }
+  return 0;
+}
+
 - (BOOL) writeData: (NSData*)item error: (NSError **) error
 {
     int		rval = 0;
-  const void*	ptr = [item bytes];
-  unsigned int	len = [item length];
+  const void*	ptr;
+  unsigned int	len;
   unsigned int	pos = 0;
+  NSUInteger	count;
 
   if (![self checkWriteWithError: error])
     {
@@ -1541,6 +1631,22 @@ NSString * const GSSOCKSRecvAddr = @"GSSOCKSRecvAddr";
     {
       [self setNonBlocking: NO];
     }
+  count = GSPrivateDataChunks(item, 0, 0, 0, 0);
+  if (count > 1
+#if	USE_ZLIB
+    && 0 == gzDescriptor
+#endif
+    && [self methodForSelector: @selector(write:length:)] == plainWrite)
+    {
+      if ([self writeChunks: item count: count] < 0)
+	{
+	  SET_ERROR_WITH_UNDERLYING(error, NSFileWriteUnknownError, [NSError _last], @"unable to write to descriptor")
+	  return NO;
+	}
+      return YES;
+    }
+  ptr = [item bytes];
+  len = [item length];
   while (pos < len)
     {
       int	toWrite = len - pos;
@@ -744,6 +744,62 @@ parse_one_spec (const unichar *format, size_t posn, struct printf_spec *spec,
   return nargs;
 }
 
+/* The parsed form of a format string: its specs and the number of
+   arguments they consume.  Where the format is entirely ASCII, BYTES
+   holds an 8-bit copy of it which is used to output the literal text.  */
+typedef struct
+{
+  const unichar *format;
+  const unsigned char *bytes;
+  const unichar *lead_str_end;
+  size_t nspecs;
+  size_t nargs;
+  struct printf_spec *specs;
+} format_plan;
+
+/* Parse FORMAT into PLAN.  The NSPECS_MAX elements of SPECS are used for
+   the specs if there is room, otherwise an array is obtained from malloc
+   and the caller must free PLAN->specs.  */
+static void
+parse_format (const unichar *format, format_plan *plan,
+	      struct printf_spec *specs, size_t nspecs_max)
+{
+  struct printf_spec *initial = specs;
+  size_t nspecs = 0;
+  size_t nargs = 0;
+  size_t max_ref_arg = 0;
+  const unichar *f;
+
+  plan->format = format;
+  plan->bytes = NULL;
+  plan->lead_str_end = f = find_spec (format);
+
+  for (; *f != '\0'; f = specs[nspecs++].next_fmt)
+    {
+      if (nspecs >= nspecs_max)
+	{
+	  /* Extend the array of format specifiers.  */
+	  nspecs_max = (nspecs_max == 0) ? 8 : nspecs_max * 2;
+	  if (specs == initial)
+	    {
+	      specs = malloc (nspecs_max * sizeof (struct printf_spec));
+	      if (nspecs > 0)
+		memcpy (specs, initial, nspecs * sizeof (struct printf_spec));
+	    }
+	  else
+	    specs = realloc (specs, nspecs_max * sizeof (struct printf_spec));
+	}
+
+      /* Parse the format specifier.  */
+      nargs += parse_one_spec (f, nargs, &specs[nspecs], &max_ref_arg);
+    }
+
+  plan->nspecs = nspecs;
+  /* Determine the number of arguments the format string consumes.  */
+  plan->nargs = MAX (nargs, max_ref_arg);
+  plan->specs = specs;
+}
+
 static inline void GSStrAppendUnichar(GSStr s, unichar u)
 {
   GSPrivateStrAppendUnichars(s, &u, 1);
@@ -751,6 +807,19 @@ static inline void GSStrAppendUnichar(GSStr s, unichar u)
 
 #define	outchar(Ch)		GSStrAppendUnichar(s, Ch)
 #define outstring(String, Len)	GSPrivateStrAppendUnichars(s, String, Len)
+#define outbytes(Bytes, Len)	GSPrivateStrAppendChars(s, Bytes, Len)
+
+/* Write the literal text of the format between FROM and TO, directly from
+   the 8-bit copy if there is one.  */
+#define outliteral(From, To)						      \
+  do									      \
+    {									      \
+      if (plan->bytes != NULL)						      \
+	outbytes (plan->bytes + ((From) - plan->format), (To) - (From));      \
+      else								      \
+	outstring ((From), (To) - (From));				      \
+    }									      \
+  while (0)
 
 /* For handling long_double and longlong we use the same flag.  If
    `long' and `long long' are effectively the same type define it to
@@ -807,10 +876,11 @@ static int printf_unknown (GSStr, const struct printf_info *,
 static unichar *group_number (unichar *, unichar *, const char *, NSString *);
 
 
-/* The function itself.  */
-void
-GSPrivateFormat (GSStr s, const unichar *format, va_list ap,
-NSDictionary *locale)
+/* Write the arguments to S as described by PLAN.  SPECS is a copy of the
+   specs of the plan which may be modified.  */
+static void
+format_with_plan (GSStr s, const format_plan *plan, struct printf_spec *specs,
+		  va_list ap, NSDictionary *locale)
 {
   /* The character used as thousands separator.  */
   NSString *thousands_sep = @"";
@@ -821,12 +891,6 @@ NSDictionary *locale)
   /* Place to accumulate the result.  */
   int done;
 
-  /* Current character in format string.  */
-  const unichar *f;
-
-  /* End of leading constant string.  */
-  const unichar *lead_str_end;
-
   /* Points to next format specifier.  */
 
   /* Buffer intermediate results.  */
@@ -893,16 +957,11 @@ NSDictionary *locale)
 #endif
   nspecs_done = 0;
 
-  /* Find the first format specifier.  */
-  f = lead_str_end = find_spec ((const unichar *) format);
-
-
   /* Write the literal text before the first format.  */
-  outstring ((const unichar *) format,
-	     lead_str_end - (const unichar *) format);
+  outliteral (plan->format, plan->lead_str_end);
 
   /* If we only have to print a simple string, return now.  */
-  if (*f == '\0')
+  if (plan->nspecs == 0)
     goto all_done;
 
   /* Process whole format string.  */
@@ -911,25 +970,12 @@ NSDictionary *locale)
 
   /* Here starts the more complex loop to handle positional parameters.  */
   {
-    /* Array with information about the needed arguments.  This has to
-       be dynamically extensible.  */
-    size_t nspecs = 0;
-    size_t nspecs_max = 32;	/* A more or less arbitrary start value.  */
-    struct printf_spec *specs
-      = alloca (nspecs_max * sizeof (struct printf_spec));
-
-    /* The number of arguments the format string requests.  This will
-       determine the size of the array needed to store the argument
-       attributes.  */
-    size_t nargs = 0;
+    /* The specs of the format and the number of arguments they use.  */
+    size_t nspecs = plan->nspecs;
+    size_t nargs = plan->nargs;
     int *args_type;
     union printf_arg *args_value = NULL;
 
-    /* Positional parameters refer to arguments directly.  This could
-       also determine the maximum number of arguments.  Track the
-       maximum number.  */
-    size_t max_ref_arg = 0;
-
     /* Just a counter.  */
     size_t cnt;
 
@@ -944,39 +990,6 @@ NSDictionary *locale)
 	  grouping = NULL;
       }
 
-    for (f = lead_str_end; *f != '\0'; f = specs[nspecs++].next_fmt)
-      {
-	if (nspecs >= nspecs_max)
-	  {
-	    /* Extend the array of format specifiers.  */
-	    struct printf_spec *old = specs;
-
-	    nspecs_max *= 2;
-	    specs = alloca (nspecs_max * sizeof (struct printf_spec));
-
-	    if (specs == &old[nspecs])
-	      /* Stack grows up, OLD was the last thing allocated;
-		 extend it.  */
-	      nspecs_max += nspecs_max / 2;
-	    else
-	      {
-		/* Copy the old array's elements to the new space.  */
-		memcpy (specs, old, nspecs * sizeof (struct printf_spec));
-		if (old == &specs[nspecs])
-		  /* Stack grows down, OLD was just below the new
-		     SPECS.  We can use that space when the new space
-		     runs out.  */
-		  nspecs_max += nspecs_max / 2;
-	      }
-	  }
-
-	/* Parse the format specifier.  */
-	nargs += parse_one_spec (f, nargs, &specs[nspecs], &max_ref_arg);
-      }
-
-    /* Determine the number of arguments the format string consumes.  */
-    nargs = MAX (nargs, max_ref_arg);
-
     /* Allocate memory for the argument descriptions.  */
     args_type = alloca (nargs * sizeof (int));
     memset (args_type, 0, nargs * sizeof (int));
@@ -1529,6 +1542,15 @@ NSDictionary *locale)
 		  }
 		bp++;
 	      }
+	    else if ((unsigned char)*bp < 128)
+	      {
+		char	*ep = bp;
+
+		while (*++ep != '\0' && *ep != '\033' && (unsigned char)*ep < 128)
+		  ;
+		outbytes ((const unsigned char *)bp, ep - bp);
+		bp = ep;
+	      }
 	    else
 	      {
 		outchar(*bp++);
@@ -1647,6 +1669,15 @@ NSDictionary *locale)
 		  }
 		bp++;
 	      }
+	    else if ((unsigned char)*bp < 128)
+	      {
+		char	*ep = bp;
+
+		while (*++ep != '\0' && *ep != '\033' && (unsigned char)*ep < 128)
+		  ;
+		outbytes ((const unsigned char *)bp, ep - bp);
+		bp = ep;
+	      }
 	    else
 	      {
 		outchar(*bp++);
@@ -1761,6 +1792,7 @@ NSDictionary *locale)
 	       string into a unicode string.  */
 	    const char			*str = (const char*)string;
 	    unsigned			blen;
+	    size_t			n;
 	    static NSStringEncoding	enc = GSUndefinedEncoding;
 	    static BOOL			byteEncoding = NO;
 
@@ -1807,6 +1839,20 @@ NSDictionary *locale)
 		  }
 	      }
 
+	    /* ASCII needs no conversion, so copy it directly.
+	     */
+	    for (n = 0; n < len && (unsigned char)str[n] < 128; n++)
+	      ;
+	    if (n == len)
+	      {
+		if ((width -= len) > 0 && !left)
+		  PAD (' ');
+		outbytes ((const unsigned char *)str, len);
+		if (width > 0 && left)
+		  PAD (' ');
+		break;
+	      }
+
 	    /* Allocate dynamically an array which definitely is long
 	     * enough for the unichar version.
 	     */
@@ -1861,6 +1907,9 @@ NSDictionary *locale)
 	size_t len;
 	id obj;
 	NSString *dsc;
+	const void *contents;
+	NSUInteger clen;
+	BOOL wide;
 
 	obj = args_value[specs[nspecs_done].data_arg].pa_object;
 
@@ -1874,6 +1923,23 @@ NSDictionary *locale)
 
 	len = [dsc length];
 
+	/* The characters of a concrete string can be copied directly,
+	   and an 8-bit string stays 8-bit.  */
+	contents = GSPrivateStrContents(dsc, &clen, &wide);
+	if (contents != NULL)
+	  {
+	    if (prec >= 0 && prec < (int)len) len = prec;
+	    if ((width -= len) > 0 && !left)
+	      PAD (' ');
+	    if (wide)
+	      outstring ((const unichar *)contents, len);
+	    else
+	      outbytes ((const unsigned char *)contents, len);
+	    if (width > 0 && left)
+	      PAD (' ');
+	    break;
+	  }
+
 	string_malloced = 0;
 	  {
 	    /* This is complicated.  We have to transform the
@@ -1939,9 +2005,8 @@ NSDictionary *locale)
 	  }
 
 	/* Write the following constant string.  */
-	outstring (specs[nspecs_done].end_of_fmt,
-		   specs[nspecs_done].next_fmt
-		   - specs[nspecs_done].end_of_fmt);
+	outliteral (specs[nspecs_done].end_of_fmt,
+		    specs[nspecs_done].next_fmt);
       }
   }
 
@@ -1953,6 +2018,157 @@ all_done:
 #endif
   return;
 }
+
+void
+GSPrivateFormat (GSStr s, const unichar *format, va_list ap,
+NSDictionary *locale)
+{
+  /* A more or less arbitrary number of specs to parse on the stack.  */
+  struct printf_spec specs[32];
+  format_plan plan;
+
+  parse_format (format, &plan, specs, sizeof (specs) / sizeof (specs[0]));
+  format_with_plan (s, &plan, plan.specs, ap, locale);
+  if (plan.specs != specs)
+    free (plan.specs);
+}
+
+/* The parsed forms of constant format strings, found by the address of
+   the string.  Constant strings are never deallocated, so an entry stays
+   valid for the life of the process.  Entries are published atomically
+   and never altered or removed, so looking one up needs no lock.  A
+   format whose probe sequence is full of other formats is not cached and
+   is parsed on each use, which bounds the memory used.  */
+#define	PLAN_SLOTS	1024
+#define	PLAN_PROBES	8
+#define	PLAN_MAXLEN	1024
+
+typedef struct
+{
+  NSString *key;
+  format_plan plan;
+} plan_entry;
+
+static plan_entry *plans[PLAN_SLOTS];
+static Class constantStringClass = Nil;
+
+static plan_entry *
+new_plan_entry (NSString *format)
+{
+  NSUInteger len = [format length];
+  NSUInteger i;
+  plan_entry *e;
+  unichar *u;
+  unsigned char *b;
+
+  /* The entry holds the characters of the format and an 8-bit copy.  */
+  e = malloc (sizeof (plan_entry) + (len + 1) * (sizeof (unichar) + 1));
+  if (e == NULL)
+    return NULL;
+  u = (unichar *) (e + 1);
+  b = (unsigned char *) (u + len + 1);
+  [format getCharacters: u range: NSMakeRange (0, len)];
+  u[len] = '\0';
+  for (i = 0; i < len && u[i] < 128; i++)
+    b[i] = u[i];
+  b[i] = '\0';
+
+  parse_format (u, &e->plan, NULL, 0);
+  if (i == len)
+    e->plan.bytes = b;
+  e->key = format;
+  return e;
+}
+
+static void
+free_plan_entry (plan_entry *e)
+{
+  free (e->plan.specs);
+  free (e);
+}
+
+static const format_plan *
+cached_plan (NSString *format)
+{
+  uintptr_t h = (uintptr_t) format;
+  plan_entry *n = NULL;
+  unsigned int i;
+
+  h = (h >> 4) ^ (h >> 14);
+  for (i = 0; i < PLAN_PROBES; i++)
+    {
+      plan_entry **slot = &plans[(h + i) % PLAN_SLOTS];
+      plan_entry *e = __atomic_load_n (slot, __ATOMIC_ACQUIRE);
+
+      if (e == NULL)
+	{
+	  if (n == NULL)
+	    {
+	      if ([format length] > PLAN_MAXLEN
+		|| (n = new_plan_entry (format)) == NULL)
+		return NULL;
+	    }
+	  if (__atomic_compare_exchange_n (slot, &e, n, 0,
+	    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+	    return &n->plan;
+	  /* Another thread filled the slot; E is now its entry.  */
+	}
+      if (e->key == format)
+	{
+	  if (n != NULL)
+	    free_plan_entry (n);
+	  return &e->plan;
+	}
+    }
+  if (n != NULL)
+    free_plan_entry (n);
+  return NULL;
+}
+
+void
+GSPrivateFormatString (GSStr s, NSString *format, va_list ap,
+		       NSDictionary *locale)
+{
+  /* For the %m format we must keep the `errno' value of the caller.  */
+  int save_errno = errno;
+  const format_plan *plan = NULL;
+
+  if (constantStringClass == Nil)
+    constantStringClass = [NXConstantString class];
+  if (object_getClass (format) == constantStringClass)
+    plan = cached_plan (format);
+
+  if (plan != NULL)
+    {
+      /* Formatting fills in the width and precision of specs which take
+	 them from arguments, so it must work on a copy.  */
+      struct printf_spec *specs
+	= alloca ((plan->nspecs + 1) * sizeof (struct printf_spec));
+
+      if (plan->nspecs > 0)
+	memcpy (specs, plan->specs,
+		plan->nspecs * sizeof (struct printf_spec));
+      errno = save_errno;
+      format_with_plan (s, plan, specs, ap, locale);
+    }
+  else
+    {
+      unichar buf[1024];
+      unichar *fmt = buf;
+      NSUInteger len = [format length];
+
+      /* Use an on-stack buffer for the characters of the format unless
+	 it is really big (a rare occurrence).  */
+      if (len >= sizeof (buf) / sizeof (buf[0]))
+	fmt = malloc ((len + 1) * sizeof (unichar));
+      [format getCharacters: fmt range: NSMakeRange (0, len)];
+      fmt[len] = '\0';
+      errno = save_errno;
+      GSPrivateFormat (s, fmt, ap, locale);
+      if (fmt != buf)
+	free (fmt);
+    }
+}
 
 /* Handle an unknown format specifier.  This prints out a canonicalized
    representation of the format spec itself.  */
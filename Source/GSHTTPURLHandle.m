@@ -1318,6 +1318,7 @@ debugWrite(GSHTTPURLHandle *handle, NSData *data)
             GSTLSRemoteHosts,
             GSTLSRevokeFile,
             GSTLSServerName,
+            GSTLSSessionCacheKey,
             GSTLSVerify,
             nil];
         }
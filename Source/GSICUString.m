@@ -24,6 +24,7 @@
 #import "common.h"
 #if GS_USE_ICU == 1
 #import "GSICUString.h"
+#import "GSPrivate.h"
 
 /**
  * The number of characters that we use per chunk when fetching a block of
@@ -33,6 +34,43 @@
  */
 static const NSUInteger chunkSize = 32;
 
+/**
+ * The number of characters per chunk for strings holding Latin-1 bytes.
+ * These are widened directly from the string's storage without a message
+ * send, so a larger chunk costs little and saves calls into the provider.
+ */
+static const NSUInteger latin1ChunkSize = 1024;
+
+/**
+ * Copies characters from the string backing a UText into dest.  Where the
+ * UText was set up with direct access to the string's storage (ut->q) this
+ * reads UTF-16 (ut->b set) or Latin-1 characters without messaging the
+ * string.
+ */
+static inline void
+UTextNSStringFetch(UText *ut, unichar *dest, NSRange r)
+{
+  if (NULL == ut->q)
+    {
+      [(NSString*)ut->p getCharacters: dest range: r];
+    }
+  else if (ut->b)
+    {
+      memcpy(dest, ((const unichar*)ut->q) + r.location,
+	r.length * sizeof(unichar));
+    }
+  else
+    {
+      const unsigned char	*src = ((const unsigned char*)ut->q) + r.location;
+      NSUInteger		i;
+
+      for (i = 0; i < r.length; i++)
+	{
+	  dest[i] = src[i];
+	}
+    }
+}
+
 /**
  * Returns the number of UTF16 characters in a UText backed by an NSString.
  */
@@ -55,6 +93,7 @@ UTextNSStringAccess(UText *ut, int64_t nativeIndex, UBool forward)
 {
   NSString	*str = (NSString*)ut->p;
   NSInteger	length = (-1 == ut->c) ? (NSInteger)[str length] : ut->c;
+  NSInteger	size = ut->extraSize / sizeof(unichar);
   NSInteger     nativeStart = ut->chunkNativeStart;
   NSInteger     nativeLimit = ut->chunkNativeLimit;
   NSRange	r;
@@ -83,7 +122,7 @@ UTextNSStringAccess(UText *ut, int64_t nativeIndex, UBool forward)
        * and to start at the beginning of that buffer.
        */
       nativeStart = nativeIndex;
-      nativeLimit = nativeIndex + chunkSize;
+      nativeLimit = nativeIndex + size;
       if (nativeLimit > length)
         {
           nativeLimit = length;
@@ -117,7 +156,7 @@ UTextNSStringAccess(UText *ut, int64_t nativeIndex, UBool forward)
         {
           nativeLimit = length;
         }
-      nativeStart = nativeLimit - chunkSize;
+      nativeStart = nativeLimit - size;
       if (nativeStart < 0)
         {
           nativeStart = 0;
@@ -126,7 +165,7 @@ UTextNSStringAccess(UText *ut, int64_t nativeIndex, UBool forward)
       r.length = nativeLimit - nativeStart;
       ut->chunkOffset = r.length;
     }
-  [str getCharacters: ut->pExtra range: r];
+  UTextNSStringFetch(ut, ut->pExtra, r);
   ut->chunkNativeLimit = nativeLimit;
   ut->chunkNativeStart = nativeStart;
   ut->nativeIndexingLimit = r.length;
@@ -134,6 +173,36 @@ UTextNSStringAccess(UText *ut, int64_t nativeIndex, UBool forward)
   return TRUE;
 }
 
+/**
+ * Sets the position in a UText whose single chunk is the whole of the
+ * UTF-16 storage of the string, so no characters ever need to be loaded.
+ */
+static UBool
+UTextUnicharsAccess(UText *ut, int64_t nativeIndex, UBool forward)
+{
+  int64_t	length = ut->chunkNativeLimit;
+
+  if (forward)
+    {
+      if (nativeIndex >= length)
+	{
+	  ut->chunkOffset = ut->chunkLength;
+	  return FALSE;
+	}
+      ut->chunkOffset = (nativeIndex < 0) ? 0 : nativeIndex;
+    }
+  else
+    {
+      if (nativeIndex <= 0)
+	{
+	  ut->chunkOffset = 0;
+	  return FALSE;
+	}
+      ut->chunkOffset = (nativeIndex > length) ? length : nativeIndex;
+    }
+  return TRUE;
+}
+
 /**
  * Replaces characters in an NSString-backed UText.
  */
@@ -211,7 +280,7 @@ UTextNSStringExtract(UText *ut,
         {
           r.length = destCapacity;
         }
-      [str getCharacters: dest range: r];
+      UTextNSStringFetch(ut, dest, r);
       if (destCapacity > r.length)
         {
           dest[r.length] = 0;
@@ -268,6 +337,7 @@ UTextNStringClose(UText *ut)
   ut->chunkContents = NULL;
   [(NSString*)ut->p release];
   ut->p = NULL;
+  ut->q = NULL;
 }
 
 /**
@@ -344,6 +414,25 @@ static const UTextFuncs NSStringFuncs =
   0, 0, 0             // Spare
 };
 
+/**
+ * Vtable for UTexts backed by the UTF-16 storage of a GSUnicodeString.
+ */
+static const UTextFuncs UnicharsFuncs = 
+{
+  sizeof(UTextFuncs), // Table size
+  0, 0, 0,            // Reserved
+  UTextNSStringClone,
+  UTextNSStringNativeLength,
+  UTextUnicharsAccess,
+  UTextNSStringExtract,
+  0,                  // Replace
+  UTextNSStringCopy,
+  UTextNSStringMapOffsetToNative,
+  0,                // Map to UTF16
+  UTextNStringClose,
+  0, 0, 0             // Spare
+};
+
 /**
  * Vtable for NSMutableString-backed UTexts.
  */
@@ -376,6 +465,7 @@ UTextInitWithNSMutableString(UText *txt, NSMutableString *str)
     }
 
   txt->p = [str retain];
+  txt->q = NULL;
   txt->pFuncs = &NSMutableStringFuncs;
   txt->chunkContents = txt->pExtra;
   txt->c = -1;  // Need to fetch length every time
@@ -387,8 +477,42 @@ UTextInitWithNSMutableString(UText *txt, NSMutableString *str)
 UText*
 UTextInitWithNSString(UText *txt, NSString *str)
 {
-  UErrorCode status = 0;
-  txt = utext_setup(txt, 64, &status);
+  UErrorCode	status = 0;
+  NSUInteger	length = 0;
+  BOOL		wide = NO;
+  const void	*chars = GSPrivateStrContents(str, &length, &wide);
+
+  if (length > INT32_MAX)
+    {
+      chars = NULL;	// Too long for a single chunk
+    }
+  if (NULL != chars && YES == wide)
+    {
+      /* The string holds UTF-16 so the whole of its storage is used as
+       * the one and only chunk.
+       */
+      txt = utext_setup(txt, 0, &status);
+      if (U_FAILURE(status))
+	{
+	  return NULL;
+	}
+      txt->p = [str retain];
+      txt->q = chars;
+      txt->b = 1;
+      txt->pFuncs = &UnicharsFuncs;
+      txt->chunkContents = chars;
+      txt->chunkNativeStart = 0;
+      txt->chunkNativeLimit = length;
+      txt->chunkLength = length;
+      txt->nativeIndexingLimit = length;
+      txt->chunkOffset = 0;
+      txt->c = length;
+      txt->providerProperties = 1<<UTEXT_PROVIDER_STABLE_CHUNKS;
+      return txt;
+    }
+
+  txt = utext_setup(txt, (NULL == chars ? chunkSize : latin1ChunkSize)
+    * sizeof(unichar), &status);
 
   if (U_FAILURE(status))
     {
@@ -396,9 +520,11 @@ UTextInitWithNSString(UText *txt, NSString *str)
     }
 
   txt->p = [str retain];
+  txt->q = chars;
+  txt->b = 0;
   txt->pFuncs = &NSStringFuncs;
   txt->chunkContents = txt->pExtra;
-  txt->c = [str length];
+  txt->c = (NULL == chars) ? [str length] : length;
 
   return txt;
 }
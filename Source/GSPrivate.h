@@ -34,6 +34,7 @@
 @class	NSNotification;
 @class	NSPointerArray;
 @class	NSRecursiveLock;
+@class	NSTimeZone;
 
 #if ( (__GNUC__ > 3 || (__GNUC__ == 3 && __GNUC_MINOR__ >= 3) ) && HAVE_VISIBILITY_ATTRIBUTE )
 #define GS_ATTRIB_PRIVATE __attribute__ ((visibility("internal")))
@@ -80,7 +81,12 @@ typedef struct objc_category* Category;
   unsigned	_capacity;
   int		_grow_factor;
   unsigned long		_version;
+  GSArray	*_shared;	// Immutable copy using _contents_array
 }
+/* Gives the array its own copy of a buffer shared with an immutable copy.
+ * Must be called before any change to the contents.
+ */
+- (void) _unshare;
 @end
 
 @interface GSPlaceholderArray : NSArray
@@ -363,6 +369,10 @@ typedef enum {
 /* Cancel all pending performers.
  */
 - (void) invalidate;
+/* Wake the loop's thread if it is waiting for input, without adding a
+ * performer.  May be called from any thread.
+ */
+- (void) wake;
 @end
 
 /* Return (and optionally create) GSRunLoopThreadInfo for the specified
@@ -427,6 +437,13 @@ void
 GSPrivateFormat(GSStr fb, const unichar *fmt, va_list ap, NSDictionary *loc)
   GS_ATTRIB_PRIVATE;
 
+/* Format arguments into an internal string as GSPrivateFormat() does.
+ * The parsed form of a constant format string is cached and reused.
+ */
+void
+GSPrivateFormatString(GSStr fb, NSString *fmt, va_list ap, NSDictionary *loc)
+  GS_ATTRIB_PRIVATE;
+
 /* determine whether data in a particular encoding can
  * generally be represented as 8-bit characters including ascii.
  */
@@ -486,11 +503,39 @@ typedef NSRange (*GSRSFunc)(id, id, unsigned, NSRange);
 GSRSFunc
 GSPrivateRangeOfString(NSString *receiver, NSString *target) GS_ATTRIB_PRIVATE;
 
+/* Function to return an immutable string using (without copying) the
+ * length bytes of ASCII characters at bytes, which must lie inside the
+ * immutable owner object.  The owner is retained for as long as the
+ * string exists.  Returns nil if the bytes are not all ASCII.
+ */
+NSString*
+GSPrivateStringWithOwnedBytes(id owner, const unsigned char *bytes,
+  NSUInteger length) GS_ATTRIB_PRIVATE;
+
+/* Function to write aPropertyList in binary format directly into dest,
+ * replacing its contents.  Used by NSKeyedArchiver to avoid building
+ * and then copying a separate data object.  Raises an exception if the
+ * property list cannot be written.
+ */
+void
+GSPrivateBinaryPropertyList(id aPropertyList, NSMutableData *dest)
+  GS_ATTRIB_PRIVATE;
+
 /* Function to return the hash value for a small integer (used by NSNumber).
  */
 unsigned
 GSPrivateSmallHash(int n) GS_ATTRIB_PRIVATE;
 
+/* Function to return the offset from GMT (in seconds) of the time zone at
+ * the given time (seconds since 1970).  If from and until are not NULL,
+ * they are set to the start and end of the range of times over which the
+ * offset is known not to change (an empty range when the zone can not
+ * tell us that cheaply), so that callers may cache the offset.
+ */
+NSInteger
+GSPrivateTimeZoneOffset(NSTimeZone *zone, NSTimeInterval when,
+  NSTimeInterval *from, NSTimeInterval *until) GS_ATTRIB_PRIVATE;
+
 /* Function to return the info dictionary of the bundle at the sepecified
  * path (the bundle of the current program if the path is nil) without
  * involving initialisation of NSBundle or NSUserDefaults.
@@ -512,12 +557,31 @@ void
 GSPrivateStrAppendUnichars(GSStr s, const unichar *u, unsigned l)
   GS_ATTRIB_PRIVATE;
 
+/* Function to append 8-bit characters to an GSStr.  The characters must
+ * be ASCII, or Latin-1 if that is the encoding of 8-bit strings (as for
+ * those returned by GSPrivateStrContents()), so each byte is the unicode
+ * character with that value.
+ */
+void
+GSPrivateStrAppendChars(GSStr s, const unsigned char *c, unsigned l)
+  GS_ATTRIB_PRIVATE;
+
 /* Replace bad UTF16 codepoints with the replacement character (0xFFFD)
  */
 void
 GSPrivateCleanUnichars(unichar *u, unsigned l)
   GS_ATTRIB_PRIVATE;
 
+/* Return the characters of an immutable concrete string for direct
+ * read-only access, or NULL if the string is of some other class.
+ * On return *wide says whether the characters are UTF-16 or Latin-1 bytes
+ * (in which case each byte is the unicode character with that value).
+ * The storage is only valid while the string is retained.
+ */
+const void *
+GSPrivateStrContents(NSString *s, NSUInteger *length, BOOL *wide)
+  GS_ATTRIB_PRIVATE;
+
 /* Make the content of this string into unicode if it is not in
  * the external defaults C string encoding.
  */
@@ -623,6 +687,47 @@ GSPrivateIsCollectable(const void *ptr) GS_ATTRIB_PRIVATE;
 NSZone*
 GSAtomicMallocZone (void);
 
+/* The size class allocator used by NSAllocateObject() for small objects
+ * (see NSZone.m).  GSPrivateMagazineSetUp() turns it on and must be called
+ * before any other of these functions.  GSPrivateMagazineClass() returns
+ * the size class for a block of the given size, or zero if the block is
+ * too big.  Blocks must be freed with the size class they were allocated
+ * with, but may be freed by any thread.
+ */
+void
+GSPrivateMagazineSetUp(void) GS_ATTRIB_PRIVATE;
+
+unsigned
+GSPrivateMagazineClass(size_t size) GS_ATTRIB_PRIVATE;
+
+void *
+GSPrivateMagazineMalloc(unsigned sizeClass) GS_ATTRIB_PRIVATE;
+
+void
+GSPrivateMagazineFree(void *ptr, unsigned sizeClass) GS_ATTRIB_PRIVATE;
+
+/* Return YES if zone was created by GSCreateArenaZone().
+ */
+BOOL
+GSPrivateIsArenaZone(NSZone *zone) GS_ATTRIB_PRIVATE;
+
+/* Return the zone most recently pushed by GSPushAllocationZone() in the
+ * current thread, or NULL if there is none.
+ */
+NSZone*
+GSPrivateScopedZone(void) GS_ATTRIB_PRIVATE;
+
+/* Return the number of separately allocated pieces in which the contents
+ * of data are held (one for most data objects, more for those made by
+ * +chunkedDataWithCapacity:), and store the addresses and lengths of up to
+ * max of them, starting with the piece at index first, in ptrs and lens.
+ * This lets the contents be written out without first being made
+ * contiguous.
+ */
+NSUInteger
+GSPrivateDataChunks(NSData *data, NSUInteger first,
+  const void **ptrs, NSUInteger *lens, NSUInteger max) GS_ATTRIB_PRIVATE;
+
 /* Generate a 32bit hash from supplied byte data.
  */
 uint32_t
@@ -675,6 +780,23 @@ void
 GSPrivateEncodeBase64(const uint8_t *src, NSUInteger length, uint8_t *dst)
   GS_ATTRIB_PRIVATE;
 
+/** Function to base64 encode groups * 3 bytes from src as groups * 4
+ * characters at dst, with no padding or line breaks.
+ */
+void
+GSPrivateEncodeBase64Groups(const uint8_t *src, NSUInteger groups,
+  uint8_t *dst) GS_ATTRIB_PRIVATE;
+
+/** Function to decode complete groups of four base64 characters from the
+ * start of the length bytes at src, stopping at the first character
+ * (padding, white space etc) which is not in the standard alphabet.
+ * Writes three bytes to dst for each group and returns the number of
+ * characters consumed (a multiple of four).
+ */
+NSUInteger
+GSPrivateDecodeBase64Groups(const uint8_t *src, NSUInteger length,
+  uint8_t *dst) GS_ATTRIB_PRIVATE;
+
 #ifndef OBJC_CAP_ARC
 /* When we don't have a runtime with ARC to support weak references, we
  * use our own version.
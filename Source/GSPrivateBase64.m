@@ -0,0 +1,428 @@
+/**
+   GSPrivateBase64.m
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep Base Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+   
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+   
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 31 Milk Street #960789 Boston, MA 02196 USA.
+*/ 
+
+#import "common.h"
+#import "GSPrivate.h"
+
+/* Base64 kernels shared by NSData and GSMime.  These work only on
+ * complete groups (three bytes of data, four characters of text); the
+ * callers deal with line breaks, padding and any characters outside the
+ * alphabet.  Where the compiler and CPU allow it, vector versions are
+ * selected at runtime.
+ */
+
+static const char	b64[]
+  = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* Maps each character to its six bit value, or 0xff if it is not part
+ * of the base64 alphabet.
+ */
+#define	XX	0xff
+static const uint8_t	d64[256] = {
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, 62, XX, XX, XX, 63,
+  52, 53, 54, 55, 56, 57, 58, 59, 60, 61, XX, XX, XX, XX, XX, XX,
+  XX,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+  15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, XX, XX, XX, XX, XX,
+  XX, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+  41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX
+};
+#undef	XX
+
+static NSUInteger
+encodeGroups(const uint8_t *src, NSUInteger groups, uint8_t *dst)
+{
+  NSUInteger	i;
+
+  for (i = 0; i < groups; i++)
+    {
+      uint32_t	v = (src[0] << 16) | (src[1] << 8) | src[2];
+
+      dst[0] = b64[v >> 18];
+      dst[1] = b64[(v >> 12) & 077];
+      dst[2] = b64[(v >> 6) & 077];
+      dst[3] = b64[v & 077];
+      src += 3;
+      dst += 4;
+    }
+  return groups;
+}
+
+static NSUInteger
+decodeGroups(const uint8_t *src, NSUInteger length, uint8_t *dst)
+{
+  const uint8_t	*start = src;
+  const uint8_t	*end = src + (length & ~(NSUInteger)3);
+
+  while (src < end)
+    {
+      uint32_t	a = d64[src[0]];
+      uint32_t	b = d64[src[1]];
+      uint32_t	c = d64[src[2]];
+      uint32_t	d = d64[src[3]];
+      uint32_t	v;
+
+      if ((a | b | c | d) & 0x80)
+	{
+	  break;	// Not in the alphabet
+	}
+      v = (a << 18) | (b << 12) | (c << 6) | d;
+      dst[0] = (uint8_t)(v >> 16);
+      dst[1] = (uint8_t)(v >> 8);
+      dst[2] = (uint8_t)v;
+      src += 4;
+      dst += 3;
+    }
+  return src - start;
+}
+
+#if	(defined(__x86_64__) || defined(__i386__)) \
+  && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define	GS_BASE64_X86	1
+#include <immintrin.h>
+
+/* The vector kernels follow the well known approach of Wojciech Muła
+ * and Daniel Lemire: bytes are shuffled into place and split into six
+ * bit fields with multiplies, then mapped to and from ASCII using small
+ * lookup tables indexed by pshufb.
+ */
+
+__attribute__((target("ssse3")))
+static inline __m128i
+enc_reshuffle128(__m128i in)
+{
+  __m128i	t0;
+  __m128i	t1;
+  __m128i	t2;
+  __m128i	t3;
+
+  in = _mm_shuffle_epi8(in, _mm_set_epi8(
+    10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+  t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+  t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+  t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+  t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+  return _mm_or_si128(t1, t3);
+}
+
+__attribute__((target("ssse3")))
+static inline __m128i
+enc_translate128(__m128i idx)
+{
+  const __m128i	lut = _mm_setr_epi8(
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+    '/' - 63, 'A', 0, 0);
+  __m128i	r;
+
+  r = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+  r = _mm_or_si128(r, _mm_and_si128(
+    _mm_cmpgt_epi8(_mm_set1_epi8(26), idx), _mm_set1_epi8(13)));
+  return _mm_add_epi8(_mm_shuffle_epi8(lut, r), idx);
+}
+
+__attribute__((target("ssse3")))
+static NSUInteger
+encodeGroupsSSSE3(const uint8_t *src, NSUInteger groups, uint8_t *dst)
+{
+  NSUInteger	i = 0;
+
+  /* Each step reads 16 bytes but encodes only the first 12.
+   */
+  while (i + 6 <= groups)
+    {
+      __m128i	in = _mm_loadu_si128((const __m128i*)(src + 3 * i));
+
+      _mm_storeu_si128((__m128i*)(dst + 4 * i),
+	enc_translate128(enc_reshuffle128(in)));
+      i += 4;
+    }
+  return i + encodeGroups(src + 3 * i, groups - i, dst + 4 * i);
+}
+
+/* Convert sixteen characters to their six bit values, setting *bad
+ * if any of them is not in the alphabet.
+ */
+__attribute__((target("ssse3")))
+static inline __m128i
+dec_translate128(__m128i in, int *bad)
+{
+  const __m128i	shiftLUT = _mm_setr_epi8(
+    0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i	maskLUT = _mm_setr_epi8(
+    (char)0xa8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8,
+    (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8,
+    (char)0xf0, 0x54, 0x50, 0x50, 0x50, 0x54);
+  const __m128i	bitLUT = _mm_setr_epi8(
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80,
+    0, 0, 0, 0, 0, 0, 0, 0);
+  __m128i	hi = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+  __m128i	lo = _mm_and_si128(in, _mm_set1_epi8(0x0f));
+  __m128i	slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+  __m128i	shift;
+  __m128i	m;
+
+  m = _mm_and_si128(_mm_shuffle_epi8(maskLUT, lo),
+    _mm_shuffle_epi8(bitLUT, hi));
+  *bad = _mm_movemask_epi8(_mm_cmpeq_epi8(m, _mm_setzero_si128()));
+  shift = _mm_shuffle_epi8(shiftLUT, hi);
+  shift = _mm_or_si128(_mm_andnot_si128(slash, shift),
+    _mm_and_si128(slash, _mm_set1_epi8(16)));
+  return _mm_add_epi8(in, shift);
+}
+
+/* Pack sixteen six bit values into twelve bytes at the start of the
+ * result.
+ */
+__attribute__((target("ssse3")))
+static inline __m128i
+dec_pack128(__m128i v)
+{
+  v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+  v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+  return _mm_shuffle_epi8(v, _mm_setr_epi8(
+    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+__attribute__((target("ssse3")))
+static NSUInteger
+decodeGroupsSSSE3(const uint8_t *src, NSUInteger length, uint8_t *dst)
+{
+  NSUInteger	i = 0;
+  NSUInteger	o = 0;
+
+  while (i + 16 <= length)
+    {
+      __m128i	v;
+      uint32_t	w;
+      int	bad;
+
+      v = dec_translate128(_mm_loadu_si128((const __m128i*)(src + i)), &bad);
+      if (bad)
+	{
+	  break;
+	}
+      v = dec_pack128(v);
+      _mm_storel_epi64((__m128i*)(dst + o), v);
+      w = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+      memcpy(dst + o + 8, &w, 4);
+      i += 16;
+      o += 12;
+    }
+  return i + decodeGroups(src + i, length - i, dst + o);
+}
+
+__attribute__((target("avx2")))
+static NSUInteger
+encodeGroupsAVX2(const uint8_t *src, NSUInteger groups, uint8_t *dst)
+{
+  const __m256i	shuf = _mm256_set_epi8(
+    10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+    10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+  const __m256i	lut = _mm256_setr_epi8(
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+    '/' - 63, 'A', 0, 0,
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+    '/' - 63, 'A', 0, 0);
+  NSUInteger	i = 0;
+
+  /* Each step encodes 24 bytes, reading 16 from each of two offsets
+   * twelve bytes apart.
+   */
+  while (i + 10 <= groups)
+    {
+      const uint8_t	*s = src + 3 * i;
+      __m256i		in;
+      __m256i		t0;
+      __m256i		t1;
+      __m256i		t2;
+      __m256i		t3;
+      __m256i		r;
+
+      in = _mm256_inserti128_si256(_mm256_castsi128_si256(
+	_mm_loadu_si128((const __m128i*)s)),
+	_mm_loadu_si128((const __m128i*)(s + 12)), 1);
+      in = _mm256_shuffle_epi8(in, shuf);
+      t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+      t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+      t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+      t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+      in = _mm256_or_si256(t1, t3);
+      r = _mm256_subs_epu8(in, _mm256_set1_epi8(51));
+      r = _mm256_or_si256(r, _mm256_and_si256(
+	_mm256_cmpgt_epi8(_mm256_set1_epi8(26), in), _mm256_set1_epi8(13)));
+      r = _mm256_add_epi8(_mm256_shuffle_epi8(lut, r), in);
+      _mm256_storeu_si256((__m256i*)(dst + 4 * i), r);
+      i += 8;
+    }
+  return i + encodeGroupsSSSE3(src + 3 * i, groups - i, dst + 4 * i);
+}
+
+__attribute__((target("avx2")))
+static NSUInteger
+decodeGroupsAVX2(const uint8_t *src, NSUInteger length, uint8_t *dst)
+{
+  const __m256i	shiftLUT = _mm256_setr_epi8(
+    0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i	maskLUT = _mm256_setr_epi8(
+    (char)0xa8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8,
+    (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8,
+    (char)0xf0, 0x54, 0x50, 0x50, 0x50, 0x54,
+    (char)0xa8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8,
+    (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8,
+    (char)0xf0, 0x54, 0x50, 0x50, 0x50, 0x54);
+  const __m256i	bitLUT = _mm256_setr_epi8(
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80,
+    0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i	pack = _mm256_setr_epi8(
+    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  NSUInteger	i = 0;
+  NSUInteger	o = 0;
+
+  while (i + 32 <= length)
+    {
+      __m256i	in = _mm256_loadu_si256((const __m256i*)(src + i));
+      __m256i	hi;
+      __m256i	lo;
+      __m256i	slash;
+      __m256i	shift;
+      __m256i	m;
+      __m128i	h;
+      uint32_t	w;
+
+      hi = _mm256_and_si256(_mm256_srli_epi32(in, 4), _mm256_set1_epi8(0x0f));
+      lo = _mm256_and_si256(in, _mm256_set1_epi8(0x0f));
+      m = _mm256_and_si256(_mm256_shuffle_epi8(maskLUT, lo),
+	_mm256_shuffle_epi8(bitLUT, hi));
+      if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(m, _mm256_setzero_si256())))
+	{
+	  break;
+	}
+      slash = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('/'));
+      shift = _mm256_blendv_epi8(_mm256_shuffle_epi8(shiftLUT, hi),
+	_mm256_set1_epi8(16), slash);
+      in = _mm256_add_epi8(in, shift);
+      in = _mm256_maddubs_epi16(in, _mm256_set1_epi32(0x01400140));
+      in = _mm256_madd_epi16(in, _mm256_set1_epi32(0x00011000));
+      in = _mm256_shuffle_epi8(in, pack);
+      h = _mm256_castsi256_si128(in);
+      _mm_storel_epi64((__m128i*)(dst + o), h);
+      w = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(h, 8));
+      memcpy(dst + o + 8, &w, 4);
+      h = _mm256_extracti128_si256(in, 1);
+      _mm_storel_epi64((__m128i*)(dst + o + 12), h);
+      w = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(h, 8));
+      memcpy(dst + o + 20, &w, 4);
+      i += 32;
+      o += 24;
+    }
+  return i + decodeGroupsSSSE3(src + i, length - i, dst + o);
+}
+#endif	/* GS_BASE64_X86 */
+
+typedef NSUInteger (*GSBase64Kernel)(const uint8_t*, NSUInteger, uint8_t*);
+
+static GSBase64Kernel	encodeKernel = 0;
+static GSBase64Kernel	decodeKernel = 0;
+
+/* Select the fastest kernels the CPU we are running on supports.
+ */
+static void
+selectKernels(void)
+{
+  GSBase64Kernel	enc = encodeGroups;
+  GSBase64Kernel	dec = decodeGroups;
+
+#if	defined(GS_BASE64_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    {
+      enc = encodeGroupsAVX2;
+      dec = decodeGroupsAVX2;
+    }
+  else if (__builtin_cpu_supports("ssse3"))
+    {
+      enc = encodeGroupsSSSE3;
+      dec = decodeGroupsSSSE3;
+    }
+#endif
+  decodeKernel = dec;
+  encodeKernel = enc;
+}
+
+void
+GSPrivateEncodeBase64Groups(const uint8_t *src, NSUInteger groups,
+  uint8_t *dst)
+{
+  if (0 == encodeKernel)
+    {
+      selectKernels();
+    }
+  (*encodeKernel)(src, groups, dst);
+}
+
+NSUInteger
+GSPrivateDecodeBase64Groups(const uint8_t *src, NSUInteger length,
+  uint8_t *dst)
+{
+  if (0 == decodeKernel)
+    {
+      selectKernels();
+    }
+  return (*decodeKernel)(src, length, dst);
+}
+
+void
+GSPrivateEncodeBase64(const uint8_t *src, NSUInteger length, uint8_t *dst)
+{
+  NSUInteger	groups = length / 3;
+  NSUInteger	rem = length - 3 * groups;
+
+  GSPrivateEncodeBase64Groups(src, groups, dst);
+  if (rem > 0)
+    {
+      uint8_t	tail[3] = { 0, 0, 0 };
+
+      memcpy(tail, src + 3 * groups, rem);
+      encodeGroups(tail, 1, dst + 4 * groups);
+      dst[4 * groups + 3] = '=';
+      if (1 == rem)
+	{
+	  dst[4 * groups + 2] = '=';
+	}
+    }
+}
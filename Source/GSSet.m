@@ -55,7 +55,9 @@ static SEL      privateCountOfSel;
   GSIMapTable_t	map;
 @private
   unsigned long	_version;
+  GSSet		*_shared;	// Immutable copy using our map
 }
+- (void) _unshare;
 @end
 
 @interface GSSetEnumerator : NSEnumerator
@@ -104,6 +106,7 @@ static SEL      privateCountOfSel;
 static Class	arrayClass;
 static Class	setClass;
 static Class	mutableSetClass;
+static IMP	setDealloc;	// -[GSSet dealloc]
 
 - (NSUInteger) sizeOfContentExcluding: (NSHashTable*)exclude
 {
@@ -559,6 +562,7 @@ static Class	mutableSetClass;
   if (self == [GSMutableSet class])
     {
       GSObjCAddClassBehavior(self, [GSSet class]);
+      setDealloc = [GSSet instanceMethodForSelector: @selector(dealloc)];
     }
 }
 
@@ -574,6 +578,10 @@ static Class	mutableSetClass;
   node = GSIMapNodeForKey(&map, (GSIMapKey)anObject);
   if (node == 0)
     {
+      if (nil != _shared)
+	{
+	  [self _unshare];
+	}
       GSIMapAddKey(&map, (GSIMapKey)anObject);
       _version++;
     }
@@ -599,6 +607,10 @@ static Class	mutableSetClass;
 	  node = GSIMapNodeForKey(&map, (GSIMapKey)anObject);
 	  if (node == 0)
 	    {
+	      if (nil != _shared)
+		{
+		  [self _unshare];
+		}
 	      GSIMapAddKey(&map, (GSIMapKey)anObject);
 	      _version++;
 	    }
@@ -609,9 +621,50 @@ static Class	mutableSetClass;
 /* Override _version from GSSet */
 - (id) copyWithZone: (NSZone*)z
 {
-  NSSet	*copy = [setClass allocWithZone: z];
+  GSSet	*copy;
+  GSSet	*expected = nil;
 
-  return [copy initWithSet: self copyItems: NO];
+  copy = __atomic_load_n(&_shared, __ATOMIC_ACQUIRE);
+  if (nil != copy)
+    {
+      return RETAIN(copy);	// Unchanged since the last copy.
+    }
+  if (0 == map.nodeCount)
+    {
+      copy = [setClass allocWithZone: z];
+      return [copy initWithSet: self copyItems: NO];
+    }
+  /* The copy takes over our map, and we keep using it until the next
+   * change (see -_unshare), so a copy costs O(1) and repeated copies of
+   * an unchanged set are the same object.
+   * Copies may be made in several threads at once, so the map goes to
+   * the one installed in _shared, and a thread losing that race returns
+   * the winner instead.
+   */
+  copy = (GSSet*)NSAllocateObject(setClass, 0, z);
+  copy->map = map;
+  RETAIN(copy);
+  if (NO == __atomic_compare_exchange_n(&_shared, &expected, copy, NO,
+    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+      memset(&copy->map, '\0', sizeof(copy->map));
+      RELEASE(copy);
+      RELEASE(copy);
+      return RETAIN(expected);
+    }
+  return copy;
+}
+
+- (void) dealloc
+{
+  if (nil != _shared)
+    {
+      /* The copy owns the map, so forget it before anything can empty it.
+       */
+      memset(&map, '\0', sizeof(map));
+      DESTROY(_shared);
+    }
+  (*setDealloc)(self, _cmd);
 }
 
 - (id) init
@@ -656,6 +709,10 @@ static Class	mutableSetClass;
 
 - (void) intersectSet: (NSSet*)other
 {
+  if (nil != _shared)
+    {
+      [self _unshare];
+    }
   if (nil == other)
     {
       GSIMapCleanMap(&map);
@@ -729,18 +786,30 @@ static Class	mutableSetClass;
 
 - (BOOL) makeImmutable
 {
+  if (nil != _shared)
+    {
+      [self _unshare];
+    }
   GSClassSwizzle(self, [GSSet class]);
   return YES;
 }
 
 - (id) makeImmutableCopyOnFail: (BOOL)force
 {
+  if (nil != _shared)
+    {
+      [self _unshare];
+    }
   GSClassSwizzle(self, [GSSet class]);
   return self;
 }
 
 - (void) minusSet: (NSSet*) other
 {
+  if (nil != _shared)
+    {
+      [self _unshare];
+    }
   if (other == self)
     {
       GSIMapCleanMap(&map);
@@ -758,9 +827,28 @@ static Class	mutableSetClass;
     }
 }
 
+- (NSEnumerator*) objectEnumerator
+{
+  NSSet	*s = (nil == _shared) ? (NSSet*)self : _shared;
+
+  return AUTORELEASE([[GSSetEnumerator alloc] initWithSet: s]);
+}
+
 - (void) removeAllObjects
 {
-  GSIMapCleanMap(&map);
+  if (nil != _shared)
+    {
+      NSZone	*z = map.zone;
+
+      /* Nothing to keep, so just leave the map with the copy.
+       */
+      DESTROY(_shared);
+      GSIMapInitWithZoneAndCapacity(&map, z, 0);
+    }
+  else
+    {
+      GSIMapCleanMap(&map);
+    }
 }
 
 - (void) removeObject: (id)anObject
@@ -770,6 +858,10 @@ static Class	mutableSetClass;
       NSWarnMLog(@"attempt to remove nil object");
       return;
     }
+  if (nil != _shared)
+    {
+      [self _unshare];
+    }
   GSIMapRemoveKey(&map, (GSIMapKey)anObject);
   _version++;
 }
@@ -793,6 +885,10 @@ static Class	mutableSetClass;
 	      node = GSIMapNodeForKey(&map, (GSIMapKey)anObject);
 	      if (node == 0)
 		{
+		  if (nil != _shared)
+		    {
+		      [self _unshare];
+		    }
 		  GSIMapAddKey(&map, (GSIMapKey)anObject);
 		  _version++;
 		}
@@ -809,6 +905,28 @@ static Class	mutableSetClass;
   return GSIMapCountByEnumeratingWithStateObjectsCount
     (&map, state, stackbuf, len);
 }
+
+- (void) _unshare
+{
+  if (nil != _shared)
+    {
+      GSIMapEnumerator_t	enumerator;
+      GSIMapNode		node;
+
+      /* Leave the map with the immutable copy and build our own.
+       */
+      GSIMapInitWithZoneAndCapacity(&map, _shared->map.zone,
+	_shared->map.nodeCount);
+      enumerator = GSIMapEnumeratorForMap(&_shared->map);
+      while ((node = GSIMapEnumeratorNextNode(&enumerator)) != 0)
+	{
+	  IF_NO_ARC(RETAIN(node->key.obj);)
+	  GSIMapAddKeyNoRetain(&map, node->key);
+	}
+      GSIMapEndEnumerator(&enumerator);
+      DESTROY(_shared);
+    }
+}
 @end
 
 @interface	NSGSet : NSSet
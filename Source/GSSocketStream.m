@@ -690,6 +690,7 @@ static NSArray  *keys = nil;
         GSTLSRemoteHosts,
         GSTLSRevokeFile,
         GSTLSServerName,
+        GSTLSSessionCacheKey,
         GSTLSVerify,
         nil];
       [[NSObject leakAt: &keys] release];
@@ -880,7 +881,21 @@ static NSArray  *keys = nil;
 		 withSecurityLevel: str
 		   fromInputStream: i
 		    orOutputStream: o];
-  
+
+  /* Let a client resume an earlier session with the same remote end.
+   */
+  if (NO == server && nil == [opts objectForKey: GSTLSSessionCacheKey])
+    {
+      NSString	*a = [i propertyForKey: GSStreamRemoteAddressKey];
+      NSString	*p = [i propertyForKey: GSStreamRemotePortKey];
+
+      if (nil != a && nil != p)
+	{
+	  [opts setObject: [NSString stringWithFormat: @"%@:%@", a, p]
+		   forKey: GSTLSSessionCacheKey];
+	}
+    }
+
   session = [[GSTLSSession alloc] initWithOptions: opts
                                         direction: (server ? NO : YES)
                                         transport: (void*)self
@@ -1823,6 +1838,12 @@ setNonBlocking(SOCKET fd)
 	      result = [NSString stringWithFormat: @"%d",
 		(int)GSPrivateSockaddrPort((struct sockaddr*)&sin)];
 	    }
+	  else
+	    {
+	      // Assume we are not yet connected.
+	      result = [NSString stringWithFormat: @"%d",
+		(int)GSPrivateSockaddrPort((struct sockaddr*)&_address)];
+	    }
 	}
     }
   return result;
@@ -587,6 +587,19 @@ instance.
 }
 @end
 
+
+/*
+GSCDataString, a concrete subclass that uses 8-bit data held by another
+(immutable) object such as an NSData instance, and retains that object
+for as long as the string exists.
+*/
+@interface GSCDataString : GSCString
+{
+@public
+  id		_owner;
+}
+@end
+
 /*
  *	Include sequence handling code with instructions to generate search
  *	and compare functions for NSString objects.
@@ -639,6 +652,7 @@ static Class GSCStringClass = 0;
 static Class GSCBufferStringClass = 0;
 static Class GSCInlineStringClass = 0;
 static Class GSCSubStringClass = 0;
+static Class GSCDataStringClass = 0;
 static Class GSUnicodeStringClass = 0;
 static Class GSUnicodeBufferStringClass = 0;
 static Class GSUnicodeSubStringClass = 0;
@@ -697,6 +711,7 @@ setup(BOOL rerun)
       GSCInlineStringClass = [GSCInlineString class];
       GSUInlineStringClass = [GSUInlineString class];
       GSCSubStringClass = [GSCSubString class];
+      GSCDataStringClass = [GSCDataString class];
       GSUnicodeSubStringClass = [GSUnicodeSubString class];
       GSMutableStringClass = [GSMutableString class];
       NSConstantStringClass = [NXConstantString class];
@@ -1608,31 +1623,16 @@ fixBOM(unsigned char **bytes, NSUInteger*length, BOOL *owned,
 {
   GSStr		f;
   unsigned char	buf[2048];
-  unichar	fbuf[1024];
-  unichar	*fmt = fbuf;
-  size_t	len;
   GSStr		me;
 
   if (NULL == format)
     [NSException raise: NSInvalidArgumentException
       format: @"[GSPlaceholderString-initWithFormat:locale:arguments:]: NULL format"];
-  /*
-   * First we provide an array of unichar characters containing the
-   * format string.  For performance reasons we try to use an on-stack
-   * buffer if the format string is small enough ... it almost always
-   * will be.
-   */
-  len = [format length];
-  if (len >= 1024)
-    {
-      fmt = NSZoneMalloc(NSDefaultMallocZone(), (len+1)*sizeof(unichar));
-    }
-  [format getCharacters: fmt];
-  fmt[len] = '\0';
 
   /*
-   * Now set up 'f' as a GSMutableString object whose initial buffer is
-   * allocated on the stack.  The GSPrivateFormat function can write into it.
+   * Set up 'f' as a GSMutableString object whose initial buffer is
+   * allocated on the stack.  The GSPrivateFormatString function can
+   * write into it, and leaves it 8-bit unless some character needs more.
    */
   f = (GSStr)alloca(class_getInstanceSize(GSMutableStringClass));
   object_setClass(f, GSMutableStringClass);
@@ -1642,11 +1642,7 @@ fixBOM(unsigned char **bytes, NSUInteger*length, BOOL *owned,
   f->_count = 0;
   f->_flags.wide = 0;
   f->_flags.owned = 0;
-  GSPrivateFormat(f, fmt, argList, locale);
-  if (fmt != fbuf)
-    {
-      NSZoneFree(NSDefaultMallocZone(), fmt);
-    }
+  GSPrivateFormatString(f, format, argList, locale);
 
   /*
    * Don't use noCopy because f->_contents.u may be memory on the stack,
@@ -3351,6 +3347,44 @@ rangeOfCharacter_u(GSStr self, NSCharacterSet *aSet, unsigned mask,
   return range;
 }
 
+NSString*
+GSPrivateStringWithOwnedBytes(id owner, const unsigned char *bytes,
+  NSUInteger length)
+{
+  GSCDataString	*me;
+  NSUInteger	i;
+  id		tiny;
+
+  if (length == 0)
+    {
+      return @"";
+    }
+  if (length > UINT_MAX)
+    {
+      return nil;
+    }
+  for (i = 0; i < length; i++)
+    {
+      if (bytes[i] > 127)
+	{
+	  return nil;
+	}
+    }
+  if ((tiny = createTinyString((const char*)bytes, (int)length)) != nil)
+    {
+      return tiny;
+    }
+  setup(NO);
+  me = (GSCDataString*)NSAllocateObject(GSCDataStringClass,
+    0, NSDefaultMallocZone());
+  me->_contents.c = (unsigned char*)bytes;
+  me->_count = (unsigned int)length;
+  me->_flags.wide = 0;
+  me->_flags.owned = 0;
+  me->_owner = RETAIN(owner);
+  return AUTORELEASE((id)me);
+}
+
 GSRSFunc
 GSPrivateRangeOfString(NSString *receiver, NSString *target)
 {
@@ -3975,6 +4009,41 @@ agree, create a new GSCInlineString otherwise.
 
 
 
+@implementation	GSCDataString
+
+/*
+ * The owner of the characters is immutable, so a copy may simply retain
+ * the receiver.
+ */
+- (id) copyWithZone: (NSZone*)z
+{
+  if (NSShouldRetainWithZone(self, z) == NO)
+    {
+      GSCInlineString	*o;
+
+      o = newCInline(_count, z);
+      memcpy(o->_contents.c, _contents.c, _count);
+      return (id)o;
+    }
+  return RETAIN(self);
+}
+
+- (void) dealloc
+{
+  _contents.c = 0;
+  DESTROY(_owner);
+  [super dealloc];
+}
+
+- (NSUInteger) sizeOfContentExcluding: (NSHashTable*)exclude
+{
+  return 0;	// The characters belong to the owner
+}
+
+@end
+
+
+
 @implementation	GSCSubString
 
 /*
@@ -4450,26 +4519,9 @@ agree, create a new GSUInlineString otherwise.
 - (void) appendFormat: (NSString*)format, ...
 {
   va_list	ap;
-  unichar	buf[1024];
-  unichar	*fmt = buf;
-  size_t	len;
 
   va_start(ap, format);
 
-  /*
-   * Make sure we have the format string in a nul terminated array of
-   * unichars for passing to GSPrivateFormat.  Use on-stack memory for
-   * performance unless the size of the format string is really big
-   * (a rare occurrence).
-   */
-  len = [format length];
-  if (len >= 1024)
-    {
-      fmt = NSZoneMalloc(NSDefaultMallocZone(), (len+1)*sizeof(unichar));
-    }
-  [format getCharacters: fmt];
-  fmt[len] = '\0';
-
   /*
    * If no zone is set, make sure we have one so any memory mangement
    * (buffer growth) is done with the correct zone.
@@ -4478,12 +4530,8 @@ agree, create a new GSUInlineString otherwise.
     {
       _zone = [self zone];
     }
-  GSPrivateFormat((GSStr)self, fmt, ap, nil);
+  GSPrivateFormatString((GSStr)self, format, ap, nil);
   _flags.hash = 0;	// Invalidate the hash for this string.
-  if (fmt != buf)
-    {
-      NSZoneFree(NSDefaultMallocZone(), fmt);
-    }
   va_end(ap);
 }
 
@@ -4929,32 +4977,10 @@ NSAssert(_flags.owned == 1 && _zone != 0, NSInternalInconsistencyException);
                locale: (NSDictionary*)locale
 	    arguments: (va_list)argList
 {
-  unichar	fbuf[1024];
-  unichar	*fmt = fbuf;
-  size_t	len;
-
   if (NULL == format)
     [NSException raise: NSInvalidArgumentException
       format: @"[GSMutableString-initWithFormat:locale:arguments:]: NULL format"];
-  /*
-   * First we provide an array of unichar characters containing the
-   * format string.  For performance reasons we try to use an on-stack
-   * buffer if the format string is small enough ... it almost always
-   * will be.
-   */
-  len = [format length];
-  if (len >= 1024)
-    {
-      fmt = NSZoneMalloc(NSDefaultMallocZone(), (len+1)*sizeof(unichar));
-    }
-  [format getCharacters: fmt];
-  fmt[len] = '\0';
-
-  GSPrivateFormat((GSStr)self, fmt, argList, locale);
-  if (fmt != fbuf)
-    {
-      NSZoneFree(NSDefaultMallocZone(), fmt);
-    }
+  GSPrivateFormatString((GSStr)self, format, argList, locale);
   return self;
 }
 
@@ -5485,6 +5511,348 @@ NSAssert(_flags.owned == 1 && _zone != 0, NSInternalInconsistencyException);
 
 @end
 
+/*
+ * GSChunkedString - mutable string for building up by appending.  The
+ * contents are kept as UTF-8 in a chunked data object, so an append never
+ * copies the existing contents or widens them to 16-bit characters.
+ * Reading characters uses a flat immutable copy made on demand, and any
+ * change other than an append is made to a flat copy which then replaces
+ * the contents.
+ */
+@interface GSChunkedString : NSMutableString
+{
+  NSMutableData	*_utf8;		// Contents as UTF-8 in chunks
+  NSString	*_flat;		// Copy for reading, made on demand
+  NSUInteger	_length;	// Length in 16-bit characters
+  BOOL		_ascii;		// YES while all characters are ASCII
+}
+- (NSString*) _flatString;
+@end
+
+/* Encode n UTF-16 characters as UTF-8 in buf (which must have space for
+ * 3 bytes per character) and return the number of bytes used.  A lone
+ * surrogate becomes U+FFFD so the length in characters is unchanged.
+ */
+static NSUInteger
+chunkedEncode(const unichar *u, NSUInteger n, uint8_t *buf)
+{
+  uint8_t	*p = buf;
+  NSUInteger	i;
+
+  for (i = 0; i < n; i++)
+    {
+      uint32_t	c = u[i];
+
+      if (c < 0x80)
+	{
+	  *p++ = c;
+	}
+      else if (c < 0x800)
+	{
+	  *p++ = 0xC0 | (c >> 6);
+	  *p++ = 0x80 | (c & 0x3F);
+	}
+      else
+	{
+	  if (c >= 0xD800 && c < 0xE000)
+	    {
+	      if (c < 0xDC00 && i + 1 < n
+		&& u[i + 1] >= 0xDC00 && u[i + 1] < 0xE000)
+		{
+		  c = 0x10000 + ((c - 0xD800) << 10) + (u[++i] - 0xDC00);
+		  *p++ = 0xF0 | (c >> 18);
+		  *p++ = 0x80 | ((c >> 12) & 0x3F);
+		  *p++ = 0x80 | ((c >> 6) & 0x3F);
+		  *p++ = 0x80 | (c & 0x3F);
+		  continue;
+		}
+	      c = 0xFFFD;
+	    }
+	  *p++ = 0xE0 | (c >> 12);
+	  *p++ = 0x80 | ((c >> 6) & 0x3F);
+	  *p++ = 0x80 | (c & 0x3F);
+	}
+    }
+  return p - buf;
+}
+
+@implementation GSChunkedString
+
++ (void) initialize
+{
+  setup(NO);
+}
+
+- (void) appendString: (NSString*)aString
+{
+  NSUInteger	len = [aString length];
+  unichar	u[256];
+  uint8_t	b[256 * 3];
+  NSUInteger	pos = 0;
+  Class		c;
+
+  if (len == 0)
+    {
+      return;
+    }
+  c = object_getClass(aString);
+  if ((c == GSMutableStringClass || GSObjCIsKindOf(c, GSStringClass) == YES)
+    && ((GSStr)aString)->_flags.wide == 0)
+    {
+      const unsigned char	*p = ((GSStr)aString)->_contents.c;
+
+      /* ASCII is the same in the internal encoding and in UTF-8, so
+       * it can be appended as it is.
+       */
+      while (pos < len && p[pos] < 0x80)
+	{
+	  pos++;
+	}
+      if (pos == len)
+	{
+	  [_utf8 appendBytes: p length: len];
+	  _length += len;
+	  DESTROY(_flat);
+	  return;
+	}
+      pos = 0;
+    }
+#ifndef GNUSTEP_NEW_STRING_ABI
+  else if (c == NSConstantStringClass)
+    {
+      NXConstantString	*l = (NXConstantString*)aString;
+
+      /* A literal string is already UTF-8.
+       */
+      [_utf8 appendBytes: l->nxcsptr length: l->nxcslen];
+      if (l->nxcslen != len)
+	{
+	  _ascii = NO;
+	}
+      _length += len;
+      DESTROY(_flat);
+      return;
+    }
+#endif
+
+  /* The characters are fetched before anything is appended, and _flat
+   * is kept until the end, so aString may be the receiver.
+   */
+  while (pos < len)
+    {
+      NSUInteger	n = len - pos;
+      NSUInteger	l;
+
+      if (n > 256)
+	{
+	  n = 256;
+	}
+      [aString getCharacters: u range: NSMakeRange(pos, n)];
+      if (pos + n < len && u[n - 1] >= 0xD800 && u[n - 1] < 0xDC00)
+	{
+	  n--;		// Don't split a surrogate pair between batches.
+	}
+      l = chunkedEncode(u, n, b);
+      if (l != n)
+	{
+	  _ascii = NO;
+	}
+      [_utf8 appendBytes: b length: l];
+      pos += n;
+    }
+  _length += len;
+  DESTROY(_flat);
+}
+
+- (unichar) characterAtIndex: (NSUInteger)index
+{
+  return [[self _flatString] characterAtIndex: index];
+}
+
+- (id) copyWithZone: (NSZone*)z
+{
+  return [[self _flatString] copyWithZone: z];
+}
+
+- (const char*) cStringUsingEncoding: (NSStringEncoding)encoding
+{
+  if (NSUTF8StringEncoding == encoding
+    || (YES == _ascii && GSPrivateIsByteEncoding(encoding) == YES))
+    {
+      return [self UTF8String];
+    }
+  return [[self _flatString] cStringUsingEncoding: encoding];
+}
+
+- (NSData*) dataUsingEncoding: (NSStringEncoding)encoding
+	 allowLossyConversion: (BOOL)flag
+{
+  if (NSUTF8StringEncoding == encoding
+    || (YES == _ascii && GSPrivateIsByteEncoding(encoding) == YES))
+    {
+      return AUTORELEASE([_utf8 copy]);
+    }
+  return [[self _flatString] dataUsingEncoding: encoding
+			  allowLossyConversion: flag];
+}
+
+- (void) dealloc
+{
+  DESTROY(_utf8);
+  DESTROY(_flat);
+  [super dealloc];
+}
+
+- (void) getCharacters: (unichar*)buffer range: (NSRange)aRange
+{
+  [[self _flatString] getCharacters: buffer range: aRange];
+}
+
+- (id) init
+{
+  return [self initWithCapacity: 0];
+}
+
+- (id) initWithBytesNoCopy: (void*)bytes
+		    length: (NSUInteger)length
+		  encoding: (NSStringEncoding)encoding
+	      freeWhenDone: (BOOL)flag
+{
+  NSString	*s;
+
+  s = [[NSStringClass allocWithZone: NSDefaultMallocZone()]
+    initWithBytesNoCopy: bytes
+		 length: length
+	       encoding: encoding
+	   freeWhenDone: flag];
+  if (nil == s)
+    {
+      DESTROY(self);
+      return nil;
+    }
+  self = [self initWithCapacity: length];
+  [self appendString: s];
+  RELEASE(s);
+  return self;
+}
+
+- (id) initWithCapacity: (NSUInteger)capacity
+{
+  _utf8 = RETAIN([NSMutableData chunkedDataWithCapacity: capacity]);
+  _ascii = YES;
+  return self;
+}
+
+- (id) initWithCharactersNoCopy: (unichar*)chars
+			 length: (NSUInteger)length
+		   freeWhenDone: (BOOL)flag
+{
+  NSString	*s;
+
+  s = [[NSStringClass allocWithZone: NSDefaultMallocZone()]
+    initWithCharactersNoCopy: chars length: length freeWhenDone: flag];
+  self = [self initWithCapacity: length];
+  [self appendString: s];
+  RELEASE(s);
+  return self;
+}
+
+- (NSUInteger) length
+{
+  return _length;
+}
+
+- (NSUInteger) lengthOfBytesUsingEncoding: (NSStringEncoding)encoding
+{
+  if (NSUTF8StringEncoding == encoding)
+    {
+      return [_utf8 length];
+    }
+  return [super lengthOfBytesUsingEncoding: encoding];
+}
+
+- (void) replaceCharactersInRange: (NSRange)aRange
+		       withString: (NSString*)aString
+{
+  NSMutableString	*m;
+
+  if (aRange.location == _length && aRange.length == 0)
+    {
+      [self appendString: aString];
+      return;
+    }
+  GS_RANGE_CHECK(aRange, _length);
+  m = [[self _flatString] mutableCopy];
+  [m replaceCharactersInRange: aRange withString: aString];
+  [self setString: m];
+  RELEASE(m);
+}
+
+- (void) setString: (NSString*)aString
+{
+  if (aString != (NSString*)self)
+    {
+      RETAIN(aString);	// In case it is our _flat copy
+      [_utf8 setLength: 0];
+      _length = 0;
+      _ascii = YES;
+      DESTROY(_flat);
+      [self appendString: aString];
+      RELEASE(aString);
+    }
+}
+
+- (NSUInteger) sizeInBytesExcluding: (NSHashTable*)exclude
+{
+  NSUInteger    size = GSPrivateMemorySize(self, exclude);
+
+  if (size > 0)
+    {
+      size += [_utf8 capacity];
+    }
+  return size;
+}
+
+- (const char*) UTF8String
+{
+  NSUInteger	l = [_utf8 length];
+  char		*r = (char*)GSAutoreleasedBuffer(l + 1);
+
+  [_utf8 getBytes: r range: NSMakeRange(0, l)];
+  r[l] = '\0';
+  return r;
+}
+
+/* Return an immutable copy of the contents, made the first time it is
+ * needed after each change.
+ */
+- (NSString*) _flatString
+{
+  if (nil == _flat)
+    {
+      _flat = [[NSStringClass allocWithZone: NSDefaultMallocZone()]
+	initWithBytes: [_utf8 bytes]
+	       length: [_utf8 length]
+	     encoding: (_ascii ? NSASCIIStringEncoding : NSUTF8StringEncoding)];
+    }
+  return _flat;
+}
+
+@end
+
+/**
+ * GNUstep specific extensions to NSMutableString.
+ */
+@implementation NSMutableString (GNUstepExtensions)
+
++ (NSMutableString*) chunkedStringWithCapacity: (NSUInteger)capacity
+{
+  return AUTORELEASE([[GSChunkedString allocWithZone: NSDefaultMallocZone()]
+    initWithCapacity: capacity]);
+}
+
+@end
+
 
 
 #ifndef GNUSTEP_NEW_STRING_ABI
@@ -6285,6 +6653,55 @@ GSPrivateStrAppendUnichars(GSStr s, const unichar *u, unsigned l)
     }
 }
 
+/**
+ * Append 8-bit characters which need no conversion to a string.
+ */
+void
+GSPrivateStrAppendChars(GSStr s, const unsigned char *c, unsigned l)
+{
+  if (s->_count + l + 1 >= s->_capacity)
+    {
+      GSStrMakeSpace(s, l);
+    }
+  if (s->_flags.wide == 1)
+    {
+      unichar	*u = s->_contents.u + s->_count;
+      unsigned	i;
+
+      for (i = 0; i < l; i++)
+	{
+	  u[i] = c[i];
+	}
+    }
+  else
+    {
+      memcpy(s->_contents.c + s->_count, c, l);
+    }
+  s->_count += l;
+}
+
+
+const void *
+GSPrivateStrContents(NSString *s, NSUInteger *length, BOOL *wide)
+{
+  Class	c = object_getClass(s);
+
+  if (GSObjCIsKindOf(c, GSUnicodeStringClass) == YES)
+    {
+      *length = ((GSStr)s)->_count;
+      *wide = YES;
+      return ((GSStr)s)->_contents.u;
+    }
+  if (GSObjCIsKindOf(c, GSCStringClass) == YES
+    && (internalEncoding == NSISOLatin1StringEncoding
+      || internalEncoding == NSASCIIStringEncoding))
+    {
+      *length = ((GSStr)s)->_count;
+      *wide = NO;
+      return ((GSStr)s)->_contents.c;
+    }
+  return NULL;
+}
 
 void
 GSPrivateStrExternalize(GSStr s)
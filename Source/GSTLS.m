@@ -31,6 +31,7 @@
 #import "Foundation/NSHost.h"
 #import "Foundation/NSException.h"
 #import "Foundation/NSLock.h"
+#import "Foundation/NSMapTable.h"
 #import "Foundation/NSNotification.h"
 #import "Foundation/NSProcessInfo.h"
 #import "Foundation/NSStream.h"
@@ -1550,8 +1551,164 @@ retrieve_callback(gnutls_session_t session,
 }
 #endif
 
+/* The largest number of sessions remembered for resumption.
+ */
+#define	MAX_CACHED_SESSIONS	256
+
+/* Client side cache of session data, keyed by the GSTLSSessionCacheKey
+ * option along with the other options which must match for a session to
+ * be resumed.  The order array records the keys oldest first, so that the
+ * oldest session may be discarded when the cache is full.
+ */
+static NSLock                   *resumeLock = nil;
+static NSMutableDictionary      *resumeCache = nil;
+static NSMutableArray           *resumeOrder = nil;
+
+/* The cache key of each outgoing session which may be resumed, kept here
+ * rather than in an instance variable so that the public layout of the
+ * class is unchanged.  Protected by resumeLock.
+ */
+static NSMapTable               *resumeKeys = 0;
+
+#if GNUTLS_VERSION_NUMBER >= 0x020C00
+/* Parsed priority strings, so that each session can use a cached priority
+ * rather than parsing the string every time.  These are never released.
+ */
+static NSLock                   *priorityLock = nil;
+static NSMutableDictionary      *priorityCache = nil;
+#endif
+
+#if GNUTLS_VERSION_NUMBER >= 0x020A00
+/* The key used to encrypt the session tickets we issue as a server.
+ */
+static gnutls_datum_t           ticketKey = { 0, 0 };
+#endif
+
+/* Set the priorities for a session from a priority string, parsing the
+ * string only the first time it is used.
+ */
+static int
+setPriority(gnutls_session_t session, const char *str, const char **err_pos)
+{
+#if GNUTLS_VERSION_NUMBER >= 0x020C00
+  NSString              *key = [NSString stringWithUTF8String: str];
+  NSValue               *v;
+  gnutls_priority_t     p;
+
+  [priorityLock lock];
+  if (nil == (v = [priorityCache objectForKey: key]))
+    {
+      int       ret = gnutls_priority_init(&p, str, err_pos);
+
+      if (ret < 0)
+        {
+          [priorityLock unlock];
+          return ret;
+        }
+      [priorityCache setObject: [NSValue valueWithPointer: p] forKey: key];
+    }
+  else
+    {
+      p = (gnutls_priority_t)[v pointerValue];
+    }
+  [priorityLock unlock];
+  return gnutls_priority_set(session, p);
+#else
+  return gnutls_priority_set_direct(session, str, err_pos);
+#endif
+}
+
+/* Remove and return the session data cached for key (each ticket should
+ * only be used once).
+ */
+static NSData *
+takeSessionData(NSString *key)
+{
+  NSData        *data;
+
+  [resumeLock lock];
+  data = [[resumeCache objectForKey: key] retain];
+  if (nil != data)
+    {
+      [resumeCache removeObjectForKey: key];
+      [resumeOrder removeObject: key];
+    }
+  [resumeLock unlock];
+  return [data autorelease];
+}
+
+static NSString *
+getResumeKey(GSTLSSession *s)
+{
+  NSString      *key;
+
+  [resumeLock lock];
+  key = [(NSString*)NSMapGet(resumeKeys, s) retain];
+  [resumeLock unlock];
+  return [key autorelease];
+}
+
+static void
+setResumeKey(GSTLSSession *s, NSString *key)
+{
+  [resumeLock lock];
+  if (nil == key)
+    {
+      NSMapRemove(resumeKeys, s);
+    }
+  else
+    {
+      NSMapInsert(resumeKeys, s, key);
+    }
+  [resumeLock unlock];
+}
+
+static void
+putSessionData(NSString *key, NSData *data)
+{
+  [resumeLock lock];
+  if (nil == [resumeCache objectForKey: key])
+    {
+      if ([resumeOrder count] >= MAX_CACHED_SESSIONS)
+        {
+          [resumeCache removeObjectForKey: [resumeOrder objectAtIndex: 0]];
+          [resumeOrder removeObjectAtIndex: 0];
+        }
+      [resumeOrder addObject: key];
+    }
+  [resumeCache setObject: data forKey: key];
+  [resumeLock unlock];
+}
+
 @implementation GSTLSSession
 
++ (void) initialize
+{
+  if ([GSTLSSession class] == self && nil == resumeLock)
+    {
+      resumeLock = [NSLock new];
+      resumeCache = [NSMutableDictionary new];
+      resumeOrder = [NSMutableArray new];
+      resumeKeys = NSCreateMapTable(NSNonOwnedPointerMapKeyCallBacks,
+        NSObjectMapValueCallBacks, 0);
+#if GNUTLS_VERSION_NUMBER >= 0x020C00
+      priorityLock = [NSLock new];
+      priorityCache = [NSMutableDictionary new];
+#endif
+#if GNUTLS_VERSION_NUMBER >= 0x020A00
+      gnutls_session_ticket_key_generate(&ticketKey);
+#endif
+    }
+}
+
++ (void) flushSessionCache
+{
+  [resumeLock lock];
+  [resumeCache removeAllObjects];
+  [resumeOrder removeAllObjects];
+  [resumeLock unlock];
+}
+
 + (GSTLSSession*) sessionWithOptions: (NSDictionary*)options
                            direction: (BOOL)isOutgoing
                            transport: (void*)ioHandle
@@ -1591,9 +1748,43 @@ retrieve_callback(gnutls_session_t session,
   DESTROY(problem);
   DESTROY(issuer);
   DESTROY(owner);
+  setResumeKey(self, nil);
   [super dealloc];
 }
 
+/* Remember the data for this session so that the next connection with
+ * the same cache key can resume it rather than performing a full handshake.
+ * With TLS 1.3 the data is only usable once the server has sent a ticket,
+ * which happens after the handshake, so this is called again before the
+ * session is shut down.
+ */
+- (void) _cacheSessionData
+{
+  gnutls_datum_t        data;
+  NSString              *resumeKey;
+
+  if (NO == active || nil == (resumeKey = getResumeKey(self)))
+    {
+      return;
+    }
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+  if (gnutls_protocol_get_version(session) == GNUTLS_TLS1_3
+    && 0 == (gnutls_session_get_flags(session) & GNUTLS_SFLAGS_SESSION_TICKET))
+    {
+      return;   // No ticket received yet
+    }
+#endif
+  if (gnutls_session_get_data2(session, &data) == GNUTLS_E_SUCCESS)
+    {
+      if (data.size > 0)
+        {
+          putSessionData(resumeKey,
+            [NSData dataWithBytes: data.data length: data.size]);
+        }
+      gnutls_free(data.data);
+    }
+}
+
 - (BOOL) debug
 {
   return debug;
@@ -1607,6 +1798,7 @@ retrieve_callback(gnutls_session_t session,
     {
       int	result;
 
+      [self _cacheSessionData];
       active = NO;
       handshake = NO;
       if (NO == reusable)
@@ -1747,6 +1939,15 @@ retrieve_callback(gnutls_session_t session,
       else
         {
           gnutls_init(&session, GNUTLS_SERVER);
+#if GNUTLS_VERSION_NUMBER >= 0x020A00
+          /* Issue session tickets so that clients can resume sessions
+           * without our keeping any state for them.
+           */
+          if (ticketKey.size > 0)
+            {
+              gnutls_session_ticket_enable_server(session, &ticketKey);
+            }
+#endif
           if (NO == verify)
             {
               /* We don't want to demand/verify the client certificate,
@@ -1864,8 +2065,7 @@ retrieve_callback(gnutls_session_t session,
                 0 };
               gnutls_protocol_set_priority(session, proto_prio);
 #else
-              gnutls_priority_set_direct(session,
-                "NORMAL:-VERS-TLS-ALL:+VERS-SSL3.0", NULL);
+              setPriority(session, "NORMAL:-VERS-TLS-ALL:+VERS-SSL3.0", NULL);
 #endif
               GSOnceMLog(@"NSStreamSocketSecurityLevelSSLv3 is insecure ..."
                 @" please change your code to stop using it");
@@ -1882,8 +2082,7 @@ retrieve_callback(gnutls_session_t session,
                 0 };
               gnutls_protocol_set_priority(session, proto_prio);
 #else
-              gnutls_priority_set_direct(session,
-                "NORMAL:-VERS-SSL3.0:+VERS-TLS-ALL", NULL);
+              setPriority(session, "NORMAL:-VERS-SSL3.0:+VERS-TLS-ALL", NULL);
 #endif
             }
           else
@@ -1894,7 +2093,7 @@ retrieve_callback(gnutls_session_t session,
               /* By default we disable SSL3.0 as the 'POODLE' attack (Oct 2014)
                * renders it insecure.
                */
-              gnutls_priority_set_direct(session, "NORMAL:-VERS-SSL3.0", NULL);
+              setPriority(session, "NORMAL:-VERS-SSL3.0", NULL);
 #endif
             }
         }
@@ -1907,11 +2106,11 @@ retrieve_callback(gnutls_session_t session,
 	   * renders it insecure.
 	   */
           const char *err_pos;
-          if (gnutls_priority_set_direct(session, [str UTF8String], &err_pos))
+          if (setPriority(session, [str UTF8String], &err_pos))
             {
               NSLog(@"Invalid GSTLSPriority: %s", err_pos);
               NSLog(@"Falling back to NORMAL:-VERS-SSL3.0");
-              gnutls_priority_set_direct(session, "NORMAL:-VERS-SSL3.0", NULL);
+              setPriority(session, "NORMAL:-VERS-SSL3.0", NULL);
             }
 #endif
         }
@@ -1943,6 +2142,37 @@ retrieve_callback(gnutls_session_t session,
       gnutls_transport_set_push_function(session, pushFunc);
       gnutls_transport_set_ptr(session, (gnutls_transport_ptr_t)ioHandle);
       gnutls_session_set_ptr(session, (void*)self);
+
+      /* Offer to resume an earlier session with the same remote end.
+       * Everything which affects the security of the session is part of
+       * the key, so a session is only resumed with the same settings.
+       */
+      str = [opts objectForKey: GSTLSSessionCacheKey];
+      if (YES == outgoing && [str length] > 0)
+        {
+          NSString      *resumeKey;
+          NSData        *data;
+
+          resumeKey = [NSString stringWithFormat:
+            @"%@|%@|%@|%@|%@|%@|%@|%@|%@|%@|%@|%@",
+            str, pri,
+            [opts objectForKey: GSTLSServerName],
+            [opts objectForKey: GSTLSPriority],
+            [opts objectForKey: GSTLSVerify],
+            [opts objectForKey: GSTLSRemoteHosts],
+            [opts objectForKey: GSTLSIssuers],
+            [opts objectForKey: GSTLSOwners],
+            [opts objectForKey: GSTLSCAFile],
+            [opts objectForKey: GSTLSRevokeFile],
+            [opts objectForKey: GSTLSCertificateFile],
+            [opts objectForKey: GSTLSCertificateKeyFile]];
+          setResumeKey(self, resumeKey);
+          data = takeSessionData(resumeKey);
+          if (nil != data)
+            {
+              gnutls_session_set_data(session, [data bytes], [data length]);
+            }
+        }
     }
 
   return self;
@@ -2061,6 +2291,7 @@ retrieve_callback(gnutls_session_t session,
             }
           if (requireVerified)
             {
+              setResumeKey(self, nil);  // Never resume an unverified session
               [self disconnect: NO];
             }
 	  else if (outgoing && nil == [opts objectForKey: GSTLSVerify])
@@ -2085,6 +2316,7 @@ retrieve_callback(gnutls_session_t session,
               NSLog(@"%p succeeded verify:\n%@", handle, [self sessionInfo]);
             }
         }
+      [self _cacheSessionData];
       return YES;       // Handshake complete
     }
 }
@@ -2094,6 +2326,15 @@ retrieve_callback(gnutls_session_t session,
   return issuer;
 }
 
+- (BOOL) resumed
+{
+  if (YES == active)
+    {
+      return gnutls_session_is_resumed(session) ? YES : NO;
+    }
+  return NO;
+}
+
 - (NSDictionary*) options
 {
   return opts;
@@ -52,6 +52,9 @@
 #import "GSPThread.h"
 #import "GSDispatch.h"
 #import "GSSorting.h"
+#if defined(__OBJC2__)
+#import "NSKeyValueCoding+Caching.h"
+#endif
 
 static BOOL GSMacOSXCompatiblePropertyLists(void)
 {
@@ -1520,6 +1523,28 @@ compare(id elem1, id elem2, void* context)
       NSUInteger	count = [self count];
       volatile id	object = nil;
 
+      if (null == nil)
+	{
+	  null = RETAIN([NSNull null]);
+	}
+#if defined(__OBJC2__)
+      if (count > 0)
+	{
+	  GS_BEGINIDBUF(values, count);
+
+	  count = valuesForKeyWithCaching(self, key, values);
+	  for (i = 0; i < count; i++)
+	    {
+	      if (values[i] == nil)
+		{
+		  values[i] = null;
+		}
+	    }
+	  results = [NSMutableArray arrayWithObjects: values count: count];
+	  GS_ENDIDBUF();
+	  return results;
+	}
+#endif
       results = [NSMutableArray arrayWithCapacity: count];
 
       for (i = 0; i < count; i++)
@@ -1530,10 +1555,6 @@ compare(id elem1, id elem2, void* context)
           result = [object valueForKey: key];
           if (result == nil)
             {
-              if (null == nil)
-		{
-		  null = RETAIN([NSNull null]);
-		}
               result = null;
             }
 
@@ -1577,6 +1598,9 @@ compare(id elem1, id elem2, void* context)
             }
           else if ([op isEqualToString: @"@avg"] == YES)
             {
+#if defined(__OBJC2__)
+              result = aggregateForKeyWithCaching(self, rem, GSKVCAvg);
+#else
               double        d = 0;
 
               if (count > 0)
@@ -1591,9 +1615,13 @@ compare(id elem1, id elem2, void* context)
                   d /= count;
                 }
               result = [NSNumber numberWithDouble: d];
+#endif
             }
           else if ([op isEqualToString: @"@max"] == YES)
             {
+#if defined(__OBJC2__)
+              result = aggregateForKeyWithCaching(self, rem, GSKVCMax);
+#else
               if (count > 0)
                 {
                   NSEnumerator  *e = [self objectEnumerator];
@@ -1609,9 +1637,13 @@ compare(id elem1, id elem2, void* context)
                         }
                     }
                 }
+#endif
             }
           else if ([op isEqualToString: @"@min"] == YES)
             {
+#if defined(__OBJC2__)
+              result = aggregateForKeyWithCaching(self, rem, GSKVCMin);
+#else
               if (count > 0)
                 {
                   NSEnumerator  *e = [self objectEnumerator];
@@ -1627,9 +1659,13 @@ compare(id elem1, id elem2, void* context)
                         }
                     }
                 }
+#endif
             }
           else if ([op isEqualToString: @"@sum"] == YES)
             {
+#if defined(__OBJC2__)
+              result = aggregateForKeyWithCaching(self, rem, GSKVCSum);
+#else
               double        d = 0;
 
               if (count > 0)
@@ -1643,6 +1679,7 @@ compare(id elem1, id elem2, void* context)
                     }
                 }
               result = [NSNumber numberWithDouble: d];
+#endif
             }
           else if ([op isEqualToString: @"@distinctUnionOfArrays"] == YES)
             {
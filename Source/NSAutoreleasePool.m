@@ -417,7 +417,10 @@ pop_pool_from_cache(struct autorelease_thread_vars *tv)
         }
       return p;
     }
-  p = (NSAutoreleasePool*)NSAllocateObject (self, 0, zone);
+  /* Pools are cached for reuse by the thread, so they must outlive any
+   * zone pushed by GSPushAllocationZone().
+   */
+  p = (NSAutoreleasePool*)NSAllocateObject (self, 0, NSDefaultMallocZone());
 
 #if	LOG_LIFETIME
   fprintf(stderr, "*** %p autorelease pool allocated in %p\n",
@@ -55,6 +55,8 @@
   GSIMapTable		_localTargets; \
   GSIMapTable		_remoteProxies; \
   GSIMapTable		_replyMap; \
+  GSIMapTable		_replyWaiters; \
+  GSIMapTable		_replyFutures; \
   NSTimeInterval	_replyTimeout; \
   NSTimeInterval	_requestTimeout; \
   NSMutableArray	*_requestModes; \
@@ -70,6 +72,7 @@
   int			_lastKeepalive
 
 #define	EXPOSE_NSDistantObject_IVARS	1
+#define	EXPOSE_GSDistantFuture_IVARS	1
 
 #ifdef HAVE_MALLOC_H
 #if !defined(__OpenBSD__)
@@ -297,6 +300,8 @@ GS_PRIVATE_INTERNAL(NSConnection)
 #define	IlocalTargets		(internal->_localTargets)
 #define	IremoteProxies		(internal->_remoteProxies)
 #define	IreplyMap		(internal->_replyMap)
+#define	IreplyWaiters		(internal->_replyWaiters)
+#define	IreplyFutures		(internal->_replyFutures)
 #define	IreplyTimeout		(internal->_replyTimeout)
 #define	IrequestTimeout		(internal->_requestTimeout)
 #define	IrequestModes		(internal->_requestModes)
@@ -346,6 +351,16 @@ GS_PRIVATE_INTERNAL(NSConnection)
 + (void) _threadWillExit: (NSNotification*)notification;
 @end
 
+@interface NSConnection (GSDistantFuturePrivate)
+- (void) _completeFuture: (GSDistantFuture*)f
+	   withException: (NSException*)e;
+- (void) _completeFuture: (GSDistantFuture*)f
+	       withReply: (NSPortCoder*) NS_CONSUMED rmc;
+- (void) _setCompletionHandler: (GSDistantFutureHandler)handler
+		     forFuture: (GSDistantFuture*)f;
+- (void) _waitForFuture: (GSDistantFuture*)f;
+@end
+
 
 
 /* class defaults */
@@ -390,6 +405,11 @@ existingConnection(NSPort *receivePort, NSPort *sendPort)
 static NSMapTable *root_object_map;
 static NSLock *root_object_map_gate = nil;
 
+/* Signalled when a future which a thread is blocked waiting for (because
+ * another thread has claimed it) is completed.
+ */
+static NSCondition *future_done = nil;
+
 static id
 rootObjectForInPort(NSPort *aPort)
 {
@@ -667,6 +687,11 @@ static NSLock	*cached_proxies_gate = nil;
 	  root_object_map_gate = [NSLock new];
           [[NSObject leakAt: &root_object_map_gate] release];
 	}
+      if (future_done == nil)
+	{
+	  future_done = [NSCondition new];
+          [[NSObject leakAt: &future_done] release];
+	}
 
       /*
        * When any thread exits, we must check to see if we are using its
@@ -1062,6 +1087,21 @@ static NSLock	*cached_proxies_gate = nil;
   IreplyMap = (GSIMapTable)NSZoneMalloc(z, sizeof(GSIMapTable_t));
   GSIMapInitWithZoneAndCapacity(IreplyMap, z, 4);
 
+  /*
+   * This maps the sequence numbers of replies being waited for to the
+   * run loop information (not retained) of the waiting threads, so that
+   * whichever thread reads a reply can wake the thread waiting for it.
+   */
+  IreplyWaiters = (GSIMapTable)NSZoneMalloc(z, sizeof(GSIMapTable_t));
+  GSIMapInitWithZoneAndCapacity(IreplyWaiters, z, 4);
+
+  /*
+   * This maps the sequence numbers of requests sent asynchronously to the
+   * (retained) futures which are to receive their replies.
+   */
+  IreplyFutures = (GSIMapTable)NSZoneMalloc(z, sizeof(GSIMapTable_t));
+  GSIMapInitWithZoneAndCapacity(IreplyFutures, z, 4);
+
   /*
    * This maps (void*)obj to (id)obj.  The obj's are retained.
    * We use this instead of an NSHashTable because we only care about
@@ -1214,6 +1254,8 @@ static NSLock	*cached_proxies_gate = nil;
  */
 - (void) invalidate
 {
+  NSMutableArray	*failed = nil;
+
   GS_M_LOCK(IrefGate);
   if (IisValid == NO)
     {
@@ -1234,8 +1276,63 @@ static NSLock	*cached_proxies_gate = nil;
   NSHashRemove(connection_table, self);
   GSM_UNLOCK(connection_table_gate);
 
+  /*
+   * Wake any threads waiting for replies so they see the invalidation.
+   */
+  if (IreplyWaiters != 0)
+    {
+      GSIMapEnumerator_t	enumerator;
+      GSIMapNode 		node;
+
+      enumerator = GSIMapEnumeratorForMap(IreplyWaiters);
+      while ((node = GSIMapEnumeratorNextNode(&enumerator)) != 0)
+	{
+	  [(GSRunLoopThreadInfo*)node->value.ptr wake];
+	}
+    }
+
+  /*
+   * Take any futures nobody is waiting for, so we can fail them below.
+   */
+  if (IreplyFutures != 0 && IreplyFutures->nodeCount > 0)
+    {
+      GSIMapEnumerator_t	enumerator;
+      GSIMapNode 		node;
+
+      failed = [NSMutableArray arrayWithCapacity: IreplyFutures->nodeCount];
+      enumerator = GSIMapEnumeratorForMap(IreplyFutures);
+      while ((node = GSIMapEnumeratorNextNode(&enumerator)) != 0)
+	{
+	  GSDistantFuture	*f = node->value.obj;
+
+	  if (f->_waiting == NO)
+	    {
+	      f->_claimed = YES;
+	      [failed addObject: f];
+	    }
+	}
+      GS_FOR_IN(GSDistantFuture*, f, failed)
+	{
+	  GSIMapRemoveKey(IreplyMap, (GSIMapKey)(NSUInteger)f->_sequence);
+	  GSIMapRemoveKey(IreplyFutures, (GSIMapKey)(NSUInteger)f->_sequence);
+	  RELEASE(f);
+	}
+      GS_END_FOR(failed)
+    }
   GSM_UNLOCK(IrefGate);
 
+  if (failed != nil)
+    {
+      NSException	*e;
+
+      e = [NSException exceptionWithName: NSInvalidReceivePortException
+				  reason: @"invalidated while awaiting reply"
+				userInfo: nil];
+      GS_FOR_IN(GSDistantFuture*, f, failed)
+	[self _completeFuture: f withException: e];
+      GS_END_FOR(failed)
+    }
+
   /*
    * Don't need notifications any more - so remove self as observer.
    */
@@ -1938,6 +2035,26 @@ static NSLock	*cached_proxies_gate = nil;
       NSZoneFree(IreplyMap->zone, (void*)IreplyMap);
       IreplyMap = 0;
     }
+  if (IreplyWaiters != 0)
+    {
+      GSIMapEmptyMap(IreplyWaiters);
+      NSZoneFree(IreplyWaiters->zone, (void*)IreplyWaiters);
+      IreplyWaiters = 0;
+    }
+  if (IreplyFutures != 0)
+    {
+      GSIMapEnumerator_t	enumerator;
+      GSIMapNode 		node;
+
+      enumerator = GSIMapEnumeratorForMap(IreplyFutures);
+      while ((node = GSIMapEnumeratorNextNode(&enumerator)) != 0)
+	{
+	  RELEASE(node->value.obj);
+	}
+      GSIMapEmptyMap(IreplyFutures);
+      NSZoneFree(IreplyFutures->zone, (void*)IreplyFutures);
+      IreplyFutures = 0;
+    }
 
   DESTROY(IcachedDecoders);
   DESTROY(IcachedEncoders);
@@ -1950,15 +2067,20 @@ static NSLock	*cached_proxies_gate = nil;
 }
 
 /*
- * NSDistantObject's -forwardInvocation: method calls this to send the message
- * over the wire.
+ * Encode inv as a request to the remote object represented by object and
+ * send it, returning the sequence number of the request.  On return,
+ * *outParams says whether the invocation passes values by reference and
+ * *types points to the method types used to encode it.  If no reply is
+ * expected (a oneway void method) the placeholder for the reply is
+ * removed and *needsResponse is set to NO.
  */
-- (void) forwardInvocation: (NSInvocation*)inv
-		  forProxy: (NSDistantObject*)object
+- (unsigned) _sendInvocation: (NSInvocation*)inv
+		    forProxy: (NSDistantObject*)object
+		   outParams: (BOOL*)outParams
+	       needsResponse: (BOOL*)needsResponse
+		       types: (const char**)types
 {
   NSPortCoder	*op;
-  BOOL		outParams;
-  BOOL		needsResponse;
   const char	*name;
   const char	*type;
   unsigned	seq;
@@ -1994,6 +2116,7 @@ static NSLock	*cached_proxies_gate = nil;
     }
   NSParameterAssert(type);
   NSParameterAssert(*type);
+  *types = type;
 
   op = [self _newOutRmc: 0 generate: (int*)&seq reply: YES];
 
@@ -2001,21 +2124,21 @@ static NSLock	*cached_proxies_gate = nil;
     NSLog(@"building packet seq %d", seq);
 
   [inv setTarget: object];
-  outParams = [inv encodeWithDistantCoder: op passPointers: NO];
+  *outParams = [inv encodeWithDistantCoder: op passPointers: NO];
 
-  if (outParams == YES)
+  if (*outParams == YES)
     {
-      needsResponse = YES;
+      *needsResponse = YES;
     }
   else
     {
       int		flags;
 
-      needsResponse = NO;
+      *needsResponse = NO;
       flags = objc_get_type_qualifiers(type);
       if ((flags & _F_ONEWAY) == 0)
 	{
-	  needsResponse = YES;
+	  *needsResponse = YES;
 	}
       else
 	{
@@ -2023,7 +2146,7 @@ static NSLock	*cached_proxies_gate = nil;
 
 	  if (*tmptype != _C_VOID)
 	    {
-	      needsResponse = YES;
+	      *needsResponse = YES;
 	    }
 	}
     }
@@ -2032,7 +2155,7 @@ static NSLock	*cached_proxies_gate = nil;
   name = sel_getName([inv selector]);
   NSDebugMLLog(@"RMC", @"Sent message %s RMC %d to %p", name, seq, self);
 
-  if (needsResponse == NO)
+  if (*needsResponse == NO)
     {
       GSIMapNode	node;
 
@@ -2066,126 +2189,168 @@ static NSLock	*cached_proxies_gate = nil;
       GSIMapRemoveKey(IreplyMap, (GSIMapKey)(NSUInteger)seq);
       GSM_UNLOCK(IrefGate);
     }
-  else
-    {
-      int		argnum;
-      int		flags;
-      const char	*tmptype;
-      void		*datum;
-      NSPortCoder	*aRmc;
-      BOOL		is_exception;
+  return seq;
+}
 
-      if ([self isValid] == NO)
-	{
-	  [NSException raise: NSGenericException
-	    format: @"connection waiting for request was shut down"];
-	}
-      aRmc = [self _getReplyRmc: seq for: name];
+/*
+ * Decode the reply aRmc to a request built from inv (using the method
+ * types type) into inv, and finish with the reply coder.  Returns the
+ * exception sent by the remote end in place of the return values, or nil.
+ */
+- (id) _decodeReply: (NSPortCoder*)aRmc
+      forInvocation: (NSInvocation*)inv
+	      types: (const char*)type
+	  outParams: (BOOL)outParams
+{
+  int		argnum;
+  int		flags;
+  const char	*tmptype;
+  void		*datum;
+  BOOL		is_exception;
 
-      /*
-       * Find out if the server is returning an exception instead
-       * of the return values.
-       */
-      [aRmc decodeValueOfObjCType: @encode(BOOL) at: &is_exception];
-      if (is_exception == YES)
-	{
-	  /* Decode the exception object, and raise it. */
-	  id exc = [aRmc decodeObject];
+  /*
+   * Find out if the server is returning an exception instead
+   * of the return values.
+   */
+  [aRmc decodeValueOfObjCType: @encode(BOOL) at: &is_exception];
+  if (is_exception == YES)
+    {
+      /* Decode the exception object, and return it. */
+      id exc = [aRmc decodeObject];
 
-	  [self _doneInReply: aRmc];
-	  [exc raise];
-	}
+      [self _doneInReply: aRmc];
+      return exc;
+    }
 
-      /* Get the return type qualifier flags, and the return type. */
-      flags = objc_get_type_qualifiers(type);
-      tmptype = objc_skip_type_qualifiers(type);
+  /* Get the return type qualifier flags, and the return type. */
+  flags = objc_get_type_qualifiers(type);
+  tmptype = objc_skip_type_qualifiers(type);
 
-      /* Decode the return value and pass-by-reference values, if there
-	 are any.  OUT_PARAMETERS should be the value returned by
-	 cifframe_dissect_call(). */
-      if (outParams || *tmptype != _C_VOID || (flags & _F_ONEWAY) == 0)
-	/* xxx What happens with method declared "- (oneway) foo: (out int*)ip;" */
-	/* xxx What happens with method declared "- (in char *) bar;" */
-	/* xxx Is this right?  Do we also have to check _F_ONEWAY? */
-	{
-	  id	obj;
+  /* Decode the return value and pass-by-reference values, if there
+     are any.  OUT_PARAMETERS should be the value returned by
+     cifframe_dissect_call(). */
+  if (outParams || *tmptype != _C_VOID || (flags & _F_ONEWAY) == 0)
+    /* xxx What happens with method declared "- (oneway) foo: (out int*)ip;" */
+    /* xxx What happens with method declared "- (in char *) bar;" */
+    /* xxx Is this right?  Do we also have to check _F_ONEWAY? */
+    {
+      id	obj;
 
-	  /* If there is a return value, decode it, and put it in datum. */
-	  if (*tmptype != _C_VOID || (flags & _F_ONEWAY) == 0)
+      /* If there is a return value, decode it, and put it in datum. */
+      if (*tmptype != _C_VOID || (flags & _F_ONEWAY) == 0)
+	{
+	  switch (*tmptype)
 	    {
-	      switch (*tmptype)
-		{
-		  case _C_ID:
-		    datum = &obj;
-		    [aRmc decodeValueOfObjCType: tmptype at: datum];
-		    [obj autorelease];
-		    break;
-		  case _C_PTR:
-		    /* We are returning a pointer to something. */
-		    tmptype++;
-		    datum = alloca (objc_sizeof_type (tmptype));
-		    [aRmc decodeValueOfObjCType: tmptype at: datum];
-		    break;
+	      case _C_ID:
+		datum = &obj;
+		[aRmc decodeValueOfObjCType: tmptype at: datum];
+		[obj autorelease];
+		break;
+	      case _C_PTR:
+		/* We are returning a pointer to something. */
+		tmptype++;
+		datum = alloca (objc_sizeof_type (tmptype));
+		[aRmc decodeValueOfObjCType: tmptype at: datum];
+		break;
 
-		  case _C_VOID:
-		    datum = alloca (sizeof (int));
-		    [aRmc decodeValueOfObjCType: @encode(int) at: datum];
-		    break;
+	      case _C_VOID:
+		datum = alloca (sizeof (int));
+		[aRmc decodeValueOfObjCType: @encode(int) at: datum];
+		break;
 
-		  default:
-		    datum = alloca (objc_sizeof_type (tmptype));
-		    [aRmc decodeValueOfObjCType: tmptype at: datum];
-		    break;
-		}
-	    }
-	  else
-	    {
-	      datum = 0;
+	      default:
+		datum = alloca (objc_sizeof_type (tmptype));
+		[aRmc decodeValueOfObjCType: tmptype at: datum];
+		break;
 	    }
-	  [inv setReturnValue: datum];
+	}
+      else
+	{
+	  datum = 0;
+	}
+      [inv setReturnValue: datum];
 
-	  /* Decode the values returned by reference.  Note: this logic
-	     must match exactly the code in _service_forwardForProxy:
-	     */
-	  if (outParams)
+      /* Decode the values returned by reference.  Note: this logic
+	 must match exactly the code in _service_forwardForProxy:
+	 */
+      if (outParams)
+	{
+	  /* Step through all the arguments, finding the ones that were
+	     passed by reference. */
+	  for (tmptype = skip_argspec (tmptype), argnum = 0;
+	    *tmptype != '\0';
+	    tmptype = skip_argspec (tmptype), argnum++)
 	    {
-	      /* Step through all the arguments, finding the ones that were
-		 passed by reference. */
-	      for (tmptype = skip_argspec (tmptype), argnum = 0;
-	        *tmptype != '\0';
-	        tmptype = skip_argspec (tmptype), argnum++)
+	      /* Get the type qualifiers, like IN, OUT, INOUT, ONEWAY. */
+	      flags = objc_get_type_qualifiers(tmptype);
+	      /* Skip over the type qualifiers, so now TYPE is
+		 pointing directly at the char corresponding to the
+		 argument's type. */
+	      tmptype = objc_skip_type_qualifiers(tmptype);
+
+	      if (*tmptype == _C_PTR
+		&& ((flags & _F_OUT) || !(flags & _F_IN)))
 		{
-		  /* Get the type qualifiers, like IN, OUT, INOUT, ONEWAY. */
-		  flags = objc_get_type_qualifiers(tmptype);
-		  /* Skip over the type qualifiers, so now TYPE is
-		     pointing directly at the char corresponding to the
-		     argument's type. */
-		  tmptype = objc_skip_type_qualifiers(tmptype);
-
-		  if (*tmptype == _C_PTR
-		    && ((flags & _F_OUT) || !(flags & _F_IN)))
-		    {
-		      /* If the arg was byref, we obtain its address
-		       * and decode the data directly to it.
-		       */
-		      tmptype++;
-		      [inv getArgument: &datum atIndex: argnum];
-		      [aRmc decodeValueOfObjCType: tmptype at: datum];
-		      if (*tmptype == _C_ID)
-			{
-			  [*(id*)datum autorelease];
-			}
-		    }
-		  else if (*tmptype == _C_CHARPTR
-		    && ((flags & _F_OUT) || !(flags & _F_IN)))
+		  /* If the arg was byref, we obtain its address
+		   * and decode the data directly to it.
+		   */
+		  tmptype++;
+		  [inv getArgument: &datum atIndex: argnum];
+		  [aRmc decodeValueOfObjCType: tmptype at: datum];
+		  if (*tmptype == _C_ID)
 		    {
-		      [aRmc decodeValueOfObjCType: tmptype at: &datum];
-		      [inv setArgument: datum atIndex: argnum];
+		      [*(id*)datum autorelease];
 		    }
 		}
+	      else if (*tmptype == _C_CHARPTR
+		&& ((flags & _F_OUT) || !(flags & _F_IN)))
+		{
+		  [aRmc decodeValueOfObjCType: tmptype at: &datum];
+		  [inv setArgument: datum atIndex: argnum];
+		}
 	    }
 	}
-      [self _doneInReply: aRmc];
+    }
+  [self _doneInReply: aRmc];
+  return nil;
+}
+
+/*
+ * NSDistantObject's -forwardInvocation: method calls this to send the message
+ * over the wire.
+ */
+- (void) forwardInvocation: (NSInvocation*)inv
+		  forProxy: (NSDistantObject*)object
+{
+  BOOL		outParams;
+  BOOL		needsResponse;
+  const char	*type;
+  unsigned	seq;
+
+  seq = [self _sendInvocation: inv
+		     forProxy: object
+		    outParams: &outParams
+		needsResponse: &needsResponse
+			types: &type];
+  if (needsResponse == YES)
+    {
+      NSPortCoder	*aRmc;
+      id		exc;
+
+      if ([self isValid] == NO)
+	{
+	  [NSException raise: NSGenericException
+	    format: @"connection waiting for request was shut down"];
+	}
+      aRmc = [self _getReplyRmc: seq for: sel_getName([inv selector])];
+      exc = [self _decodeReply: aRmc
+		 forInvocation: inv
+			 types: type
+		     outParams: outParams];
+      if (exc != nil)
+	{
+	  [exc raise];
+	}
     }
 }
 
@@ -2371,8 +2536,9 @@ static NSLock	*cached_proxies_gate = nil;
       case METHODTYPE_REPLY:
       case RETAIN_REPLY:
 	{
-	  int		sequence;
-	  GSIMapNode	node;
+	  int			sequence;
+	  GSIMapNode		node;
+	  GSDistantFuture	*future = nil;
 
 	  [rmc decodeValueOfObjCType: @encode(int) at: &sequence];
 	  if (type == ROOTPROXY_REPLY && GSIVar(conn, _keepaliveWait) == YES
@@ -2393,20 +2559,59 @@ static NSLock	*cached_proxies_gate = nil;
 		sequence, conn);
 	      [self _doneInRmc: rmc];
 	    }
-	  else if (node->value.obj == dummyObject)
-	    {
-	      NSDebugMLLog(@"NSConnection", @"Saving reply RMC %d on %@",
-		sequence, conn);
-	      node->value.obj = rmc;
-	    }
 	  else
 	    {
-	      NSDebugMLLog(@"NSConnection", @"Replace reply RMC %d on %@",
-		sequence, conn);
-	      [self _doneInRmc: node->value.obj];
+	      GSRunLoopThreadInfo	*waiter;
+
+	      if (node->value.obj == dummyObject)
+		{
+		  NSDebugMLLog(@"NSConnection", @"Saving reply RMC %d on %@",
+		    sequence, conn);
+		}
+	      else
+		{
+		  NSDebugMLLog(@"NSConnection", @"Replace reply RMC %d on %@",
+		    sequence, conn);
+		  [self _doneInRmc: node->value.obj];
+		}
 	      node->value.obj = rmc;
+
+	      /* If the reply is for a future which nobody is waiting for,
+	       * take it to complete the future once we have unlocked.
+	       */
+	      node = GSIMapNodeForKey(GSIVar(conn, _replyFutures),
+		(GSIMapKey)(NSUInteger)sequence);
+	      if (node != 0
+		&& ((GSDistantFuture*)node->value.obj)->_waiting == NO)
+		{
+		  future = node->value.obj;
+		  future->_claimed = YES;
+		  GSIMapRemoveKey(GSIVar(conn, _replyFutures),
+		    (GSIMapKey)(NSUInteger)sequence);
+		  GSIMapRemoveKey(GSIVar(conn, _replyMap),
+		    (GSIMapKey)(NSUInteger)sequence);
+		}
+
+	      /* If another thread is waiting for this reply, wake it so
+	       * that it finds the reply at once.
+	       */
+	      node = GSIMapNodeForKey(GSIVar(conn, _replyWaiters),
+		(GSIMapKey)(NSUInteger)sequence);
+	      if (node != 0)
+		{
+		  waiter = (GSRunLoopThreadInfo*)node->value.ptr;
+		  if (waiter != GSRunLoopInfoForThread(nil))
+		    {
+		      [waiter wake];
+		    }
+		}
 	    }
 	  GSM_UNLOCK(GSIVar(conn, _refGate));
+	  if (future != nil)
+	    {
+	      [conn _completeFuture: future withReply: rmc];
+	      RELEASE(future);
+	    }
 	}
 	break;
 
@@ -3101,6 +3306,7 @@ static NSLock	*cached_proxies_gate = nil;
   NSDate		*start_date = nil;
   NSRunLoop		*runLoop;
   BOOL			isLocked = NO;
+  BOOL			isWaiting = NO;
 
   if (IisValid == NO)
     {
@@ -3130,27 +3336,12 @@ static NSLock	*cached_proxies_gate = nil;
 	}
     }
 
-  if (ImultipleThreads == YES)
-    {
-      /* Since multiple threads are using this connection, another
-       * thread may read the reply we are waiting for - so we must
-       * break out of the runloop frequently to check.  We do this
-       * by setting a small delay and increasing it each time round
-       * so that this semi-busy wait doesn't consume too much
-       * processor time (I hope).
-       * We set an upper limit on the delay to avoid responsiveness
-       * problems.
-       */
-      last_interval = 0.0001;
-      maximum_interval = 1.0;
-    }
-  else
-    {
-      /* As the connection is single threaded, we can wait indefinitely
-       * for a response ... but we recheck every five minutes anyway.
-       */
-      last_interval = maximum_interval = 300.0;
-    }
+  /* We can wait indefinitely for a response ... but we recheck every
+   * five minutes anyway.  If multiple threads are using this connection,
+   * another thread may read the reply we are waiting for, but we register
+   * as waiting for it below and the thread which reads it wakes us.
+   */
+  last_interval = maximum_interval = 300.0;
 
   NS_DURING
     {
@@ -3159,6 +3350,12 @@ static NSLock	*cached_proxies_gate = nil;
       NSDebugMLLog(@"RMC", @"Waiting up to %g sec for reply RMC %d (%s) on %@",
         IreplyTimeout, sn, request, self);
       GS_M_LOCK(IrefGate); isLocked = YES;
+      if (ImultipleThreads == YES)
+	{
+	  GSIMapAddPair(IreplyWaiters, (GSIMapKey)(NSUInteger)sn,
+	    (GSIMapVal)(void*)GSRunLoopInfoForThread(nil));
+	  isWaiting = YES;
+	}
       while (IisValid == YES
 	&& (node = GSIMapNodeForKey(IreplyMap, (GSIMapKey)(NSUInteger)sn)) != 0
 	&& node->value.obj == dummyObject)
@@ -3221,6 +3418,11 @@ static NSLock	*cached_proxies_gate = nil;
 	    }
 	  GS_M_LOCK(IrefGate); isLocked = YES;
 	}
+      if (YES == isWaiting)
+	{
+	  GSIMapRemoveKey(IreplyWaiters, (GSIMapKey)(NSUInteger)sn);
+	  isWaiting = NO;
+	}
       if (node == 0)
 	{
 	  rmc = nil;
@@ -3258,6 +3460,17 @@ static NSLock	*cached_proxies_gate = nil;
     }
   NS_HANDLER
     {
+      if (isWaiting == YES)
+	{
+	  if (isLocked == NO)
+	    {
+	      GS_M_LOCK(IrefGate); isLocked = YES;
+	    }
+	  if (IreplyWaiters != 0)
+	    {
+	      GSIMapRemoveKey(IreplyWaiters, (GSIMapKey)(NSUInteger)sn);
+	    }
+	}
       if (isLocked == YES)
 	{
 	  GSM_UNLOCK(IrefGate);
@@ -4066,3 +4279,267 @@ static NSLock	*cached_proxies_gate = nil;
     }
 }
 @end
+
+@implementation	NSConnection (GSDistantFuture)
+
+- (GSDistantFuture*) sendInvocation: (NSInvocation*)inv
+			   forProxy: (NSDistantObject*)proxy
+{
+  GSDistantFuture	*f;
+  NSPortCoder		*rmc = nil;
+  GSIMapNode		node;
+  const char		*type;
+  BOOL			needsResponse;
+  BOOL			registered = NO;
+
+  f = AUTORELEASE([GSDistantFuture new]);
+  f->_connection = RETAIN(self);
+  f->_invocation = RETAIN(inv);
+  [inv retainArguments];
+  f->_sequence = [self _sendInvocation: inv
+			      forProxy: proxy
+			     outParams: &f->_outParams
+			 needsResponse: &needsResponse
+				 types: &type];
+  if (needsResponse == NO)
+    {
+      f->_done = YES;
+      return f;
+    }
+  f->_types = NSZoneMalloc(NSDefaultMallocZone(), strlen(type) + 1);
+  strcpy(f->_types, type);
+
+  /* The reply may already have been read by another thread, in which case
+   * we can complete the future at once.  Otherwise we register it so that
+   * the reply is decoded into it when it arrives.
+   */
+  GS_M_LOCK(IrefGate);
+  node = GSIMapNodeForKey(IreplyMap, (GSIMapKey)(NSUInteger)f->_sequence);
+  if (node != 0 && node->value.obj != dummyObject)
+    {
+      rmc = node->value.obj;
+      GSIMapRemoveKey(IreplyMap, (GSIMapKey)(NSUInteger)f->_sequence);
+    }
+  else if (node != 0)
+    {
+      GSIMapAddPair(IreplyFutures,
+	(GSIMapKey)(NSUInteger)f->_sequence, (GSIMapVal)(id)RETAIN(f));
+      registered = YES;
+    }
+  GSM_UNLOCK(IrefGate);
+
+  if (rmc != nil)
+    {
+      [self _completeFuture: f withReply: rmc];
+    }
+  else if (registered == NO)
+    {
+      [self _completeFuture: f withException:
+	[NSException exceptionWithName: NSInvalidReceivePortException
+				reason: @"invalidated while awaiting reply"
+			      userInfo: nil]];
+    }
+  return f;
+}
+
+@end
+
+@implementation	NSConnection (GSDistantFuturePrivate)
+
+- (void) _completeFuture: (GSDistantFuture*)f
+	   withException: (NSException*)e
+{
+  GSDistantFutureHandler	handler;
+  BOOL				blocked;
+
+  GS_M_LOCK(IrefGate);
+  ASSIGN(f->_exception, e);
+  f->_done = YES;
+  blocked = f->_blocked;
+  handler = f->_handler;
+  f->_handler = NULL;
+  GSM_UNLOCK(IrefGate);
+
+  if (YES == blocked)
+    {
+      [future_done lock];
+      [future_done broadcast];
+      [future_done unlock];
+    }
+
+  if (handler != NULL)
+    {
+      NS_DURING
+	CALL_NON_NULL_BLOCK(handler, f);
+      NS_HANDLER
+	NSLog(@"Exception in completion handler of %@ - %@",
+	  f, localException);
+      NS_ENDHANDLER
+      Block_release(handler);
+    }
+}
+
+- (void) _completeFuture: (GSDistantFuture*)f
+	       withReply: (NSPortCoder*)rmc
+{
+  NSException	*e = nil;
+
+  NS_DURING
+    {
+      e = [self _decodeReply: rmc
+	       forInvocation: f->_invocation
+		       types: f->_types
+		   outParams: f->_outParams];
+    }
+  NS_HANDLER
+    {
+      [self _failInRmc: rmc];
+      e = localException;
+    }
+  NS_ENDHANDLER
+  [self _completeFuture: f withException: e];
+}
+
+- (void) _setCompletionHandler: (GSDistantFutureHandler)handler
+		     forFuture: (GSDistantFuture*)f
+{
+  GS_M_LOCK(IrefGate);
+  if (f->_done == NO)
+    {
+      if (f->_handler != NULL)
+	{
+	  Block_release(f->_handler);
+	}
+      f->_handler = (NULL == handler) ? NULL : Block_copy(handler);
+      handler = NULL;
+    }
+  GSM_UNLOCK(IrefGate);
+  if (handler != NULL)
+    {
+      CALL_NON_NULL_BLOCK(handler, f);
+    }
+}
+
+- (void) _waitForFuture: (GSDistantFuture*)f
+{
+  NSPortCoder	*rmc = nil;
+
+  GS_M_LOCK(IrefGate);
+  if (f->_done == YES)
+    {
+      GSM_UNLOCK(IrefGate);
+      return;
+    }
+  if (f->_claimed == YES)
+    {
+      /* Another thread has taken the future to complete it (having read
+       * its reply or found the connection invalid), so the reply is no
+       * longer available to us.  Block until that thread has finished,
+       * which does not take long since it does not block.  Having set
+       * _blocked while holding the lock we know that the completing
+       * thread will signal us once it has set _done.
+       */
+      f->_blocked = YES;
+      GSM_UNLOCK(IrefGate);
+      [future_done lock];
+      while (f->_done == NO)
+	{
+	  [future_done wait];
+	}
+      [future_done unlock];
+      return;
+    }
+  if (f->_waiting == YES)
+    {
+      GSM_UNLOCK(IrefGate);
+      [NSException raise: NSInternalInconsistencyException
+		  format: @"%@ is already being waited for", f];
+    }
+  f->_waiting = YES;
+  GSM_UNLOCK(IrefGate);
+
+  NS_DURING
+    {
+      rmc = [self _getReplyRmc: f->_sequence
+			   for: sel_getName([f->_invocation selector])];
+    }
+  NS_HANDLER
+    {
+      rmc = nil;
+      [self _completeFuture: f withException: localException];
+    }
+  NS_ENDHANDLER
+
+  GS_M_LOCK(IrefGate);
+  if (IreplyFutures != 0 && GSIMapNodeForKey(IreplyFutures,
+    (GSIMapKey)(NSUInteger)f->_sequence) != 0)
+    {
+      GSIMapRemoveKey(IreplyFutures, (GSIMapKey)(NSUInteger)f->_sequence);
+      RELEASE(f);
+    }
+  f->_waiting = NO;
+  GSM_UNLOCK(IrefGate);
+
+  if (rmc != nil)
+    {
+      [self _completeFuture: f withReply: rmc];
+    }
+}
+
+@end
+
+@implementation	GSDistantFuture
+
+- (void) dealloc
+{
+  RELEASE(_connection);
+  RELEASE(_invocation);
+  RELEASE(_exception);
+  if (_handler != NULL)
+    {
+      Block_release(_handler);
+    }
+  if (_types != 0)
+    {
+      NSZoneFree(NSDefaultMallocZone(), _types);
+    }
+  [super dealloc];
+}
+
+- (NSString*) description
+{
+  return [NSString stringWithFormat: @"%@ for %@ (RMC %u%s)",
+    [super description], NSStringFromSelector([_invocation selector]),
+    _sequence, (_done ? ", done" : "")];
+}
+
+- (NSException*) exception
+{
+  return _exception;
+}
+
+- (NSInvocation*) invocation
+{
+  return _invocation;
+}
+
+- (BOOL) isDone
+{
+  return _done;
+}
+
+- (void) setCompletionHandler: (GSDistantFutureHandler)handler
+{
+  [_connection _setCompletionHandler: handler forFuture: self];
+}
+
+- (void) waitUntilDone
+{
+  [_connection _waitForFuture: self];
+  if (_exception != nil)
+    {
+      [_exception raise];
+    }
+}
+
+@end
@@ -133,6 +133,7 @@ static Class	dataMalloc;
 static Class	mutableDataMalloc;
 static Class	dataBlock;
 static Class	mutableDataBlock;
+static Class	mutableDataChunked;
 static Class	NSDataAbstract;
 static Class	NSMutableDataAbstract;
 static SEL	appendSel;
@@ -146,9 +147,6 @@ decodebase64(unsigned char *dst, const unsigned char *src)
   dst[2] = ((src[2] & 0x03) << 6) |  (src[3] & 0x3F);
 }
 
-static char b64[]
-  = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-
 static const int crlf64 = NSDataBase64EncodingEndLineWithCarriageReturn
   | NSDataBase64EncodingEndLineWithLineFeed;
 
@@ -159,9 +157,6 @@ encodebase64(unsigned char **dstRef,
   NSDataBase64EncodingOptions options)
 {
   unsigned char *dst;
-  NSUInteger dIndex = 0;
-  NSUInteger dIndexNoNewLines = 0;
-  NSUInteger sIndex;
   NSUInteger lineLength;
   NSUInteger destLen;
 
@@ -179,56 +174,47 @@ encodebase64(unsigned char **dstRef,
       options |= crlf64;
     }
 
-  /* estimate destination length */
+  /* calculate destination length, with line-endings between lines */
   destLen = 4 * ((length + 2) / 3);
-  /* we need to take in account line-endings */
-  if (lineLength)
+  if (lineLength && destLen > lineLength)
     {
+      NSUInteger	breaks = (destLen - 1) / lineLength;
+
       if ((options & crlf64) == crlf64)
-        destLen += (destLen / lineLength)*2;    // CR and LF
+        destLen += breaks * 2;    // CR and LF
       else
-        destLen += (destLen / lineLength);      // CR or LF
+        destLen += breaks;        // CR or LF
     }
 
   dst = NSZoneMalloc(NSDefaultMallocZone(), destLen);
 
-  for (sIndex = 0; sIndex < length; sIndex += 3)
+  if (0 == lineLength)
+    {
+      GSPrivateEncodeBase64(src, length, dst);
+    }
+  else
     {
-      int	c0 = src[sIndex];
-      int	c1 = (sIndex+1 < length) ? src[sIndex+1] : 0;
-      int	c2 = (sIndex+2 < length) ? src[sIndex+2] : 0;
+      NSUInteger	perLine = (lineLength / 4) * 3;
+      unsigned char	*out = dst;
 
-      dst[dIndex++] = b64[(c0 >> 2) & 077];
-      dst[dIndex++] = b64[((c0 << 4) & 060) | ((c1 >> 4) & 017)];
-      dst[dIndex++] = b64[((c1 << 2) & 074) | ((c2 >> 6) & 03)];
-      dst[dIndex++] = b64[c2 & 077];
-      dIndexNoNewLines += 4;
-      if (lineLength && !(dIndexNoNewLines % lineLength) )
+      /* Encode whole lines, then the remainder with any padding.
+       */
+      while (length > perLine)
         {
+          GSPrivateEncodeBase64Groups(src, perLine / 3, out);
+          src += perLine;
+          length -= perLine;
+          out += lineLength;
           if (options & NSDataBase64EncodingEndLineWithCarriageReturn)
-            dst[dIndex++] = '\r';
+            *out++ = '\r';
           if (options & NSDataBase64EncodingEndLineWithLineFeed)
-            dst[dIndex++] = '\n';
+            *out++ = '\n';
         }
+      GSPrivateEncodeBase64(src, length, out);
     }
 
-   /* If len was not a multiple of 3, then we have encoded too
-    * many characters.  Adjust appropriately.
-    */
-   if (sIndex == length + 1)
-     {
-       /* There were only 2 bytes in that last group */
-       dst[dIndex - 1] = '=';
-     }
-   else if (sIndex == length + 2)
-     {
-       /* There was only 1 byte in that last group */
-       dst[dIndex - 1] = '=';
-       dst[dIndex - 2] = '=';
-     }
-
   *dstRef = dst;
-  return dIndex;
+  return destLen;
 }
 
 /* A NULL value for buf causes the existence and length of the file to
@@ -579,6 +565,34 @@ failure:
 @interface NSMutableDataWithDeallocatorBlock : NSMutableDataMalloc
 @end
 
+/* A chunked data object holds its contents in a list of separately
+ * allocated chunks, so appending never moves (or reallocates) bytes
+ * which are already stored.  The chunks are merged into one (flattened)
+ * only when something asks for a pointer to the whole of the contents.
+ */
+typedef struct {
+  uint8_t	*bytes;
+  NSUInteger	used;
+  NSUInteger	size;
+} GSDataChunk;
+
+@interface	NSMutableDataChunked : NSMutableData
+{
+  GSDataChunk	*chunks;	// Chunks in use, only the last has space
+  NSUInteger	count;		// Number of chunks in use
+  NSUInteger	slots;		// Size of the chunks array
+  NSUInteger	length;		// Total bytes in all chunks
+  NSUInteger	next;		// Size of the next chunk to be allocated
+  NSZone	*zone;
+}
+- (NSUInteger) _chunks: (const void**)ptrs
+	       lengths: (NSUInteger*)lens
+		  from: (NSUInteger)first
+		   max: (NSUInteger)max;
+- (void) _flatten;
+- (GSDataChunk*) _space: (NSUInteger)want;
+@end
+
 #ifdef	HAVE_MMAP
 @interface	NSDataMappedFile : NSDataMalloc
 @end
@@ -630,6 +644,7 @@ failure:
       dataBlock = [NSDataWithDeallocatorBlock class];
       mutableDataMalloc = [NSMutableDataMalloc class];
       mutableDataBlock = [NSMutableDataWithDeallocatorBlock class];
+      mutableDataChunked = [NSMutableDataChunked class];
       appendSel = @selector(appendBytes:length:);
       appendImp = [mutableDataMalloc instanceMethodForSelector: appendSel];
     }
@@ -871,8 +886,24 @@ failure:
 
   while (src != end)
     {
-      int	c = *src++;
+      int	c;
 
+      if (0 == pos)
+	{
+	  NSUInteger	used;
+
+	  /* Decode as many complete groups as we can in one go before
+	   * falling back to examining characters one at a time.
+	   */
+	  used = GSPrivateDecodeBase64Groups(src, end - src, dst);
+	  src += used;
+	  dst += (used / 4) * 3;
+	  if (src == end)
+	    {
+	      break;
+	    }
+	}
+      c = *src++;
       if (isupper(c))
 	{
 	  c -= 'A';
@@ -3337,6 +3368,26 @@ failure:
   return AUTORELEASE(d);
 }
 
+/**
+ * Returns a new autoreleased instance intended for building up large
+ * contents by appending many (possibly small) pieces.<br />
+ * The data is stored in a list of separately allocated chunks (the first
+ * holding at least capacity bytes and later ones growing geometrically),
+ * so an append never copies bytes which are already stored.  The chunks
+ * are merged into one buffer only when something needs a pointer to the
+ * whole of the contents (eg. -bytes or -mutableBytes), while
+ * -getBytes:range: and writing the data to an [NSFileHandle] work on the
+ * chunks directly.
+ */
++ (id) chunkedDataWithCapacity: (NSUInteger)capacity
+{
+  NSMutableData	*d;
+
+  d = [mutableDataChunked allocWithZone: NSDefaultMallocZone()];
+  d = [d initWithCapacity: capacity];
+  return AUTORELEASE(d);
+}
+
 /**
  *  Returns current capacity of data buffer.
  */
@@ -4855,6 +4906,359 @@ getBytes(void* dst, void* src, unsigned len, unsigned limit, unsigned *pos)
 
 @end
 
+#define	CHUNK_MIN	256
+#define	CHUNK_MAX	(1024 * 1024)
+
+@implementation	NSMutableDataChunked
+
+- (Class) classForCoder
+{
+  return NSMutableDataAbstract;
+}
+
+- (id) copyWithZone: (NSZone*)z
+{
+  void	*ptr = 0;
+
+  if (length > 0)
+    {
+      ptr = NSAllocateCollectable(length, 0);
+      if (ptr == 0)
+	{
+	  [NSException raise: NSMallocException
+	    format: @"Unable to copy %"PRIuPTR" bytes of data", length];
+	}
+      [self getBytes: ptr range: NSMakeRange(0, length)];
+    }
+  return [[dataMalloc allocWithZone: z] initWithBytesNoCopy: ptr
+						     length: length
+					       freeWhenDone: YES];
+}
+
+- (id) mutableCopyWithZone: (NSZone*)z
+{
+  NSMutableData	*d;
+
+  d = [[mutableDataMalloc allocWithZone: z] initWithLength: length];
+  [self getBytes: [d mutableBytes] range: NSMakeRange(0, length)];
+  return d;
+}
+
+- (void) dealloc
+{
+  while (count > 0)
+    {
+      NSZoneFree(zone, chunks[--count].bytes);
+    }
+  if (chunks != 0)
+    {
+      NSZoneFree(zone, chunks);
+      chunks = 0;
+    }
+  [super dealloc];
+}
+
+- (id) initWithBytesNoCopy: (void*)aBuffer
+		    length: (NSUInteger)bufferSize
+	      freeWhenDone: (BOOL)shouldFree
+{
+  if (aBuffer == 0 && bufferSize > 0)
+    {
+      [NSException raise: NSInvalidArgumentException
+	format: @"[%@-initWithBytesNoCopy:length:freeWhenDone:] called with "
+	@"length but null bytes", NSStringFromClass([self class])];
+    }
+  self = [self initWithCapacity: bufferSize];
+  if (self)
+    {
+      [self appendBytes: aBuffer length: bufferSize];
+    }
+  if (aBuffer != 0 && shouldFree == YES)
+    {
+      NSZoneFree(NSZoneFromPointer(aBuffer), aBuffer);
+    }
+  return self;
+}
+
+// THIS IS THE DESIGNATED INITIALISER
+- (id) initWithCapacity: (NSUInteger)size
+{
+  zone = [self zone];
+  next = (size < CHUNK_MIN) ? CHUNK_MIN : size;
+  return self;
+}
+
+- (id) initWithLength: (NSUInteger)size
+{
+  self = [self initWithCapacity: size];
+  if (self)
+    {
+      [self setLength: size];
+    }
+  return self;
+}
+
+/* Return the last chunk if it has space, otherwise add a new chunk with
+ * space for at least want bytes.
+ */
+- (GSDataChunk*) _space: (NSUInteger)want
+{
+  GSDataChunk	*c;
+  NSUInteger	size;
+
+  if (count > 0 && chunks[count - 1].used < chunks[count - 1].size)
+    {
+      return &chunks[count - 1];
+    }
+  if (count == slots)
+    {
+      slots = (slots == 0) ? 8 : slots * 2;
+      chunks = NSZoneRealloc(zone, chunks, slots * sizeof(GSDataChunk));
+      if (chunks == 0)
+	{
+	  [NSException raise: NSMallocException
+	    format: @"Unable to grow chunked data to %"PRIuPTR" chunks", slots];
+	}
+    }
+  size = (want > next) ? want : next;
+  c = &chunks[count];
+  c->bytes = NSZoneMalloc(zone, size);
+  if (c->bytes == 0)
+    {
+      [NSException raise: NSMallocException
+	format: @"Unable to allocate a data chunk of %"PRIuPTR" bytes", size];
+    }
+  c->used = 0;
+  c->size = size;
+  count++;
+  if (next < CHUNK_MAX)
+    {
+      next *= 2;
+    }
+  return c;
+}
+
+- (void) _flatten
+{
+  if (count > 1)
+    {
+      uint8_t		*buf = NSZoneMalloc(zone, length);
+      NSUInteger	pos = 0;
+      NSUInteger	i;
+
+      if (buf == 0)
+	{
+	  [NSException raise: NSMallocException
+	    format: @"Unable to flatten %"PRIuPTR" bytes of data", length];
+	}
+      for (i = 0; i < count; i++)
+	{
+	  memcpy(buf + pos, chunks[i].bytes, chunks[i].used);
+	  pos += chunks[i].used;
+	  NSZoneFree(zone, chunks[i].bytes);
+	}
+      chunks[0].bytes = buf;
+      chunks[0].used = length;
+      chunks[0].size = length;
+      count = 1;
+    }
+}
+
+- (NSUInteger) _chunks: (const void**)ptrs
+	       lengths: (NSUInteger*)lens
+		  from: (NSUInteger)first
+		   max: (NSUInteger)max
+{
+  NSUInteger	i;
+
+  for (i = 0; i < max && first + i < count; i++)
+    {
+      ptrs[i] = chunks[first + i].bytes;
+      lens[i] = chunks[first + i].used;
+    }
+  return count;
+}
+
+- (void) appendBytes: (const void*)aBuffer
+	      length: (NSUInteger)bufferSize
+{
+  if (bufferSize > 0)
+    {
+      if (aBuffer == 0)
+	{
+	  [NSException raise: NSInvalidArgumentException
+	    format: @"[%@-appendBytes:length:] called with "
+	    @"length but null bytes", NSStringFromClass([self class])];
+	}
+      /* Chunks never move once allocated, so aBuffer may safely point
+       * into the receiver's own contents.
+       */
+      while (bufferSize > 0)
+	{
+	  GSDataChunk	*c = [self _space: bufferSize];
+	  NSUInteger	n = c->size - c->used;
+
+	  if (n > bufferSize)
+	    {
+	      n = bufferSize;
+	    }
+	  memcpy(c->bytes + c->used, aBuffer, n);
+	  c->used += n;
+	  length += n;
+	  aBuffer += n;
+	  bufferSize -= n;
+	}
+    }
+}
+
+- (NSUInteger) capacity
+{
+  NSUInteger	total = 0;
+  NSUInteger	i;
+
+  for (i = 0; i < count; i++)
+    {
+      total += chunks[i].size;
+    }
+  return total;
+}
+
+- (void) getBytes: (void*)buffer range: (NSRange)aRange
+{
+  NSUInteger	pos = aRange.location;
+  NSUInteger	left = aRange.length;
+  NSUInteger	i = 0;
+
+  GS_RANGE_CHECK(aRange, length);
+  while (left > 0)
+    {
+      if (pos >= chunks[i].used)
+	{
+	  pos -= chunks[i++].used;
+	}
+      else
+	{
+	  NSUInteger	n = chunks[i].used - pos;
+
+	  if (n > left)
+	    {
+	      n = left;
+	    }
+	  memcpy(buffer, chunks[i++].bytes + pos, n);
+	  buffer += n;
+	  left -= n;
+	  pos = 0;
+	}
+    }
+}
+
+- (NSUInteger) length
+{
+  return length;
+}
+
+- (void*) mutableBytes
+{
+  [self _flatten];
+  return (count > 0) ? chunks[0].bytes : 0;
+}
+
+- (id) setCapacity: (NSUInteger)size
+{
+  if (size < length)
+    {
+      [self setLength: size];
+    }
+  if (count == 0)
+    {
+      next = (size < CHUNK_MIN) ? CHUNK_MIN : size;
+    }
+  else
+    {
+      [self _flatten];
+      if (size != chunks[0].size)
+	{
+	  uint8_t	*tmp = NSZoneRealloc(zone, chunks[0].bytes, size);
+
+	  if (tmp == 0)
+	    {
+	      [NSException raise: NSMallocException
+		format: @"Unable to set data capacity to '%"PRIuPTR"'", size];
+	    }
+	  chunks[0].bytes = tmp;
+	  chunks[0].size = size;
+	}
+    }
+  return self;
+}
+
+- (void) setLength: (NSUInteger)size
+{
+  if (size < length)
+    {
+      NSUInteger	drop = length - size;
+
+      while (drop > 0 && chunks[count - 1].used <= drop)
+	{
+	  drop -= chunks[--count].used;
+	  NSZoneFree(zone, chunks[count].bytes);
+	}
+      if (drop > 0)
+	{
+	  chunks[count - 1].used -= drop;
+	}
+    }
+  else if (size > length)
+    {
+      NSUInteger	extra = size - length;
+
+      if (count == 1 && size > chunks[0].size)
+	{
+	  NSUInteger	growTo = chunks[0].size + chunks[0].size / 2;
+
+	  /* Keep a flat buffer flat, as it is probably being extended in
+	   * order to be written to through -mutableBytes.
+	   */
+	  [self setCapacity: (size > growTo) ? size : growTo];
+	}
+      while (extra > 0)
+	{
+	  GSDataChunk	*c = [self _space: extra];
+	  NSUInteger	n = c->size - c->used;
+
+	  if (n > extra)
+	    {
+	      n = extra;
+	    }
+	  memset(c->bytes + c->used, '\0', n);
+	  c->used += n;
+	  extra -= n;
+	}
+    }
+  length = size;
+}
+
+@end
+
+NSUInteger
+GSPrivateDataChunks(NSData *data, NSUInteger first,
+  const void **ptrs, NSUInteger *lens, NSUInteger max)
+{
+  if (object_getClass(data) == mutableDataChunked)
+    {
+      return [(NSMutableDataChunked*)data _chunks: ptrs
+					  lengths: lens
+					     from: first
+					      max: max];
+    }
+  if (first == 0 && max > 0)
+    {
+      ptrs[0] = [data bytes];
+      lens[0] = [data length];
+    }
+  return 1;
+}
+
 
 #ifdef	HAVE_SHMCTL
 @implementation	NSMutableDataShared
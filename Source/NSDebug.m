@@ -597,6 +597,13 @@ GSDebugAllocationList(BOOL changeFlag)
 	    }
         }
       free(items);
+      if (GSObjectMagazineZone() != NULL)
+	{
+	  struct NSZoneStats	stats = NSZoneStats(GSObjectMagazineZone());
+
+	  [result appendFormat: @"%lu\t(in magazines, %lu bytes cached)\n",
+	    (unsigned long)stats.chunks_used, (unsigned long)stats.bytes_free];
+	}
       return [result UTF8String];
     }
 }
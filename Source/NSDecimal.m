@@ -33,6 +33,7 @@
 #import "Foundation/NSDecimal.h"
 #import "Foundation/NSDictionary.h"
 #import "Foundation/NSUserDefaults.h"
+#import "GSPrivate.h"
 
 #ifndef NAN
 #define NAN 0.0
@@ -107,6 +108,384 @@ static NSDecimal one = {0, NO, YES, 1, {1}};
 
 #endif
 
+#if	!USE_GMP && defined(__SIZEOF_INT128__)
+/*
+  Where the compiler provides a 128-bit integer type, the arithmetic
+  functions convert the decimal digits of the mantissas to binary integers
+  (any 38 digit mantissa fits) and add, subtract, multiply or divide those
+  directly whenever the result is exact in 38 digits, which is by far the
+  most common case.  Anything needing rounding goes through the digit by
+  digit code, so the results are the same either way.  Setting
+  GNUSTEP_DECIMAL_DIGITS=YES in the environment disables the binary code.
+  Numbers whose exponent is so large that compacting them could reach the
+  top of the range (where the digit code keeps trailing zeros and treats
+  carries specially) are also left to the digit code.
+ */
+#define	GS_DECIMAL_BINARY	1
+#define	BINARY_EXPONENT_MAX	(127 - NSDecimalMaxDigit - 1)
+
+typedef unsigned __int128 GSDecimalWide;
+
+static GSDecimalWide	powersOf10[NSDecimalMaxDigit + 1];
+static BOOL		binaryEnabled = NO;
+static BOOL		binarySetUp = NO;
+
+static BOOL
+binaryArithmetic(void)
+{
+  if (NO == __atomic_load_n(&binarySetUp, __ATOMIC_ACQUIRE))
+    {
+      int	i;
+
+      powersOf10[0] = 1;
+      for (i = 1; i <= NSDecimalMaxDigit; i++)
+	{
+	  powersOf10[i] = powersOf10[i - 1] * 10;
+	}
+      binaryEnabled = !GSPrivateEnvironmentFlag("GNUSTEP_DECIMAL_DIGITS", NO);
+      __atomic_store_n(&binarySetUp, YES, __ATOMIC_RELEASE);
+    }
+  return binaryEnabled;
+}
+
+/* Return the mantissa of a number as a binary integer.
+ */
+static inline GSDecimalWide
+GSDecimalMantissa(const NSDecimal *number)
+{
+  const unsigned char	*d = number->cMantissa;
+  int			l = number->length;
+  uint64_t		hi = 0;
+  uint64_t		lo = 0;
+  int			i = 0;
+
+  /* Each half fits in 64 bits, so only one 128-bit multiply is needed.
+   */
+  if (l > 19)
+    {
+      for (; i < l - 19; i++)
+	{
+	  hi = hi * 10 + d[i];
+	}
+    }
+  for (; i < l; i++)
+    {
+      lo = lo * 10 + d[i];
+    }
+  if (hi > 0)
+    {
+      return (GSDecimalWide)hi * powersOf10[19] + lo;
+    }
+  return lo;
+}
+
+static inline uint64_t
+GSDecimalMantissa64(const NSDecimal *number)
+{
+  const unsigned char	*d = number->cMantissa;
+  int			l = number->length;
+  uint64_t		m = 0;
+  int			i;
+
+  for (i = 0; i < l; i++)
+    {
+      m = m * 10 + d[i];
+    }
+  return m;
+}
+
+static inline int
+GSDecimalDigits64(uint64_t v, unsigned char *end, int min)
+{
+  int	n = 0;
+
+  while (v > 0 || n < min)
+    {
+      *--end = v % 10;
+      v /= 10;
+      n++;
+    }
+  return n;
+}
+
+/* Store a binary mantissa (less than 10^38), exponent and sign in a
+ * number and compact it.
+ */
+static void
+GSDecimalSetMantissa(NSDecimal *number, GSDecimalWide m, int exponent,
+  BOOL negative)
+{
+  unsigned char	buf[NSDecimalMaxDigit];
+  unsigned char	*end = buf + NSDecimalMaxDigit;
+  int		l;
+
+  number->validNumber = YES;
+  if (0 == m)
+    {
+      number->length = 0;
+      number->exponent = 0;
+      number->isNegative = NO;
+      return;
+    }
+  if (m > UINT64_MAX)
+    {
+      GSDecimalWide	hi = m / powersOf10[19];
+
+      l = GSDecimalDigits64((uint64_t)(m - hi * powersOf10[19]), end, 19);
+      l += GSDecimalDigits64((uint64_t)hi, end - l, 0);
+    }
+  else
+    {
+      l = GSDecimalDigits64((uint64_t)m, end, 0);
+    }
+
+  /* Cut off trailing zeros as GSDecimalCompact() does.
+   */
+  while (0 == end[-1] && exponent < 127)
+    {
+      end--;
+      l--;
+      exponent++;
+    }
+  memcpy(number->cMantissa, end - l, l);
+  number->length = l;
+  number->exponent = exponent;
+  number->isNegative = negative;
+}
+
+/* As GSDecimalSetMantissa() for a mantissa which fits in 64 bits.
+ */
+static inline void
+GSDecimalSetMantissa64(NSDecimal *number, uint64_t m, int exponent,
+  BOOL negative)
+{
+  unsigned char	buf[20];
+  unsigned char	*end = buf + sizeof(buf);
+  unsigned char	*start = end;
+
+  number->validNumber = YES;
+  if (0 == m)
+    {
+      number->length = 0;
+      number->exponent = 0;
+      number->isNegative = NO;
+      return;
+    }
+  while (0 == m % 10 && exponent < 127)
+    {
+      m /= 10;
+      exponent++;
+    }
+  /* Two digits per division halves the length of the dependency chain.
+   */
+  while (m >= 100)
+    {
+      unsigned	r = (unsigned)(m % 100);
+
+      m /= 100;
+      *--start = r % 10;
+      *--start = r / 10;
+    }
+  if (m >= 10)
+    {
+      *--start = (unsigned)m % 10;
+      *--start = (unsigned)m / 10;
+    }
+  else
+    {
+      *--start = (unsigned)m;
+    }
+  memcpy(number->cMantissa, start, end - start);
+  number->length = end - start;
+  number->exponent = exponent;
+  number->isNegative = negative;
+}
+
+/* Add a term (m * 10^e, negative if n is YES) to a sum held as a magnitude,
+ * exponent and sign.  Returns NO, leaving the sum unchanged, if the result
+ * can not be held exactly in 38 digits.
+ */
+static BOOL
+GSDecimalAccumulate(GSDecimalWide *sum, int *exponent, BOOL *negative,
+  GSDecimalWide m, int e, BOOL n)
+{
+  GSDecimalWide	s = *sum;
+  int		x = *exponent;
+
+  if (0 == s)
+    {
+      *sum = m;
+      *exponent = e;
+      *negative = n;
+      return YES;
+    }
+  if (e > x)
+    {
+      if (e - x > NSDecimalMaxDigit || m >= powersOf10[NSDecimalMaxDigit - (e - x)])
+	return NO;
+      m *= powersOf10[e - x];
+    }
+  else if (e < x)
+    {
+      if (x - e > NSDecimalMaxDigit || s >= powersOf10[NSDecimalMaxDigit - (x - e)])
+	return NO;
+      s *= powersOf10[x - e];
+      x = e;
+    }
+
+  if (n == *negative)
+    {
+      s += m;
+      if (s >= powersOf10[NSDecimalMaxDigit])
+	return NO;
+    }
+  else if (s >= m)
+    {
+      s -= m;
+    }
+  else
+    {
+      s = m - s;
+      *negative = n;
+    }
+  *sum = s;
+  *exponent = x;
+  return YES;
+}
+
+/* Add (or subtract) two non-zero valid numbers if the result is exact.
+ */
+static BOOL
+GSBinaryAdd(NSDecimal *result, const NSDecimal *left, const NSDecimal *right,
+  BOOL subtract)
+{
+  GSDecimalWide	sum;
+  int		exponent = left->exponent;
+  BOOL		negative = left->isNegative;
+
+  if (left->exponent > BINARY_EXPONENT_MAX
+    || right->exponent > BINARY_EXPONENT_MAX)
+    {
+      return NO;
+    }
+
+  /* When both aligned operands have at most 18 digits the sum fits in
+   * 64 bits, which covers most everyday (eg monetary) values.
+   */
+  if (left->length <= 18 && right->length <= 18)
+    {
+      int	shift = left->exponent - right->exponent;
+      uint64_t	l = GSDecimalMantissa64(left);
+      uint64_t	r = GSDecimalMantissa64(right);
+
+      if (shift > 0 && left->length + shift <= 18)
+	{
+	  l *= (uint64_t)powersOf10[shift];
+	  exponent = right->exponent;
+	  shift = 0;
+	}
+      else if (shift < 0 && right->length - shift <= 18)
+	{
+	  r *= (uint64_t)powersOf10[-shift];
+	  shift = 0;
+	}
+      if (0 == shift)
+	{
+	  if ((right->isNegative != subtract) == negative)
+	    {
+	      l += r;
+	    }
+	  else if (l >= r)
+	    {
+	      l -= r;
+	    }
+	  else
+	    {
+	      l = r - l;
+	      negative = !negative;
+	    }
+	  GSDecimalSetMantissa64(result, l, exponent, negative);
+	  return YES;
+	}
+    }
+
+  sum = GSDecimalMantissa(left);
+  if (NO == GSDecimalAccumulate(&sum, &exponent, &negative,
+    GSDecimalMantissa(right), right->exponent,
+    right->isNegative != subtract))
+    {
+      return NO;
+    }
+  GSDecimalSetMantissa(result, sum, exponent, negative);
+  return YES;
+}
+
+/* Divide the mantissa of l by that of r (both positive and non-zero) if
+ * the quotient is a terminating decimal short enough that the digit by
+ * digit division would produce it exactly.  Writing b as 2^x * 5^y * q,
+ * the quotient of a by b terminates if q divides a, and then needs at most
+ * max(x, y) fractional digits.
+ */
+static BOOL
+GSBinaryDivide(NSDecimal *result, const NSDecimal *l, const NSDecimal *r)
+{
+  GSDecimalWide	a;
+  GSDecimalWide	b;
+  GSDecimalWide	d;
+  int		twos = 0;
+  int		fives = 0;
+  int		scale;
+
+  if (l->exponent > BINARY_EXPONENT_MAX || r->exponent > BINARY_EXPONENT_MAX)
+    {
+      return NO;
+    }
+  a = GSDecimalMantissa(l);
+  b = GSDecimalMantissa(r);
+
+  /* This is much cheaper than reducing the fraction by the greatest
+   * common divisor, and rejects the common non-terminating case quickly.
+   */
+  d = b;
+  while (0 == (d & 1))
+    {
+      d >>= 1;
+      twos++;
+    }
+  while (0 == d % 5)
+    {
+      d /= 5;
+      fives++;
+    }
+  if (d != 1)
+    {
+      if (a <= UINT64_MAX && d <= UINT64_MAX)
+	{
+	  if ((uint64_t)a % (uint64_t)d != 0)
+	    {
+	      return NO;
+	    }
+	}
+      else if (a % d != 0)
+	{
+	  return NO;
+	}
+    }
+  scale = MAX(twos, fives);
+  /* Leave a margin below the digit limit of GSSimpleDivide().
+   */
+  if (l->length + scale > NSDecimalMaxDigit - 4)
+    {
+      return NO;
+    }
+  GSDecimalSetMantissa(result, a * powersOf10[scale] / b, -scale, NO);
+  return YES;
+}
+
+#else
+#define	GS_DECIMAL_BINARY	0
+#endif
+
 
 GS_DECLARE void
 NSDecimalCopy(NSDecimal *destination, const NSDecimal *source)
@@ -473,6 +852,13 @@ NSDecimalAdd(NSDecimal *result, const NSDecimal *left, const NSDecimal *right,
       return error;
     }
 
+#if	GS_DECIMAL_BINARY
+  if (binaryArithmetic() && GSBinaryAdd(result, left, right, NO))
+    {
+      return error;
+    }
+#endif
+
   // For different signs use subtraction
   if (left->isNegative != right->isNegative)
     {
@@ -568,6 +954,13 @@ NSDecimalSubtract(NSDecimal *result, const NSDecimal *left,
       return error;
     }
 
+#if	GS_DECIMAL_BINARY
+  if (binaryArithmetic() && GSBinaryAdd(result, left, right, YES))
+    {
+      return error;
+    }
+#endif
+
   // For different signs use addition
   if (left->isNegative != right->isNegative)
     {
@@ -675,24 +1068,36 @@ NSDecimalMultiply(NSDecimal *result, const NSDecimal *l, const NSDecimal *r,
       return NSCalculationOverflow;
     }
 
-  NSDecimalCopy(&n1, l);
-  NSDecimalCopy(&n2, r);
-  n1.exponent = 0;
-  n2.exponent = 0;
-  n1.isNegative = NO;
-  n2.isNegative = NO;
-  comp = NSSimpleCompare(&n1, &n2);
-
-  if (NSOrderedDescending == comp)
+#if	GS_DECIMAL_BINARY
+  /* A product of at most 38 digits is exact.
+   */
+  if (l->length + r->length <= NSDecimalMaxDigit && binaryArithmetic())
     {
-      error = GSSimpleMultiply(result, &n1, &n2, mode);
+      GSDecimalSetMantissa(result,
+	GSDecimalMantissa(l) * GSDecimalMantissa(r), 0, NO);
     }
   else
+#endif
     {
-      error = GSSimpleMultiply(result, &n2, &n1, mode);
-    }
+      NSDecimalCopy(&n1, l);
+      NSDecimalCopy(&n2, r);
+      n1.exponent = 0;
+      n2.exponent = 0;
+      n1.isNegative = NO;
+      n2.isNegative = NO;
+      comp = NSSimpleCompare(&n1, &n2);
 
-  NSDecimalCompact(result);
+      if (NSOrderedDescending == comp)
+	{
+	  error = GSSimpleMultiply(result, &n1, &n2, mode);
+	}
+      else
+	{
+	  error = GSSimpleMultiply(result, &n2, &n1, mode);
+	}
+
+      NSDecimalCompact(result);
+    }
   if (result->exponent + exp > 127)
     {
       result->validNumber = NO;
@@ -749,17 +1154,24 @@ NSDecimalDivide(NSDecimal *result, const NSDecimal *l, const NSDecimal *rr,
       return error;
     }
 
-  // Should also check for one
-
-  NSDecimalCopy(&n1, l);
-  n1.exponent = 0;
-  n1.isNegative = NO;
-  NSDecimalCopy(&n2, rr);
-  n2.exponent = 0;
-  n2.isNegative = NO;
+#if	GS_DECIMAL_BINARY
+  if (binaryArithmetic() && GSBinaryDivide(result, l, rr))
+    {
+      error = NSCalculationNoError;
+    }
+  else
+#endif
+    {
+      NSDecimalCopy(&n1, l);
+      n1.exponent = 0;
+      n1.isNegative = NO;
+      NSDecimalCopy(&n2, rr);
+      n2.exponent = 0;
+      n2.isNegative = NO;
 
-  error = GSSimpleDivide(result, &n1, &n2, mode);
-  NSDecimalCompact(result);
+      error = GSSimpleDivide(result, &n1, &n2, mode);
+      NSDecimalCompact(result);
+    }
 
   if (result->exponent + exp > 127)
     {
@@ -849,6 +1261,102 @@ NSDecimalMultiplyByPowerOf10(NSDecimal *result, const NSDecimal *n, short power,
   return NSCalculationNoError;
 }
 
+/* Sum the terms a[i] (or the products a[i] * b[i] if b is not NULL),
+ * giving the same result as adding them one at a time.
+ */
+static NSCalculationError
+GSDecimalSumTerms(NSDecimal *result, const NSDecimal *a, const NSDecimal *b,
+  NSUInteger count, NSRoundingMode mode)
+{
+  NSCalculationError	error = NSCalculationNoError;
+  NSCalculationError	e;
+  NSDecimal		sum;
+  NSDecimal		term;
+  NSUInteger		i = 0;
+
+  NSDecimalCopy(&sum, &zero);
+#if	GS_DECIMAL_BINARY
+  /* Accumulate exact terms in binary for as long as the sum stays exact,
+   * then carry on one term at a time from there.
+   */
+  if (binaryArithmetic())
+    {
+      GSDecimalWide	acc = 0;
+      int		exponent = 0;
+      BOOL		negative = NO;
+
+      for (; i < count; i++)
+	{
+	  const NSDecimal	*x = &a[i];
+	  GSDecimalWide		m;
+	  int			ex;
+	  BOOL			neg;
+
+	  if (!x->validNumber)
+	    break;
+	  if (NULL == b)
+	    {
+	      m = GSDecimalMantissa(x);
+	      ex = x->exponent;
+	      neg = x->isNegative;
+	    }
+	  else
+	    {
+	      const NSDecimal	*y = &b[i];
+
+	      if (!y->validNumber
+		|| x->length + y->length > NSDecimalMaxDigit)
+		break;
+	      ex = x->exponent + y->exponent;
+	      if (ex < -128)
+		break;
+	      m = GSDecimalMantissa(x) * GSDecimalMantissa(y);
+	      neg = x->isNegative != y->isNegative;
+	    }
+	  if (ex > BINARY_EXPONENT_MAX)
+	    break;
+	  if (m != 0
+	    && NO == GSDecimalAccumulate(&acc, &exponent, &negative, m, ex, neg))
+	    break;
+	}
+      GSDecimalSetMantissa(&sum, acc, exponent, negative);
+    }
+#endif
+
+  for (; i < count; i++)
+    {
+      if (NULL == b)
+	{
+	  e = NSDecimalAdd(&sum, &sum, &a[i], mode);
+	}
+      else
+	{
+	  e = NSDecimalMultiply(&term, &a[i], &b[i], mode);
+	  if (NSCalculationNoError == error)
+	    error = e;
+	  e = NSDecimalAdd(&sum, &sum, &term, mode);
+	}
+      if (NSCalculationNoError == error)
+	error = e;
+    }
+  NSDecimalCopy(result, &sum);
+  return error;
+}
+
+GS_DECLARE NSCalculationError
+NSDecimalSum(NSDecimal *result, const NSDecimal *values, NSUInteger count,
+  NSRoundingMode mode)
+{
+  return GSDecimalSumTerms(result, values, NULL, count, mode);
+}
+
+GS_DECLARE NSCalculationError
+NSDecimalDotProduct(NSDecimal *result, const NSDecimal *a, const NSDecimal *b,
+  NSUInteger count, NSRoundingMode mode)
+{
+  return GSDecimalSumTerms(result, a, b, count, mode);
+}
+
 static NSString*
 GSDecimalString(const GSDecimal *number, NSDictionary *locale)
 {
@@ -951,6 +951,22 @@ GS_ROOT_CLASS @interface	GSDistantObjectPlaceHolder
 
 @end
 
+
+@implementation NSDistantObject (GSDistantFuture)
+
+- (GSDistantFuture*) sendInvocation: (NSInvocation*)inv
+{
+  if (![_connection isValid])
+    [NSException
+	   raise: NSGenericException
+	  format: @"Trying to send message to an invalid Proxy."];
+
+  [inv setTarget: self];
+  return [_connection sendInvocation: inv forProxy: self];
+}
+
+@end
+
 
 @implementation Protocol (DistributedObjectsCoding)
 
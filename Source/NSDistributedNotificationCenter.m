@@ -32,6 +32,9 @@
 #import	"Foundation/NSException.h"
 #import	"Foundation/NSFileManager.h"
 #import	"Foundation/NSArchiver.h"
+#import	"Foundation/NSArray.h"
+#import	"Foundation/NSNull.h"
+#import	"Foundation/NSValue.h"
 #import	"Foundation/NSNotification.h"
 #import	"Foundation/NSDate.h"
 #import	"Foundation/NSPathUtilities.h"
@@ -55,6 +58,7 @@
 		     userInfo: (NSData*)info
 		     selector: (NSString*)aSelector
 			   to: (uint64_t)observer;
+- (oneway void) postNotificationBatch: (NSData*)batch;
 @end
 
 /**
@@ -546,6 +550,7 @@ static gs_mutex_t 			classLock = GS_MUTEX_INIT_STATIC;
 		  deliverImmediately: (BOOL)deliverImmediately
 			         for: (id<GDNCClient>)client;
 - (void) registerClient: (id<GDNCClient>)client;
+- (void) registerBatchingClient: (id<GDNCClient>)client;
 - (void) removeObserver: (uint64_t)anObserver
 		   name: (NSString*)notificationname
 		 object: (NSString*)anObject
@@ -574,6 +579,9 @@ static gs_mutex_t 			classLock = GS_MUTEX_INIT_STATIC;
 - (void) registerClient: (id<GDNCClient>)client
 {
 }
+- (void) registerBatchingClient: (id<GDNCClient>)client
+{
+}
 - (void) removeObserver: (uint64_t)anObserver
 		   name: (NSString*)notificationname
 		 object: (NSString*)anObject
@@ -799,7 +807,19 @@ static gs_mutex_t 			classLock = GS_MUTEX_INIT_STATIC;
 	   selector: @selector(_invalidated:)
 	       name: NSConnectionDidDieNotification
 	     object: c];
-      [_remote registerClient: (id<GDNCClient>)self];
+      /*
+       *	Ask for notifications to be sent in batches, falling back to
+       *	one message per notification with an older server.
+       */
+      NS_DURING
+	{
+	  [_remote registerBatchingClient: (id<GDNCClient>)self];
+	}
+      NS_HANDLER
+	{
+	  [_remote registerClient: (id<GDNCClient>)self];
+	}
+      NS_ENDHANDLER
     }
 }
 
@@ -838,5 +858,38 @@ static gs_mutex_t 			classLock = GS_MUTEX_INIT_STATIC;
 		  withObject: notification];
 }
 
+- (oneway void) postNotificationBatch: (NSData*)batch
+{
+  NSArray	*entries = [NSUnarchiver unarchiveObjectWithData: batch];
+  NSNull	*null = [NSNull null];
+  NSUInteger	count = [entries count];
+  NSUInteger	index;
+
+  for (index = 0; index < count; index++)
+    {
+      NSArray	*e = [entries objectAtIndex: index];
+      id	object = [e objectAtIndex: 1];
+      id	info = [e objectAtIndex: 2];
+
+      /* An exception in one observer must not lose the rest of the batch.
+       */
+      NS_DURING
+	{
+	  [self postNotificationName: [e objectAtIndex: 0]
+			      object: (object == null ? nil : object)
+			    userInfo: (info == null ? nil : info)
+			    selector: [e objectAtIndex: 3]
+				  to: [[e objectAtIndex: 4]
+				    unsignedLongLongValue]];
+	}
+      NS_HANDLER
+	{
+	  NSLog(@"Problem delivering distributed notification: %@",
+	    localException);
+	}
+      NS_ENDHANDLER
+    }
+}
+
 @end
 
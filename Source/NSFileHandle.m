@@ -1154,6 +1154,23 @@ GSTLSHandlePush(gnutls_transport_ptr_t handle, const void *buffer, size_t len)
               ASSIGNCOPY(opts, d);
             }
         }
+      /* Let a client resume an earlier session with the same remote end.
+       */
+      if (YES == isOutgoing
+        && nil == [opts objectForKey: GSTLSSessionCacheKey])
+        {
+          NSString              *a = [self socketAddress];
+          NSString              *p = [self socketService];
+
+          if (nil != a && nil != p)
+            {
+              NSMutableDictionary   *d = AUTORELEASE([opts mutableCopy]);
+
+              [d setObject: [NSString stringWithFormat: @"%@:%@", a, p]
+                    forKey: GSTLSSessionCacheKey];
+              ASSIGNCOPY(opts, d);
+            }
+        }
       [self setNonBlocking: YES];
       session = [[GSTLSSession alloc] initWithOptions: opts
                                             direction: isOutgoing
@@ -21,11 +21,145 @@
    Software Foundation, Inc., 31 Milk Street #960789 Boston, MA 02196 USA.
 */
 
+#import "common.h"
+#import "Foundation/NSArray.h"
 #import "Foundation/NSCoder.h"
 #import "Foundation/NSDateFormatter.h"
 #import "Foundation/NSISO8601DateFormatter.h"
+#import "Foundation/NSNull.h"
 #import "Foundation/NSString.h"
 #import "Foundation/NSTimeZone.h"
+#import "GSPrivate.h"
+
+#include <math.h>
+
+/* The ICU formatter of an NSISO8601DateFormatter, which also holds what
+ * the fast paths cache, so that the public instance layout is unchanged.
+ */
+@interface GSISO8601Formatter : NSDateFormatter
+{
+@public
+  NSString		*_format;	// ICU format, or nil if not configured
+  NSTimeZone		*_offsetZone;	// Zone for which the offset is cached
+  NSTimeInterval	_offsetFrom;	// Start of range the offset is valid for
+  NSTimeInterval	_offsetUntil;	// End of range the offset is valid for
+  NSInteger		_offset;	// Cached offset from GMT in seconds
+}
+@end
+
+@implementation GSISO8601Formatter
+- (void) dealloc
+{
+  RELEASE(_format);
+  RELEASE(_offsetZone);
+  [super dealloc];
+}
+@end
+
+#define	CACHE	((GSISO8601Formatter*)_formatter)
+
+/* The fixed layouts of ISO 8601 calendar dates are formatted and parsed
+ * here without the ICU date formatter (which is slow to use, and to
+ * reconfigure).  The ICU formatter remains in use for week dates, for
+ * years which ICU would treat differently (those before the Gregorian
+ * calendar reform and beyond four digits), and for any string the fast
+ * parser does not understand, so behavior is unchanged in those cases.
+ */
+
+/* Days since 1970-01-01 of a date in the proleptic Gregorian calendar.
+ */
+static inline int64_t
+daysFromCivil(int64_t y, unsigned m, unsigned d)
+{
+  int64_t	era;
+  unsigned	yoe;
+  unsigned	doy;
+  unsigned	doe;
+
+  y -= (m <= 2);
+  era = (y >= 0 ? y : y - 399) / 400;
+  yoe = (unsigned)(y - era * 400);
+  doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int64_t)doe - 719468;
+}
+
+/* Date in the proleptic Gregorian calendar for days since 1970-01-01.
+ */
+static inline void
+civilFromDays(int64_t z, int64_t *y, unsigned *m, unsigned *d)
+{
+  int64_t	era;
+  unsigned	doe;
+  unsigned	yoe;
+  unsigned	doy;
+  unsigned	mp;
+
+  z += 719468;
+  era = (z >= 0 ? z : z - 146096) / 146097;
+  doe = (unsigned)(z - era * 146097);
+  yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  mp = (5 * doy + 2) / 153;
+  *d = doy - (153 * mp + 2) / 5 + 1;
+  *m = mp < 10 ? mp + 3 : mp - 9;
+  *y = (int64_t)yoe + era * 400 + (*m <= 2);
+}
+
+static inline int64_t
+floorDiv(int64_t a, int64_t b)
+{
+  int64_t	q = a / b;
+
+  return (q * b > a) ? q - 1 : q;
+}
+
+static const unsigned char monthDays[12] = {
+  31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+};
+
+static inline char *
+putDigits(char *p, unsigned v, unsigned width)
+{
+  char	*e = p + width;
+
+  while (e > p)
+    {
+      *--e = '0' + v % 10;
+      v /= 10;
+    }
+  return p + width;
+}
+
+static inline BOOL
+getDigits(const char **p, unsigned width, unsigned *v)
+{
+  const char	*s = *p;
+  unsigned	r = 0;
+
+  while (width-- > 0)
+    {
+      if (*s < '0' || *s > '9')
+	{
+	  return NO;
+	}
+      r = r * 10 + (*s++ - '0');
+    }
+  *p = s;
+  *v = r;
+  return YES;
+}
+
+static inline BOOL
+getChar(const char **p, char c)
+{
+  if (**p != c)
+    {
+      return NO;
+    }
+  (*p)++;
+  return YES;
+}
 
 @implementation NSISO8601DateFormatter
 
@@ -142,13 +276,329 @@
   return result;
 }
 
+/* The zone dates are formatted in, with the local time zone (which
+ * follows the default time zone) resolved to the actual zone.
+ */
+- (NSTimeZone *) _zone
+{
+  if (nil == _timeZone || [NSTimeZone localTimeZone] == _timeZone)
+    {
+      return [NSTimeZone defaultTimeZone];
+    }
+  return _timeZone;
+}
+
+/* Returns the offset of zone at the time t (seconds since 1970), caching
+ * it for the period up to the next transition of the zone.
+ */
+- (NSInteger) _offsetAt: (NSTimeInterval)t zone: (NSTimeZone *)zone
+{
+  GSISO8601Formatter	*c = CACHE;
+
+  if (zone != c->_offsetZone || t < c->_offsetFrom || t >= c->_offsetUntil)
+    {
+      ASSIGN(c->_offsetZone, zone);
+      c->_offset = GSPrivateTimeZoneOffset(zone, t,
+	&c->_offsetFrom, &c->_offsetUntil);
+    }
+  return c->_offset;
+}
+
+- (NSDateFormatter *) _formatterForZone: (NSTimeZone *)zone
+{
+  if (nil == CACHE->_format)
+    {
+      CACHE->_format = RETAIN([self _buildFormatWithOptions]);
+      [_formatter setDateFormat: CACHE->_format];
+    }
+  if ([_formatter timeZone] != zone)
+    {
+      [_formatter setTimeZone: zone];
+    }
+  return _formatter;
+}
+
+- (NSDate *) _dateFromString: (NSString *)string zone: (NSTimeZone *)zone
+{
+  NSISO8601DateFormatOptions	o = _formatOptions;
+  char				buf[48];
+  const char			*p = buf;
+  unsigned			year = 1970;
+  unsigned			month = 1;
+  unsigned			day = 1;
+  unsigned			hour = 0;
+  unsigned			minute = 0;
+  unsigned			second = 0;
+  unsigned			millis = 0;
+  BOOL				hasDate = NO;
+  BOOL				hasZone = NO;
+  NSInteger			offset = 0;
+  int64_t			local;
+  NSTimeInterval		t;
+
+  if ((o & NSISO8601DateFormatWithWeekOfYear)
+    || NO == [string getCString: buf
+		      maxLength: sizeof(buf)
+		       encoding: NSASCIIStringEncoding])
+    {
+      goto icu;
+    }
+
+  if (o & NSISO8601DateFormatWithYear)
+    {
+      if (NO == getDigits(&p, 4, &year))
+	{
+	  goto icu;
+	}
+      hasDate = YES;
+    }
+  if (o & NSISO8601DateFormatWithMonth)
+    {
+      if (((o & NSISO8601DateFormatWithDashSeparatorInDate)
+	&& NO == getChar(&p, '-'))
+	|| NO == getDigits(&p, 2, &month))
+	{
+	  goto icu;
+	}
+      hasDate = YES;
+    }
+  if (o & NSISO8601DateFormatWithDay)
+    {
+      if (((o & NSISO8601DateFormatWithDashSeparatorInDate)
+	&& NO == getChar(&p, '-'))
+	|| NO == getDigits(&p, 2, &day))
+	{
+	  goto icu;
+	}
+      hasDate = YES;
+    }
+  if (o & NSISO8601DateFormatWithTime)
+    {
+      BOOL	colon = (o & NSISO8601DateFormatWithColonSeparatorInTime) != 0;
+
+      if (hasDate && NO == getChar(&p,
+	(o & NSISO8601DateFormatWithSpaceBetweenDateAndTime) ? ' ' : 'T'))
+	{
+	  goto icu;
+	}
+      if (NO == getDigits(&p, 2, &hour)
+	|| (colon && NO == getChar(&p, ':'))
+	|| NO == getDigits(&p, 2, &minute)
+	|| (colon && NO == getChar(&p, ':'))
+	|| NO == getDigits(&p, 2, &second))
+	{
+	  goto icu;
+	}
+      if ((o & NSISO8601DateFormatWithFractionalSeconds)
+	&& (NO == getChar(&p, '.') || NO == getDigits(&p, 3, &millis)))
+	{
+	  goto icu;
+	}
+    }
+  if (o & NSISO8601DateFormatWithTimeZone)
+    {
+      BOOL	colon;
+      char	sign = *p;
+      unsigned	hh;
+      unsigned	mm;
+
+      colon = (o & NSISO8601DateFormatWithColonSeparatorInTimeZone) != 0;
+      if (colon && getChar(&p, 'Z'))
+	{
+	  offset = 0;
+	}
+      else
+	{
+	  if ((sign != '+' && sign != '-')
+	    || (p++, NO == getDigits(&p, 2, &hh))
+	    || (colon && NO == getChar(&p, ':'))
+	    || NO == getDigits(&p, 2, &mm)
+	    || hh > 23 || mm > 59)
+	    {
+	      goto icu;
+	    }
+	  offset = (hh * 60 + mm) * 60;
+	  if ('-' == sign)
+	    {
+	      offset = -offset;
+	    }
+	}
+      hasZone = YES;
+    }
+  if (*p != '\0'
+    || year < 1583 || month < 1 || month > 12 || day < 1
+    || hour > 23 || minute > 59 || second > 59)
+    {
+      goto icu;
+    }
+  if (day > monthDays[month - 1])
+    {
+      if (2 != month || day > 29
+	|| (year % 4 != 0 || (year % 100 == 0 && year % 400 != 0)))
+	{
+	  goto icu;
+	}
+    }
+
+  local = daysFromCivil(year, month, day) * 86400
+    + hour * 3600 + minute * 60 + second;
+  if (NO == hasZone)
+    {
+      /* Convert from local time using the offset at the resulting time.
+       * Near a transition a local time may be repeated or skipped, and
+       * we leave ICU to decide what those mean.
+       */
+      offset = [self _offsetAt: (NSTimeInterval)local zone: zone];
+      if ((NSTimeInterval)(local - offset) - 86400.0 < CACHE->_offsetFrom
+	|| (NSTimeInterval)(local - offset) + 86400.0 >= CACHE->_offsetUntil)
+	{
+	  goto icu;
+	}
+    }
+  t = (NSTimeInterval)(local - offset) + millis / 1000.0;
+  return [NSDate dateWithTimeIntervalSince1970: t];
+
+icu:
+  return [[self _formatterForZone: zone] dateFromString: string];
+}
+
+- (NSString *) _stringFromDate: (NSDate *)date zone: (NSTimeZone *)zone
+{
+  NSISO8601DateFormatOptions	o = _formatOptions;
+  NSTimeInterval		t = [date timeIntervalSince1970];
+  char				buf[48];
+  char				*p = buf;
+  BOOL				hasDate = NO;
+  NSInteger			offset;
+  int64_t			ms;
+  int64_t			secs;
+  int64_t			days;
+  int64_t			year;
+  unsigned			month;
+  unsigned			day;
+  unsigned			sod;
+  unsigned			frac;
+
+  if (nil == date
+    || (o & NSISO8601DateFormatWithWeekOfYear)
+    || !(t > -1.0e12 && t < 1.0e12))
+    {
+      goto icu;
+    }
+  offset = [self _offsetAt: t zone: zone];
+  if ((o & NSISO8601DateFormatWithTimeZone) && offset % 60 != 0)
+    {
+      goto icu;
+    }
+  ms = (int64_t)floor(t * 1000.0) + (int64_t)offset * 1000;
+  secs = floorDiv(ms, 1000);
+  frac = (unsigned)(ms - secs * 1000);
+  days = floorDiv(secs, 86400);
+  sod = (unsigned)(secs - days * 86400);
+  civilFromDays(days, &year, &month, &day);
+  if (year < 1583 || year > 9999)
+    {
+      goto icu;
+    }
+
+  if (o & NSISO8601DateFormatWithYear)
+    {
+      p = putDigits(p, (unsigned)year, 4);
+      hasDate = YES;
+    }
+  if (o & NSISO8601DateFormatWithMonth)
+    {
+      if (o & NSISO8601DateFormatWithDashSeparatorInDate)
+	{
+	  *p++ = '-';
+	}
+      p = putDigits(p, month, 2);
+      hasDate = YES;
+    }
+  if (o & NSISO8601DateFormatWithDay)
+    {
+      if (o & NSISO8601DateFormatWithDashSeparatorInDate)
+	{
+	  *p++ = '-';
+	}
+      p = putDigits(p, day, 2);
+      hasDate = YES;
+    }
+  if (o & NSISO8601DateFormatWithTime)
+    {
+      BOOL	colon = (o & NSISO8601DateFormatWithColonSeparatorInTime) != 0;
+
+      if (hasDate)
+	{
+	  *p++ = (o & NSISO8601DateFormatWithSpaceBetweenDateAndTime)
+	    ? ' ' : 'T';
+	}
+      p = putDigits(p, sod / 3600, 2);
+      if (colon)
+	{
+	  *p++ = ':';
+	}
+      p = putDigits(p, (sod / 60) % 60, 2);
+      if (colon)
+	{
+	  *p++ = ':';
+	}
+      p = putDigits(p, sod % 60, 2);
+      if (o & NSISO8601DateFormatWithFractionalSeconds)
+	{
+	  *p++ = '.';
+	  p = putDigits(p, frac, 3);
+	}
+    }
+  if (o & NSISO8601DateFormatWithTimeZone)
+    {
+      BOOL	colon;
+      unsigned	minutes;
+
+      colon = (o & NSISO8601DateFormatWithColonSeparatorInTimeZone) != 0;
+      if (colon && 0 == offset)
+	{
+	  *p++ = 'Z';
+	}
+      else
+	{
+	  *p++ = (offset < 0) ? '-' : '+';
+	  minutes = (unsigned)((offset < 0 ? -offset : offset) / 60);
+	  p = putDigits(p, minutes / 60, 2);
+	  if (colon)
+	    {
+	      *p++ = ':';
+	    }
+	  p = putDigits(p, minutes % 60, 2);
+	}
+    }
+  return AUTORELEASE([[NSString alloc] initWithBytes: buf
+					      length: p - buf
+					    encoding: NSASCIIStringEncoding]);
+
+icu:
+  return [[self _formatterForZone: zone] stringFromDate: date];
+}
+
 - (NSDate *) dateFromString: (NSString *)string
 {
-  NSString *formatString = [self _buildFormatWithOptions];
+  return [self _dateFromString: string zone: [self _zone]];
+}
+
+- (NSArray *) datesFromStrings: (NSArray *)strings
+{
+  NSTimeZone		*zone = [self _zone];
+  NSMutableArray	*result;
+
+  result = [NSMutableArray arrayWithCapacity: [strings count]];
+  GS_FOR_IN(NSString*, string, strings)
+    {
+      NSDate	*d = [self _dateFromString: string zone: zone];
 
-  [_formatter setTimeZone: _timeZone];
-  [_formatter setDateFormat: formatString];
-  return [_formatter dateFromString: string];
+      [result addObject: (nil == d) ? (id)[NSNull null] : (id)d];
+    }
+  GS_END_FOR(strings)
+  return result;
 }
 
 - (oneway void) dealloc
@@ -183,7 +633,7 @@
   self = [super init];
   if (self != nil)
     {
-      _formatter = [[NSDateFormatter alloc] init];
+      _formatter = [[GSISO8601Formatter alloc] init];
       _timeZone = RETAIN([NSTimeZone localTimeZone]);
       _formatOptions = NSISO8601DateFormatWithInternetDateTime;
     }
@@ -194,7 +644,7 @@
 {
   if ((self = [super initWithCoder: decoder]) != nil)
     {
-      _formatter = [[NSDateFormatter alloc] init];
+      _formatter = [[GSISO8601Formatter alloc] init];
       if ([decoder allowsKeyedCoding])
         {
           ASSIGN(_timeZone, [decoder decodeObjectForKey: @"NS.timeZone"]);
@@ -211,21 +661,37 @@
 }
 - (void) setFormatOptions: (NSISO8601DateFormatOptions)options
 {
-  _formatOptions = options;
+  if (options != _formatOptions)
+    {
+      _formatOptions = options;
+      DESTROY(CACHE->_format);
+    }
 }
   
 - (void) setTimeZone: (NSTimeZone *)tz
 {
-  _timeZone = tz;
+  ASSIGN(_timeZone, tz);
 }
 
 - (NSString *) stringFromDate: (NSDate *)date
 {
-  NSString *formatString = [self _buildFormatWithOptions];
+  return [self _stringFromDate: date zone: [self _zone]];
+}
+
+- (NSArray *) stringsFromDates: (NSArray *)dates
+{
+  NSTimeZone		*zone = [self _zone];
+  NSMutableArray	*result;
 
-  [_formatter setTimeZone: _timeZone];
-  [_formatter setDateFormat: formatString];
-  return [_formatter stringFromDate: date];
+  result = [NSMutableArray arrayWithCapacity: [dates count]];
+  GS_FOR_IN(NSDate*, date, dates)
+    {
+      NSString	*s = [self _stringFromDate: date zone: zone];
+
+      [result addObject: (nil == s) ? (id)[NSNull null] : (id)s];
+    }
+  GS_END_FOR(dates)
+  return result;
 }
 
 - (NSString *) stringForObjectValue: (id)obj
@@ -53,3 +53,31 @@
 
 id
 valueForKeyWithCaching(id obj, NSString *aKey) GS_ATTRIB_PRIVATE;
+
+/* The collection operators which aggregateForKeyWithCaching() evaluates.
+ */
+typedef enum {
+  GSKVCSum,
+  GSKVCAvg,
+  GSKVCMax,
+  GSKVCMin
+} GSKVCAggregate;
+
+/* Store the value of aKey for each object in collection in values (which
+ * must have space for them all), as -valueForKey: would, looking up the
+ * accessor once for each run of objects of the same class.  Objects whose
+ * class implements its own -valueForKey: are sent it.  Returns the number
+ * of values stored, any of which may be nil.
+ */
+NSUInteger
+valuesForKeyWithCaching(id collection, NSString *aKey, id *values)
+  GS_ATTRIB_PRIVATE;
+
+/* Return the result of the @sum, @avg, @max or @min operator for aKey (a
+ * key path) over the objects in collection, reading scalar values straight
+ * from the getter or instance variable instead of boxing each of them in
+ * an NSNumber.
+ */
+id
+aggregateForKeyWithCaching(id collection, NSString *aKey, GSKVCAggregate op)
+  GS_ATTRIB_PRIVATE;
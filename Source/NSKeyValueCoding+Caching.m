@@ -595,39 +595,20 @@ ValueForKeyLookup(Class cls, NSObject *self, NSString *boxedKey,
   return slot;
 }
 
-id
-valueForKeyWithCaching(id obj, NSString *aKey)
+static GSIMapTable_t  cacheTable = {};
+static gs_mutex_t     cacheTableLock = GS_MUTEX_INIT_STATIC;
+
+/* Return the shared slot for the getter of aKey (whose hash is given) in
+ * cls, looking it up and adding it to the table if needed, or NULL if the
+ * key is undefined for the class.
+ */
+static struct _KVCCacheSlot *
+_KVCSlotForClassAndKey(Class cls, id obj, NSString *aKey, uintptr_t hash)
 {
   struct _KVCCacheSlot *cachedSlot = NULL;
   GSIMapNode            node = NULL;
-  static GSIMapTable_t  cacheTable = {};
-  static gs_mutex_t     cacheTableLock = GS_MUTEX_INIT_STATIC;
-
-  struct _KVCThreadCache *threadCache = NULL;
-  unsigned int           threadCacheIndex = 0;
-
-  Class cls = object_getClass(obj);
   // Fill out the required fields for hashing
-  struct _KVCCacheSlot slot = {.cls = cls, .hash = [aKey hash]};
-
-  if (__atomic_load_n(&kvcThreadCacheKeyReady, __ATOMIC_ACQUIRE))
-    {
-      threadCache = GS_THREAD_KEY_GET(kvcThreadCacheKey);
-      threadCacheIndex = (unsigned int)
-        (((uintptr_t) cls ^ (uintptr_t) slot.hash) % KVC_THREAD_CACHE_SIZE);
-      if (threadCache != NULL)
-        {
-          cachedSlot = threadCache->slots[threadCacheIndex];
-          if (cachedSlot != NULL
-            && cachedSlot->cls == cls
-            && cachedSlot->hash == slot.hash
-            && cachedSlot->version == objc_method_cache_version)
-            {
-              return cachedSlot->get(cachedSlot, obj);
-            }
-          cachedSlot = NULL;
-        }
-    }
+  struct _KVCCacheSlot slot = {.cls = cls, .hash = hash};
 
   GS_MUTEX_LOCK(cacheTableLock);
   if (cacheTable.zone == 0)
@@ -653,7 +634,7 @@ valueForKeyWithCaching(id obj, NSString *aKey)
       if (slot.contents != 0)
         {
           slot.cls = cls;
-          slot.hash = [aKey hash];
+          slot.hash = hash;
 
           // Copy slot to heap
           cachedSlot
@@ -666,7 +647,7 @@ valueForKeyWithCaching(id obj, NSString *aKey)
         }
       else
         {
-          return [obj valueForUndefinedKey:aKey];
+          return NULL;
         }
     }
   cachedSlot = node->key.ptr;
@@ -681,12 +662,57 @@ valueForKeyWithCaching(id obj, NSString *aKey)
       // as it is unlikely, that the return type has changed.
       slot
         = ValueForKeyLookup(cls, obj, aKey, [aKey UTF8String], [aKey length]);
+      // Keep the fields the table hashes on.
+      slot.cls = cls;
+      slot.hash = hash;
 
       // Update entry
       GS_MUTEX_LOCK(cacheTableLock);
       memcpy(cachedSlot, &slot, sizeof(struct _KVCCacheSlot));
       GS_MUTEX_UNLOCK(cacheTableLock);
     }
+  if (cachedSlot->get == NULL)
+    {
+      return NULL;
+    }
+  return cachedSlot;
+}
+
+id
+valueForKeyWithCaching(id obj, NSString *aKey)
+{
+  struct _KVCCacheSlot *cachedSlot = NULL;
+  struct _KVCThreadCache *threadCache = NULL;
+  unsigned int           threadCacheIndex = 0;
+
+  Class cls = object_getClass(obj);
+  uintptr_t hash = [aKey hash];
+
+  threadCacheIndex = (unsigned int)
+    (((uintptr_t) cls ^ hash) % KVC_THREAD_CACHE_SIZE);
+  if (__atomic_load_n(&kvcThreadCacheKeyReady, __ATOMIC_ACQUIRE))
+    {
+      threadCache = GS_THREAD_KEY_GET(kvcThreadCacheKey);
+      if (threadCache != NULL)
+        {
+          cachedSlot = threadCache->slots[threadCacheIndex];
+          if (cachedSlot != NULL
+            && cachedSlot->cls == cls
+            && cachedSlot->hash == hash
+            && cachedSlot->version == objc_method_cache_version
+            && cachedSlot->get != NULL)
+            {
+              return cachedSlot->get(cachedSlot, obj);
+            }
+          cachedSlot = NULL;
+        }
+    }
+
+  cachedSlot = _KVCSlotForClassAndKey(cls, obj, aKey, hash);
+  if (cachedSlot == NULL)
+    {
+      return [obj valueForUndefinedKey:aKey];
+    }
 
   if (__atomic_load_n(&kvcThreadCacheKeyReady, __ATOMIC_ACQUIRE))
     {
@@ -701,8 +727,6 @@ valueForKeyWithCaching(id obj, NSString *aKey)
                   GS_THREAD_KEY_SET(kvcThreadCacheKey, threadCache);
                 }
             }
-          threadCacheIndex = (unsigned int)
-            (((uintptr_t) cls ^ (uintptr_t) slot.hash) % KVC_THREAD_CACHE_SIZE);
         }
       if (threadCache != NULL)
         {
@@ -712,3 +736,291 @@ valueForKeyWithCaching(id obj, NSString *aKey)
 
   return cachedSlot->get(cachedSlot, obj);
 }
+
+/* The accessor for a key in one class, as used by the collection functions
+ * below while they step through a run of objects of the same class.
+ */
+struct _KVCRun
+{
+  Class                 cls;
+  NSString             *key;
+  uintptr_t             hash;
+  BOOL                  isPath;   // Objects are sent -valueForKeyPath:
+  BOOL                  simple;   // Key is not a path
+  struct _KVCCacheSlot *slot;     // NULL if objects must be sent messages
+};
+
+static IMP keyIMP = 0;
+static IMP pathIMP = 0;
+
+static inline void
+_KVCRunStart(struct _KVCRun *run, NSString *key, BOOL isPath)
+{
+  if (0 == pathIMP)
+    {
+      keyIMP = class_getMethodImplementation([NSObject class],
+        @selector(valueForKey:));
+      pathIMP = class_getMethodImplementation([NSObject class],
+        @selector(valueForKeyPath:));
+    }
+  run->cls = Nil;
+  run->key = key;
+  run->hash = [key hash];
+  run->isPath = isPath;
+  run->simple = YES;
+  if (isPath && [key rangeOfString: @"."].length > 0)
+    {
+      run->simple = NO;
+    }
+  run->slot = NULL;
+}
+
+/* Make run refer to the class of obj.  The cached getter is only used for
+ * classes which inherit -valueForKey: (and -valueForKeyPath: if that is the
+ * message the objects would be sent) from NSObject.
+ */
+static inline void
+_KVCRunClass(struct _KVCRun *run, id obj)
+{
+  Class cls = object_getClass(obj);
+
+  if (cls != run->cls)
+    {
+      run->cls = cls;
+      run->slot = NULL;
+      if (run->simple
+        && class_getMethodImplementation(cls, @selector(valueForKey:))
+          == keyIMP
+        && (NO == run->isPath
+          || class_getMethodImplementation(cls, @selector(valueForKeyPath:))
+            == pathIMP))
+        {
+          run->slot = _KVCSlotForClassAndKey(cls, obj, run->key, run->hash);
+        }
+    }
+  else if (run->slot != NULL
+    && run->slot->version != objc_method_cache_version)
+    {
+      run->slot = _KVCSlotForClassAndKey(cls, obj, run->key, run->hash);
+    }
+}
+
+static inline id
+_KVCRunValue(struct _KVCRun *run, id obj)
+{
+  if (run->slot != NULL)
+    {
+      return run->slot->get(run->slot, obj);
+    }
+  if (run->isPath)
+    {
+      return [obj valueForKeyPath: run->key];
+    }
+  return [obj valueForKey: run->key];
+}
+
+NSUInteger
+valuesForKeyWithCaching(id collection, NSString *aKey, id *values)
+{
+  struct _KVCRun run;
+  NSUInteger     i = 0;
+
+  _KVCRunStart(&run, aKey, NO);
+  for (id o in collection)
+    {
+      _KVCRunClass(&run, o);
+      values[i++] = _KVCRunValue(&run, o);
+    }
+  return i;
+}
+
+/* A scalar read straight from a getter or instance variable.  The kind is
+ * 'i' for signed integers, 'u' for unsigned integers and 'd' for floating
+ * point values.
+ */
+struct _KVCScalar
+{
+  char kind;
+  char type;
+  union
+  {
+    long long          i;
+    unsigned long long u;
+    double             d;
+  };
+};
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wcast-align"
+
+#define KVC_READ_SCALAR(_type, _field)                                         \
+  if (slot->selector != 0)                                                     \
+    {                                                                          \
+      v->_field = ((_type(*)(id, SEL)) slot->imp)(obj, slot->selector);        \
+    }                                                                          \
+  else                                                                         \
+    {                                                                          \
+      v->_field = *(_type *) ((char *) obj + slot->offset);                    \
+    }
+
+static inline BOOL
+_KVCReadScalar(struct _KVCCacheSlot *slot, id obj, struct _KVCScalar *v)
+{
+  v->type = slot->types[0];
+  switch (v->type)
+    {
+      case 'c': v->kind = 'i'; KVC_READ_SCALAR(char, i); return YES;
+      case 's': v->kind = 'i'; KVC_READ_SCALAR(short, i); return YES;
+      case 'i': v->kind = 'i'; KVC_READ_SCALAR(int, i); return YES;
+      case 'l': v->kind = 'i'; KVC_READ_SCALAR(long, i); return YES;
+      case 'q': v->kind = 'i'; KVC_READ_SCALAR(long long, i); return YES;
+      case 'B': v->kind = 'u'; KVC_READ_SCALAR(bool, u); return YES;
+      case 'C': v->kind = 'u'; KVC_READ_SCALAR(unsigned char, u); return YES;
+      case 'S': v->kind = 'u'; KVC_READ_SCALAR(unsigned short, u); return YES;
+      case 'I': v->kind = 'u'; KVC_READ_SCALAR(unsigned int, u); return YES;
+      case 'L': v->kind = 'u'; KVC_READ_SCALAR(unsigned long, u); return YES;
+      case 'Q': v->kind = 'u';
+        KVC_READ_SCALAR(unsigned long long, u); return YES;
+      case 'f': v->kind = 'd'; KVC_READ_SCALAR(float, d); return YES;
+      case 'd': v->kind = 'd'; KVC_READ_SCALAR(double, d); return YES;
+      default: return NO;
+    }
+}
+
+#pragma clang diagnostic pop
+
+static inline double
+_KVCScalarDouble(struct _KVCScalar *v)
+{
+  switch (v->kind)
+    {
+      case 'i': return (double)v->i;
+      case 'u': return (double)v->u;
+      default: return v->d;
+    }
+}
+
+/* Box a scalar exactly as the getter functions above would have done.
+ */
+static id
+_KVCBoxScalar(struct _KVCScalar *v)
+{
+  switch (v->type)
+    {
+      case 'c': return [NSNumber numberWithChar: (char)v->i];
+      case 's': return [NSNumber numberWithShort: (short)v->i];
+      case 'i': return [NSNumber numberWithInt: (int)v->i];
+      case 'l': return [NSNumber numberWithLong: (long)v->i];
+      case 'q': return [NSNumber numberWithLongLong: v->i];
+      case 'B': return [NSNumber numberWithBool: (BOOL)v->u];
+      case 'C': return [NSNumber numberWithUnsignedChar: (unsigned char)v->u];
+      case 'S':
+        return [NSNumber numberWithUnsignedShort: (unsigned short)v->u];
+      case 'I': return [NSNumber numberWithUnsignedInt: (unsigned int)v->u];
+      case 'L': return [NSNumber numberWithUnsignedLong: (unsigned long)v->u];
+      case 'Q': return [NSNumber numberWithUnsignedLongLong: v->u];
+      case 'f': return [NSNumber numberWithFloat: (float)v->d];
+      default: return [NSNumber numberWithDouble: v->d];
+    }
+}
+
+/* Compare two scalars of the same kind.
+ */
+static inline NSComparisonResult
+_KVCCompareScalars(struct _KVCScalar *a, struct _KVCScalar *b)
+{
+  switch (a->kind)
+    {
+      case 'i':
+        return a->i < b->i ? NSOrderedAscending
+          : (a->i > b->i ? NSOrderedDescending : NSOrderedSame);
+      case 'u':
+        return a->u < b->u ? NSOrderedAscending
+          : (a->u > b->u ? NSOrderedDescending : NSOrderedSame);
+      default:
+        return a->d < b->d ? NSOrderedAscending
+          : (a->d > b->d ? NSOrderedDescending : NSOrderedSame);
+    }
+}
+
+id
+aggregateForKeyWithCaching(id collection, NSString *aKey, GSKVCAggregate op)
+{
+  struct _KVCRun    run;
+  struct _KVCScalar v;
+
+  _KVCRunStart(&run, aKey, YES);
+  if (GSKVCSum == op || GSKVCAvg == op)
+    {
+      NSUInteger count = 0;
+      double     d = 0;
+
+      for (id o in collection)
+        {
+          count++;
+          _KVCRunClass(&run, o);
+          if (run.slot != NULL && _KVCReadScalar(run.slot, o, &v))
+            {
+              d += _KVCScalarDouble(&v);
+            }
+          else
+            {
+              d += [_KVCRunValue(&run, o) doubleValue];
+            }
+        }
+      if (GSKVCAvg == op && count > 0)
+        {
+          d /= count;
+        }
+      return [NSNumber numberWithDouble: d];
+    }
+  else
+    {
+      NSComparisonResult replace;
+      struct _KVCScalar  best;
+      BOOL               haveBest = NO;
+      BOOL               first = YES;
+      id                 result = nil;
+
+      /* Keep the extreme value as a scalar for as long as every value is a
+       * scalar of the same kind (and not a NaN), then carry on comparing
+       * objects as -compare: would.
+       */
+      replace = (GSKVCMax == op) ? NSOrderedAscending : NSOrderedDescending;
+      for (id o in collection)
+        {
+          BOOL scalar;
+
+          _KVCRunClass(&run, o);
+          scalar = (run.slot != NULL && _KVCReadScalar(run.slot, o, &v));
+          if (scalar && (haveBest || first)
+            && (NO == haveBest || v.kind == best.kind)
+            && (v.kind != 'd' || v.d == v.d))
+            {
+              if (NO == haveBest || _KVCCompareScalars(&best, &v) == replace)
+                {
+                  best = v;
+                  haveBest = YES;
+                }
+              first = NO;
+              continue;
+            }
+          first = NO;
+          if (haveBest)
+            {
+              result = _KVCBoxScalar(&best);
+              haveBest = NO;
+            }
+          o = scalar ? _KVCBoxScalar(&v) : _KVCRunValue(&run, o);
+          if (result == nil || [result compare: o] == replace)
+            {
+              result = o;
+            }
+        }
+      if (haveBest)
+        {
+          result = _KVCBoxScalar(&best);
+        }
+      return result;
+    }
+}
@@ -69,11 +69,32 @@
 
 static NSRecursiveLock	*kvoLock = nil;
 static NSMapTable	*classTable = 0;
-static NSMapTable	*infoTable = 0;
 static NSMapTable       *dependentKeyTable;
 static Class		baseClass;
 static id               null;
 
+/* The observation information of instances is held in a table split into
+ * shards by instance address, each with its own lock, so that looking up
+ * the information of one observed instance does not contend with changes
+ * to another.
+ */
+#define	INFO_SHARDS	16
+#define	INFO_SHARD(o)	(&infoShards[(((uintptr_t)(o)) >> 4) % INFO_SHARDS])
+typedef struct {
+  gs_mutex_t	lock;
+  NSMapTable	*map;
+} GSKVOInfoShard;
+static GSKVOInfoShard	infoShards[INFO_SHARDS];
+
+/* Instances whose observation information was set while their class was
+ * not a KVO replacement (ie other than by -addObserver:...) are recorded
+ * here (protected by kvoLock) and counted in foreignInfo.  While there are
+ * none, an instance which has not had its class replaced cannot have any
+ * observation information and lookups for it need take no lock.
+ */
+static NSHashTable	*foreignTable = 0;
+static unsigned		foreignInfo = 0;
+
 static inline void
 setup()
 {
@@ -84,12 +105,20 @@ setup()
       GS_MUTEX_LOCK(setupLock);
       if (nil == kvoLock)
 	{
+	  int	i;
+
 	  kvoLock = [NSRecursiveLock new];
 	  null = [[NSNull null] retain];
 	  classTable = NSCreateMapTable(NSNonOwnedPointerMapKeyCallBacks,
 	    NSNonOwnedPointerMapValueCallBacks, 128);
-	  infoTable = NSCreateMapTable(NSNonOwnedPointerMapKeyCallBacks,
-	    NSObjectMapValueCallBacks, 1024);
+	  for (i = 0; i < INFO_SHARDS; i++)
+	    {
+	      GS_MUTEX_INIT(infoShards[i].lock);
+	      infoShards[i].map = NSCreateMapTable(
+		NSNonOwnedPointerMapKeyCallBacks,
+		NSNonOwnedPointerMapValueCallBacks, 64);
+	    }
+	  foreignTable = NSCreateHashTable(NSNonOwnedPointerHashCallBacks, 16);
 	  dependentKeyTable = NSCreateMapTable(NSNonOwnedPointerMapKeyCallBacks,
 	      NSOwnedPointerMapValueCallBacks, 128);
 	  baseClass = NSClassFromString(@"GSKVOBase");
@@ -173,7 +202,7 @@ setup()
 @interface	GSKVOInfo : NSObject
 {
   NSObject	        *instance;	// Not retained.
-  NSRecursiveLock	        *iLock;
+  gs_mutex_t	        iLock;
   NSMapTable	        *paths;
 }
 - (GSKVOPathInfo *) lockReturningPathInfoForKey: (NSString *)key;
@@ -1112,18 +1141,18 @@ cifframe_callback(ffi_cif *cif, void *retp, void **args, void *user)
 {
   GSKVOPathInfo *pathInfo;
 
-  [iLock lock];
+  GS_MUTEX_LOCK(iLock);
   pathInfo = AUTORELEASE(RETAIN((GSKVOPathInfo*)NSMapGet(paths, (void*)key)));
   if (pathInfo == nil)
     {
-      [iLock unlock];
+      GS_MUTEX_UNLOCK(iLock);
     }
   return pathInfo;
 }
 
 - (void) unlock
 {
-  [iLock unlock];
+  GS_MUTEX_UNLOCK(iLock);
 }
 
 - (void) addObserver: (NSObject*)anObserver
@@ -1140,7 +1169,7 @@ cifframe_callback(ffi_cif *cif, void *retp, void **args, void *user)
     {
       return;
     }
-  [iLock lock];
+  GS_MUTEX_LOCK(iLock);
   pathInfo = (GSKVOPathInfo*)NSMapGet(paths, (void*)aPath);
   if (pathInfo == nil)
     {
@@ -1204,13 +1233,13 @@ cifframe_callback(ffi_cif *cif, void *retp, void **args, void *user)
                                   change: pathInfo->change
                                  context: aContext];
     }
-  [iLock unlock];
+  GS_MUTEX_UNLOCK(iLock);
 }
 
 - (void) dealloc
 {
   if (paths != 0) NSFreeMapTable(paths);
-  RELEASE(iLock);
+  GS_MUTEX_DESTROY(iLock);
   [super dealloc];
 }
 
@@ -1219,7 +1248,7 @@ cifframe_callback(ffi_cif *cif, void *retp, void **args, void *user)
   instance = i;
   paths = NSCreateMapTable(NSObjectMapKeyCallBacks,
     NSObjectMapValueCallBacks, 8);
-  iLock = [NSRecursiveLock new];
+  GS_MUTEX_INIT_RECURSIVE(iLock);
   return self;
 }
 
@@ -1227,12 +1256,12 @@ cifframe_callback(ffi_cif *cif, void *retp, void **args, void *user)
 {
   BOOL	result = NO;
 
-  [iLock lock];
+  GS_MUTEX_LOCK(iLock);
   if (NSCountMapTable(paths) == 0)
     {
       result = YES;
     }
-  [iLock unlock];
+  GS_MUTEX_UNLOCK(iLock);
   return result;
 }
 
@@ -1243,7 +1272,7 @@ cifframe_callback(ffi_cif *cif, void *retp, void **args, void *user)
 {
   GSKVOPathInfo	*pathInfo;
 
-  [iLock lock];
+  GS_MUTEX_LOCK(iLock);
   pathInfo = (GSKVOPathInfo*)NSMapGet(paths, (void*)aPath);
   if (pathInfo != nil)
     {
@@ -1269,7 +1298,7 @@ cifframe_callback(ffi_cif *cif, void *retp, void **args, void *user)
             }
 	}
     }
-  [iLock unlock];
+  GS_MUTEX_UNLOCK(iLock);
 }
 
 - (void*) contextForObserver: (NSObject*)anObserver ofKeyPath: (NSString*)aPath
@@ -1277,7 +1306,7 @@ cifframe_callback(ffi_cif *cif, void *retp, void **args, void *user)
   GSKVOPathInfo	*pathInfo;
   void          *context = 0;
 
-  [iLock lock];
+  GS_MUTEX_LOCK(iLock);
   pathInfo = (GSKVOPathInfo*)NSMapGet(paths, (void*)aPath);
   if (pathInfo != nil)
     {
@@ -1295,7 +1324,7 @@ cifframe_callback(ffi_cif *cif, void *retp, void **args, void *user)
             }
 	}
     }
-  [iLock unlock];
+  GS_MUTEX_UNLOCK(iLock);
   return context;
 }
 
@@ -1305,7 +1334,7 @@ cifframe_callback(ffi_cif *cif, void *retp, void **args, void *user)
 {
   GSKVOPathInfo	*pathInfo;
   
-  [iLock lock];
+  GS_MUTEX_LOCK(iLock);
   pathInfo = (GSKVOPathInfo*)NSMapGet(paths, (void*)aPath);
   if (pathInfo != nil)
     {
@@ -1332,7 +1361,7 @@ cifframe_callback(ffi_cif *cif, void *retp, void **args, void *user)
             }
         }
     }
-  [iLock unlock];  
+  GS_MUTEX_UNLOCK(iLock);  
 }
 
 @end
@@ -1551,9 +1580,9 @@ cifframe_callback(ffi_cif *cif, void *retp, void **args, void *user)
   if (info == nil)
     {
       info = [[GSKVOInfo alloc] initWithInstance: self];
+      object_setClass(self, [r replacement]);
       [self setObservationInfo: info];
       RELEASE(info);
-      object_setClass(self, [r replacement]);
     }
 
   /*
@@ -2198,29 +2227,72 @@ triggerChangeNotificationsForDependentKey: (NSString*)dependentKey
 
 - (void*) observationInfo
 {
-  void	*info;
+  GSKVOInfoShard	*shard;
+  id			info;
 
+  /* An instance with observers added by -addObserver:... has had its class
+   * replaced, so unless observation information has been set some other way
+   * we know without any lookup that the receiver is not being observed.
+   */
+  if (object_getClass(self) == [self class]
+    && 0 == __atomic_load_n(&foreignInfo, __ATOMIC_ACQUIRE))
+    {
+      return 0;
+    }
   setup();
-  [kvoLock lock];
-  info = NSMapGet(infoTable, (void*)self);
-  IF_NO_ARC(AUTORELEASE(RETAIN((id)info));)
-  [kvoLock unlock];
-  return info;
+  shard = INFO_SHARD(self);
+  GS_MUTEX_LOCK(shard->lock);
+  info = (id)NSMapGet(shard->map, (void*)self);
+  IF_NO_ARC(RETAIN(info);)
+  GS_MUTEX_UNLOCK(shard->lock);
+  return (void*)AUTORELEASE(info);
 }
 
 - (void) setObservationInfo: (void*)observationInfo
 {
+  GSKVOInfoShard	*shard;
+  id			old;
+
   setup();
-  [kvoLock lock];
+  IF_NO_ARC(RETAIN((id)observationInfo);)
+  shard = INFO_SHARD(self);
+  GS_MUTEX_LOCK(shard->lock);
+  old = (id)NSMapGet(shard->map, (void*)self);
   if (observationInfo == 0)
     {
-      NSMapRemove(infoTable, (void*)self);
+      NSMapRemove(shard->map, (void*)self);
     }
   else
     {
-      NSMapInsert(infoTable, (void*)self, observationInfo);
+      NSMapInsert(shard->map, (void*)self, observationInfo);
     }
-  [kvoLock unlock];
+  GS_MUTEX_UNLOCK(shard->lock);
+
+  if (observationInfo != 0 && object_getClass(self) == [self class])
+    {
+      [kvoLock lock];
+      if (NSHashGet(foreignTable, (void*)self) == 0)
+	{
+	  NSHashInsert(foreignTable, (void*)self);
+	  __atomic_fetch_add(&foreignInfo, 1, __ATOMIC_RELEASE);
+	}
+      [kvoLock unlock];
+    }
+  else if (observationInfo == 0
+    && __atomic_load_n(&foreignInfo, __ATOMIC_ACQUIRE) > 0)
+    {
+      [kvoLock lock];
+      if (NSHashGet(foreignTable, (void*)self) != 0)
+	{
+	  NSHashRemove(foreignTable, (void*)self);
+	  __atomic_fetch_sub(&foreignInfo, 1, __ATOMIC_RELEASE);
+	}
+      [kvoLock unlock];
+    }
+  /* Release the old information outside the lock since its deallocation
+   * may run arbitrary code.
+   */
+  IF_NO_ARC(RELEASE(old);)
 }
 
 @end
@@ -854,11 +854,29 @@ static NSDictionary *makeReference(unsigned ref)
   [final setObject: [NSNumber numberWithInt: 100000] forKey: @"$version"];
   [final setObject: _enc forKey: @"$top"];
   [final setObject: _obj forKey: @"$objects"];
-  data = [NSPropertyListSerialization dataFromPropertyList: final
-						    format: _format
-					  errorDescription: &error];
+  if (NSPropertyListBinaryFormat_v1_0 == _format)
+    {
+      /* Generate the binary archive directly into the output data.
+       */
+      NS_DURING
+	{
+	  GSPrivateBinaryPropertyList(final, _data);
+	}
+      NS_HANDLER
+	{
+	  RELEASE(final);
+	  [localException raise];
+	}
+      NS_ENDHANDLER
+    }
+  else
+    {
+      data = [NSPropertyListSerialization dataFromPropertyList: final
+							format: _format
+					      errorDescription: &error];
+      [_data setData: data];
+    }
   RELEASE(final);
-  [_data setData: data];
   [_delegate archiverDidFinish: self];
 }
 
@@ -163,20 +163,128 @@ typedef struct _NSNotificationQueueRegistration
 {
   struct _NSNotificationQueueRegistration	*next;
   struct _NSNotificationQueueRegistration	*prev;
+  struct _NSNotificationQueueRegistration	*nameNext;
+  struct _NSNotificationQueueRegistration	*namePrev;
+  struct _NSNotificationQueueRegistration	*objectNext;
+  struct _NSNotificationQueueRegistration	*objectPrev;
   NSNotification				*notification;
   id						name;
   id						object;
   NSArray					*modes;
+  NSUInteger					nameHash;
 } NSNotificationQueueRegistration;
 
 struct _NSNotificationQueueList;
 
+/* As well as the list of registrations in the order they were queued,
+ * each queue keeps two hash indexes (chains of registrations with the
+ * same name hash and with the same object address) so that coalescing
+ * looks only at registrations which may match rather than at the whole
+ * queue.  Removed registrations are kept on a small free list for reuse,
+ * and the modes array most recently queued is kept so that a queue of
+ * notifications for the same modes shares one copy of the array.
+ */
 typedef struct _NSNotificationQueueList
 {
   struct _NSNotificationQueueRegistration	*head;
   struct _NSNotificationQueueRegistration	*tail;
+  struct _NSNotificationQueueRegistration	**byName;
+  struct _NSNotificationQueueRegistration	**byObject;
+  struct _NSNotificationQueueRegistration	*free;
+  NSArray					*modes;
+  NSUInteger					buckets;
+  NSUInteger					count;
+  NSUInteger					freeCount;
 } NSNotificationQueueList;
 
+#define	QUEUE_MIN_BUCKETS	16
+#define	QUEUE_MAX_FREE		64
+
+static inline NSUInteger
+object_bucket(NSNotificationQueueList *queue, id object)
+{
+  uintptr_t	h = (uintptr_t)object;
+
+  h ^= (h >> 4) ^ (h >> 12);
+  return (NSUInteger)h & (queue->buckets - 1);
+}
+
+static inline NSUInteger
+name_bucket(NSNotificationQueueList *queue, NSUInteger hash)
+{
+  return hash & (queue->buckets - 1);
+}
+
+static inline void
+index_item(NSNotificationQueueList *queue,
+  NSNotificationQueueRegistration *item)
+{
+  NSNotificationQueueRegistration	**bucket;
+
+  bucket = &queue->byName[name_bucket(queue, item->nameHash)];
+  item->namePrev = NULL;
+  item->nameNext = *bucket;
+  if (*bucket)
+    {
+      (*bucket)->namePrev = item;
+    }
+  *bucket = item;
+
+  bucket = &queue->byObject[object_bucket(queue, item->object)];
+  item->objectPrev = NULL;
+  item->objectNext = *bucket;
+  if (*bucket)
+    {
+      (*bucket)->objectPrev = item;
+    }
+  *bucket = item;
+}
+
+/* Make sure there are enough buckets for the queue to hold one more item,
+ * rebuilding the indexes from the list if the table has to grow.
+ */
+static void
+grow_index(NSNotificationQueueList *queue, NSZone *_zone)
+{
+  NSNotificationQueueRegistration	**byName;
+  NSNotificationQueueRegistration	**byObject;
+  NSNotificationQueueRegistration	*item;
+  NSUInteger				want;
+
+  if (queue->count < queue->buckets * 2)
+    {
+      return;
+    }
+  want = (queue->buckets == 0) ? QUEUE_MIN_BUCKETS : queue->buckets * 2;
+  byName = NSZoneCalloc(_zone, want, sizeof(*byName));
+  byObject = NSZoneCalloc(_zone, want, sizeof(*byObject));
+  if (byName == 0 || byObject == 0)
+    {
+      if (byName)
+        {
+          NSZoneFree(_zone, byName);
+        }
+      if (byObject)
+        {
+          NSZoneFree(_zone, byObject);
+        }
+      [NSException raise: NSMallocException
+      		  format: @"Unable to add to notification queue"];
+    }
+  if (queue->buckets > 0)
+    {
+      NSZoneFree(_zone, queue->byName);
+      NSZoneFree(_zone, queue->byObject);
+    }
+  queue->byName = byName;
+  queue->byObject = byObject;
+  queue->buckets = want;
+  for (item = queue->head; item; item = item->next)
+    {
+      index_item(queue, item);
+    }
+}
+
 /*
  * Queue functions
  *
@@ -209,6 +317,33 @@ remove_from_queue_no_release(NSNotificationQueueList *queue,
       NSCAssert(queue->head == item, @"head item not at head of queue!");
       queue->head = item->next;
     }
+
+  if (item->nameNext)
+    {
+      item->nameNext->namePrev = item->namePrev;
+    }
+  if (item->namePrev)
+    {
+      item->namePrev->nameNext = item->nameNext;
+    }
+  else
+    {
+      queue->byName[name_bucket(queue, item->nameHash)] = item->nameNext;
+    }
+
+  if (item->objectNext)
+    {
+      item->objectNext->objectPrev = item->objectPrev;
+    }
+  if (item->objectPrev)
+    {
+      item->objectPrev->objectNext = item->objectNext;
+    }
+  else
+    {
+      queue->byObject[object_bucket(queue, item->object)] = item->objectNext;
+    }
+  queue->count--;
 }
 
 static void
@@ -218,7 +353,16 @@ remove_from_queue(NSNotificationQueueList *queue,
   remove_from_queue_no_release(queue, item);
   RELEASE(item->notification);
   RELEASE(item->modes);
-  NSZoneFree(_zone, item);
+  if (queue->freeCount < QUEUE_MAX_FREE)
+    {
+      item->next = queue->free;
+      queue->free = item;
+      queue->freeCount++;
+    }
+  else
+    {
+      NSZoneFree(_zone, item);
+    }
 }
 
 static void
@@ -227,17 +371,39 @@ add_to_queue(NSNotificationQueueList *queue, NSNotification *notification,
 {
   NSNotificationQueueRegistration	*item;
 
-  item = NSZoneCalloc(_zone, 1, sizeof(NSNotificationQueueRegistration));
-  if (item == 0)
+  grow_index(queue, _zone);
+  if ((item = queue->free) != 0)
     {
-      [NSException raise: NSMallocException
-      		  format: @"Unable to add to notification queue"];
+      queue->free = item->next;
+      queue->freeCount--;
+    }
+  else
+    {
+      item = NSZoneMalloc(_zone, sizeof(NSNotificationQueueRegistration));
+      if (item == 0)
+	{
+	  [NSException raise: NSMallocException
+		      format: @"Unable to add to notification queue"];
+	}
+    }
+
+  /* Share the copy of the modes array made for the last notification
+   * queued if the modes are the same, as they almost always are.
+   */
+  if (modes != queue->modes
+    && (queue->modes == nil || NO == [modes isEqual: queue->modes]))
+    {
+      NSArray	*copy = [modes copyWithZone: [modes zone]];
+
+      RELEASE(queue->modes);
+      queue->modes = copy;
     }
 
   item->notification = RETAIN(notification);
   item->name = [notification name];
   item->object = [notification object];
-  item->modes = [modes copyWithZone: [modes zone]];
+  item->modes = RETAIN(queue->modes);
+  item->nameHash = [item->name hash];
 
   item->next = NULL;
   item->prev = queue->tail;
@@ -250,9 +416,85 @@ add_to_queue(NSNotificationQueueList *queue, NSNotification *notification,
     {
       queue->head = item;
     }
+  index_item(queue, item);
+  queue->count++;
+}
+
+/* Remove the items in the queue whose name and/or object match those given
+ * according to the coalesce mask.  Only the chain of the index for the
+ * object (or for the name if we are not matching on the object) needs to
+ * be examined.
+ */
+static void
+remove_matching(NSNotificationQueueList *queue, id name, id object,
+  NSUInteger coalesceMask, NSZone *_zone)
+{
+  NSNotificationQueueRegistration	*item;
+  NSNotificationQueueRegistration	*next;
+
+  if (queue->count == 0)
+    {
+      return;
+    }
+  if (coalesceMask & NSNotificationCoalescingOnSender)
+    {
+      BOOL	onName = (coalesceMask & NSNotificationCoalescingOnName)
+	? YES : NO;
+
+      item = queue->byObject[object_bucket(queue, object)];
+      while (item != 0)
+	{
+	  next = item->objectNext;
+          //PENDING: should object comparison be '==' instead of isEqual?!
+	  if (object == item->object
+	    && (NO == onName || [name isEqual: item->name]))
+	    {
+	      remove_from_queue(queue, item, _zone);
+	    }
+	  item = next;
+	}
+    }
+  else if (coalesceMask & NSNotificationCoalescingOnName)
+    {
+      NSUInteger	hash = [name hash];
+
+      item = queue->byName[name_bucket(queue, hash)];
+      while (item != 0)
+	{
+	  next = item->nameNext;
+	  if (hash == item->nameHash && [name isEqual: item->name])
+	    {
+	      remove_from_queue(queue, item, _zone);
+	    }
+	  item = next;
+	}
+    }
 }
 
-
+static void
+destroy_queue(NSNotificationQueueList *queue, NSZone *_zone)
+{
+  NSNotificationQueueRegistration	*item;
+
+  while ((item = queue->head) != 0)
+    {
+      remove_from_queue(queue, item, _zone);
+    }
+  while ((item = queue->free) != 0)
+    {
+      queue->free = item->next;
+      NSZoneFree(_zone, item);
+    }
+  if (queue->buckets > 0)
+    {
+      NSZoneFree(_zone, queue->byName);
+      NSZoneFree(_zone, queue->byObject);
+    }
+  RELEASE(queue->modes);
+  NSZoneFree(_zone, queue);
+}
+
+
 
 /*
  * NSNotificationQueue class implementation
@@ -349,8 +591,6 @@ static NSArray	*defaultMode = nil;
 
 - (void) dealloc
 {
-  NSNotificationQueueRegistration	*item;
-
   /*
    * remove from class instances list
    */
@@ -359,17 +599,14 @@ static NSArray	*defaultMode = nil;
   /*
    * release items from our queues
    */
-  while ((item = _asapQueue->head) != 0)
+  if (_asapQueue != 0)
     {
-      remove_from_queue(_asapQueue, item, _zone);
+      destroy_queue(_asapQueue, _zone);
     }
-  NSZoneFree(_zone, _asapQueue);
-
-  while ((item = _idleQueue->head) != 0)
+  if (_idleQueue != 0)
     {
-      remove_from_queue(_idleQueue, item, _zone);
+      destroy_queue(_idleQueue, _zone);
     }
-  NSZoneFree(_zone, _idleQueue);
 
   RELEASE(_center);
   [super dealloc];
@@ -391,88 +628,11 @@ static NSArray	*defaultMode = nil;
 - (void) dequeueNotificationsMatching: (NSNotification*)notification
 			 coalesceMask: (NSUInteger)coalesceMask
 {
-  NSNotificationQueueRegistration	*item;
-  NSNotificationQueueRegistration	*prev;
-  id					name   = [notification name];
-  id					object = [notification object];
+  id	name   = [notification name];
+  id	object = [notification object];
 
-  if ((coalesceMask & NSNotificationCoalescingOnName)
-    && (coalesceMask & NSNotificationCoalescingOnSender))
-    {
-      /*
-       * find in ASAP notification in queue matching both
-       */
-      for (item = _asapQueue->tail; item; item = prev)
-	{
-          prev = item->prev;
-          //PENDING: should object comparison be '==' instead of isEqual?!
-          if ((object == item->object) && [name isEqual: item->name])
-	    {
-              remove_from_queue(_asapQueue, item, _zone);
-	    }
-	}
-      /*
-       * find in idle notification in queue matching both
-       */
-      for (item = _idleQueue->tail; item; item = prev)
-	{
-          prev = item->prev;
-          if ((object == item->object) && [name isEqual: item->name])
-	    {
-              remove_from_queue(_idleQueue, item, _zone);
-	    }
-	}
-    }
-  else if ((coalesceMask & NSNotificationCoalescingOnName))
-    {
-      /*
-       * find in ASAP notification in queue matching name
-       */
-      for (item = _asapQueue->tail; item; item = prev)
-	{
-          prev = item->prev;
-          if ([name isEqual: item->name])
-	    {
-              remove_from_queue(_asapQueue, item, _zone);
-	    }
-	}
-      /*
-       * find in idle notification in queue matching name
-       */
-      for (item = _idleQueue->tail; item; item = prev)
-	{
-          prev = item->prev;
-          if ([name isEqual: item->name])
-	    {
-              remove_from_queue(_idleQueue, item, _zone);
-	    }
-	}
-    }
-  else if ((coalesceMask & NSNotificationCoalescingOnSender))
-    {
-      /*
-       * find in ASAP notification in queue matching sender
-       */
-      for (item = _asapQueue->tail; item; item = prev)
-	{
-          prev = item->prev;
-          if (object == item->object)
-	    {
-              remove_from_queue(_asapQueue, item, _zone);
-	    }
-	}
-      /*
-       * find in idle notification in queue matching sender
-       */
-      for (item = _idleQueue->tail; item; item = prev)
-	{
-          prev = item->prev;
-          if (object == item->object)
-	    {
-              remove_from_queue(_idleQueue, item, _zone);
-	    }
-	}
-    }
+  remove_matching(_asapQueue, name, object, coalesceMask, _zone);
+  remove_matching(_idleQueue, name, object, coalesceMask, _zone);
 }
 
 /**
@@ -551,84 +711,90 @@ static NSArray	*defaultMode = nil;
 
 @end
 
+static inline BOOL
+modes_match(NSArray *modes, NSString *mode, NSArray **last, BOOL *match)
+{
+  if (modes != *last)
+    {
+      *last = modes;
+      *match = (mode == nil || [modes indexOfObject: mode] != NSNotFound)
+	? YES : NO;
+    }
+  return *match;
+}
+
 static void
-notify(NSNotificationCenter *center, NSNotificationQueueList *list,
-  NSString *mode, NSZone *zone)
+notify(NSNotificationQueue *queue, NSNotificationQueueList *list,
+  NSString *mode)
 {
+  NSNotificationCenter			*center = queue->_center;
+  NSZone				*zone = queue->_zone;
   BOOL					allocated = NO;
-  void					*buf[100];
-  void					**ptr = buf;
+  NSNotification			*buf[64];
+  NSNotification			**ptr = buf;
   unsigned				len = sizeof(buf) / sizeof(*buf);
   unsigned				pos = 0;
   NSNotificationQueueRegistration	*item = list->head;
-
-  /* Gather matching items into a buffer.
+  NSArray				*last = nil;
+  BOOL					match = NO;
+
+  /* Gather every matching notification into a buffer, removing each
+   * item from the queue as we go so that when we get round to posting
+   * the notifications we will not get problems with another notify()
+   * trying to use the same items.  An observer dequeuing a notification
+   * will therefore not stop it being posted in this pass.
    */
   while (item != 0)
     {
-      if (mode == nil || [item->modes indexOfObject: mode] != NSNotFound)
+      NSNotificationQueueRegistration	*next = item->next;
+
+      if (modes_match(item->modes, mode, &last, &match))
 	{
 	  if (pos == len)
 	    {
-	      unsigned	want;
+	      unsigned	want = len * 2;
 
-	      want = (len == 0) ? 2 : len * 2;
 	      if (NO == allocated)
 		{
-		  void		*tmp;
-		  
+		  NSNotification	**tmp;
+
 		  tmp = NSZoneMalloc(NSDefaultMallocZone(),
-		    want * sizeof(void*));
-		  memcpy(tmp, (void*)ptr, len * sizeof(void*));
+		    want * sizeof(NSNotification*));
+		  memcpy(tmp, ptr, len * sizeof(NSNotification*));
 		  ptr = tmp;
 		  allocated = YES;
 		}
 	      else
 		{
 		  ptr = NSZoneRealloc(NSDefaultMallocZone(),
-		    ptr, want * sizeof(void*));
+		    ptr, want * sizeof(NSNotification*));
 		}
 	      len = want;
 	    }
-	  ptr[pos++] = item;
+	  ptr[pos++] = RETAIN(item->notification);
+	  remove_from_queue(list, item, zone);
 	}
-      item = item->next;	// head --> tail uses next link
+      item = next;	// head --> tail uses next link
     }
-  len = pos;	// Number of items found
+  len = pos;	// Number of notifications found
 
-  /* Posting a notification catches exceptions, so it's OK to use
+  /* Now that we no longer need to worry about r-entrancy, we step
+   * through our notifications, posting each one in turn.
+   * Posting a notification catches exceptions, so it's OK to use
    * retain/release of objects here as we won't get an exception
-   * causing a leak.
+   * causing a leak.  The center is retained in case an observer
+   * releases the queue which owns it.
    */
-  if (len > 0)
+  RETAIN(center);
+  for (pos = 0; pos < len; pos++)
     {
-      /* First, we make a note of each notification while removing the
-       * corresponding list item from the queue ... so that when we get
-       * round to posting the notifications we will not get problems
-       * with another notif() trying to use the same items.
-       */
-      for (pos = 0; pos < len; pos++)
-	{
-	  item = ptr[pos];
-	  ptr[pos] = RETAIN(item->notification);
-	  remove_from_queue(list, item, zone);
-	}
-
-      /* Now that we no longer need to worry about r-entrancy,
-       * we step through our notifications, posting each one in turn.
-       */
-      for (pos = 0; pos < len; pos++)
-	{
-	  NSNotification	*n = (NSNotification*)ptr[pos];
-
-	  [center postNotification: n];
-	  RELEASE(n);
-	}
-
-      if (allocated)
-	{
-	  NSZoneFree(NSDefaultMallocZone(), ptr);
-	}
+      [center postNotification: ptr[pos]];
+      RELEASE(ptr[pos]);
+    }
+  RELEASE(center);
+  if (allocated)
+    {
+      NSZoneFree(NSDefaultMallocZone(), ptr);
     }
 }
 
@@ -646,12 +812,9 @@ GSPrivateNotifyASAP(NSString *mode)
 
   for (item = currentList(); item; item = item->next)
     {
-      if (item->queue)
+      if (item->queue && item->queue->_asapQueue->head)
 	{
-	  notify(item->queue->_center,
-	    item->queue->_asapQueue,
-	    mode,
-	    item->queue->_zone);
+	  notify(item->queue, item->queue->_asapQueue, mode);
 	}
     }
 }
@@ -663,12 +826,9 @@ GSPrivateNotifyIdle(NSString *mode)
 
   for (item = currentList(); item; item = item->next)
     {
-      if (item->queue)
+      if (item->queue && item->queue->_idleQueue->head)
 	{
-	  notify(item->queue->_center,
-	    item->queue->_idleQueue,
-	    mode,
-	    item->queue->_zone);
+	  notify(item->queue, item->queue->_idleQueue, mode);
 	}
     }
 }
@@ -683,11 +843,13 @@ GSPrivateNotifyMore(NSString *mode)
       if (item->queue != nil)
 	{
           NSNotificationQueueRegistration	*r;
+	  NSArray				*last = nil;
+	  BOOL					match = NO;
 
 	  r = item->queue->_idleQueue->head;
 	  while (r != 0)
 	    {
-	      if (mode == nil || [r->modes indexOfObject: mode] != NSNotFound)
+	      if (modes_match(r->modes, mode, &last, &match))
 		{
 		  return YES;
 		}
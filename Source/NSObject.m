@@ -171,6 +171,12 @@ static gs_mutex_t  allocationLock = GS_MUTEX_INIT_STATIC;
 BOOL	NSZombieEnabled = NO;
 BOOL	NSDeallocateZombies = NO;
 
+#ifndef OBJC_CAP_ARC
+/* Set if small objects come from the size class allocator in NSZone.m
+ */
+static BOOL	useMagazines = NO;
+#endif
+
 @class	NSZombie;
 static Class		zombieClass = Nil;
 static NSMapTable	*zombieMap = 0;
@@ -460,7 +466,12 @@ static inline pthread_mutex_t   *GSAllocationLockForObject(id p)
 typedef struct {
   BOOL	hadWeakReference: 1;	// if the instance ever had a weak reference
   BOOL	hadAssociations: 1;	// if the instance ever had associated objects
+  unsigned char	sizeClass: 5;	// magazine size class, ARENA_CLASS or zero
 } gsinstinfo_t;
+
+/* The size class of objects in arena zones, whose memory is not freed.
+ */
+#define	ARENA_CLASS	31
 #endif
 
 /*
@@ -824,18 +835,34 @@ NSAllocateObject(Class aClass, NSUInteger extraBytes, NSZone *zone)
 #ifdef OBJC_CAP_ARC
   new = class_createInstance(aClass, extraBytes);
 #else
-  int	size;
+  int		size;
+  unsigned	sizeClass = 0;
 
   NSCAssert((!class_isMetaClass(aClass)), @"Bad class for new object");
   size = class_getInstanceSize(aClass) + extraBytes + sizeof(struct obj_layout);
   if (zone == 0)
     {
-      zone = NSDefaultMallocZone();
+      NSZone	*scoped = GSPrivateScopedZone();
+
+      zone = (scoped == 0) ? NSDefaultMallocZone() : scoped;
+    }
+  if (useMagazines && zone == NSDefaultMallocZone()
+    && (sizeClass = GSPrivateMagazineClass(size)) > 0)
+    {
+      new = GSPrivateMagazineMalloc(sizeClass);
+    }
+  else
+    {
+      if (GSPrivateIsArenaZone(zone))
+	{
+	  sizeClass = ARENA_CLASS;
+	}
+      new = NSZoneMalloc(zone, size);
     }
-  new = NSZoneMalloc(zone, size);
   if (new != nil)
     {
       memset (new, 0, size);
+      ((obj)new)->extra.sizeClass = sizeClass;
       new = (id)&((obj)new)[1];
       object_setClass(new, aClass);
     }
@@ -866,7 +893,8 @@ NSDeallocateObject(id anObject)
     {
 #ifndef OBJC_CAP_ARC
       obj	o = &((obj)anObject)[-1];
-      NSZone	*z = NSZoneFromPointer(o);
+      unsigned	sizeClass = o->extra.sizeClass;
+      NSZone	*z = sizeClass ? NULL : NSZoneFromPointer(o);
 #endif
 
       /* Call the default finalizer to handle C++ destructors.
@@ -899,7 +927,14 @@ NSDeallocateObject(id anObject)
 	       * free memory as the isa pointer in the freed memory may let
 	       * it work as a zombie until it is overwritten.
 	       */
-	      NSZoneFree(z, o);
+	      if (0 == sizeClass)
+		{
+		  NSZoneFree(z, o);
+		}
+	      else if (sizeClass != ARENA_CLASS)
+		{
+		  GSPrivateMagazineFree(o, sizeClass);
+		}
 #endif
 	    }
 	}
@@ -909,7 +944,14 @@ NSDeallocateObject(id anObject)
 	  object_dispose(anObject);
 #else
 	  object_setClass((id)anObject, (Class)(void*)0xdeadface);
-	  NSZoneFree(z, o);
+	  if (0 == sizeClass)
+	    {
+	      NSZoneFree(z, o);
+	    }
+	  else if (sizeClass != ARENA_CLASS)
+	    {
+	      GSPrivateMagazineFree(o, sizeClass);
+	    }
 #endif
 	}
     }
@@ -1135,6 +1177,16 @@ static id gs_weak_load(id obj)
        */
       NSConstantStringClass = [NSString constantStringClass];
 
+#ifndef OBJC_CAP_ARC
+      /* Use the size class allocator for small objects if wanted.
+       */
+      if (GSPrivateEnvironmentFlag("GNUSTEP_OBJECT_MAGAZINES", NO))
+	{
+	  GSPrivateMagazineSetUp();
+	  useMagazines = (GSObjectMagazineZone() != NULL);
+	}
+#endif
+
       /* Determine zombie management flags and set up a map to store
        * information about zombie objects.
        */
@@ -1179,12 +1231,15 @@ static id gs_weak_load(id obj)
 /**
  * Allocates a new instance of the receiver from the default
  * zone, by invoking +allocWithZone: with
- * <code>NSDefaultMallocZone()</code> as the zone argument.<br />
+ * <code>NSDefaultMallocZone()</code> as the zone argument
+ * (or the zone set by GSPushAllocationZone() if there is one).<br />
  * Returns the created instance.
  */
 + (id) alloc
 {
-  return [self allocWithZone: NSDefaultMallocZone()];
+  NSZone	*z = GSPrivateScopedZone();
+
+  return [self allocWithZone: (0 == z) ? NSDefaultMallocZone() : z];
 }
 
 /**
@@ -27,6 +27,9 @@
 
 #import "common.h"
 
+#define	GS_NSComparisonPredicate_IVARS \
+  id	_regex	/* Compiled constant pattern, made on first use */
+
 #define	EXPOSE_NSComparisonPredicate_IVARS	1
 #define	EXPOSE_NSCompoundPredicate_IVARS	1
 #define	EXPOSE_NSExpression_IVARS	1
@@ -44,10 +47,19 @@
 #import "Foundation/NSException.h"
 #import "Foundation/NSKeyValueCoding.h"
 #import "Foundation/NSNull.h"
+#import "Foundation/NSRegularExpression.h"
 #import "Foundation/NSScanner.h"
 #import "Foundation/NSValue.h"
 
 #import "GSPrivate.h"
+#import "GSDispatch.h"
+
+#define	GSInternal		NSComparisonPredicateInternal
+#include	"GSInternal.h"
+GS_PRIVATE_INTERNAL(NSComparisonPredicate)
+#if	defined(__OBJC2__)
+#import "NSKeyValueCoding+Caching.h"
+#endif
 
 // For pow()
 #include <math.h>
@@ -176,6 +188,7 @@ extern void     GSPropertyListMake(id,NSDictionary*,BOOL,BOOL,unsigned,id*);
 {
   @public
   NSString	*_keyPath;
+  void		*_plan;		// Key path split into keys, made on first use
 }
 @end
 
@@ -1175,6 +1188,7 @@ extern void     GSPropertyListMake(id,NSDictionary*,BOOL,BOOL,unsigned,id*);
 {
   if ((self = [super init]) != nil)
     {
+      GS_CREATE_INTERNAL(NSComparisonPredicate)
       ASSIGN(_left, left);
       ASSIGN(_right, right);
       _selector = sel;
@@ -1191,6 +1205,7 @@ extern void     GSPropertyListMake(id,NSDictionary*,BOOL,BOOL,unsigned,id*);
 {
   if ((self = [super init]) != nil)
     {
+      GS_CREATE_INTERNAL(NSComparisonPredicate)
       ASSIGN(_left, left);
       ASSIGN(_right, right);
       _modifier = modifier;
@@ -1204,6 +1219,11 @@ extern void     GSPropertyListMake(id,NSDictionary*,BOOL,BOOL,unsigned,id*);
 {
   RELEASE(_left);
   RELEASE(_right);
+  if (GS_EXISTS_INTERNAL)
+    {
+      RELEASE(internal->_regex);
+      GS_DESTROY_INTERNAL(NSComparisonPredicate)
+    }
   DEALLOC
 }
 
@@ -1382,8 +1402,90 @@ GSICUStringMatchesRegex(NSString *string, NSString *regex, NSStringCompareOption
 
   return result;
 }
+
+/* Compile a MATCHES or LIKE pattern as a regular expression which must
+ * match the whole of a string.  An invalid pattern gives an expression
+ * which matches nothing, as it does when the pattern is compiled for
+ * each evaluation.
+ */
+static NSRegularExpression *
+GSPredicateRegex(NSString *pattern, NSPredicateOperatorType type,
+  NSStringCompareOptions opts)
+{
+  NSRegularExpressionOptions	flags;
+  NSRegularExpression		*regex;
+
+  if (NSLikePredicateOperatorType == type)
+    {
+      pattern = [pattern stringByReplacingOccurrencesOfString: @"*"
+						   withString: @".*"];
+      pattern = [pattern stringByReplacingOccurrencesOfString: @"?"
+						   withString: @".?"];
+      pattern = [NSString stringWithFormat: @"^%@$", pattern];
+    }
+  flags = NSRegularExpressionDotMatchesLineSeparators;
+  if ((opts & NSCaseInsensitiveSearch) != 0)
+    {
+      flags |= NSRegularExpressionCaseInsensitive;
+    }
+  regex = [[NSRegularExpression alloc] initWithPattern:
+    [NSString stringWithFormat: @"\\A(?:%@)\\z", pattern]
+					       options: flags
+						 error: NULL];
+  if (nil == regex)
+    {
+      regex = [[NSRegularExpression alloc] initWithPattern: @"(?!)"
+						   options: 0
+						     error: NULL];
+    }
+  return regex;
+}
 #endif
 
+/* For a MATCHES or LIKE comparison against a constant pattern, returns the
+ * regular expression for the pattern (compiled once and kept for all later
+ * evaluations).  Returns nil if the pattern is not constant.
+ */
+- (NSRegularExpression *) _regexWithOptions: (NSStringCompareOptions)opts
+{
+#if	GS_USE_ICU == 1
+  id	regex;
+
+  if (NO == GS_EXISTS_INTERNAL)
+    {
+      return nil;	// Subclass which did not use our initialisers
+    }
+  regex = __atomic_load_n(&internal->_regex, __ATOMIC_ACQUIRE);
+  if (nil == regex)
+    {
+      id	expected = nil;
+      id	pattern = nil;
+
+      if ([_right expressionType] == NSConstantValueExpressionType)
+	{
+	  pattern = [_right constantValue];
+	}
+      if ([pattern isKindOfClass: [NSString class]])
+	{
+	  regex = GSPredicateRegex(pattern, _type, opts);
+	}
+      else
+	{
+	  regex = RETAIN([NSNull null]);
+	}
+      if (NO == __atomic_compare_exchange_n(&internal->_regex, &expected,
+	regex, NO, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+	{
+	  RELEASE(regex);
+	  regex = expected;
+	}
+    }
+  return (regex == [NSNull null]) ? nil : regex;
+#else
+  return nil;
+#endif
+}
+
 - (BOOL) _evaluateLeftValue: (id)leftResult
 		 rightValue: (id)rightResult
 		     object: (id)object
@@ -1517,6 +1619,18 @@ GSICUStringMatchesRegex(NSString *string, NSString *regex, NSStringCompareOption
 	return ![leftResult isEqual: rightResult];
       case NSMatchesPredicateOperatorType:
 #if	GS_USE_ICU == 1
+	{
+	  NSRegularExpression	*regex;
+
+	  regex = [self _regexWithOptions: compareOptions];
+	  if (regex != nil)
+	    {
+	      return [regex rangeOfFirstMatchInString: leftResult
+		options: 0
+		range: NSMakeRange(0, [leftResult length])].location
+		!= NSNotFound;
+	    }
+	}
 	return GSICUStringMatchesRegex(leftResult, rightResult, compareOptions);
 #else
 	return [leftResult compare: rightResult options: compareOptions]
@@ -1525,7 +1639,17 @@ GSICUStringMatchesRegex(NSString *string, NSString *regex, NSStringCompareOption
       case NSLikePredicateOperatorType:
 #if	GS_USE_ICU == 1
 	{
-	  NSString *regex;
+	  NSRegularExpression	*compiled;
+	  NSString		*regex;
+
+	  compiled = [self _regexWithOptions: compareOptions];
+	  if (compiled != nil)
+	    {
+	      return [compiled rangeOfFirstMatchInString: leftResult
+		options: 0
+		range: NSMakeRange(0, [leftResult length])].location
+		!= NSNotFound;
+	    }
 
 	  /* The right hand is a pattern with '?' meaning match one character,
 	   * and '*' meaning match zero or more characters, so translate that
@@ -1642,7 +1766,18 @@ GSICUStringMatchesRegex(NSString *string, NSString *regex, NSStringCompareOption
 - (BOOL) evaluateWithObject: (id)object
 {
   id leftValue = [_left expressionValueWithObject: object context: nil];
-  id rightValue = [_right expressionValueWithObject: object context: nil];
+  id rightValue;
+
+  /* A constant needs no evaluation.
+   */
+  if ([_right expressionType] == NSConstantValueExpressionType)
+    {
+      rightValue = [_right constantValue];
+    }
+  else
+    {
+      rightValue = [_right expressionValueWithObject: object context: nil];
+    }
 
   if (_modifier == NSDirectPredicateModifier)
     {
@@ -1683,6 +1818,11 @@ GSICUStringMatchesRegex(NSString *string, NSString *regex, NSStringCompareOption
   copy = (NSComparisonPredicate *)NSCopyObject(self, 0, z);
   copy->_left = [_left copyWithZone: z];
   copy->_right = [_right copyWithZone: z];
+  if (GS_EXISTS_INTERNAL)
+    {
+      GS_COPY_INTERNAL(copy, z)
+      GSIVar(copy, _regex) = nil;
+    }
   return copy;
 }
 
@@ -2548,10 +2688,122 @@ GSICUStringMatchesRegex(NSString *string, NSString *regex, NSStringCompareOption
   return [_keyPath hash];
 }
 
+/* The key path split into its keys, so that evaluation need not split
+ * the path again for every object.  A count of zero means the path uses
+ * collection operators and must be passed to -valueForKeyPath: whole.
+ */
+typedef struct {
+  NSUInteger	count;
+  NSString	**keys;		// The key at each step
+  NSString	**paths;	// The path remaining at each step
+} GSKeyPathPlan;
+
+static void
+freePlan(GSKeyPathPlan *plan)
+{
+  NSUInteger	i;
+
+  for (i = 0; i < plan->count; i++)
+    {
+      RELEASE(plan->keys[i]);
+      RELEASE(plan->paths[i]);
+    }
+  free(plan);
+}
+
+- (GSKeyPathPlan *) _plan
+{
+  GSKeyPathPlan	*plan = __atomic_load_n(&_plan, __ATOMIC_ACQUIRE);
+
+  if (NULL == plan)
+    {
+      NSArray		*keys = [_keyPath componentsSeparatedByString: @"."];
+      NSUInteger	count = [keys count];
+      NSUInteger	pos = 0;
+      NSUInteger	i;
+      void		*expected = NULL;
+
+      plan = malloc(sizeof(GSKeyPathPlan) + 2 * count * sizeof(NSString*));
+      if (NULL == plan)
+	{
+	  [NSException raise: NSMallocException
+		      format: @"Unable to plan key path '%@'", _keyPath];
+	}
+      plan->keys = (NSString**)(plan + 1);
+      plan->paths = plan->keys + count;
+      plan->count = count;
+      for (i = 0; i < count; i++)
+	{
+	  NSString	*key = [keys objectAtIndex: i];
+
+	  if ([key hasPrefix: @"@"])
+	    {
+	      plan->count = i;
+	      freePlan(plan);
+	      plan = malloc(sizeof(GSKeyPathPlan));
+	      if (NULL == plan)
+		{
+		  [NSException raise: NSMallocException
+			      format: @"Unable to plan key path '%@'", _keyPath];
+		}
+	      plan->count = 0;
+	      break;
+	    }
+	  plan->keys[i] = RETAIN(key);
+	  plan->paths[i] = RETAIN([_keyPath substringFromIndex: pos]);
+	  pos += [key length] + 1;
+	}
+      if (NO == __atomic_compare_exchange_n(&_plan, &expected, plan,
+	NO, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+	{
+	  freePlan(plan);
+	  plan = expected;
+	}
+    }
+  return plan;
+}
+
 - (id) expressionValueWithObject: (id)object
 			 context: (NSMutableDictionary *)context
 {
-  return [object valueForKeyPath: _keyPath];
+  static IMP		pathIMP = 0;
+  static IMP		keyIMP = 0;
+  GSKeyPathPlan		*plan = [self _plan];
+  NSUInteger		i;
+
+  if (0 == plan->count)
+    {
+      return [object valueForKeyPath: _keyPath];
+    }
+  if (0 == pathIMP)
+    {
+      keyIMP = class_getMethodImplementation([NSObject class],
+	@selector(valueForKey:));
+      pathIMP = class_getMethodImplementation([NSObject class],
+	@selector(valueForKeyPath:));
+    }
+  /* Step through the keys as -[NSObject valueForKeyPath:] would, unless
+   * we reach an object which handles key paths itself (a collection).
+   */
+  for (i = 0; i < plan->count && object != nil; i++)
+    {
+      Class	c = object_getClass(object);
+
+      if (class_getMethodImplementation(c, @selector(valueForKeyPath:))
+	!= pathIMP)
+	{
+	  return [object valueForKeyPath: plan->paths[i]];
+	}
+#if	defined(__OBJC2__)
+      if (class_getMethodImplementation(c, @selector(valueForKey:)) == keyIMP)
+	{
+	  object = valueForKeyWithCaching(object, plan->keys[i]);
+	  continue;
+	}
+#endif
+      object = [object valueForKey: plan->keys[i]];
+    }
+  return object;
 }
 
 - (NSString *) keyPath
@@ -2561,6 +2813,10 @@ GSICUStringMatchesRegex(NSString *string, NSString *regex, NSStringCompareOption
 
 - (void) dealloc;
 {
+  if (_plan != NULL)
+    {
+      freePlan(_plan);
+    }
   RELEASE(_keyPath);
   DEALLOC
 }
@@ -2571,6 +2827,7 @@ GSICUStringMatchesRegex(NSString *string, NSString *regex, NSStringCompareOption
 
   copy = (GSKeyPathExpression *)[super copyWithZone: zone];
   copy->_keyPath = [_keyPath copyWithZone: zone];
+  copy->_plan = NULL;
   return copy;
 }
 
@@ -3288,19 +3545,123 @@ do { \
 
 - (NSArray *) filteredArrayUsingPredicate: (NSPredicate *)predicate
 {
-  NSMutableArray	*result;
-  NSEnumerator		*e = [self objectEnumerator];
-  id			object;
+  return [self filteredArrayUsingPredicate: predicate options: 0];
+}
 
-  result = [NSMutableArray arrayWithCapacity: [self count]];
-  while ((object = [e nextObject]) != nil)
+/* The objects are evaluated in batches (each with its own autorelease
+ * pool) into a table of results, and the matching objects are collected
+ * from that table, so that concurrent evaluation keeps the array order.
+ */
+#define	FILTER_BATCH	1024
+
+- (NSArray *) filteredArrayUsingPredicate: (NSPredicate *)predicate
+				  options: (NSEnumerationOptions)opts
+{
+  NSUInteger		count = [self count];
+  NSUInteger		batches = (count + FILTER_BATCH - 1) / FILTER_BATCH;
+  NSUInteger		found = 0;
+  NSUInteger		i;
+  NSArray		*result;
+  id			*objects;
+  BOOL			*matches;
+
+  if (0 == count)
     {
-      if ([predicate evaluateWithObject: object] == YES)
-        {
-          [result addObject: object];  // passes filter
-        }
+      return [NSArray array];
     }
-  return GS_IMMUTABLE(result);
+  objects = malloc(count * (sizeof(id) + sizeof(BOOL)));
+  if (NULL == objects)
+    {
+      [NSException raise: NSMallocException
+		  format: @"Unable to allocate memory to filter array"];
+    }
+  matches = (BOOL*)(objects + count);
+  [self getObjects: objects];
+#if	__has_feature(blocks) && (GS_USE_LIBDISPATCH == 1)
+  if ((opts & NSEnumerationConcurrent) && batches > 1)
+    {
+      __block NSException	*failure = nil;
+
+      dispatch_apply(batches, GS_DISPATCH_GET_DEFAULT_CONCURRENT_QUEUE(),
+	^(size_t b) {
+	  NSUInteger	end = (b + 1) * FILTER_BATCH;
+	  NSUInteger	j;
+
+	  if (end > count)
+	    {
+	      end = count;
+	    }
+	  ENTER_POOL
+	  NS_DURING
+	    {
+	      for (j = b * FILTER_BATCH; j < end; j++)
+		{
+		  matches[j] = [predicate evaluateWithObject: objects[j]];
+		}
+	    }
+	  NS_HANDLER
+	    {
+	      id	expected = nil;
+
+	      for (j = b * FILTER_BATCH; j < end; j++)
+		{
+		  matches[j] = NO;
+		}
+	      RETAIN(localException);
+	      if (NO == __atomic_compare_exchange_n(&failure, &expected,
+		localException, NO, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+		{
+		  RELEASE(localException);
+		}
+	    }
+	  NS_ENDHANDLER
+	  LEAVE_POOL
+	});
+      if (failure != nil)
+	{
+	  free(objects);
+	  [AUTORELEASE(failure) raise];
+	}
+    }
+  else
+#endif
+    {
+      NS_DURING
+	{
+	  for (i = 0; i < batches; i++)
+	    {
+	      NSUInteger	end = (i + 1) * FILTER_BATCH;
+	      NSUInteger	j;
+
+	      if (end > count)
+		{
+		  end = count;
+		}
+	      ENTER_POOL
+	      for (j = i * FILTER_BATCH; j < end; j++)
+		{
+		  matches[j] = [predicate evaluateWithObject: objects[j]];
+		}
+	      LEAVE_POOL
+	    }
+	}
+      NS_HANDLER
+	{
+	  free(objects);
+	  [localException raise];
+	}
+      NS_ENDHANDLER
+    }
+  for (i = 0; i < count; i++)
+    {
+      if (matches[i])
+	{
+	  objects[found++] = objects[i];
+	}
+    }
+  result = [NSArray arrayWithObjects: objects count: found];
+  free(objects);
+  return result;
 }
 
 @end
@@ -49,6 +49,28 @@
 #import "GNUstepBase/NSString+GNUstepBase.h"
 #import "GSPrivate.h"
 
+/*
+ * Setup for inline operation of the maps used by the binary property
+ * list generator to unique objects.  The 'extra' field of each map
+ * holds the kind of object it contains (see PLKind below), which
+ * selects the hash and equality rules used.
+ */
+#define	GSI_MAP_KTYPES	GSUNION_OBJ
+#define	GSI_MAP_VTYPES	GSUNION_NSINT
+#define	GSI_MAP_RETAIN_KEY(M, X)
+#define	GSI_MAP_RELEASE_KEY(M, X)
+#define	GSI_MAP_RETAIN_VAL(M, X)
+#define	GSI_MAP_RELEASE_VAL(M, X)
+#define	GSI_MAP_HASH(M, X)	uniqueHash((M)->extra, (X).obj)
+#define	GSI_MAP_EQUAL(M, X, Y)	uniqueEqual((M)->extra, (X).obj, (Y).obj)
+#define	GSI_MAP_NOCLEAN	1
+#define	GSI_MAP_EXTRA	unsigned
+
+static inline NSUInteger uniqueHash(unsigned kind, id o);
+static inline BOOL uniqueEqual(unsigned kind, id a, id b);
+
+#include "GNUstepBase/GSIMap.h"
+
 static id       boolN = nil;
 static id       boolY = nil;
 
@@ -464,39 +486,117 @@ foundIgnorableWhitespace: (NSString *)string
   unsigned		root_index;	// Index of root object
   unsigned		table_start;	// Start address of object table
   NSHashTable           *_stack; // The stack of objects we are currently parsing
+  BOOL			lazy;	// Decode containers on demand
 }
 
 - (id) initWithData: (NSData*)plData
 	 mutability: (NSPropertyListMutabilityOptions)m;
 - (id) rootObject;
 - (id) objectAtIndex: (NSUInteger)index;
+- (id) objectIndexedAt: (unsigned)pos into: (id*)slot;
+- (unsigned) indexSize;
+- (void) _checkGraph;
+
+@end
+
+/* Read-only collections returned when a binary property list is decoded
+ * lazily.  They hold the offset of the table of object indexes in the
+ * data and decode each member the first time it is asked for.
+ */
+@interface GSBinaryPLArray : NSArray
+{
+  GSBinaryPLParser	*_parser;
+  unsigned		_start;
+  NSUInteger		_count;
+  id			*_objects;
+}
+- (id) initWithParser: (GSBinaryPLParser*)parser
+		count: (NSUInteger)count
+		   at: (unsigned)start;
+@end
+
+@interface GSBinaryPLDictionary : NSDictionary
+{
+  GSBinaryPLParser	*_parser;
+  unsigned		_start;
+  NSUInteger		_count;
+  id			*_keys;		// Keys followed by values
+  NSMapTable		*_map;		// Key to position plus one
+}
+- (id) initWithParser: (GSBinaryPLParser*)parser
+		count: (NSUInteger)count
+		   at: (unsigned)start;
+@end
 
+/* A data object using bytes inside the data of a binary property list
+ * which is decoded lazily (and retaining that data) rather than a copy.
+ */
+@interface GSBinaryPLData : NSData
+{
+  NSData		*_parent;
+  const unsigned char	*_bytes;
+  NSUInteger		_length;
+}
+- (id) initWithParent: (NSData*)parent
+		bytes: (const unsigned char*)bytes
+	       length: (NSUInteger)length;
 @end
 
+/* The kinds of object the binary property list generator knows how to
+ * write.  Values from PLKindString to PLKindData are uniqued by value,
+ * collections only by identity (so that writing a large graph does not
+ * require deep comparisons of its containers).
+ */
+typedef enum {
+  PLKindIdentity = 0,
+  PLKindString,
+  PLKindNumber,
+  PLKindDate,
+  PLKindData,
+  PLKindArray,
+  PLKindDictionary,
+  PLKindUID,
+  PLKindUnknown
+} PLKind;
+
 @interface GSBinaryPLGenerator : NSObject
 {
-  NSMutableData *dest;
-  NSMapTable 	*objectList;
-  NSMutableArray *objectsToDoList;
-  id root;
+@public
+  NSMutableData		*dest;		// Output if writing to memory
+  NSOutputStream	*stream;	// Output if writing to a stream
+  unsigned char		*buffer;	// Pending output
+  NSUInteger		used;		// Bytes of pending output
+  unsigned long long	written;	// Total bytes produced
+  id			root;
+  GSIMapTable_t		uniques[PLKindData + 1];  // Object to index maps
+  id			*objects;	// Objects in the order written
+  unsigned char		*kinds;		// Kind of each object
+  NSUInteger		*refStart;	// Start of each object's references
+  NSUInteger		count;
+  NSUInteger		capacity;
+  NSUInteger		*refs;		// Indexes of referenced objects
+  NSUInteger		refCount;
+  NSUInteger		refCapacity;
+  Class			lastClass;	// Cache for classification
+  unsigned		lastKind;
 
   // Number of bytes per object table index
   unsigned int index_size;
   // Number of bytes per object table entry
   unsigned int offset_size;
 
-  unsigned int table_start;
-  unsigned int table_size;
-  unsigned int *table;
+  unsigned long long	table_start;
 }
 
 + (void) serializePropertyList: (id)aPropertyList
                       intoData: (NSMutableData *)destination;
++ (unsigned long long) serializePropertyList: (id)aPropertyList
+				    toStream: (NSOutputStream *)destination;
 - (id) initWithPropertyList: (id)aPropertyList
                    intoData: (NSMutableData *)destination;
+- (id) initWithPropertyList: (id)aPropertyList
+                   toStream: (NSOutputStream *)destination;
 - (void) generate;
-- (BOOL) storeObject: (id)object;
-- (void) cleanup;
 
 @end
 
@@ -2597,7 +2697,20 @@ static BOOL	classInitialized = NO;
     }
   else if (aFormat == NSPropertyListBinaryFormat_v1_0)
     {
-      [GSBinaryPLGenerator serializePropertyList: aPropertyList intoData: dest];
+      NS_DURING
+	{
+	  [GSBinaryPLGenerator serializePropertyList: aPropertyList
+					    intoData: dest];
+	}
+      NS_HANDLER
+	{
+	  if (error != NULL)
+	    {
+	      *error = create_error(0, [localException reason]);
+	    }
+	  dest = nil;
+	}
+      NS_ENDHANDLER
     }
   else
     {
@@ -2606,6 +2719,13 @@ static BOOL	classInitialized = NO;
   return dest;
 }
 
+void
+GSPrivateBinaryPropertyList(id aPropertyList, NSMutableData *dest)
+{
+  [NSPropertyListSerialization class];	// Ensure classes are cached
+  [GSBinaryPLGenerator serializePropertyList: aPropertyList intoData: dest];
+}
+
 /**
  * <p>Make <var>obj</var> into a plist in <var>str</var>, using the locale <var>loc</var>.</p>
  *
@@ -2777,6 +2897,12 @@ checkPL(id aPropertyList, NSPropertyListFormat aFormat)
   id			result = nil;
   const unsigned char	*bytes = 0;
   unsigned int		length = 0;
+  NSPropertyListReadOptions	lazy;
+
+  /* Only the binary format parser knows about lazy decoding.
+   */
+  lazy = anOption & GSPropertyListLazyDecoding;
+  anOption &= ~GSPropertyListLazyDecoding;
 
   if (data == nil)
     {
@@ -2909,7 +3035,7 @@ checkPL(id aPropertyList, NSPropertyListFormat aFormat)
 	      {
                 GSBinaryPLParser	*p = [GSBinaryPLParser alloc];
             
-		p = [p initWithData: data mutability: anOption];
+		p = [p initWithData: data mutability: anOption | lazy];
 		result = AUTORELEASE(RETAIN([AUTORELEASE(p) rootObject]));
 	      }
 	    NS_HANDLER
@@ -2955,12 +3081,38 @@ checkPL(id aPropertyList, NSPropertyListFormat aFormat)
                         options: (NSPropertyListWriteOptions)anOption
                           error: (out NSError**)error
 {
+  NSData	*data;
+
+  if (aFormat == NSPropertyListBinaryFormat_v1_0 && aPropertyList != nil)
+    {
+      NSInteger	result = 0;
+
+      /* The binary generator writes to the stream as it goes, so large
+       * property lists need not be built in memory first.
+       */
+      NS_DURING
+	{
+	  result = (NSInteger)[GSBinaryPLGenerator
+	    serializePropertyList: aPropertyList toStream: stream];
+	}
+      NS_HANDLER
+	{
+	  if (error != NULL)
+	    {
+	      *error = create_error(0, [localException reason]);
+	    }
+	  result = 0;
+	}
+      NS_ENDHANDLER
+      return result;
+    }
+
   // FIXME: The NSData operations should be implemented on top of this method, 
   // not the other way round,
-  NSData *data = [self dataWithPropertyList: aPropertyList
-                                     format: aFormat
-                                    options: anOption
-                                      error: error];
+  data = [self dataWithPropertyList: aPropertyList
+                             format: aFormat
+                            options: anOption
+                              error: error];
 
   return [stream write: [data bytes] maxLength: [data length]];
 }
@@ -3119,9 +3271,24 @@ checkPL(id aPropertyList, NSPropertyListFormat aFormat)
 	}
       else
 	{
-	  ASSIGN(data, plData);
+	  mutability = m & ~GSPropertyListLazyDecoding;
+	  if ((m & GSPropertyListLazyDecoding)
+	    && mutability == NSPropertyListImmutable)
+	    {
+	      lazy = YES;
+	    }
+	  /* Objects decoded lazily use the bytes of the data, so we
+	   * must make sure that they can not change.
+	   */
+	  if (lazy)
+	    {
+	      data = [plData copy];
+	    }
+	  else
+	    {
+	      data = RETAIN(plData);
+	    }
 	  _bytes = (const unsigned char*)[data bytes];
-	  mutability = m;
 	}
     }
 
@@ -3223,11 +3390,138 @@ NSAssert(pos + 4 < _length, NSInvalidArgumentException);
     }
 }
 
+- (unsigned) indexSize
+{
+  return index_size;
+}
+
+/* Decode the object whose index is stored at pos and store it (retained)
+ * in slot, unless another thread has already done so.  Returns the object
+ * stored in the slot.
+ */
+- (id) objectIndexedAt: (unsigned)pos into: (id*)slot
+{
+  id	o = RETAIN([self objectAtIndex: [self readObjectIndexAt: &pos]]);
+  id	old = nil;
+
+  if (NO == __atomic_compare_exchange_n(slot, &old, o, NO,
+    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+      RELEASE(o);
+      o = old;
+    }
+  return o;
+}
+
 - (id) rootObject
 {
+  if (lazy)
+    {
+      [self _checkGraph];
+    }
   return [self objectAtIndex: root_index];
 }
 
+/* Containers decoded lazily do not decode their contents, so the check
+ * for cycles made while decoding them eagerly never happens, and a list
+ * whose containers refer to themselves would produce an endless tree of
+ * proxies.  So before decoding lazily we walk the graph of containers
+ * reachable from the root (reading only their object references) and
+ * reject it if there is a cycle.
+ * The walk uses an explicit stack, on which an object may appear at
+ * most once, so that a deep graph can not exhaust the thread's stack.
+ */
+- (void) _checkGraph
+{
+  typedef struct {
+    unsigned		pos;	// Position of the next reference
+    unsigned long	left;	// Number of references still to visit
+    unsigned		index;	// Index of the container
+  } Frame;
+  unsigned char	*state;	// 0 unvisited, 1 on the stack, 2 finished
+  Frame		*frames;
+  unsigned	depth = 0;
+  unsigned	index = root_index;
+
+  state = [[NSMutableData dataWithLength: object_count] mutableBytes];
+  frames = [[NSMutableData dataWithLength: object_count * sizeof(Frame)]
+    mutableBytes];
+  for (;;)
+    {
+      if (index < object_count && 0 == state[index])
+	{
+	  unsigned	counter = [self offsetForIndex: index];
+	  unsigned char	next;
+	  unsigned long	len = 0;
+	  unsigned long	refs;
+	  unsigned	size = index_size;
+
+	  if (counter >= _length)
+	    {
+	      [NSException raise: NSGenericException
+			  format: @"Object offset out of range %u", counter];
+	    }
+	  next = _bytes[counter++];
+	  if ((next >= 0xA0) && (next < 0xAF))
+	    {
+	      len = next - 0xA0;
+	    }
+	  else if (next == 0xAF)
+	    {
+	      len = [self readCountAt: &counter];
+	    }
+	  else if ((next >= 0xD0) && (next < 0xDF))
+	    {
+	      len = next - 0xD0;
+	      size *= 2;
+	    }
+	  else if (next == 0xDF)
+	    {
+	      len = [self readCountAt: &counter];
+	      size *= 2;
+	    }
+	  if (counter > _length || len > (_length - counter) / size)
+	    {
+	      [NSException raise: NSGenericException
+		format: @"Invalid binary property list container size %lu",
+		len];
+	    }
+	  refs = len * (size / index_size);
+	  if (refs > 0)
+	    {
+	      state[index] = 1;
+	      frames[depth].pos = counter;
+	      frames[depth].left = refs;
+	      frames[depth].index = index;
+	      depth++;
+	    }
+	  else
+	    {
+	      state[index] = 2;
+	    }
+	}
+      else if (index < object_count && 1 == state[index])
+	{
+	  [NSException raise: NSGenericException
+		      format: @"Cyclic object graph"];
+	}
+
+      /* Move to the next reference of the innermost unfinished container.
+       */
+      while (depth > 0 && 0 == frames[depth - 1].left)
+	{
+	  depth--;
+	  state[frames[depth].index] = 2;
+	}
+      if (0 == depth)
+	{
+	  break;
+	}
+      frames[depth - 1].left--;
+      index = [self readObjectIndexAt: &frames[depth - 1].pos];
+    }
+}
+
 - (BOOL)_pushObject: (NSUInteger)index
 {
   uintptr_t val;
@@ -3250,6 +3544,28 @@ NSAssert(pos + 4 < _length, NSInvalidArgumentException);
     }
 }
 
+- (id) _lazyArray: (unsigned long)len at: (unsigned)counter
+{
+  if (counter > _length || len > (_length - counter) / index_size)
+    {
+      [NSException raise: NSGenericException
+	format: @"Invalid binary property list array size %lu", len];
+    }
+  return AUTORELEASE([[GSBinaryPLArray alloc]
+    initWithParser: self count: len at: counter]);
+}
+
+- (id) _lazyDictionary: (unsigned long)len at: (unsigned)counter
+{
+  if (counter > _length || len > (_length - counter) / (2 * index_size))
+    {
+      [NSException raise: NSGenericException
+	format: @"Invalid binary property list dictionary size %lu", len];
+    }
+  return AUTORELEASE([[GSBinaryPLDictionary alloc]
+    initWithParser: self count: len at: counter]);
+}
+
 - (id) objectAtIndex: (NSUInteger)index
 {
   unsigned char	next;
@@ -3323,7 +3639,12 @@ NSAssert(pos + 4 < _length, NSInvalidArgumentException);
       unsigned len = next - 0x40;
 
 NSAssert(counter + len <= _length, NSInvalidArgumentException);
-      if (mutability == NSPropertyListMutableContainersAndLeaves)
+      if (lazy)
+	{
+	  result = AUTORELEASE([[GSBinaryPLData alloc]
+	    initWithParent: data bytes: _bytes + counter length: len]);
+	}
+      else if (mutability == NSPropertyListMutableContainersAndLeaves)
 	{
 	  result = [NSMutableData dataWithBytes: _bytes + counter
 					 length: len];
@@ -3341,7 +3662,12 @@ NSAssert(counter + len <= _length, NSInvalidArgumentException);
 
       len = [self readCountAt: &counter];
 NSAssert(counter + len <= _length, NSInvalidArgumentException);
-      if (mutability == NSPropertyListMutableContainersAndLeaves)
+      if (lazy)
+	{
+	  result = AUTORELEASE([[GSBinaryPLData alloc]
+	    initWithParent: data bytes: _bytes + counter length: len]);
+	}
+      else if (mutability == NSPropertyListMutableContainersAndLeaves)
 	{
 	  result = [NSMutableData dataWithBytes: _bytes + counter
 					 length: len];
@@ -3371,6 +3697,11 @@ NSAssert(counter + len <= _length, NSInvalidArgumentException);
 	  [NSException raise: NSInvalidArgumentException
 	    format: @"binary plist string extends beyond the supplied data"];
 	}
+      if (lazy && (result = GSPrivateStringWithOwnedBytes(data,
+	_bytes + counter, len)) != nil)
+	{
+	  return result;	// ASCII string using our data
+	}
       s = [s initWithBytes: _bytes + counter
                     length: len
                   encoding: NSUTF8StringEncoding];
@@ -3395,6 +3726,11 @@ NSAssert(counter + len <= _length, NSInvalidArgumentException);
 	  [NSException raise: NSInvalidArgumentException
 	    format: @"binary plist string extends beyond the supplied data"];
 	}
+      if (lazy && (result = GSPrivateStringWithOwnedBytes(data,
+	_bytes + counter, len)) != nil)
+	{
+	  return result;	// ASCII string using our data
+	}
       s = [s initWithBytes: _bytes + counter
                     length: len
                   encoding: NSUTF8StringEncoding];
@@ -3473,6 +3809,11 @@ NSAssert(counter + len <= _length, NSInvalidArgumentException);
       unsigned	len = next - 0xA0;
       unsigned	i;
       id	objects[len];
+
+      if (lazy)
+	{
+	  return [self _lazyArray: len at: counter];
+	}
       PUSH_OBJ(index);
       for (i = 0; i < len; i++)
         {
@@ -3504,6 +3845,10 @@ NSAssert(counter + len <= _length, NSInvalidArgumentException);
 	  [NSException raise: NSGenericException
 		format: @"Invalid binary property list array size %lu", len];
 	}
+      if (lazy)
+	{
+	  return [self _lazyArray: len at: counter];
+	}
       objects = NSAllocateCollectable(sizeof(id) * len, NSScannedOption);
       PUSH_OBJ(index);
       for (i = 0; i < len; i++)
@@ -3531,6 +3876,11 @@ NSAssert(counter + len <= _length, NSInvalidArgumentException);
       unsigned	i;
       id	keys[len];
       id	values[len];
+
+      if (lazy)
+	{
+	  return [self _lazyDictionary: len at: counter];
+	}
       PUSH_OBJ(index);
       for (i = 0; i < len; i++)
         {
@@ -3574,6 +3924,10 @@ NSAssert(counter + len <= _length, NSInvalidArgumentException);
 	  [NSException raise: NSGenericException
 		format: @"Invalid binary property list dictionary size %lu", len];
 	}
+      if (lazy)
+	{
+	  return [self _lazyDictionary: len at: counter];
+	}
       keys = NSAllocateCollectable(sizeof(id) * len * 2, NSScannedOption);
       values = keys + len;
       PUSH_OBJ(index);
@@ -3618,452 +3972,805 @@ NSAssert(counter + len <= _length, NSInvalidArgumentException);
 #undef POP_OBJ
 @end
 
-/* Test two items for equality ... both are objects.
- * If either is an NSNumber, we insist that they are the same class
- * so that numbers with the same numeric value but different classes
- * are not treated as the same number (that confuses OSXs decoding).
- */
-static BOOL
-isEqualFunc(const void *item1, const void *item2,
-  NSUInteger (*size)(const void *item))
-{
-  id	o1 = (id)item1;
-  id	o2 = (id)item2;
+@implementation GSBinaryPLArray
 
-  if ([o1 isKindOfClass: [NSNumber class]]
-    || [o2 isKindOfClass: [NSNumber class]])
-    {
-      if ([o1 class] != [o2 class])
-	{
-	  return NO;
-	}
-    }
-  return [o1 isEqual: o2];
+- (id) copyWithZone: (NSZone*)z
+{
+  return RETAIN(self);
 }
 
-@implementation GSBinaryPLGenerator
-
-+ (void) serializePropertyList: (id)aPropertyList
-		      intoData: (NSMutableData *)destination
+- (Class) classForCoder
 {
-  GSBinaryPLGenerator *gen;
-
-  gen = [[GSBinaryPLGenerator alloc]
-    initWithPropertyList: aPropertyList intoData: destination];
-  [gen generate];
-  RELEASE(gen);
+  return NSArrayClass;
 }
 
-- (id) initWithPropertyList: (id) aPropertyList
-		   intoData: (NSMutableData *)destination
+- (NSUInteger) count
 {
-  ASSIGN(root, aPropertyList);
-  ASSIGN(dest, destination);
-  [dest setLength: 0];
-
-  return self;
+  return _count;
 }
 
 - (void) dealloc
 {
-  DESTROY(root);
-  [self cleanup];
-  DESTROY(dest);
+  if (_objects != 0)
+    {
+      NSUInteger	i;
+
+      for (i = 0; i < _count; i++)
+	{
+	  RELEASE(_objects[i]);
+	}
+      NSZoneFree(NSDefaultMallocZone(), _objects);
+    }
+  DESTROY(_parser);
   [super dealloc];
 }
 
-- (NSData*) data
+- (id) initWithParser: (GSBinaryPLParser*)parser
+		count: (NSUInteger)count
+		   at: (unsigned)start
 {
-  return dest;
+  _parser = RETAIN(parser);
+  _start = start;
+  _count = count;
+  if (_count > 0)
+    {
+      _objects = NSZoneCalloc(NSDefaultMallocZone(), _count, sizeof(id));
+    }
+  return self;
 }
 
-- (void) setup
+- (id) objectAtIndex: (NSUInteger)index
 {
-  NSPointerFunctions	*k;
-  NSPointerFunctions	*v;
+  id	o;
 
-  [dest setLength: 0];
-  if (index_size == 1)
-    {
-      table_size = 256;
-    }
-  else if (index_size == 2)
-    {
-      table_size = 256 * 256;
-    }
-  else if (index_size == 3)
+  if (index >= _count)
     {
-      table_size = 256 * 256 * 256;
+      [NSException raise: NSRangeException
+		  format: @"Index %"PRIuPTR" is out of range %"PRIuPTR
+	@" (in '%@')", index, _count, NSStringFromSelector(_cmd)];
     }
-  else if (index_size == 4)
+  o = __atomic_load_n(&_objects[index], __ATOMIC_ACQUIRE);
+  if (nil == o)
     {
-      table_size = UINT_MAX;
+      o = [_parser objectIndexedAt: _start + index * [_parser indexSize]
+			      into: &_objects[index]];
     }
+  return o;
+}
+
+@end
 
-  table = NSZoneMalloc(0, table_size * sizeof(int));
+@implementation GSBinaryPLDictionary
 
-  objectsToDoList = [[NSMutableArray alloc] init];
-  k = [NSPointerFunctions pointerFunctionsWithOptions:
-    NSPointerFunctionsObjectPersonality];
-  [k setIsEqualFunction: isEqualFunc];
-  v = [NSPointerFunctions pointerFunctionsWithOptions:
-    NSPointerFunctionsIntegerPersonality|NSPointerFunctionsOpaqueMemory];
-  objectList = [[NSMapTable alloc] initWithKeyPointerFunctions: k
-					 valuePointerFunctions: v
-						      capacity: 1000];
+/* Dictionaries with more than this many entries are looked up through a
+ * map table rather than by comparing the key with each key in turn.
+ */
+#define	LAZY_MAP_THRESHOLD	8
 
-  [objectsToDoList addObject: root];
-  [objectList setObject: (id)1 forKey: root];
+- (id) copyWithZone: (NSZone*)z
+{
+  return RETAIN(self);
 }
 
-- (void) cleanup
+- (Class) classForCoder
 {
-  DESTROY(objectsToDoList);
-  DESTROY(objectList);
-  if (table != NULL)
-    {
-      NSZoneFree(0, table);
-      table = NULL;
-    }
+  return NSDictionaryClass;
 }
 
-- (BOOL) writeObjects
+- (NSUInteger) count
 {
-  id object;
-  const char *prefix = "bplist00";
+  return _count;
+}
 
-  [dest appendBytes: prefix length: strlen(prefix)];
+- (void) dealloc
+{
+  if (_keys != 0)
+    {
+      NSUInteger	i;
 
-  while ([objectsToDoList count] != 0)
+      for (i = 0; i < 2 * _count; i++)
+	{
+	  RELEASE(_keys[i]);
+	}
+      NSZoneFree(NSDefaultMallocZone(), _keys);
+    }
+  if (_map != 0)
     {
-      object = [objectsToDoList objectAtIndex: 0];
-      if (NO == [self storeObject: object])
-        {
-          return NO;
-        }
-      [objectsToDoList removeObjectAtIndex: 0];
+      NSFreeMapTable(_map);
     }
-  return YES;
+  DESTROY(_parser);
+  [super dealloc];
 }
 
-- (BOOL) markOffset: (unsigned int) offset for: (id)object
+- (id) initWithParser: (GSBinaryPLParser*)parser
+		count: (NSUInteger)count
+		   at: (unsigned)start
 {
-  int oid;
-
-  oid = (NSInteger)[objectList objectForKey: object];
-  if (oid <= 0)
-    {
-      [NSException raise: NSGenericException
-		   format: @"Unknown object %@.", object];
-    }
-  oid--;
-  if (oid >= table_size)
+  _parser = RETAIN(parser);
+  _start = start;
+  _count = count;
+  if (_count > 0)
     {
-      return NO;
+      _keys = NSZoneCalloc(NSDefaultMallocZone(), 2 * _count, sizeof(id));
     }
-
-  table[oid] = offset;
-  return YES;
+  return self;
 }
 
-- (void) writeObjectTable
+/* Return the key (for a position less than the count) or the value
+ * (for a position from count onwards) at pos, decoding it if needed.
+ */
+- (id) _objectAt: (NSUInteger)pos
 {
-  unsigned int size;
-  unsigned int len;
-  unsigned int i;
-  unsigned char *buffer;
-  unsigned int last_offset;
+  id	o = __atomic_load_n(&_keys[pos], __ATOMIC_ACQUIRE);
 
-  table_start = [dest length];
-  // This is a bit too much, as the length
-  // of the last object is added.
-  last_offset = table_start;
-
-  if (last_offset < 256)
-    {
-      offset_size = 1;
-    }
-  else if (last_offset < 256 * 256)
-    {
-      offset_size = 2;
-    }
-  else if (last_offset < 256 * 256 * 256)
-    {
-      offset_size = 3;
-    }
-  else
+  if (nil == o)
     {
-      offset_size = 4;
+      o = [_parser objectIndexedAt: _start + pos * [_parser indexSize]
+			      into: &_keys[pos]];
     }
+  return o;
+}
 
-  len = [objectList count];
-  size = offset_size * len;
-
-  buffer = NSZoneMalloc(0, size);
+- (NSMapTable*) _map
+{
+  NSMapTable	*m = __atomic_load_n(&_map, __ATOMIC_ACQUIRE);
 
-  if (offset_size == 1)
+  if (0 == m)
     {
-      for (i = 0; i < len; i++)
-        {
-	  unsigned char ci;
+      NSMapTable	*old = 0;
+      NSUInteger	i;
 
-	  ci = table[i];
-	  buffer[i] = ci;
+      m = NSCreateMapTable(NSObjectMapKeyCallBacks,
+	NSIntegerMapValueCallBacks, _count);
+      for (i = 0; i < _count; i++)
+	{
+	  NSMapInsert(m, [self _objectAt: i], (void*)(uintptr_t)(i + 1));
 	}
-    }
-  else if (offset_size == 2)
-    {
-      for (i = 0; i < len; i++)
-        {
-	  unsigned short si;
-
-	  si = table[i];
-	  buffer[2 * i] = (si >> 8);
-	  buffer[2 * i + 1] = si % 256;
+      if (NO == __atomic_compare_exchange_n(&_map, &old, m, NO,
+	__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+	{
+	  NSFreeMapTable(m);
+	  m = old;
 	}
     }
-  else if (offset_size == 3)
-    {
-      for (i = 0; i < len; i++)
-        {
-	  unsigned int si;
+  return m;
+}
 
-	  si = table[i];
-	  buffer[3 * i] = (si >> 16);
-	  buffer[3 * i + 1] = (si >> 8) % 256;
-	  buffer[3 * i + 2] = si % 256;
-	}
+- (NSUInteger) countByEnumeratingWithState: (NSFastEnumerationState*)state
+				   objects: (__unsafe_unretained id[])stackbuf
+				     count: (NSUInteger)len
+{
+  NSUInteger	n;
+
+  state->mutationsPtr = (unsigned long *)&state->mutationsPtr;
+  if (state->state >= _count)
+    {
+      return 0;
     }
-  else if (offset_size == 4)
+  for (n = state->state; n < _count; n++)
     {
-      for (i = 0; i < len; i++)
-        {
-	  unsigned int si;
-
-	  si = table[i];
-	  buffer[4 * i] = (si >> 24);
-	  buffer[4 * i + 1] = (si >> 16) % 256;
-	  buffer[4 * i + 2] = (si >> 8) % 256;
-	  buffer[4 * i + 3] = si % 256;
-	}
+      [self _objectAt: n];
     }
-
-  [dest appendBytes: buffer length: size];
-  NSZoneFree(0, buffer);
+  state->itemsPtr = _keys + state->state;
+  n = _count - state->state;
+  state->state = _count;
+  return n;
 }
 
-- (void) writeMetaData
+- (NSEnumerator*) keyEnumerator
 {
-  unsigned char meta[32];
-  unsigned int i;
-  unsigned int len;
+  NSUInteger	i;
 
-  for (i = 0; i < 32; i++)
+  for (i = 0; i < _count; i++)
     {
-      meta[i] = 0;
+      [self _objectAt: i];
     }
-
-  meta[6] = offset_size;
-  meta[7] = index_size;
-
-  len = [objectList count];
-  meta[12] = (len >> 24);
-  meta[13] = (len >> 16) % 256;
-  meta[14] = (len >> 8) % 256;
-  meta[15] = len % 256;
-  // root index is always 0, no need to write it
-  meta[28] = (table_start >> 24);
-  meta[29] = (table_start >> 16) % 256;
-  meta[30] = (table_start >> 8) % 256;
-  meta[31] = table_start % 256;
-
-  [dest appendBytes: meta length: 32];
+  return [[NSArray arrayWithObjects: _keys count: _count] objectEnumerator];
 }
 
-- (NSInteger) indexForObject: (id)object
+- (NSEnumerator*) objectEnumerator
 {
-  NSInteger index;
+  NSUInteger	i;
 
-  index = (NSInteger)[objectList objectForKey: object];
-  if (index <= 0)
+  for (i = 0; i < _count; i++)
     {
-      index = [objectList count];
-      [objectList setObject: (id)(++index) forKey: object];
-      [objectsToDoList addObject: object];
+      [self _objectAt: _count + i];
     }
-
-  return index - 1;
+  return [[NSArray arrayWithObjects: _keys + _count count: _count]
+    objectEnumerator];
 }
 
-- (void) storeIndex: (NSInteger)index
+- (id) objectForKey: (id)aKey
 {
-  if (index_size == 1)
-    {
-      unsigned char oid;
+  NSUInteger	i;
 
-      oid = index;
-      [dest appendBytes: &oid length: 1];
+  if (nil == aKey)
+    {
+      return nil;
     }
-  else if (index_size == 2)
+  if (_count > LAZY_MAP_THRESHOLD)
     {
-      unsigned short oid;
+      i = (NSUInteger)(uintptr_t)NSMapGet([self _map], aKey);
+      if (0 == i)
+	{
+	  return nil;
+	}
+      return [self _objectAt: _count + i - 1];
+    }
 
-      oid = NSSwapHostShortToBig(index);
-      [dest appendBytes: &oid length: 2];
+  /* Later entries with the same key replace earlier ones, as they would
+   * when building a dictionary, so we search backwards.
+   */
+  i = _count;
+  while (i-- > 0)
+    {
+      if ([aKey isEqual: [self _objectAt: i]])
+	{
+	  return [self _objectAt: _count + i];
+	}
     }
-  else if (index_size == 3)
+  return nil;
+}
+
+@end
+
+@implementation GSBinaryPLData
+
+- (const void*) bytes
+{
+  return _bytes;
+}
+
+- (Class) classForCoder
+{
+  return NSDataClass;
+}
+
+- (id) copyWithZone: (NSZone*)z
+{
+  return RETAIN(self);
+}
+
+- (void) dealloc
+{
+  DESTROY(_parent);
+  [super dealloc];
+}
+
+- (id) initWithParent: (NSData*)parent
+		bytes: (const unsigned char*)bytes
+	       length: (NSUInteger)length
+{
+  _parent = RETAIN(parent);
+  _bytes = bytes;
+  _length = length;
+  return self;
+}
+
+- (NSUInteger) length
+{
+  return _length;
+}
+
+@end
+
+/* Hash an object for uniquing in a map of the given kind.
+ */
+static inline NSUInteger
+uniqueHash(unsigned kind, id o)
+{
+  switch (kind)
     {
-      uint8_t	buffer[index_size];
-      unsigned	num = index;
-      int 	i;
+      case PLKindString:
+      case PLKindNumber:
+      case PLKindData:
+	return [o hash];
+      case PLKindDate:
+	{
+	  union { double d; uint64_t u; } v;
 
-      for (i = 2; i >= 0; i--)
-        {
-	  buffer[i] = (uint8_t)(num & 0xFF);
-          num >>= 8;
+	  v.d = [o timeIntervalSinceReferenceDate];
+	  return (NSUInteger)(v.u ^ (v.u >> 32));
 	}
-      [dest appendBytes: buffer length: index_size];
+      default:
+	return ((NSUInteger)(uintptr_t)o) >> 3;
     }
-  else if (index_size == 4)
-    {
-      unsigned int oid;
+}
 
-      oid = NSSwapHostIntToBig(index);
-      [dest appendBytes: &oid length: 4];
+/* Test two items for equality in a map of the given kind.
+ * For numbers, we insist that they are the same class so that numbers
+ * with the same numeric value but different classes are not treated
+ * as the same number (that confuses OSXs decoding).
+ */
+static inline BOOL
+uniqueEqual(unsigned kind, id a, id b)
+{
+  if (a == b)
+    {
+      return YES;
+    }
+  switch (kind)
+    {
+      case PLKindString:
+	return [a isEqualToString: b];
+      case PLKindNumber:
+	return (object_getClass(a) == object_getClass(b)
+	  && [a isEqualToNumber: b]) ? YES : NO;
+      case PLKindDate:
+	return ([a timeIntervalSinceReferenceDate]
+	  == [b timeIntervalSinceReferenceDate]) ? YES : NO;
+      case PLKindData:
+	return [a isEqualToData: b];
+      default:
+	return NO;
     }
-  else
+}
+
+/* Size of the generator's output buffer.  Output is staged here and
+ * passed to the destination data or stream in large chunks.
+ */
+#define	PL_BUFSIZE	65536
+
+static void
+writeOut(GSBinaryPLGenerator *g, const uint8_t *bytes, NSUInteger length)
+{
+  if (g->dest != nil)
     {
-      [NSException raise: NSGenericException
-		   format: @"Unknown table size %d", index_size];
+      [g->dest appendBytes: bytes length: length];
+      return;
+    }
+  while (length > 0)
+    {
+      NSInteger	n = [g->stream write: bytes maxLength: length];
+
+      if (n <= 0)
+	{
+	  NSError	*e = [g->stream streamError];
+
+	  [NSException raise: NSGenericException
+		      format: @"Unable to write binary property list: %@",
+	    (e == nil) ? (id)@"stream closed" : (id)[e localizedDescription]];
+	}
+      bytes += n;
+      length -= n;
     }
 }
 
-- (void) storeCount: (unsigned int)count
+static inline void
+flushBuffer(GSBinaryPLGenerator *g)
 {
-  unsigned char code;
+  if (g->used > 0)
+    {
+      writeOut(g, g->buffer, g->used);
+      g->used = 0;
+    }
+}
 
-  if (count < 256)
+static inline void
+writeBytes(GSBinaryPLGenerator *g, const void *bytes, NSUInteger length)
+{
+  g->written += length;
+  if (g->used + length > PL_BUFSIZE)
     {
-      unsigned char c;
+      flushBuffer(g);
+      if (length > PL_BUFSIZE / 2)
+	{
+	  writeOut(g, bytes, length);
+	  return;
+	}
+    }
+  memcpy(g->buffer + g->used, bytes, length);
+  g->used += length;
+}
 
-      code = 0x10;
-      [dest appendBytes: &code length: 1];
-      c = count;
-      [dest appendBytes: &c length: 1];
+static inline void
+writeByte(GSBinaryPLGenerator *g, uint8_t c)
+{
+  if (g->used == PL_BUFSIZE)
+    {
+      flushBuffer(g);
     }
-  else if (count < 256 * 256)
+  g->buffer[g->used++] = c;
+  g->written++;
+}
+
+/* Write the low size bytes of v in big-endian order.
+ */
+static inline void
+writeBE(GSBinaryPLGenerator *g, unsigned long long v, unsigned size)
+{
+  uint8_t	b[8];
+  unsigned	i = size;
+
+  while (i-- > 0)
     {
-      unsigned short c;
+      b[i] = (uint8_t)(v & 0xff);
+      v >>= 8;
+    }
+  writeBytes(g, b, size);
+}
 
-      code = 0x11;
-      [dest appendBytes: &code length: 1];
-      c = count;
-      c = NSSwapHostShortToBig(c);
-      [dest appendBytes: &c length: 2];
+static void
+writeCount(GSBinaryPLGenerator *g, unsigned long long c)
+{
+  if (c < 256)
+    {
+      writeByte(g, 0x10);
+      writeBE(g, c, 1);
+    }
+  else if (c < 256 * 256)
+    {
+      writeByte(g, 0x11);
+      writeBE(g, c, 2);
+    }
+  else if (c <= 0xffffffff)
+    {
+      writeByte(g, 0x12);
+      writeBE(g, c, 4);
     }
   else
     {
-      code = 0x12;
-      [dest appendBytes: &code length: 1];
-      count = NSSwapHostIntToBig(count);
-      [dest appendBytes: &count length: 4];
+      writeByte(g, 0x13);
+      writeBE(g, c, 8);
     }
 }
 
-- (void) storeData: (NSData*) data
+/* Write an object marker whose low nibble holds the length of the object
+ * or, for longer objects, 0x0F followed by the length as an integer.
+ */
+static inline void
+writeMarker(GSBinaryPLGenerator *g, uint8_t code, NSUInteger len)
 {
-  unsigned int len;
-  unsigned char code;
-
-  len = [data length];
-
   if (len < 0x0F)
     {
-      code = 0x40 + len;
-      [dest appendBytes: &code length: 1];
-      [dest appendData: data];
+      writeByte(g, code + len);
     }
   else
     {
-      code = 0x4F;
-      [dest appendBytes: &code length: 1];
-      [self storeCount: len];
-      [dest appendData: data];
+      writeByte(g, code + 0x0F);
+      writeCount(g, len);
     }
 }
 
-- (void) storeString: (NSString*) string
+static unsigned
+kindOf(GSBinaryPLGenerator *g, id o)
 {
-  unsigned int len;
-  NSData        *ascii;
-  unsigned char code;
+  Class		c = object_getClass(o);
+  unsigned	k;
+
+  if (c == g->lastClass)
+    {
+      k = g->lastKind;
+    }
+  else
+    {
+      if ([o isKindOfClass: NSStringClass])
+	k = PLKindString;
+      else if ([o isKindOfClass: NSDataClass])
+	k = PLKindData;
+      else if ([o isKindOfClass: NSNumberClass])
+	k = PLKindNumber;
+      else if ([o isKindOfClass: NSDateClass])
+	k = PLKindDate;
+      else if ([o isKindOfClass: NSArrayClass])
+	k = PLKindArray;
+      else if ([o isKindOfClass: NSDictionaryClass])
+	k = PLKindDictionary;
+      else
+	k = PLKindUnknown;
+      g->lastClass = c;
+      g->lastKind = k;
+    }
+  if (PLKindDictionary == k && [o objectForKey: @"CF$UID"] != nil)
+    {
+      // Special dictionary from keyed encoding
+      k = PLKindUID;
+    }
+  return k;
+}
 
-  len = [string length];
+/* Return the index of an object in the object table, adding it (to be
+ * written later) if no equivalent object has been seen before.
+ */
+static NSUInteger
+noteObject(GSBinaryPLGenerator *g, id o)
+{
+  GSIMapNode	n;
+  unsigned	kind;
+  NSUInteger	index;
 
-  ascii = [string dataUsingEncoding: NSASCIIStringEncoding
-               allowLossyConversion: NO];
-  if (ascii)
+  n = GSIMapNodeForKey(&g->uniques[PLKindIdentity], (GSIMapKey)o);
+  if (n != 0)
     {
-      if (len < 0x0F)
+      return n->value.nsu;
+    }
+  kind = kindOf(g, o);
+  if (kind <= PLKindData)
+    {
+      n = GSIMapNodeForKey(&g->uniques[kind], (GSIMapKey)o);
+      if (n != 0)
 	{
-	  code = 0x50 + len;
-	  [dest appendBytes: &code length: 1];
-	  [dest appendData: ascii];
+	  return n->value.nsu;
 	}
-      else
+    }
+
+  if (g->count == g->capacity)
+    {
+      g->capacity = (g->capacity < 64) ? 64 : g->capacity * 2;
+      g->objects = NSZoneRealloc(0, g->objects, g->capacity * sizeof(id));
+      g->kinds = NSZoneRealloc(0, g->kinds, g->capacity);
+      g->refStart = NSZoneRealloc(0, g->refStart,
+	g->capacity * sizeof(NSUInteger));
+    }
+  index = g->count++;
+  g->objects[index] = RETAIN(o);
+  g->kinds[index] = kind;
+  g->refStart[index] = 0;
+  GSIMapAddPair(&g->uniques[PLKindIdentity], (GSIMapKey)o, (GSIMapVal)index);
+  if (kind <= PLKindData)
+    {
+      GSIMapAddPair(&g->uniques[kind], (GSIMapKey)o, (GSIMapVal)index);
+    }
+  return index;
+}
+
+static inline void
+addRef(GSBinaryPLGenerator *g, NSUInteger index)
+{
+  if (g->refCount == g->refCapacity)
+    {
+      g->refCapacity = (g->refCapacity < 256) ? 256 : g->refCapacity * 2;
+      g->refs = NSZoneRealloc(0, g->refs, g->refCapacity * sizeof(NSUInteger));
+    }
+  g->refs[g->refCount++] = index;
+}
+
+@implementation GSBinaryPLGenerator
+
++ (void) serializePropertyList: (id)aPropertyList
+		      intoData: (NSMutableData *)destination
+{
+  GSBinaryPLGenerator *gen;
+
+  gen = [[GSBinaryPLGenerator alloc]
+    initWithPropertyList: aPropertyList intoData: destination];
+  NS_DURING
+    {
+      [gen generate];
+    }
+  NS_HANDLER
+    {
+      RELEASE(gen);
+      [localException raise];
+    }
+  NS_ENDHANDLER
+  RELEASE(gen);
+}
+
++ (unsigned long long) serializePropertyList: (id)aPropertyList
+				    toStream: (NSOutputStream *)destination
+{
+  GSBinaryPLGenerator	*gen;
+  unsigned long long	result;
+
+  gen = [[GSBinaryPLGenerator alloc]
+    initWithPropertyList: aPropertyList toStream: destination];
+  NS_DURING
+    {
+      [gen generate];
+    }
+  NS_HANDLER
+    {
+      RELEASE(gen);
+      [localException raise];
+    }
+  NS_ENDHANDLER
+  result = gen->written;
+  RELEASE(gen);
+  return result;
+}
+
+- (id) initWithPropertyList: (id) aPropertyList
+		   intoData: (NSMutableData *)destination
+{
+  ASSIGN(root, aPropertyList);
+  ASSIGN(dest, destination);
+  [dest setLength: 0];
+
+  return self;
+}
+
+- (id) initWithPropertyList: (id) aPropertyList
+		   toStream: (NSOutputStream *)destination
+{
+  ASSIGN(root, aPropertyList);
+  ASSIGN(stream, destination);
+
+  return self;
+}
+
+- (void) dealloc
+{
+  DESTROY(root);
+  [self cleanup];
+  DESTROY(dest);
+  DESTROY(stream);
+  [super dealloc];
+}
+
+- (NSData*) data
+{
+  return dest;
+}
+
+- (void) setup
+{
+  unsigned	i;
+
+  for (i = 0; i <= PLKindData; i++)
+    {
+      GSIMapInitWithZoneAndCapacity(&uniques[i], 0, 64);
+      uniques[i].extra = i;
+    }
+  buffer = NSZoneMalloc(0, PL_BUFSIZE);
+  used = 0;
+  written = 0;
+}
+
+- (void) cleanup
+{
+  if (buffer != NULL)
+    {
+      unsigned	i;
+
+      for (i = 0; i <= PLKindData; i++)
 	{
-	  code = 0x5F;
-	  [dest appendBytes: &code length: 1];
-	  [self storeCount: len];
-	  [dest appendData: ascii];
+	  GSIMapEmptyMap(&uniques[i]);
 	}
+      NSZoneFree(0, buffer);
+      buffer = NULL;
     }
-  else
+  while (count > 0)
+    {
+      RELEASE(objects[--count]);
+    }
+  if (objects != NULL)
     {
-      NSUInteger        offset;
-      unichar           *buffer;
+      NSZoneFree(0, objects);
+      objects = NULL;
+      NSZoneFree(0, kinds);
+      kinds = NULL;
+      NSZoneFree(0, refStart);
+      refStart = NULL;
+    }
+  if (refs != NULL)
+    {
+      NSZoneFree(0, refs);
+      refs = NULL;
+    }
+  capacity = refCount = refCapacity = 0;
+}
 
-      if (len < 0x0F)
+/* First pass: walk the property list breadth first, assigning each
+ * distinct object an index and recording the indexes referenced by
+ * each collection.  The object count determines the size of the
+ * indexes we write.
+ */
+- (void) collectObjects
+{
+  NSUInteger	i;
+
+  noteObject(self, root);
+  for (i = 0; i < count; i++)
+    {
+      id	o = objects[i];
+
+      if (PLKindArray == kinds[i])
 	{
-	  code = 0x60 + len;
-	  [dest appendBytes: &code length: 1];
+	  refStart[i] = refCount;
+	  GS_FOR_IN(id, item, o)
+	    addRef(self, noteObject(self, item));
+	  GS_END_FOR(o)
 	}
-      else
-        {
-	  code = 0x6F;
-	  [dest appendBytes: &code length: 1];
-	  [self storeCount: len];
+      else if (PLKindDictionary == kinds[i])
+	{
+	  NSUInteger	start = refCount;
+	  NSUInteger	len;
+	  NSUInteger	j;
+
+	  refStart[i] = start;
+	  GS_FOR_IN(id, key, o)
+	    addRef(self, noteObject(self, key));
+	  GS_END_FOR(o)
+	  len = refCount - start;
+	  for (j = 0; j < len; j++)
+	    {
+	      id	v = [o objectForKey: objects[refs[start + j]]];
+
+	      if (nil == v)
+		{
+		  [NSException raise: NSGenericException
+			      format: @"Dictionary changed while being written"];
+		}
+	      addRef(self, noteObject(self, v));
+	    }
 	}
+    }
 
-      offset = [dest length];
-      [dest setLength: offset + sizeof(unichar)*len];
-      buffer = [dest mutableBytes] + offset;
-      [string getCharacters: buffer];
+  if (count <= 256)
+    index_size = 1;
+  else if (count <= 256 * 256)
+    index_size = 2;
+  else if (count <= 256 * 256 * 256)
+    index_size = 3;
+  else
+    index_size = 4;
+}
+
+- (void) storeData: (NSData*) data
+{
+  NSUInteger	len = [data length];
+
+  writeMarker(self, 0x40, len);
+  writeBytes(self, [data bytes], len);
+}
+
+- (void) storeString: (NSString*) string
+{
+  NSUInteger	len = [string length];
+  unichar	chars[256];
+  unichar	*u = chars;
+  NSUInteger	i;
+
+  if (len > sizeof(chars) / sizeof(unichar))
+    {
+      u = NSZoneMalloc(0, len * sizeof(unichar));
+    }
+  [string getCharacters: u];
+  for (i = 0; i < len; i++)
+    {
+      if (u[i] > 127)
+	{
+	  break;
+	}
+    }
+  if (i == len)
+    {
+      uint8_t	*b = (uint8_t*)u;
 
+      /* Narrow the characters in place ... safe since we never
+       * overwrite a character we have not yet read.
+       */
+      for (i = 0; i < len; i++)
+	{
+	  b[i] = (uint8_t)u[i];
+	}
+      writeMarker(self, 0x50, len);
+      writeBytes(self, b, len);
+    }
+  else
+    {
 #if     !GS_WORDS_BIGENDIAN
       /* Always store in big-endian, so if machine is little-endian,
        * perform byte-swapping.
        */
-      {
-        uint8_t *o = (uint8_t*)buffer;
-	int     i;
-
-	for (i = 0; i < len; i++)
-	  {
-	    uint8_t c = *o++;
-
-	    o[-1] = *o;
-            *o++ = c;
-	  }
-      }
+      for (i = 0; i < len; i++)
+	{
+	  u[i] = (u[i] << 8) | (u[i] >> 8);
+	}
 #endif
+      writeMarker(self, 0x60, len);
+      writeBytes(self, u, len * sizeof(unichar));
+    }
+  if (u != chars)
+    {
+      NSZoneFree(0, u);
     }
 }
 
 - (void) storeNumber: (NSNumber*) number
 {
   const char *type;
-  unsigned char code;
 
   type = [number objCType];
 
@@ -4087,68 +4794,34 @@ isEqualFunc(const void *item1, const void *item2,
 	  // FIXME: We need a better way to determine boolean values!
 	  if ((val == 0) && ((*type == 'c') || (*type == 'C')))
 	    {
-	      code = 0x08;
-	      [dest appendBytes: &code length: 1];
+	      writeByte(self, 0x08);
 	    }
 	  else if ((val == 1) && ((*type == 'c') || (*type == 'C')))
 	    {
-	      code = 0x09;
-	      [dest appendBytes: &code length: 1];
-	    }
-	  else if (val < 256)
-	    {
-	      unsigned char cval;
-
-	      code = 0x10;
-	      [dest appendBytes: &code length: 1];
-	      cval = (unsigned char) val;
-	      [dest appendBytes: &cval length: 1];
-	    }
-	  else if (val < 256 * 256)
-	    {
-	      unsigned short sval;
-
-	      code = 0x11;
-	      [dest appendBytes: &code length: 1];
-	      sval = NSSwapHostShortToBig([number unsignedShortValue]);
-	      [dest appendBytes: &sval length: 2];
-	    }
-	  else if (val <= UINT_MAX)
-	    {
-	      unsigned int ival;
-
-	      code = 0x12;
-	      [dest appendBytes: &code length: 1];
-	      ival = NSSwapHostIntToBig([number unsignedIntValue]);
-	      [dest appendBytes: &ival length: 4];
+	      writeByte(self, 0x09);
 	    }
 	  else
 	    {
-	      unsigned long long lval;
-
-	      code = 0x13;
-	      [dest appendBytes: &code length: 1];
-	      lval = NSSwapHostLongLongToBig([number unsignedLongLongValue]);
-	      [dest appendBytes: &lval length: 8];
+	      writeCount(self, val);
 	    }
 	  break;
 	}
       case 'f':
         {
-	  NSSwappedFloat val = NSSwapHostFloatToBig([number floatValue]);
+	  union { float f; uint32_t u; } v;
 
-	  code = 0x22;
-	  [dest appendBytes: &code length: 1];
-	  [dest appendBytes: &val length: sizeof(float)];
+	  v.f = [number floatValue];
+	  writeByte(self, 0x22);
+	  writeBE(self, v.u, 4);
 	  break;
 	}
       case 'd':
         {
-	  NSSwappedDouble val = NSSwapHostDoubleToBig([number doubleValue]);
+	  union { double d; uint64_t u; } v;
 
-	  code = 0x23;
-	  [dest appendBytes: &code length: 1];
-	  [dest appendBytes: &val length: sizeof(double)];
+	  v.d = [number doubleValue];
+	  writeByte(self, 0x23);
+	  writeBE(self, v.u, 8);
 	  break;
 	}
       default:
@@ -4159,189 +4832,137 @@ isEqualFunc(const void *item1, const void *item2,
 
 - (void) storeDate: (NSDate*) date
 {
-  unsigned char code;
-  NSSwappedDouble out;
+  union { double d; uint64_t u; } v;
 
-  code = 0x33;
-  [dest appendBytes: &code length: 1];
-  out = NSSwapHostDoubleToBig([date timeIntervalSinceReferenceDate]);
-  [dest appendBytes: &out length: sizeof(double)];
+  v.d = [date timeIntervalSinceReferenceDate];
+  writeByte(self, 0x33);
+  writeBE(self, v.u, 8);
 }
 
-- (void) storeArray: (NSArray*) array
+- (void) storeUID: (NSDictionary*) dict
 {
-  unsigned char code;
-  unsigned int len;
-  unsigned int i;
+  unsigned int index;
 
-  len = [array count];
-
-  if (len < 0x0F)
+  index = [[dict objectForKey: @"CF$UID"] intValue];
+  if (index < 256)
     {
-      code = 0xA0 + len;
-      [dest appendBytes: &code length: 1];
+      writeByte(self, 0x80);
+      writeBE(self, index, 1);
     }
   else
     {
-      code = 0xAF;
-      [dest appendBytes: &code length: 1];
-      [self storeCount: len];
+      writeByte(self, 0x81);
+      writeBE(self, index, 2);
     }
+}
+
+/* Write the references to the objects contained in a collection.
+ */
+- (void) storeRefs: (NSUInteger)start count: (NSUInteger)len
+{
+  NSUInteger	i;
 
   for (i = 0; i < len; i++)
     {
-      id obj;
-      NSInteger oid;
-
-      obj = [array objectAtIndex: i];
-      oid = [self indexForObject: obj];
-      [self storeIndex: oid];
+      writeBE(self, refs[start + i], index_size);
     }
 }
 
-- (void) storeDictionary: (NSDictionary*) dict
+/* Second pass: write each object in index order, recording its offset,
+ * followed by the offset table and the trailer.
+ */
+- (void) writeObjects
 {
-  unsigned char code;
-  NSNumber *num;
-  unsigned int i;
+  unsigned long long	*table;
+  unsigned char		meta[32];
+  NSUInteger		i;
 
-  num = [dict objectForKey: @"CF$UID"];
-  if (num != nil)
+  table = NSZoneMalloc(0, count * sizeof(unsigned long long));
+  NS_DURING
     {
-      // Special dictionary from keyed encoding
-      unsigned int index;
-
-      index = [num intValue];
-      if (index < 256)
-        {
-	  unsigned char ci;
-
-	  code = 0x80;
-	  [dest appendBytes: &code length: 1];
-	  ci = (unsigned char)index;
-	  [dest appendBytes: &ci length: 1];
-	}
-      else
-        {
-	  unsigned short si;
-
-	  code = 0x81;
-	  [dest appendBytes: &code length: 1];
-	  si = NSSwapHostShortToBig((unsigned short)index);
-	  [dest appendBytes: &si length: 2];
-	}
-    }
-  else
-    {
-      unsigned int len = [dict count];
-      NSArray *keys = [dict allKeys];
-      NSMutableArray *objects = [NSMutableArray arrayWithCapacity: len];
-      id key;
+      writeBytes(self, "bplist00", 8);
+      for (i = 0; i < count; i++)
+	{
+	  id		o = objects[i];
+	  NSUInteger	len;
 
-      for (i = 0; i < len; i++)
-        {
-	  key = [keys objectAtIndex: i];
-	  [objects addObject: [dict objectForKey: key]];
+	  table[i] = written;
+	  switch (kinds[i])
+	    {
+	      case PLKindString:
+		[self storeString: o];
+		break;
+	      case PLKindData:
+		[self storeData: o];
+		break;
+	      case PLKindNumber:
+		[self storeNumber: o];
+		break;
+	      case PLKindDate:
+		[self storeDate: o];
+		break;
+	      case PLKindUID:
+		[self storeUID: o];
+		break;
+	      case PLKindArray:
+		len = [o count];
+		writeMarker(self, 0xA0, len);
+		[self storeRefs: refStart[i] count: len];
+		break;
+	      case PLKindDictionary:
+		len = [o count];
+		writeMarker(self, 0xD0, len);
+		[self storeRefs: refStart[i] count: 2 * len];
+		break;
+	      default:
+		NSLog(@"Unknown object class %@", o);
+		break;
+	    }
 	}
 
-      if (len < 0x0F)
-        {
-	  code = 0xD0 + len;
-	  [dest appendBytes: &code length: 1];
-	}
+      table_start = written;
+      if (table_start < 256)
+	offset_size = 1;
+      else if (table_start < 256 * 256)
+	offset_size = 2;
+      else if (table_start < 256 * 256 * 256)
+	offset_size = 3;
+      else if (table_start <= 0xffffffff)
+	offset_size = 4;
       else
-        {
-	  code = 0xDF;
-	  [dest appendBytes: &code length: 1];
-	  [self storeCount: len];
-	}
-
-      for (i = 0; i < len; i++)
-        {
-	  id obj;
-	  NSInteger oid;
-
-	  obj = [keys objectAtIndex: i];
-	  oid = [self indexForObject: obj];
-	  [self storeIndex: oid];
-	}
-
-      for (i = 0; i < len; i++)
-        {
-	  id obj;
-	  NSInteger oid;
-
-	  obj = [objects objectAtIndex: i];
-	  oid = [self indexForObject: obj];
-	  [self storeIndex: oid];
+	offset_size = 8;
+      for (i = 0; i < count; i++)
+	{
+	  writeBE(self, table[i], offset_size);
 	}
     }
-}
-
-- (BOOL) storeObject: (id)object
-{
-  if (NO == [self markOffset: [dest length] for: object])
+  NS_HANDLER
     {
-      return NO;
+      NSZoneFree(0, table);
+      [localException raise];
     }
+  NS_ENDHANDLER
+  NSZoneFree(0, table);
 
-  if ([object isKindOfClass: NSStringClass])
-    {
-      [self storeString: object];
-    }
-  else if ([object isKindOfClass: NSDataClass])
-    {
-      [self storeData: object];
-    }
-  else if ([object isKindOfClass: NSNumberClass])
-    {
-      [self storeNumber: object];
-    }
-  else if ([object isKindOfClass: NSDateClass])
-    {
-      [self storeDate: object];
-    }
-  else if ([object isKindOfClass: NSArrayClass])
-    {
-      [self storeArray: object];
-    }
-  else if ([object isKindOfClass: NSDictionaryClass])
-    {
-      [self storeDictionary: object];
-    }
-  else
+  memset(meta, 0, sizeof(meta));
+  meta[6] = offset_size;
+  meta[7] = index_size;
+  for (i = 0; i < 8; i++)
     {
-      NSLog(@"Unknown object class %@", object);
+      meta[15 - i] = (uint8_t)((unsigned long long)count >> (8 * i));
+      // root index is always 0, no need to write it
+      meta[31 - i] = (uint8_t)(table_start >> (8 * i));
     }
-  return YES;
+  writeBytes(self, meta, sizeof(meta));
+  flushBuffer(self);
 }
 
 - (void) generate
 {
-  BOOL done = NO;
-
-  index_size = 1;
-
-  while (!done && (index_size <= 4))
-    {
-      NS_DURING
-	{
-	  [self setup];
-	  done = [self writeObjects];
-	}
-      NS_HANDLER
-	{
-	}
-      NS_ENDHANDLER
-      if (NO == done)
-        {
-          [self cleanup];
-          index_size += 1;
-        }
-    }
-
-  [self writeObjectTable];
-  [self writeMetaData];
+  [self setup];
+  [self collectObjects];
+  [self writeObjects];
+  [self cleanup];
 }
 
 @end
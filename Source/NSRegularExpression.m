@@ -20,6 +20,9 @@
    */
 
 
+#define	GS_NSRegularExpression_IVARS \
+  void	*pool	/* Idle clones of the expression for matching */
+
 #define	EXPOSE_NSRegularExpression_IVARS	1
 #import "common.h"
 
@@ -53,6 +56,8 @@
 
 #define GSREGEXTYPE URegularExpression
 #import "GSICUString.h"
+#import "GSPrivate.h"
+#import "GSPThread.h"
 #import "Foundation/NSDictionary.h"
 #import "Foundation/NSException.h"
 #import "Foundation/NSRegularExpression.h"
@@ -64,6 +69,10 @@
 #import "Foundation/FoundationErrors.h"
 #import "Foundation/NSError.h"
 
+#define	GSInternal		NSRegularExpressionInternal
+#include	"GSInternal.h"
+GS_PRIVATE_INTERNAL(NSRegularExpression)
+
 typedef struct {
   GSRegexEnumerationCallback	h;	// The handler callback function
   void				*c;	// Context for this enumeration
@@ -207,6 +216,8 @@ blockCallback(
       return self;
     }
   options = opts;
+  GS_CREATE_INTERNAL(NSRegularExpression)
+  internal->pool = newPool();
   return self;
 }
 
@@ -322,6 +333,11 @@ blockCallback(
 
       DESTROY(self);
     }
+  else
+    {
+      GS_CREATE_INTERNAL(NSRegularExpression)
+      internal->pool = newPool();
+    }
   GS_ENDITEMBUF()
   return self;
 }
@@ -450,17 +466,130 @@ static int32_t _workLimit = DEFAULT_WORK_LIMIT;
 
 
 
+/* The largest number of idle clones of the prototype regex which each
+ * NSRegularExpression keeps for reuse.
+ */
+#define MAX_POOLED_CLONES 8
+
+typedef struct {
+  gs_mutex_t		lock;
+  unsigned		count;
+  URegularExpression	*idle[MAX_POOLED_CLONES];
+} GSRegexPool;
+
+static void *
+newPool(void)
+{
+  GSRegexPool	*p;
+
+  p = NSZoneCalloc(NSDefaultMallocZone(), 1, sizeof(GSRegexPool));
+  GS_MUTEX_INIT(p->lock);
+  return p;
+}
+
+static void
+freePool(GSRegexPool *p)
+{
+  if (NULL != p)
+    {
+      while (p->count > 0)
+	{
+	  uregex_close(p->idle[--p->count]);
+	}
+      GS_MUTEX_DESTROY(p->lock);
+      NSZoneFree(NSDefaultMallocZone(), p);
+    }
+}
+
+/* Returns the pool of clones of an expression (NULL if there is none).
+ */
+static inline GSRegexPool *
+regexPool(NSRegularExpression *re)
+{
+#if	GS_NONFRAGILE
+  return (GSRegexPool*)re->pool;
+#else
+  return (nil == re->_internal) ? NULL : (GSRegexPool*)GSIVar(re, pool);
+#endif
+}
+
+/* Takes an idle clone of the prototype from the pool of the expression,
+ * or makes a new clone if there is none.
+ */
+static URegularExpression *
+takeRegex(NSRegularExpression *re)
+{
+  GSRegexPool		*p = regexPool(re);
+  URegularExpression	*r = NULL;
+  UErrorCode		s = 0;
+
+  if (NULL != p)
+    {
+      GS_MUTEX_LOCK(p->lock);
+      if (p->count > 0)
+	{
+	  r = p->idle[--p->count];
+	}
+      GS_MUTEX_UNLOCK(p->lock);
+    }
+  if (NULL == r)
+    {
+      r = uregex_clone(re->regex, &s);
+      if (U_FAILURE(s))
+	{
+	  return NULL;
+	}
+    }
+  return r;
+}
+
+/* Puts a clone back in the pool once matching is done.  The settings made
+ * by setupRegex() are reset first, so that the pooled clone does not refer
+ * to the subject text or to the context of the caller.
+ */
+static void
+releaseRegex(NSRegularExpression *re, URegularExpression *r)
+{
+  static const UChar	empty = 0;
+  GSRegexPool		*p = regexPool(re);
+  UErrorCode		s = 0;
+
+  if (NULL == r)
+    {
+      return;
+    }
+  uregex_setMatchCallback(r, NULL, NULL, &s);
+  uregex_useAnchoringBounds(r, TRUE, &s);
+  uregex_useTransparentBounds(r, FALSE, &s);
+  uregex_setText(r, &empty, 0, &s);
+  if (NULL != p && U_SUCCESS(s))
+    {
+      GS_MUTEX_LOCK(p->lock);
+      if (p->count < MAX_POOLED_CLONES)
+	{
+	  p->idle[p->count++] = r;
+	  r = NULL;
+	}
+      GS_MUTEX_UNLOCK(p->lock);
+    }
+  if (NULL != r)
+    {
+      uregex_close(r);
+    }
+}
+
 /**
  * Sets up a libicu regex object for use.  Note: the documentation states that
  * NSRegularExpression must be thread safe.  To accomplish this, we store a
- * prototype URegularExpression in the object, and then clone it in each
- * method.  This is required because URegularExpression, unlike
+ * prototype URegularExpression in the object, and each method uses a
+ * clone of it (taken from a pool so that repeated calls do not pay for
+ * cloning).  This is required because URegularExpression, unlike
  * NSRegularExpression, is stateful, and sharing this state between threads
  * would break concurrent calls.
  */
 #if HAVE_UREGEX_OPENUTEXT
 static URegularExpression *
-setupRegex(URegularExpression *regex,
+setupRegex(NSRegularExpression *re,
   NSString *string,
   UText *txt,
   NSMatchingOptions options,
@@ -468,8 +597,12 @@ setupRegex(URegularExpression *regex,
   GSRegexContext *ctx)
 {
   UErrorCode		s = 0;
-  URegularExpression	*r = uregex_clone(regex, &s);
+  URegularExpression	*r = takeRegex(re);
 
+  if (NULL == r)
+    {
+      return NULL;
+    }
   if (options & NSMatchingReportProgress)
     {
       uregex_setMatchCallback(r, callback, ctx, &s);
@@ -495,9 +628,23 @@ setupRegex(URegularExpression *regex,
   return r;
 }
 #else
+/* Returns the UTF-16 storage of the string if it can be matched in place,
+ * so the caller need not copy the characters to a buffer.
+ */
+static const unichar *
+directCharacters(NSString *string, int32_t length)
+{
+  NSUInteger	l = 0;
+  BOOL		wide = NO;
+  const void	*c = GSPrivateStrContents(string, &l, &wide);
+
+  return (NULL != c && YES == wide && l == (NSUInteger)length) ? c : NULL;
+}
+
 static URegularExpression *
-setupRegex(URegularExpression *regex,
+setupRegex(NSRegularExpression *re,
   NSString *string,
+  const unichar *chars,
   unichar *buffer,
   int32_t length,
   NSMatchingOptions options,
@@ -505,15 +652,23 @@ setupRegex(URegularExpression *regex,
   GSRegexContext *ctx)
 {
   UErrorCode		s = 0;
-  URegularExpression	*r = uregex_clone(regex, &s);
+  URegularExpression	*r = takeRegex(re);
 
-  [string getCharacters: buffer range: NSMakeRange(0, length)];
+  if (NULL == r)
+    {
+      return NULL;
+    }
+  if (NULL == chars)
+    {
+      [string getCharacters: buffer range: NSMakeRange(0, length)];
+      chars = buffer;
+    }
   if (options & NSMatchingReportProgress)
     {
       uregex_setMatchCallback(r, callback, ctx, &s);
       if (U_FAILURE(s)) NSLog(@"uregex_setMatchCallback() failed");
     }
-  uregex_setText(r, buffer, length, &s);
+  uregex_setText(r, chars, length, &s);
   uregex_setRegion(r, range.location, range.location+range.length, &s);
   if (options & NSMatchingWithoutAnchoringBounds)
     {
@@ -594,7 +749,7 @@ prepareResult(NSRegularExpression *regex,
   UText		        txt = UTEXT_INITIALIZER;
   BOOL		        stop = NO;
   GSRegexContext	ctx = { handler, context };
-  URegularExpression    *r = setupRegex(regex, string, &txt, opts, range, &ctx);
+  URegularExpression    *r = setupRegex(self, string, &txt, opts, range, &ctx);
   NSUInteger	        groups = [self numberOfCaptureGroups] + 1;
   NSRange	        ranges[groups];
 
@@ -641,7 +796,7 @@ prepareResult(NSRegularExpression *regex,
       (*handler)(context, nil, NSMatchingCompleted, &stop);
     }
   utext_close(&txt);
-  uregex_close(r);
+  releaseRegex(self, r);
 }
 #else
 - (void) enumerateMatchesInString: (NSString*)string
@@ -657,9 +812,10 @@ prepareResult(NSRegularExpression *regex,
   NSUInteger	        groups = [self numberOfCaptureGroups] + 1;
   NSRange	        ranges[groups];
   GSRegexContext	ctx = { handler, context };
-  GS_BEGINITEMBUF(buffer, length, unichar)
+  const unichar		*chars = directCharacters(string, length);
+  GS_BEGINITEMBUF(buffer, (NULL == chars) ? length : 0, unichar)
 
-  r = setupRegex(regex, string, buffer, length, opts, range, &ctx);
+  r = setupRegex(self, string, chars, buffer, length, opts, range, &ctx);
 
   // Should this throw some kind of exception?
   if (r != NULL)
@@ -701,7 +857,7 @@ prepareResult(NSRegularExpression *regex,
 	{
 	  (*handler)(context, nil, NSMatchingCompleted, &stop);
 	}
-      uregex_close(r);
+      releaseRegex(self, r);
     }
   GS_ENDITEMBUF()
 }
@@ -841,7 +997,7 @@ rangeCallback(void *context, NSTextCheckingResult *match,
   UText		txt = UTEXT_INITIALIZER;
   UText		replacement = UTEXT_INITIALIZER;
   GSUTextString	*ret = [GSUTextString new];
-  URegularExpression *r = setupRegex(regex, string, &txt, opts, range, 0);
+  URegularExpression *r = setupRegex(self, string, &txt, opts, range, 0);
   UText		*output = NULL;
 
   UTextInitWithNSString(&replacement, template);
@@ -849,7 +1005,7 @@ rangeCallback(void *context, NSTextCheckingResult *match,
   output = uregex_replaceAllUText(r, &replacement, NULL, &s);
   if (0 != s)
     {
-      uregex_close(r);
+      releaseRegex(self, r);
       utext_close(&replacement);
       utext_close(&txt);
       DESTROY(ret);
@@ -858,7 +1014,7 @@ rangeCallback(void *context, NSTextCheckingResult *match,
   utext_clone(&ret->txt, output, TRUE, TRUE, &s);
   [string setString: ret];
   RELEASE(ret);
-  uregex_close(r);
+  releaseRegex(self, r);
 
   utext_close(&txt);
   utext_close(output);
@@ -876,21 +1032,21 @@ rangeCallback(void *context, NSTextCheckingResult *match,
   UText		replacement = UTEXT_INITIALIZER;
   UText		*output = NULL;
   GSUTextString	*ret = [GSUTextString new];
-  URegularExpression *r = setupRegex(regex, string, &txt, opts, range, 0);
+  URegularExpression *r = setupRegex(self, string, &txt, opts, range, 0);
 
   UTextInitWithNSString(&replacement, template);
 
   output = uregex_replaceAllUText(r, &replacement, NULL, &s);
   if (0 != s)
     {
-      uregex_close(r);
+      releaseRegex(self, r);
       utext_close(&replacement);
       utext_close(&txt);
       DESTROY(ret);
       return nil;
     }
   utext_clone(&ret->txt, output, TRUE, TRUE, &s);
-  uregex_close(r);
+  releaseRegex(self, r);
 
   utext_close(&txt);
   utext_close(output);
@@ -909,7 +1065,7 @@ rangeCallback(void *context, NSTextCheckingResult *match,
   UText		*output = NULL;
   GSUTextString	*ret = [GSUTextString new];
   NSRange	range = [result range];
-  URegularExpression *r = setupRegex(regex,
+  URegularExpression *r = setupRegex(self,
 				     [string substringWithRange: range],
 				     &txt,
 				     0,
@@ -921,7 +1077,7 @@ rangeCallback(void *context, NSTextCheckingResult *match,
   output = uregex_replaceFirstUText(r, &replacement, NULL, &s);
   if (0 != s)
     {
-      uregex_close(r);
+      releaseRegex(self, r);
       utext_close(&replacement);
       utext_close(&txt);
       DESTROY(ret);
@@ -929,7 +1085,7 @@ rangeCallback(void *context, NSTextCheckingResult *match,
     }
   utext_clone(&ret->txt, output, TRUE, TRUE, &s);
   utext_close(output);
-  uregex_close(r);
+  releaseRegex(self, r);
   utext_close(&txt);
   utext_close(&replacement);
   return AUTORELEASE(ret);
@@ -953,9 +1109,10 @@ rangeCallback(void *context, NSTextCheckingResult *match,
       unichar		replacement[replLength];
       int32_t		outLength;
       URegularExpression *r;
-      GS_BEGINITEMBUF(buffer, length, unichar)
+      const unichar	*chars = directCharacters(string, length);
+      GS_BEGINITEMBUF(buffer, (NULL == chars) ? length : 0, unichar)
 
-      r = setupRegex(regex, string, buffer, length, opts, range, 0);
+      r = setupRegex(self, string, chars, buffer, length, opts, range, 0);
       [template getCharacters: replacement range: NSMakeRange(0, replLength)];
 
       outLength = uregex_replaceAll(r, replacement, replLength, NULL, 0, &s);
@@ -988,7 +1145,7 @@ rangeCallback(void *context, NSTextCheckingResult *match,
 	{
 	  results = 0;
 	}
-      uregex_close(r);
+      releaseRegex(self, r);
       GS_ENDITEMBUF()
     }
   return results;
@@ -1006,9 +1163,10 @@ rangeCallback(void *context, NSTextCheckingResult *match,
   unichar	replacement[replLength];
   int32_t	outLength;
   NSString	*result = nil;
-  GS_BEGINITEMBUF(buffer, length, unichar)
+  const unichar	*chars = directCharacters(string, length);
+  GS_BEGINITEMBUF(buffer, (NULL == chars) ? length : 0, unichar)
 
-  r = setupRegex(regex, string, buffer, length, opts, range, 0);
+  r = setupRegex(self, string, chars, buffer, length, opts, range, 0);
   [template getCharacters: replacement range: NSMakeRange(0, replLength)];
 
   outLength = uregex_replaceAll(r, replacement, replLength, NULL, 0, &s);
@@ -1033,7 +1191,7 @@ rangeCallback(void *context, NSTextCheckingResult *match,
 	}
     }
 
-  uregex_close(r);
+  releaseRegex(self, r);
   GS_ENDITEMBUF()
   return result;
 }
@@ -1050,10 +1208,13 @@ rangeCallback(void *context, NSTextCheckingResult *match,
   unichar	replacement[replLength];
   int32_t	outLength;
   NSString	*str = nil;
-  GS_BEGINITEMBUF(buffer, range.length, unichar)
+  NSString	*sub = [string substringWithRange: range];
+  const unichar	*chars = directCharacters(sub, range.length);
+  GS_BEGINITEMBUF(buffer, (NULL == chars) ? range.length : 0, unichar)
 
-  r = setupRegex(regex,
-		 [string substringWithRange: range],
+  r = setupRegex(self,
+		 sub,
+		 chars,
 		 buffer,
 		 range.length,
 		 0,
@@ -1082,7 +1243,7 @@ rangeCallback(void *context, NSTextCheckingResult *match,
 	  NSZoneFree(0, output);
 	}
     }
-  uregex_close(r);
+  releaseRegex(self, r);
   GS_ENDITEMBUF()
   return str;
 }
@@ -1117,6 +1278,11 @@ rangeCallback(void *context, NSTextCheckingResult *match,
 
 - (void) dealloc
 {
+  if (GS_EXISTS_INTERNAL)
+    {
+      freePool((GSRegexPool*)internal->pool);
+      GS_DESTROY_INTERNAL(NSRegularExpression)
+    }
   uregex_close(regex);
   [super dealloc];
 }
@@ -1172,6 +1338,8 @@ rangeCallback(void *context, NSTextCheckingResult *match,
     }
   options = opts;
   regex = r;
+  GS_CREATE_INTERNAL(NSRegularExpression)
+  internal->pool = newPool();
   return self;
 }
 @end
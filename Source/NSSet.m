@@ -38,6 +38,9 @@
 #import "Foundation/NSKeyedArchiver.h"
 #import "GSPrivate.h"
 #import "GSDispatch.h"
+#if defined(__OBJC2__)
+#import "NSKeyValueCoding+Caching.h"
+#endif
 
 @class	GSSet;
 @interface GSSet : NSObject	// Help the compiler
@@ -647,9 +650,28 @@ static Class NSMutableSet_concrete_class;
 
 - (id) valueForKey: (NSString*)key
 {
+  NSMutableSet *results = [NSMutableSet setWithCapacity: [self count]];
+#if defined(__OBJC2__)
+  NSUInteger count = [self count];
+
+  if (count > 0)
+    {
+      NSUInteger i;
+      GS_BEGINIDBUF(values, count);
+
+      count = valuesForKeyWithCaching(self, key, values);
+      for (i = 0; i < count; i++)
+        {
+          if (values[i] != nil)
+            {
+              [results addObject: values[i]];
+            }
+        }
+      GS_ENDIDBUF();
+    }
+#else
   NSEnumerator *e = [self objectEnumerator];
   id object = nil;
-  NSMutableSet *results = [NSMutableSet setWithCapacity: [self count]];
 
   while ((object = [e nextObject]) != nil)
     {
@@ -660,6 +682,7 @@ static Class NSMutableSet_concrete_class;
 
       [results addObject: result];
     }
+#endif
   return results;
 }
 
@@ -695,6 +718,9 @@ static Class NSMutableSet_concrete_class;
             }
           else if ([op isEqualToString: @"@avg"] == YES)
             {
+#if defined(__OBJC2__)
+              result = aggregateForKeyWithCaching(self, rem, GSKVCAvg);
+#else
               double        d = 0;
 
               if (count > 0)
@@ -709,9 +735,13 @@ static Class NSMutableSet_concrete_class;
                   d /= count;
                 }
               result = [NSNumber numberWithDouble: d];
+#endif
             }
           else if ([op isEqualToString: @"@max"] == YES)
             {
+#if defined(__OBJC2__)
+              result = aggregateForKeyWithCaching(self, rem, GSKVCMax);
+#else
               if (count > 0)
                 {
                   NSEnumerator  *e = [self objectEnumerator];
@@ -727,9 +757,13 @@ static Class NSMutableSet_concrete_class;
                         }
                     }
                 }
+#endif
             }
           else if ([op isEqualToString: @"@min"] == YES)
             {
+#if defined(__OBJC2__)
+              result = aggregateForKeyWithCaching(self, rem, GSKVCMin);
+#else
               if (count > 0)
                 {
                   NSEnumerator  *e = [self objectEnumerator];
@@ -745,9 +779,13 @@ static Class NSMutableSet_concrete_class;
                         }
                     }
                 }
+#endif
             }
           else if ([op isEqualToString: @"@sum"] == YES)
             {
+#if defined(__OBJC2__)
+              result = aggregateForKeyWithCaching(self, rem, GSKVCSum);
+#else
               double        d = 0;
 
               if (count > 0)
@@ -761,6 +799,7 @@ static Class NSMutableSet_concrete_class;
                     }
                 }
               result = [NSNumber numberWithDouble: d];
+#endif
             }
           else if ([op isEqualToString: @"@distinctUnionOfArrays"] == YES)
             {
@@ -1255,6 +1255,18 @@ static Class	runLoopClass;
               {
                 NSDictionary	*opts = [p clientOptionsForTLS];
                 DESTROY(session);
+                if (opts && nil == [opts objectForKey: GSTLSSessionCacheKey])
+                  {
+                    NSMutableDictionary	*d = AUTORELEASE([opts mutableCopy]);
+
+                    /* Let us resume an earlier session with the same port.
+                     */
+                    [d setObject: [NSString stringWithFormat: @"%@:%d",
+                      GSPrivateSockaddrHost(&sockAddr),
+                      (int)GSPrivateSockaddrPort(&sockAddr)]
+                          forKey: GSTLSSessionCacheKey];
+                    opts = d;
+                  }
                 if (opts)
                   {
                     session = [[GSTLSSession alloc] initWithOptions: opts
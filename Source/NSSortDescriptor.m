@@ -27,10 +27,13 @@
 #import "Foundation/NSSortDescriptor.h"
 
 #import "Foundation/NSCoder.h"
+#import "Foundation/NSDate.h"
+#import "Foundation/NSDecimalNumber.h"
 #import "Foundation/NSException.h"
 #import "Foundation/NSKeyValueCoding.h"
 #import "Foundation/NSNotification.h"
 #import "Foundation/NSUserDefaults.h"
+#import "Foundation/NSValue.h"
 
 #import "GNUstepBase/GSObjCRuntime.h"
 #import "GSPrivate.h"
@@ -488,6 +491,292 @@ SortRange(id *objects, NSRange range, id *descriptors,
     }
 }
 
+/* Sorting with descriptors extracts the key value of each object for
+ * each descriptor once, before sorting, rather than using -valueForKeyPath:
+ * twice in every comparison.  The objects are then sorted as records of
+ * their key values, and where all the values for a descriptor are numbers
+ * or dates compared with -compare: those are compared as scalars.
+ */
+typedef enum {
+  GSSortKeyGeneric,	// Use the selector or comparator of the descriptor
+  GSSortKeyString,	// Strings compared with -compare:
+  GSSortKeyInteger,	// Numbers compared as 64 bit integers
+  GSSortKeyDouble	// Numbers or dates compared as doubles
+} GSSortKeyType;
+
+typedef struct {
+  id		obj;
+  union {
+    int64_t	i;
+    double	d;
+  } v;
+} GSSortKey;
+
+typedef struct {
+  NSSortDescriptor	**descriptors;
+  GSSortKeyType		*types;
+  NSUInteger		numDescriptors;
+} GSSortContext;
+
+/* Decide how values for one descriptor may be compared and, for scalar
+ * comparison, store the scalar value of each.
+ */
+static GSSortKeyType
+SortKeyType(NSSortDescriptor *sd, GSSortKey *keys, NSUInteger count,
+  NSUInteger stride)
+{
+  static Class	numberClass = Nil;
+  static Class	decimalClass = Nil;
+  static Class	dateClass = Nil;
+  static Class	stringClass = Nil;
+  BOOL		numbers = YES;
+  BOOL		dates = YES;
+  BOOL		strings = YES;
+  BOOL		integers = YES;
+  BOOL		doubles = YES;
+  NSUInteger	i;
+
+  if (sd->_comparator != NULL || !sel_isEqual(sd->_selector, @selector(compare:)))
+    {
+      return GSSortKeyGeneric;
+    }
+  if (Nil == numberClass)
+    {
+      decimalClass = [NSDecimalNumber class];
+      dateClass = [NSDate class];
+      stringClass = [NSString class];
+      numberClass = [NSNumber class];
+    }
+  for (i = 0; i < count && (numbers || dates || strings); i++)
+    {
+      id	o = keys[i * stride].obj;
+
+      if (nil == o)
+	{
+	  return GSSortKeyGeneric;
+	}
+      if (strings && NO == [o isKindOfClass: stringClass])
+	{
+	  strings = NO;
+	}
+      if (dates && NO == [o isKindOfClass: dateClass])
+	{
+	  dates = NO;
+	}
+      if (numbers && (NO == [o isKindOfClass: numberClass]
+	|| [o isKindOfClass: decimalClass]))
+	{
+	  numbers = NO;
+	}
+      if (numbers)
+	{
+	  switch (*[o objCType])
+	    {
+	      case 'f':
+	      case 'd':
+		integers = NO;
+		break;
+	      case 'L':
+	      case 'Q':
+		if ([o unsignedLongLongValue] > (unsigned long long)INT64_MAX)
+		  {
+		    numbers = NO;
+		  }
+		doubles = NO;
+		break;
+	      default:
+		doubles = NO;
+		break;
+	    }
+	  if (NO == integers && NO == doubles)
+	    {
+	      /* Mixed integers and floating point values; leave any
+	       * question of precision to NSNumber.
+	       */
+	      numbers = NO;
+	    }
+	}
+    }
+  if (strings)
+    {
+      return GSSortKeyString;
+    }
+  if (dates)
+    {
+      for (i = 0; i < count; i++)
+	{
+	  keys[i * stride].v.d
+	    = [keys[i * stride].obj timeIntervalSinceReferenceDate];
+	}
+      return GSSortKeyDouble;
+    }
+  if (numbers && integers)
+    {
+      for (i = 0; i < count; i++)
+	{
+	  keys[i * stride].v.i = [keys[i * stride].obj longLongValue];
+	}
+      return GSSortKeyInteger;
+    }
+  if (numbers)
+    {
+      for (i = 0; i < count; i++)
+	{
+	  double	d = [keys[i * stride].obj doubleValue];
+
+	  if (d != d)
+	    {
+	      return GSSortKeyGeneric;	// NaN
+	    }
+	  keys[i * stride].v.d = d;
+	}
+      return GSSortKeyDouble;
+    }
+  return GSSortKeyGeneric;
+}
+
+static NSInteger
+CompareSortKeys(id r1, id r2, void *context)
+{
+  GSSortContext	*ctx = (GSSortContext*)context;
+  GSSortKey	*k1 = (GSSortKey*)r1;
+  GSSortKey	*k2 = (GSSortKey*)r2;
+  NSUInteger	i;
+
+  /* The first key of each record holds the object itself.
+   */
+  for (i = 1; i <= ctx->numDescriptors; i++)
+    {
+      NSSortDescriptor		*sd = ctx->descriptors[i - 1];
+      NSComparisonResult	result;
+
+      switch (ctx->types[i - 1])
+	{
+	  case GSSortKeyString:
+	    result = [k1[i].obj compare: k2[i].obj];
+	    break;
+	  case GSSortKeyInteger:
+	    result = (k1[i].v.i < k2[i].v.i) ? NSOrderedAscending
+	      : ((k1[i].v.i > k2[i].v.i) ? NSOrderedDescending : NSOrderedSame);
+	    break;
+	  case GSSortKeyDouble:
+	    result = (k1[i].v.d < k2[i].v.d) ? NSOrderedAscending
+	      : ((k1[i].v.d > k2[i].v.d) ? NSOrderedDescending : NSOrderedSame);
+	    break;
+	  default:
+	    if (sd->_comparator == NULL)
+	      {
+		result = (NSComparisonResult)[k1[i].obj
+		  performSelector: sd->_selector withObject: k2[i].obj];
+	      }
+	    else
+	      {
+		result = CALL_NON_NULL_BLOCK(((NSComparator)sd->_comparator),
+		  k1[i].obj, k2[i].obj);
+	      }
+	    break;
+	}
+      if (result != NSOrderedSame)
+	{
+	  if (NO == sd->_ascending)
+	    {
+	      result = (result == NSOrderedAscending)
+		? NSOrderedDescending : NSOrderedAscending;
+	    }
+	  return result;
+	}
+    }
+  /* Records are laid out in the original order of the objects, so
+   * comparing their addresses keeps equal objects in that order whatever
+   * sorting algorithm is in use.
+   */
+  return (k1 < k2) ? NSOrderedAscending
+    : ((k1 > k2) ? NSOrderedDescending : NSOrderedSame);
+}
+
+static void
+SortObjects(id *objects, NSUInteger count, id *descriptors,
+  NSUInteger numDescriptors)
+{
+  NSUInteger	stride = numDescriptors + 1;
+  GSSortKey	*keys;
+  id		*records;
+  GSSortKeyType	types[numDescriptors];
+  GSSortContext	ctx;
+  NSUInteger	i;
+  NSUInteger	j;
+
+  /* A subclass which changes the way objects are compared must be used
+   * through its -compareObject:toObject: method.
+   */
+  for (j = 0; j < numDescriptors; j++)
+    {
+      static IMP	compareIMP = 0;
+      id		sd = descriptors[j];
+
+      if (0 == compareIMP)
+	{
+	  compareIMP = [NSSortDescriptor instanceMethodForSelector:
+	    @selector(compareObject:toObject:)];
+	}
+      if (NO == [sd isKindOfClass: [NSSortDescriptor class]]
+	|| [sd methodForSelector: @selector(compareObject:toObject:)]
+	!= compareIMP)
+	{
+	  SortRange(objects, NSMakeRange(0, count), descriptors,
+	    numDescriptors);
+	  return;
+	}
+    }
+
+  keys = malloc(sizeof(GSSortKey) * stride * count);
+  records = malloc(sizeof(id) * count);
+  if (NULL == keys || NULL == records)
+    {
+      free(keys);
+      free(records);
+      [NSException raise: NSMallocException
+		  format: @"Unable to allocate memory to sort"];
+    }
+  NS_DURING
+    {
+      for (i = 0; i < count; i++)
+	{
+	  GSSortKey	*k = keys + i * stride;
+
+	  k[0].obj = objects[i];
+	  for (j = 0; j < numDescriptors; j++)
+	    {
+	      k[j + 1].obj = [objects[i] valueForKeyPath:
+		((NSSortDescriptor*)descriptors[j])->_key];
+	    }
+	  records[i] = (id)k;
+	}
+      for (j = 0; j < numDescriptors; j++)
+	{
+	  types[j] = SortKeyType(descriptors[j], keys + j + 1, count, stride);
+	}
+      ctx.descriptors = (NSSortDescriptor**)descriptors;
+      ctx.types = types;
+      ctx.numDescriptors = numDescriptors;
+      GSSortUnstable(records, NSMakeRange(0, count), (id)CompareSortKeys,
+	GSComparisonTypeFunction, &ctx);
+      for (i = 0; i < count; i++)
+	{
+	  objects[i] = ((GSSortKey*)records[i])[0].obj;
+	}
+    }
+  NS_HANDLER
+    {
+      free(keys);
+      free(records);
+      [localException raise];
+    }
+  NS_ENDHANDLER
+  free(keys);
+  free(records);
+}
+
 @implementation NSMutableArray (NSSortDescriptorSorting)
 
 - (void) sortUsingDescriptors: (NSArray *)sortDescriptors
@@ -515,7 +804,7 @@ SortRange(id *objects, NSRange range, id *descriptors,
 	{
 	  [sortDescriptors getObjects: descriptors];
 	}
-      SortRange(objects, NSMakeRange(0, count), descriptors, numDescriptors);
+      SortObjects(objects, count, descriptors, numDescriptors);
       a = [[NSArray alloc] initWithObjects: objects count: count];
       [self setArray: a];
       RELEASE(a);
@@ -548,7 +837,11 @@ SortRange(id *objects, NSRange range, id *descriptors,
 	{
 	  [sortDescriptors getObjects: descriptors];
 	}
-      SortRange(_contents_array, NSMakeRange(0, _count), descriptors, dCount);
+      if (nil != _shared)
+	{
+	  [self _unshare];
+	}
+      SortObjects(_contents_array, _count, descriptors, dCount);
 
       GS_ENDIDBUF();
     }
@@ -1843,30 +1843,15 @@ register_printf_atsign ()
 {
   unsigned char	buf[2048];
   GSStr		f;
-  unichar	fbuf[1024];
-  unichar	*fmt = fbuf;
-  size_t	len;
 
   if (NULL == format)
     [NSException raise: NSInvalidArgumentException
       format: @"[NSString-initWithFormat:locale:arguments:]: NULL format"];
-  /*
-   * First we provide an array of unichar characters containing the
-   * format string.  For performance reasons we try to use an on-stack
-   * buffer if the format string is small enough ... it almost always
-   * will be.
-   */
-  len = [format length];
-  if (len >= 1024)
-    {
-      fmt = malloc((len+1)*sizeof(unichar));
-    }
-  [format getCharacters: fmt range: ((NSRange){0, len})];
-  fmt[len] = '\0';
 
   /*
-   * Now set up 'f' as a GSMutableString object whose initial buffer is
-   * allocated on the stack.  The GSPrivateFormat function can write into it.
+   * Set up 'f' as a GSMutableString object whose initial buffer is
+   * allocated on the stack.  The GSPrivateFormatString function can
+   * write into it.
    */
   f = (GSStr)alloca(class_getInstanceSize(GSMutableStringClass));
   object_setClass(f, GSMutableStringClass);
@@ -1878,12 +1863,8 @@ register_printf_atsign ()
   f->_flags.owned = 0;
   f->_flags.unused = 0;
   f->_flags.hash = 0;
-  GSPrivateFormat(f, fmt, argList, locale);
+  GSPrivateFormatString(f, format, argList, locale);
   GSPrivateStrExternalize(f);
-  if (fmt != fbuf)
-    {
-      free(fmt);
-    }
 
   /*
    * Don't use noCopy because f->_contents.u may be memory on the stack,
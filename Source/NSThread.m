@@ -2019,6 +2019,32 @@ lockInfoErr(NSString *str)
     }
 }
 
+- (void) wake
+{
+  [lock lock];
+#if defined(_WIN32)
+  if (INVALID_HANDLE_VALUE != event)
+    {
+      if (SetEvent(event) == 0)
+        {
+          NSLog(@"Set event failed - %@", [NSError _last]);
+        }
+    }
+#else
+  /* If the pipe is full the thread already has input pending, so there
+   * is no need to retry a failed write.
+   */
+  if (outputFd >= 0)
+    {
+      if (write(outputFd, "0", 1) != 1)
+        {
+          NSDebugMLLog(@"NSThread", @"Wake of %@ not written", self);
+        }
+    }
+#endif
+  [lock unlock];
+}
+
 - (void) dealloc
 {
   [self invalidate];
@@ -89,6 +89,7 @@
 #define	EXPOSE_NSTimeZone_IVARS	1
 #include <stdio.h>
 #include <time.h>
+#include <float.h>
 #import "Foundation/NSArray.h"
 #import "Foundation/NSCoder.h"
 #import "Foundation/NSData.h"
@@ -3245,3 +3246,71 @@ getTypeInfo(NSTimeInterval since, GSTimeZone *zone)
 
 @end
 
+
+NSInteger
+GSPrivateTimeZoneOffset(NSTimeZone *zone, NSTimeInterval when,
+  NSTimeInterval *from, NSTimeInterval *until)
+{
+  NSTimeInterval	start = when;
+  NSTimeInterval	end = when;
+  NSInteger		offset;
+  Class			c;
+
+  if ([zone isKindOfClass: [NSLocalTimeZone class]])
+    {
+      zone = [NSTimeZoneClass defaultTimeZone];
+    }
+  c = object_getClass(zone);
+  if (c == [GSAbsTimeZone class])
+    {
+      offset = ((GSAbsTimeZone*)zone)->offset;
+      start = -DBL_MAX;
+      end = DBL_MAX;
+    }
+  else if (c == [GSTimeZone class])
+    {
+      struct state	*sp = ((GSTimeZone*)zone)->sp;
+
+      offset = getTypeInfo(when, (GSTimeZone*)zone).offset;
+      /* Between the first and last transitions in the zone data the
+       * offset is constant from one transition to the next, so we can
+       * find the range by a binary search of the transition times.
+       */
+      if (sp != 0 && sp->leapcnt == 0 && sp->timecnt > 1
+	&& when >= sp->ats[0] && when < sp->ats[sp->timecnt - 1])
+	{
+	  int	lo = 0;
+	  int	hi = sp->timecnt - 1;
+
+	  while (hi - lo > 1)
+	    {
+	      int	mid = (lo + hi) / 2;
+
+	      if (when < sp->ats[mid])
+		{
+		  hi = mid;
+		}
+	      else
+		{
+		  lo = mid;
+		}
+	    }
+	  start = sp->ats[lo];
+	  end = sp->ats[hi];
+	}
+    }
+  else
+    {
+      offset = [zone secondsFromGMTForDate:
+	[NSDate dateWithTimeIntervalSince1970: when]];
+    }
+  if (from != NULL)
+    {
+      *from = start;
+    }
+  if (until != NULL)
+    {
+      *until = end;
+    }
+  return offset;
+}
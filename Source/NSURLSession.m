@@ -131,6 +131,8 @@
 #import "Foundation/NSStream.h"
 #import "Foundation/NSThread.h"
 #import "Foundation/NSTimer.h"
+#import "Foundation/NSURL.h"
+#import "Foundation/NSValue.h"
 #import "Foundation/NSUserDefaults.h"
 #import "Foundation/NSBundle.h"
 #import "Foundation/NSData.h"
@@ -175,6 +177,122 @@ nextSessionIdentifier()
   return sessionCounter;
 }
 
+#pragma mark - Shared connection pool
+
+/* One lock for each kind of data libcurl may ask to lock in a share handle.
+ */
+static gs_mutex_t	shareLocks[CURL_LOCK_DATA_LAST];
+
+static void
+share_lock(CURL *handle, curl_lock_data data, curl_lock_access access,
+  void *userptr)
+{
+  GS_MUTEX_LOCK(shareLocks[data]);
+}
+
+static void
+share_unlock(CURL *handle, curl_lock_data data, void *userptr)
+{
+  GS_MUTEX_UNLOCK(shareLocks[data]);
+}
+
+CURLSH *
+GSURLSessionSharedHandle(void)
+{
+  static gs_mutex_t	lock = GS_MUTEX_INIT_STATIC;
+  static CURLSH		*share = NULL;
+
+  GS_MUTEX_LOCK(lock);
+  if (NULL == share)
+    {
+      int	i;
+
+      for (i = 0; i < CURL_LOCK_DATA_LAST; i++)
+	{
+	  GS_MUTEX_INIT(shareLocks[i]);
+	}
+      curl_global_init(CURL_GLOBAL_SSL);
+      share = curl_share_init();
+      curl_share_setopt(share, CURLSHOPT_LOCKFUNC, share_lock);
+      curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+      curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+      curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+  GS_MUTEX_UNLOCK(lock);
+  return share;
+}
+
+/* Per-host transfer statistics for +connectionStatistics, updated as each
+ * transfer completes.  Times are totals over the new connections.
+ */
+typedef struct {
+  NSUInteger	transfers;
+  NSUInteger	connections;
+  double	lookup;
+  double	connect;
+  double	handshake;
+} HostStats;
+
+static gs_mutex_t		statsLock = GS_MUTEX_INIT_STATIC;
+static NSMutableDictionary	*stats = nil;
+
+static void
+recordTransfer(CURL *easy, const char *effectiveURL)
+{
+  NSString	*host;
+  NSMutableData	*d;
+  HostStats	*h;
+  long		connects = 0;
+  double	lookup = 0.0;
+  double	connect = 0.0;
+  double	handshake = 0.0;
+
+  if (NULL == effectiveURL)
+    {
+      return;
+    }
+  host = [[NSURL URLWithString:
+    [NSString stringWithUTF8String: effectiveURL]] host];
+  if (nil == host)
+    {
+      return;
+    }
+  curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &connects);
+  if (connects > 0)
+    {
+      curl_easy_getinfo(easy, CURLINFO_NAMELOOKUP_TIME, &lookup);
+      curl_easy_getinfo(easy, CURLINFO_CONNECT_TIME, &connect);
+      curl_easy_getinfo(easy, CURLINFO_APPCONNECT_TIME, &handshake);
+      /* The times are from the start of the transfer, so take each phase
+       * from the end of the one before.  The handshake time is zero for a
+       * connection without TLS.
+       */
+      handshake = (handshake > connect) ? handshake - connect : 0.0;
+      connect = (connect > lookup) ? connect - lookup : 0.0;
+    }
+
+  GS_MUTEX_LOCK(statsLock);
+  if (nil == stats)
+    {
+      stats = [NSMutableDictionary new];
+    }
+  if (nil == (d = [stats objectForKey: host]))
+    {
+      d = [NSMutableData dataWithLength: sizeof(HostStats)];
+      [stats setObject: d forKey: host];
+    }
+  h = (HostStats*)[d mutableBytes];
+  h->transfers++;
+  if (connects > 0)
+    {
+      h->connections += connects;
+      h->lookup += lookup;
+      h->connect += connect;
+      h->handshake += handshake;
+    }
+  GS_MUTEX_UNLOCK(statsLock);
+}
+
 #pragma mark - libcurl callbacks
 
 /* CURLMOPT_TIMERFUNCTION: Callback to receive timer requests from libcurl */
@@ -416,6 +534,17 @@ static NSURLSession * sharedSession = nil;
         CURLMOPT_MAX_HOST_CONNECTIONS,
         [internal->_configuration HTTPMaximumConnectionsPerHost]);
 
+      /* Multiplex transfers to the same host over one HTTP/2 connection
+       * (the default in newer versions of libcurl) unless configured not to.
+       */
+#if CURL_AT_LEAST_VERSION(7, 43, 0)
+      curl_multi_setopt(
+        internal->_multiHandle,
+        CURLMOPT_PIPELINING,
+        [internal->_configuration HTTPShouldUseMultiplexing]
+          ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+#endif
+
       /* Check if GSCACertificateFilePath is set */
 
       caPath = [[NSUserDefaults standardUserDefaults]
@@ -962,6 +1091,8 @@ static NSURLSession * sharedSession = nil;
             eff_url,
             curl_easy_strerror(res));
 
+          recordTransfer(easyHandle, eff_url);
+
           /* With CURLOPT_FOLLOWLOCATION disabled libcurl reports an
            * intercepted 3xx response as a completed transfer.  When the task
            * is being redirected the easy handle is about to be re-added for
@@ -1273,6 +1404,44 @@ static NSURLSession * sharedSession = nil;
   CALL_BLOCK(completionHandler, [self allTasks]);
 }
 
+#pragma mark - Connection statistics
+
++ (NSDictionary *) connectionStatistics
+{
+  NSMutableDictionary	*result = [NSMutableDictionary dictionary];
+  NSEnumerator		*e;
+  NSString		*host;
+
+  GS_MUTEX_LOCK(statsLock);
+  e = [stats keyEnumerator];
+  while (nil != (host = [e nextObject]))
+    {
+      HostStats	*h = (HostStats*)[[stats objectForKey: host] bytes];
+      double	n = (h->connections > 0) ? (double)h->connections : 1.0;
+      double	reused;
+
+      reused = (h->transfers > h->connections)
+	? (double)(h->transfers - h->connections) / h->transfers : 0.0;
+      [result setObject: [NSDictionary dictionaryWithObjectsAndKeys:
+	[NSNumber numberWithUnsignedInteger: h->transfers], @"Transfers",
+	[NSNumber numberWithUnsignedInteger: h->connections], @"NewConnections",
+	[NSNumber numberWithDouble: reused], @"ReuseRate",
+	[NSNumber numberWithDouble: h->lookup / n], @"NameLookupTime",
+	[NSNumber numberWithDouble: h->connect / n], @"ConnectTime",
+	[NSNumber numberWithDouble: h->handshake / n], @"HandshakeTime",
+	nil] forKey: host];
+    }
+  GS_MUTEX_UNLOCK(statsLock);
+  return result;
+}
+
++ (void) resetConnectionStatistics
+{
+  GS_MUTEX_LOCK(statsLock);
+  [stats removeAllObjects];
+  GS_MUTEX_UNLOCK(statsLock);
+}
+
 #pragma mark - Getter and Setter
 
 - (NSOperationQueue *) delegateQueue
@@ -30,9 +30,56 @@
 #import "Foundation/NSException.h"
 #import "Foundation/NSURLSession.h"
 #import "Foundation/NSHTTPCookie.h"
+#import "Foundation/NSMapTable.h"
+#import "GSPThread.h"
 
 #include <curl/curl.h>
 
+/* The connection pool and multiplexing settings are kept out of the
+ * public instance variable layout.  Only configurations which differ
+ * from the defaults have an entry in this table, holding a mask of the
+ * flags below.
+ */
+#define	SharesPool	1
+#define	NoMultiplex	2
+
+static gs_mutex_t	flagsLock = GS_MUTEX_INIT_STATIC;
+static NSMapTable	*flagsTable = 0;
+
+static NSUInteger
+getFlags(NSURLSessionConfiguration *c)
+{
+  NSUInteger	f;
+
+  GS_MUTEX_LOCK(flagsLock);
+  f = (0 == flagsTable) ? 0 : (NSUInteger)NSMapGet(flagsTable, c);
+  GS_MUTEX_UNLOCK(flagsLock);
+  return f;
+}
+
+static void
+setFlags(NSURLSessionConfiguration *c, NSUInteger f)
+{
+  GS_MUTEX_LOCK(flagsLock);
+  if (0 == f)
+    {
+      if (0 != flagsTable)
+        {
+          NSMapRemove(flagsTable, c);
+        }
+    }
+  else
+    {
+      if (0 == flagsTable)
+        {
+          flagsTable = NSCreateMapTable(NSNonOwnedPointerMapKeyCallBacks,
+            NSIntegerMapValueCallBacks, 0);
+        }
+      NSMapInsert(flagsTable, c, (void*)f);
+    }
+  GS_MUTEX_UNLOCK(flagsLock);
+}
+
 // TODO: This is the old implementation. It requires a rewrite!
 
 @implementation NSURLSessionConfiguration
@@ -88,6 +135,7 @@ static NSURLSessionConfiguration * def = nil;
 
 - (void) dealloc
 {
+  setFlags(self, 0);
   DESTROY(_identifier);
   DESTROY(_HTTPAdditionalHeaders);
   DESTROY(_HTTPCookieStorage);
@@ -179,6 +227,30 @@ static NSURLSessionConfiguration * def = nil;
 #endif
 }
 
+- (BOOL) sharesConnectionPool
+{
+  return (getFlags(self) & SharesPool) ? YES : NO;
+}
+
+- (void) setSharesConnectionPool: (BOOL)flag
+{
+  NSUInteger	f = getFlags(self);
+
+  setFlags(self, flag ? (f | SharesPool) : (f & ~SharesPool));
+}
+
+- (BOOL) HTTPShouldUseMultiplexing
+{
+  return (getFlags(self) & NoMultiplex) ? NO : YES;
+}
+
+- (void) setHTTPShouldUseMultiplexing: (BOOL)flag
+{
+  NSUInteger	f = getFlags(self);
+
+  setFlags(self, flag ? (f & ~NoMultiplex) : (f | NoMultiplex));
+}
+
 - (BOOL) HTTPShouldUsePipelining
 {
   return _HTTPShouldUsePipelining;
@@ -278,6 +350,8 @@ static NSURLSessionConfiguration * def = nil;
       copy->_URLCredentialStorage = [_URLCredentialStorage copy];
       copy->_protocolClasses = [_protocolClasses copyWithZone: zone];
       copy->_HTTPMaximumConnectionsPerHost = _HTTPMaximumConnectionsPerHost;
+      copy->_HTTPMaximumConnectionLifetime = _HTTPMaximumConnectionLifetime;
+      setFlags(copy, getFlags(self));
       copy->_HTTPShouldUsePipelining = _HTTPShouldUsePipelining;
       copy->_HTTPCookieAcceptPolicy = _HTTPCookieAcceptPolicy;
       copy->_HTTPCookieStorage = [_HTTPCookieStorage retain];
@@ -39,6 +39,13 @@
 
 @class NSInvocation;
 
+/* Return the process-wide libcurl share handle holding the DNS cache and
+ * the TLS session cache used by sessions whose configuration shares the
+ * connection pool.  Created on first use and never destroyed.
+ */
+extern CURLSH *
+GSURLSessionSharedHandle(void);
+
 extern NSString * GS_NSURLSESSION_DEBUG_KEY;
 
 /* Return an invocation for aSelector on target, with the target and the
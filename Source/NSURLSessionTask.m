@@ -838,40 +838,78 @@ read_callback(char *buffer, size_t size, size_t nitems, void *userdata)
   return bytesWritten;
 } /* read_callback */
 
-/* CURLOPT_WRITEFUNCTION: callback for writing received data from easy handle */
+/* The largest body we presize the in-memory buffer for on the strength
+ * of a Content-Length header.  Beyond this the buffer grows as data
+ * arrives, so a bogus header cannot make us allocate a huge buffer.
+ */
+#define	MAX_PRESIZE	(256 * 1024 * 1024)
+
+/* The receive buffer size we ask libcurl for, and so the largest fragment
+ * passed to write_callback() and to the delegate.
+ */
+#define	RECEIVE_BUFFER_SIZE	(256 * 1024)
+
+/* Returns a buffer for a body to be stored in memory, presized from the
+ * Content-Length of the response where that is known, so that the body
+ * is copied into it once as it arrives without repeated reallocation.
+ */
+static NSMutableData *
+transferData(NSURLSessionTask *task, NSMutableDictionary *taskData)
+{
+  NSMutableData	*data = [taskData objectForKey: taskTransferDataKey];
+
+  if (nil == data)
+    {
+      NSUInteger	capacity = 0;
+#if CURL_AT_LEAST_VERSION(7, 55, 0)
+      curl_off_t	expected = -1;
+
+      curl_easy_getinfo([task _easyHandle],
+	CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &expected);
+      if (expected > 0)
+	{
+	  capacity = (expected > MAX_PRESIZE)
+	    ? MAX_PRESIZE : (NSUInteger)expected;
+	}
+#endif
+      data = [[NSMutableData alloc] initWithCapacity: capacity];
+      /* Strong reference maintained by taskData */
+      [taskData setObject: data forKey: taskTransferDataKey];
+      [data release];
+    }
+  return data;
+}
+
+/* CURLOPT_WRITEFUNCTION: callback for writing received data from easy handle
+ *
+ * The fragment passed in by libcurl is only valid for the duration of the
+ * call, so it is copied straight into the in-memory body, or written
+ * straight to the temporary file of a download task, without first being
+ * wrapped in an NSData of its own.  Only a data task delegate, which keeps
+ * the fragment, is given a copy.
+ */
 static size_t
 write_callback(char *ptr, size_t size, size_t nmemb, void *userdata)
 {
   NSURLSessionTask	*task;
   NSURLSession 		*session;
   NSMutableDictionary 	*taskData;
-  NSData 		*dataFragment;
   NSInteger 		properties;
+  size_t		length = size * nmemb;
 
   task = (NSURLSessionTask *)userdata;
   session = [task _session];
   taskData = [task _taskData];
-  dataFragment = [[NSData alloc] initWithBytes: ptr length: (size * nmemb)];
   properties = [task _properties];
 
   if (properties & GSURLSessionStoresDataInMemory)
     {
-      NSMutableData	*data;
-
-      data = [taskData objectForKey: taskTransferDataKey];
-      if (!data)
-        {
-          data = [[NSMutableData alloc] init];
-          /* Strong reference maintained by taskData */
-          [taskData setObject: data forKey: taskTransferDataKey];
-          [data release];
-        }
-
-      [data appendData: dataFragment];
+      [transferData(task, taskData) appendBytes: ptr length: length];
     }
   else if (properties & GSURLSessionWritesDataToFile)
     {
       NSFileHandle	*handle;
+      NSData		*chunk;
       NSError 		*error = NULL;
 
       // Get a temporary file path and create a file handle
@@ -883,12 +921,29 @@ write_callback(char *ptr, size_t size, size_t nmemb, void *userdata)
           if (NULL != error)
             {
               [taskData setObject: error forKey: NSUnderlyingErrorKey];
-              [dataFragment release];
               return 0;
             }
         }
 
-      [handle writeData: dataFragment];
+      chunk = [[NSData alloc] initWithBytesNoCopy: ptr
+					   length: length
+				     freeWhenDone: NO];
+      NS_DURING
+	{
+	  [handle writeData: chunk];
+	}
+      NS_HANDLER
+	{
+	  [chunk release];
+	  [taskData setObject: [NSError errorWithDomain: NSURLErrorDomain
+	    code: NSURLErrorCannotWriteToFile
+	    userInfo: [NSDictionary dictionaryWithObjectsAndKeys:
+	      [localException reason], NSLocalizedDescriptionKey,
+	      nil]] forKey: NSUnderlyingErrorKey];
+	  return 0;
+	}
+      NS_ENDHANDLER
+      [chunk release];
     }
 
   /* Notify delegate */
@@ -900,12 +955,15 @@ write_callback(char *ptr, size_t size, size_t nmemb, void *userdata)
           [delegate respondsToSelector: didReceiveDataSel])
         {
           NSInvocation		*inv;
+          NSData 		*dataFragment;
 
+          dataFragment = [[NSData alloc] initWithBytes: ptr length: length];
           inv = GSURLSessionInvocation(delegate, didReceiveDataSel);
           [inv setArgument: &session atIndex: 2];
           [inv setArgument: &task atIndex: 3];
           [inv setArgument: &dataFragment atIndex: 4];
           [session _enqueueDelegateInvocation: inv];
+          [dataFragment release];
         }
 
       /* Notify delegate about the download process */
@@ -919,7 +977,7 @@ write_callback(char *ptr, size_t size, size_t nmemb, void *userdata)
           NSInvocation		*inv;
 
           downloadTask = (NSURLSessionDownloadTask *)task;
-          bytesWritten = [dataFragment length];
+          bytesWritten = length;
 
           [downloadTask _updateCountOfBytesWritten: bytesWritten];
 
@@ -937,8 +995,7 @@ write_callback(char *ptr, size_t size, size_t nmemb, void *userdata)
         }
     }
 
-  [dataFragment release];
-  return size * nmemb;
+  return length;
 } /* write_callback */
 
 @implementation NSURLSessionTask
@@ -1097,6 +1154,13 @@ write_callback(char *ptr, size_t size, size_t nmemb, void *userdata)
       curl_easy_setopt(internal->_easyHandle, CURLOPT_WRITEFUNCTION, write_callback);
       curl_easy_setopt(internal->_easyHandle, CURLOPT_WRITEDATA, self);
 
+      /* A larger receive buffer than the 16KB default means fewer, larger
+       * fragments for the callback above (and so fewer delegate messages)
+       * on a fast connection.  libcurl clamps this to what it supports.
+       */
+      curl_easy_setopt(internal->_easyHandle, CURLOPT_BUFFERSIZE,
+	(long)RECEIVE_BUFFER_SIZE);
+
       /* Retrieve the header data
        *
        * If the delegate conforms to the NSURLSessionDataDelegate
@@ -1154,6 +1218,42 @@ write_callback(char *ptr, size_t size, size_t nmemb, void *userdata)
             CURL_HTTP_VERSION_3);
 #endif
         }
+      else if ([configuration HTTPShouldUseMultiplexing])
+        {
+#if CURL_AT_LEAST_VERSION(7, 47, 0)
+          curl_easy_setopt(
+            internal->_easyHandle,
+            CURLOPT_HTTP_VERSION,
+            CURL_HTTP_VERSION_2TLS);
+#endif
+        }
+      else
+        {
+          curl_easy_setopt(
+            internal->_easyHandle,
+            CURLOPT_HTTP_VERSION,
+            CURL_HTTP_VERSION_1_1);
+        }
+
+      /* Wait for a connection which may be multiplexed rather than opening
+       * another one to the same host.
+       */
+#if CURL_AT_LEAST_VERSION(7, 43, 0)
+      if ([configuration HTTPShouldUseMultiplexing])
+        {
+          curl_easy_setopt(internal->_easyHandle, CURLOPT_PIPEWAIT, 1L);
+        }
+#endif
+
+      /* Share host name lookups and TLS sessions with other sessions.
+       */
+      if ([configuration sharesConnectionPool])
+        {
+          curl_easy_setopt(
+            internal->_easyHandle,
+            CURLOPT_SHARE,
+            GSURLSessionSharedHandle());
+        }
 
       /* Configure the custom CA certificate if available */
       if (nil != (certificateBlob = [internal->_session _certificateBlob]))
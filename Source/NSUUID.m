@@ -26,11 +26,14 @@
 #import "Foundation/NSCoder.h"
 #import "Foundation/NSUUID.h"
 #import "GNUstepBase/NSData+GNUstepBase.h"
+#import "GSPrivate.h"
+#import "GSPThread.h"
 
 
 static int uuid_from_string(const char *string, unsigned char *uuid);
 static void string_from_uuid(const unsigned char *uuid, char *string);
 static int random_uuid(unsigned char *uuid);
+static int time_ordered_uuid(unsigned char *uuid);
 
 static const int UUIDStringLength = 36;
 static const int UnformattedUUIDStringLength = 32;
@@ -50,6 +53,17 @@ static const int UUIDByteCount = 16;
   return AUTORELEASE(u);
 }
 
++ (instancetype) timeOrderedUUID
+{
+  gsuuid_t      localUUID;
+
+  if (time_ordered_uuid(localUUID) != 0)
+    {
+      return nil;
+    }
+  return AUTORELEASE([[self alloc] initWithUUIDBytes: localUUID]);
+}
+
 - (instancetype) init
 {
   gsuuid_t      localUUID;
@@ -290,16 +304,59 @@ static int random_uuid(unsigned char *uuid)
     }
 
   /* as required by the RFC, bits 48-51 should contain 0b0100 (4)
-   * and bits 64-65 should contain 0b01 (1)
+   * and bits 64-65 should contain 0b10 (the variant)
    */
   timeByte = uuid[6];
-  timeByte = (4 << 8) + (timeByte & 0x0f);
-  uuid[7] = timeByte;
+  timeByte = (4 << 4) + (timeByte & 0x0f);
+  uuid[6] = timeByte;
 
   sequenceByte = uuid[8];
-  sequenceByte = (1 << 6) + (sequenceByte & 0x3f);
+  sequenceByte = (2 << 6) + (sequenceByte & 0x3f);
   uuid[8] = sequenceByte;
 
   return 0;
 }
 
+static int time_ordered_uuid(unsigned char *uuid)
+{
+  static gs_mutex_t     lock = GS_MUTEX_INIT_STATIC;
+  static uint64_t       last = 0;
+  uint64_t              us;
+  uint64_t              stamp;
+  int                   i;
+
+  /* Version 7 UUIDs (see RFC9562, section 5.7) start with the Unix time
+   * in milliseconds, so UUIDs made close together in time are close
+   * together when sorted (good for the locality of database indexes).
+   */
+  if (NO == [NSData randomBytes: uuid ofLength: UUIDByteCount])
+    {
+      return -1;
+    }
+
+  /* We use the 12 bits following the milliseconds for a fraction of a
+   * millisecond (RFC9562, section 6.2, method 3).  To keep the UUIDs made
+   * by this process strictly increasing even when the clock steps back or
+   * two are made within the same fraction, we make the combined 60 bit
+   * value larger than the last one used.
+   */
+  us = (uint64_t)((GSPrivateTimeNow() + NSTimeIntervalSince1970) * 1000000.0);
+  stamp = ((us / 1000) << 12) | (((us % 1000) << 12) / 1000);
+  GS_MUTEX_LOCK(lock);
+  if (stamp <= last)
+    {
+      stamp = last + 1;
+    }
+  last = stamp;
+  GS_MUTEX_UNLOCK(lock);
+
+  for (i = 0; i < 6; i++)
+    {
+      uuid[i] = (unsigned char)(stamp >> (52 - 8 * i));
+    }
+  uuid[6] = (7 << 4) + ((stamp >> 8) & 0x0f);
+  uuid[7] = (unsigned char)stamp;
+  uuid[8] = (2 << 6) + (uuid[8] & 0x3f);
+  return 0;
+}
+
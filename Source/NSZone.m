@@ -1831,6 +1831,819 @@ NSZoneStats(NSZone *zone)
   return (zone->stats)(zone);
 }
 
+/* The size class allocator for small objects.
+ *
+ * Blocks are multiples of MAG_GRAIN bytes, up to MAG_CLASSES * MAG_GRAIN.
+ * Each thread keeps two magazines (lists of up to MAG_ROUNDS free blocks)
+ * of each size class, allocating from and freeing to the loaded one, and
+ * swapping it with the previous one when it is empty (or full).  Only when
+ * both are empty (or full) does a thread exchange a full magazine with
+ * the depot, a set of slots shared by all threads which are filled and
+ * emptied with atomic operations (no locks), or fall back to malloc() and
+ * free().  So memory freed by one thread is reused by others through the
+ * depot without any thread ever waiting for another.
+ *
+ * The counts of blocks allocated and freed are kept by each thread and
+ * only added up (under magazineLock) when statistics are wanted.
+ */
+#define	MAG_GRAIN	16
+#define	MAG_CLASSES	16
+#define	MAG_ROUNDS	64
+#define	MAG_DEPOT	32
+
+typedef struct mag_block {
+  struct mag_block	*next;
+} mag_block;
+
+typedef struct {
+  mag_block	*loaded;
+  mag_block	*previous;
+  unsigned	loadedCount;
+  unsigned	previousCount;
+  size_t	allocs;		// Updated only by the owning thread
+  size_t	frees;		// Updated only by the owning thread
+} mag_cache;
+
+typedef struct mag_thread {
+  struct mag_thread	*next;
+  mag_cache		caches[MAG_CLASSES];
+} mag_thread;
+
+static BOOL		magazinesActive = NO;
+static gs_thread_key_t	magazineKey;
+static gs_mutex_t	magazineLock = GS_MUTEX_INIT_STATIC;
+static mag_thread	*magazineThreads = 0;
+static size_t		magazineRetired[MAG_CLASSES];
+static size_t		magazineBlocks[MAG_CLASSES];
+static mag_block	*magazineDepot[MAG_CLASSES][MAG_DEPOT];
+
+static void* mmalloc (NSZone *zone, size_t size);
+static void* mrealloc (NSZone *zone, void *ptr, size_t size);
+static void mfree (NSZone *zone, void *ptr);
+static void mrecycle (NSZone *zone);
+static BOOL mcheck (NSZone *zone);
+static BOOL mlookup (NSZone *zone, void *ptr);
+static struct NSZoneStats mstats (NSZone *zone);
+
+static NSZone magazineZone =
+{
+  mmalloc, mrealloc, mfree, mrecycle,
+  mcheck, mlookup, mstats, MAG_GRAIN, @"magazine", 0
+};
+
+/* Put a full magazine in an empty slot of the depot, returning NO if
+ * there is none.
+ */
+static BOOL
+depotPut(unsigned sizeClass, mag_block *magazine)
+{
+  mag_block	**slots = magazineDepot[sizeClass - 1];
+  unsigned	i;
+
+  for (i = 0; i < MAG_DEPOT; i++)
+    {
+      mag_block	*empty = 0;
+
+      if (0 == __atomic_load_n(&slots[i], __ATOMIC_RELAXED)
+	&& __atomic_compare_exchange_n(&slots[i], &empty, magazine,
+	  NO, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+	{
+	  return YES;
+	}
+    }
+  return NO;
+}
+
+/* Take a full magazine from the depot, or return 0 if there is none.
+ * Slots are emptied by exchange rather than compare and swap, so a
+ * magazine is never taken twice however the slots are reused.
+ */
+static mag_block *
+depotTake(unsigned sizeClass)
+{
+  mag_block	**slots = magazineDepot[sizeClass - 1];
+  unsigned	i;
+
+  for (i = 0; i < MAG_DEPOT; i++)
+    {
+      if (__atomic_load_n(&slots[i], __ATOMIC_RELAXED) != 0)
+	{
+	  mag_block	*magazine;
+
+	  magazine = __atomic_exchange_n(&slots[i], 0, __ATOMIC_ACQUIRE);
+	  if (magazine != 0)
+	    {
+	      return magazine;
+	    }
+	}
+    }
+  return 0;
+}
+
+/* Return a list of blocks to the system.
+ */
+static void
+releaseBlocks(unsigned sizeClass, mag_block *list, unsigned count)
+{
+  while (list != 0)
+    {
+      mag_block	*next = list->next;
+
+      free(list);
+      list = next;
+    }
+  __atomic_fetch_sub(&magazineBlocks[sizeClass - 1], count, __ATOMIC_RELAXED);
+}
+
+/* Called when a thread exits, to pass its magazines to the depot (or free
+ * them) and keep its counts for the statistics.
+ */
+static void
+magazineThreadExit(void *data)
+{
+  mag_thread	*t = (mag_thread*)data;
+  unsigned	i;
+
+  for (i = 0; i < MAG_CLASSES; i++)
+    {
+      mag_cache	*c = &t->caches[i];
+
+      if (c->loadedCount < MAG_ROUNDS || !depotPut(i + 1, c->loaded))
+	{
+	  releaseBlocks(i + 1, c->loaded, c->loadedCount);
+	}
+      if (c->previousCount < MAG_ROUNDS || !depotPut(i + 1, c->previous))
+	{
+	  releaseBlocks(i + 1, c->previous, c->previousCount);
+	}
+    }
+
+  GS_MUTEX_LOCK(magazineLock);
+  if (magazineThreads == t)
+    {
+      magazineThreads = t->next;
+    }
+  else
+    {
+      mag_thread	*p = magazineThreads;
+
+      while (p != 0 && p->next != t)
+	{
+	  p = p->next;
+	}
+      if (p != 0)
+	{
+	  p->next = t->next;
+	}
+    }
+  for (i = 0; i < MAG_CLASSES; i++)
+    {
+      magazineRetired[i] += t->caches[i].allocs - t->caches[i].frees;
+    }
+  GS_MUTEX_UNLOCK(magazineLock);
+  free(t);
+}
+
+static mag_thread *
+magazineThread(void)
+{
+  mag_thread	*t = GS_THREAD_KEY_GET(magazineKey);
+
+  if (0 == t)
+    {
+      t = calloc(1, sizeof(mag_thread));
+      if (0 == t)
+	{
+	  return 0;
+	}
+      GS_THREAD_KEY_SET(magazineKey, t);
+      GS_MUTEX_LOCK(magazineLock);
+      t->next = magazineThreads;
+      magazineThreads = t;
+      GS_MUTEX_UNLOCK(magazineLock);
+    }
+  return t;
+}
+
+void
+GSPrivateMagazineSetUp(void)
+{
+  GS_MUTEX_LOCK(magazineLock);
+  if (NO == magazinesActive
+    && GS_THREAD_KEY_INIT(magazineKey, magazineThreadExit))
+    {
+      magazinesActive = YES;
+    }
+  GS_MUTEX_UNLOCK(magazineLock);
+}
+
+unsigned
+GSPrivateMagazineClass(size_t size)
+{
+  size = (size + MAG_GRAIN - 1) / MAG_GRAIN;
+  return (size > 0 && size <= MAG_CLASSES) ? (unsigned)size : 0;
+}
+
+void *
+GSPrivateMagazineMalloc(unsigned sizeClass)
+{
+  mag_thread	*t = magazineThread();
+  mag_cache	*c;
+  mag_block	*b;
+
+  if (0 == t)
+    {
+      return 0;
+    }
+  c = &t->caches[sizeClass - 1];
+  if (0 == c->loadedCount)
+    {
+      if (c->previousCount > 0)
+	{
+	  c->loaded = c->previous;
+	  c->loadedCount = c->previousCount;
+	  c->previous = 0;
+	  c->previousCount = 0;
+	}
+      else if ((c->loaded = depotTake(sizeClass)) != 0)
+	{
+	  c->loadedCount = MAG_ROUNDS;
+	}
+      else
+	{
+	  b = malloc(sizeClass * MAG_GRAIN);
+	  if (0 == b)
+	    {
+	      return 0;
+	    }
+	  __atomic_fetch_add(&magazineBlocks[sizeClass - 1], 1,
+	    __ATOMIC_RELAXED);
+	  __atomic_store_n(&c->allocs, c->allocs + 1, __ATOMIC_RELAXED);
+	  return b;
+	}
+    }
+  b = c->loaded;
+  c->loaded = b->next;
+  c->loadedCount--;
+  __atomic_store_n(&c->allocs, c->allocs + 1, __ATOMIC_RELAXED);
+  return b;
+}
+
+void
+GSPrivateMagazineFree(void *ptr, unsigned sizeClass)
+{
+  mag_thread	*t = magazineThread();
+  mag_cache	*c;
+  mag_block	*b = (mag_block*)ptr;
+
+  if (0 == t)
+    {
+      /* Can't cache the block, but its count must still be kept right
+       * for the statistics.
+       */
+      GS_MUTEX_LOCK(magazineLock);
+      magazineRetired[sizeClass - 1]--;
+      GS_MUTEX_UNLOCK(magazineLock);
+      b->next = 0;
+      releaseBlocks(sizeClass, b, 1);
+      return;
+    }
+  c = &t->caches[sizeClass - 1];
+  if (MAG_ROUNDS == c->loadedCount)
+    {
+      if (MAG_ROUNDS == c->previousCount
+	&& !depotPut(sizeClass, c->previous))
+	{
+	  releaseBlocks(sizeClass, c->previous, c->previousCount);
+	}
+      c->previous = c->loaded;
+      c->previousCount = c->loadedCount;
+      c->loaded = 0;
+      c->loadedCount = 0;
+    }
+  b->next = c->loaded;
+  c->loaded = b;
+  c->loadedCount++;
+  __atomic_store_n(&c->frees, c->frees + 1, __ATOMIC_RELAXED);
+}
+
+NSZone*
+GSObjectMagazineZone(void)
+{
+  return magazinesActive ? &magazineZone : NULL;
+}
+
+/* Blocks of the magazine zone are only allocated and freed by
+ * NSAllocateObject() and NSDeallocateObject(), which know their size.
+ */
+static void*
+mmalloc (NSZone *zone, size_t size)
+{
+  [NSException raise: NSGenericException
+	      format: @"Attempt to allocate memory in magazine zone"];
+  return 0;
+}
+
+static void*
+mrealloc (NSZone *zone, void *ptr, size_t size)
+{
+  [NSException raise: NSGenericException
+	      format: @"Attempt to realloc memory in magazine zone"];
+  return 0;
+}
+
+static void
+mfree (NSZone *zone, void *ptr)
+{
+  [NSException raise: NSGenericException
+	      format: @"Attempt to free memory in magazine zone"];
+}
+
+static void
+mrecycle (NSZone *zone)
+{
+  [NSException raise: NSGenericException
+	      format: @"Trying to recycle magazine zone"];
+}
+
+static BOOL
+mcheck (NSZone *zone)
+{
+  return YES;
+}
+
+static BOOL
+mlookup (NSZone *zone, void *ptr)
+{
+  return NO;
+}
+
+static struct NSZoneStats
+mstats (NSZone *zone)
+{
+  struct NSZoneStats	stats = {0,0,0,0,0};
+  mag_thread		*t;
+  unsigned		i;
+
+  GS_MUTEX_LOCK(magazineLock);
+  for (i = 0; i < MAG_CLASSES; i++)
+    {
+      size_t	size = (i + 1) * MAG_GRAIN;
+      size_t	blocks;
+      size_t	used;
+      intptr_t	count = (intptr_t)magazineRetired[i];
+
+      /* A block freed by a thread other than the one which allocated it
+       * is counted by each of them, so only the total is meaningful, and
+       * counts read while other threads run may be slightly out.
+       */
+      for (t = magazineThreads; t != 0; t = t->next)
+	{
+	  count += (intptr_t)(__atomic_load_n(&t->caches[i].allocs,
+	    __ATOMIC_RELAXED)
+	    - __atomic_load_n(&t->caches[i].frees, __ATOMIC_RELAXED));
+	}
+      blocks = __atomic_load_n(&magazineBlocks[i], __ATOMIC_RELAXED);
+      used = (count < 0) ? 0 : (size_t)count;
+      if (used > blocks)
+	{
+	  used = blocks;
+	}
+      stats.bytes_total += blocks * size;
+      stats.chunks_used += used;
+      stats.bytes_used += used * size;
+      stats.chunks_free += blocks - used;
+      stats.bytes_free += (blocks - used) * size;
+    }
+  GS_MUTEX_UNLOCK(magazineLock);
+  return stats;
+}
+
+/* Arena zones.
+ *
+ * Memory is allocated by advancing a pointer through a list of chunks of
+ * the zone's granularity (requests too big to share a chunk get blocks of
+ * their own), and is never freed individually.  GSResetArenaZone() makes
+ * all of it available again by going back to the start of the first
+ * chunk, keeping the chunks for reuse.  There is no locking, so a zone
+ * must only be used by one thread at a time.
+ */
+#ifdef	__BIGGEST_ALIGNMENT__
+#define	ARENA_ALIGN	(__BIGGEST_ALIGNMENT__ > ALIGN \
+  ? __BIGGEST_ALIGNMENT__ : ALIGN)
+#else
+#define	ARENA_ALIGN	(2 * ALIGN)
+#endif
+
+typedef struct _arena_chunk_struct {
+  struct _arena_chunk_struct	*next;
+  size_t			size;	// Size of chunk including header
+} arena_chunk;
+#define	ARENA_HEAD	roundupto(sizeof(arena_chunk), ARENA_ALIGN)
+
+typedef struct {
+  NSZone	common;
+  arena_chunk	*chunks;	// Chunks of the zone granularity, in order
+  arena_chunk	*current;	// The chunk being allocated from
+  arena_chunk	*large;		// Blocks for big requests, freed on reset
+  char		*top;		// Next free byte in the current chunk
+  char		*end;		// End of the current chunk
+  size_t	allocs;		// Allocations since the last reset
+  size_t	bytes;		// Bytes allocated since the last reset
+} arena_zone;
+
+static void* amalloc (NSZone *zone, size_t size);
+static void* arealloc (NSZone *zone, void *ptr, size_t size);
+static void afree (NSZone *zone, void *ptr);
+static void arecycle (NSZone *zone);
+static BOOL acheck (NSZone *zone);
+static BOOL alookup (NSZone *zone, void *ptr);
+static struct NSZoneStats astats (NSZone *zone);
+
+NSZone*
+GSCreateArenaZone(NSUInteger chunkSize)
+{
+  arena_zone	*zone;
+
+  zone = calloc(1, sizeof(arena_zone));
+  if (zone == NULL)
+    [NSException raise: NSMallocException
+		format: @"No memory to create zone"];
+  zone->common.malloc = amalloc;
+  zone->common.realloc = arealloc;
+  zone->common.free = afree;
+  zone->common.recycle = arecycle;
+  zone->common.check = acheck;
+  zone->common.lookup = alookup;
+  zone->common.stats = astats;
+  zone->common.gran = (chunkSize > 0)
+    ? roundupto(chunkSize, MINGRAN) : DEFBLOCK * 4;
+  zone->common.name = nil;
+  return (NSZone*)zone;
+}
+
+BOOL
+GSPrivateIsArenaZone(NSZone *zone)
+{
+  return (zone != NULL && zone->malloc == amalloc) ? YES : NO;
+}
+
+void
+GSResetArenaZone(NSZone *zone)
+{
+  arena_zone	*zptr = (arena_zone*)zone;
+
+  if (NO == GSPrivateIsArenaZone(zone))
+    {
+      [NSException raise: NSInvalidArgumentException
+		  format: @"Attempt to reset a zone which is not an arena"];
+    }
+  while (zptr->large != NULL)
+    {
+      arena_chunk	*next = zptr->large->next;
+
+      free(zptr->large);
+      zptr->large = next;
+    }
+  zptr->current = zptr->chunks;
+  if (zptr->current != NULL)
+    {
+      zptr->top = (char*)zptr->current + ARENA_HEAD;
+      zptr->end = (char*)zptr->current + zptr->current->size;
+    }
+  zptr->allocs = 0;
+  zptr->bytes = 0;
+}
+
+/* Allocate when the current chunk is full.
+ */
+static void*
+amalloc_slow (arena_zone *zptr, size_t size)
+{
+  size_t	gran = zptr->common.gran;
+  arena_chunk	*chunk;
+  void		*result;
+
+  if (size > (gran - ARENA_HEAD) / 4)
+    {
+      /* Too big to share a chunk without wasting much of it.
+       */
+      chunk = malloc(ARENA_HEAD + size);
+      if (chunk == NULL)
+	{
+	  return NULL;
+	}
+      chunk->size = ARENA_HEAD + size;
+      chunk->next = zptr->large;
+      zptr->large = chunk;
+      zptr->allocs++;
+      zptr->bytes += size;
+      return (char*)chunk + ARENA_HEAD;
+    }
+
+  if (zptr->current != NULL && zptr->current->next != NULL)
+    {
+      chunk = zptr->current->next;	// Reuse a chunk from before a reset
+    }
+  else
+    {
+      chunk = malloc(gran);
+      if (chunk == NULL)
+	{
+	  return NULL;
+	}
+      chunk->size = gran;
+      chunk->next = NULL;
+      if (zptr->current == NULL)
+	{
+	  zptr->chunks = chunk;
+	}
+      else
+	{
+	  zptr->current->next = chunk;
+	}
+    }
+  zptr->current = chunk;
+  zptr->top = (char*)chunk + ARENA_HEAD;
+  zptr->end = (char*)chunk + chunk->size;
+  result = zptr->top;
+  zptr->top += size;
+  zptr->allocs++;
+  zptr->bytes += size;
+  return result;
+}
+
+static void*
+amalloc (NSZone *zone, size_t size)
+{
+  arena_zone	*zptr = (arena_zone*)zone;
+  void		*result;
+
+  size = roundupto(size > 0 ? size : 1, ARENA_ALIGN);
+  if ((size_t)(zptr->end - zptr->top) < size)
+    {
+      return amalloc_slow(zptr, size);
+    }
+  result = zptr->top;
+  zptr->top += size;
+  zptr->allocs++;
+  zptr->bytes += size;
+  return result;
+}
+
+/* Find the chunk containing ptr.
+ */
+static arena_chunk*
+achunk (arena_zone *zptr, void *ptr)
+{
+  arena_chunk	*lists[2] = { zptr->chunks, zptr->large };
+  unsigned	i;
+
+  for (i = 0; i < 2; i++)
+    {
+      arena_chunk	*chunk;
+
+      for (chunk = lists[i]; chunk != NULL; chunk = chunk->next)
+	{
+	  if ((char*)ptr >= (char*)chunk + ARENA_HEAD
+	    && (char*)ptr < (char*)chunk + chunk->size)
+	    {
+	      return chunk;
+	    }
+	}
+    }
+  return NULL;
+}
+
+static void*
+arealloc (NSZone *zone, void *ptr, size_t size)
+{
+  arena_zone	*zptr = (arena_zone*)zone;
+  arena_chunk	*chunk;
+  void		*tmp;
+  size_t	old;
+
+  if (NULL == ptr)
+    {
+      return amalloc(zone, size);
+    }
+  if (0 == size)
+    {
+      return NULL;
+    }
+  /* The size of the old memory is not recorded, so copy as much as might
+   * belong to it (up to the end of its chunk or the bump pointer).
+   */
+  chunk = achunk(zptr, ptr);
+  if (NULL == chunk)
+    {
+      return NULL;
+    }
+  if (chunk == zptr->current)
+    {
+      old = zptr->top - (char*)ptr;
+    }
+  else
+    {
+      old = (char*)chunk + chunk->size - (char*)ptr;
+    }
+  tmp = amalloc(zone, size);
+  if (tmp != NULL)
+    {
+      memcpy(tmp, ptr, (size < old) ? size : old);
+    }
+  return tmp;
+}
+
+static void
+afree (NSZone *zone, void *ptr)
+{
+  return;	// Memory is only freed by a reset.
+}
+
+static void
+arecycle (NSZone *zone)
+{
+  arena_zone	*zptr = (arena_zone*)zone;
+
+  GSResetArenaZone(zone);
+  while (zptr->chunks != NULL)
+    {
+      arena_chunk	*next = zptr->chunks->next;
+
+      free(zptr->chunks);
+      zptr->chunks = next;
+    }
+  if (zone->name != nil)
+    {
+      NSString	*name = zone->name;
+
+      zone->name = nil;
+      [name release];
+    }
+  free(zptr);
+}
+
+static BOOL
+acheck (NSZone *zone)
+{
+  arena_zone	*zptr = (arena_zone*)zone;
+
+  if (zptr->current == NULL)
+    {
+      return (zptr->chunks == NULL) ? YES : NO;
+    }
+  return (zptr->top >= (char*)zptr->current + ARENA_HEAD
+    && zptr->top <= zptr->end
+    && zptr->end == (char*)zptr->current + zptr->current->size) ? YES : NO;
+}
+
+static BOOL
+alookup (NSZone *zone, void *ptr)
+{
+  return (achunk((arena_zone*)zone, ptr) != NULL) ? YES : NO;
+}
+
+static struct NSZoneStats
+astats (NSZone *zone)
+{
+  arena_zone		*zptr = (arena_zone*)zone;
+  struct NSZoneStats	stats = {0,0,0,0,0};
+  arena_chunk		*chunk;
+  BOOL			unused = NO;
+
+  /* Chunks after the current one are free for reuse.
+   */
+  for (chunk = zptr->chunks; chunk != NULL; chunk = chunk->next)
+    {
+      stats.bytes_total += chunk->size;
+      if (unused)
+	{
+	  stats.chunks_free++;
+	}
+      if (chunk == zptr->current)
+	{
+	  unused = YES;
+	}
+    }
+  for (chunk = zptr->large; chunk != NULL; chunk = chunk->next)
+    {
+      stats.bytes_total += chunk->size;
+    }
+  stats.chunks_used = zptr->allocs;
+  stats.bytes_used = zptr->bytes;
+  stats.bytes_free = stats.bytes_total - stats.bytes_used;
+  return stats;
+}
+
+/* The stack of zones which NSAllocateObject() uses in place of the default
+ * zone.  Each thread has its own, and the count of zones pushed in all
+ * threads lets allocation skip looking for one when there are none.
+ */
+typedef struct {
+  NSUInteger	depth;
+  NSUInteger	capacity;
+  NSZone	**zones;
+} zone_scopes;
+
+static gs_thread_key_t	scopesKey;
+static BOOL		scopesKeyReady = NO;
+static NSUInteger	scopesPushed = 0;
+
+static void
+zoneScopesExit(void *data)
+{
+  zone_scopes	*s = (zone_scopes*)data;
+
+  __atomic_fetch_sub(&scopesPushed, s->depth, __ATOMIC_RELAXED);
+  free(s->zones);
+  free(s);
+}
+
+void
+GSPushAllocationZone(NSZone *zone)
+{
+  zone_scopes	*s;
+
+  if (NO == __atomic_load_n(&scopesKeyReady, __ATOMIC_ACQUIRE))
+    {
+      GS_MUTEX_LOCK(zoneLock);
+      if (NO == scopesKeyReady)
+	{
+	  if (!GS_THREAD_KEY_INIT(scopesKey, zoneScopesExit))
+	    {
+	      GS_MUTEX_UNLOCK(zoneLock);
+	      [NSException raise: NSGenericException
+			  format: @"Unable to create thread key for zones"];
+	    }
+	  __atomic_store_n(&scopesKeyReady, YES, __ATOMIC_RELEASE);
+	}
+      GS_MUTEX_UNLOCK(zoneLock);
+    }
+  s = GS_THREAD_KEY_GET(scopesKey);
+  if (NULL == s)
+    {
+      s = calloc(1, sizeof(zone_scopes));
+      if (NULL == s)
+	{
+	  [NSException raise: NSMallocException
+		      format: @"No memory to push zone"];
+	}
+      GS_THREAD_KEY_SET(scopesKey, s);
+    }
+  if (s->depth == s->capacity)
+    {
+      NSUInteger	capacity = s->capacity ? s->capacity * 2 : 8;
+      NSZone		**zones;
+
+      zones = realloc(s->zones, capacity * sizeof(NSZone*));
+      if (NULL == zones)
+	{
+	  [NSException raise: NSMallocException
+		      format: @"No memory to push zone"];
+	}
+      s->zones = zones;
+      s->capacity = capacity;
+    }
+  s->zones[s->depth++] = (NULL == zone) ? &defaultZone : zone;
+  __atomic_fetch_add(&scopesPushed, 1, __ATOMIC_RELAXED);
+}
+
+void
+GSPopAllocationZone(void)
+{
+  zone_scopes	*s = NULL;
+
+  if (YES == __atomic_load_n(&scopesKeyReady, __ATOMIC_ACQUIRE))
+    {
+      s = GS_THREAD_KEY_GET(scopesKey);
+    }
+  if (NULL == s || 0 == s->depth)
+    {
+      [NSException raise: NSInternalInconsistencyException
+		  format: @"GSPopAllocationZone() without a matching push"];
+    }
+  s->depth--;
+  __atomic_fetch_sub(&scopesPushed, 1, __ATOMIC_RELAXED);
+}
+
+NSZone*
+GSPrivateScopedZone(void)
+{
+  zone_scopes	*s;
+
+  if (0 == __atomic_load_n(&scopesPushed, __ATOMIC_RELAXED))
+    {
+      return NULL;
+    }
+  s = GS_THREAD_KEY_GET(scopesKey);
+  if (NULL == s || 0 == s->depth)
+    {
+      return NULL;
+    }
+  return s->zones[s->depth - 1];
+}
+
 BOOL
 GSPrivateIsCollectable(const void *ptr)
 {
@@ -369,6 +369,7 @@ GS_DECLARE NSString* const GSTLSPriority = @"GSTLSPriority";
 GS_DECLARE NSString* const GSTLSRemoteHosts = @"GSTLSRemoteHosts";
 GS_DECLARE NSString* const GSTLSRevokeFile = @"GSTLSRevokeFile";
 GS_DECLARE NSString* const GSTLSServerName = @"GSTLSServerName";
+GS_DECLARE NSString* const GSTLSSessionCacheKey = @"GSTLSSessionCacheKey";
 GS_DECLARE NSString* const GSTLSVerify = @"GSTLSVerify";
 
 /* NSFileManager */
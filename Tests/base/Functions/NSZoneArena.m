@@ -0,0 +1,133 @@
+#import <Foundation/Foundation.h>
+#import "Testing.h"
+
+@interface Temp : NSObject
+{
+@public
+  int	value;
+}
+@end
+
+@implementation Temp
+@end
+
+int main()
+{
+  NSAutoreleasePool	*pool = [NSAutoreleasePool new];
+  struct NSZoneStats	stats;
+  NSZone		*arena;
+  char			*a;
+  char			*b;
+  char			*c;
+  char			*big;
+  Temp			*t;
+  id			o;
+  size_t		total;
+  int			i;
+  BOOL			ok;
+
+  arena = GSCreateArenaZone(4096);
+  PASS(arena != NULL, "GSCreateArenaZone() creates a zone");
+
+  a = NSZoneMalloc(arena, 10);
+  b = NSZoneMalloc(arena, 10);
+  PASS(a != NULL && b > a, "an arena allocates upwards");
+  PASS(((uintptr_t)a % 8) == 0 && ((uintptr_t)b % 8) == 0,
+    "arena memory is aligned");
+  memset(a, 'a', 10);
+  memset(b, 'b', 10);
+  NSZoneFree(arena, a);
+  PASS(a[0] == 'a', "NSZoneFree() does nothing in an arena");
+
+  c = NSZoneRealloc(arena, b, 100);
+  PASS(c != NULL && c[0] == 'b' && c[9] == 'b',
+    "NSZoneRealloc() copies the old contents");
+
+  big = NSZoneMalloc(arena, 100000);
+  PASS(big != NULL, "an arena allocates more than a chunk");
+  memset(big, 0, 100000);
+  for (i = 0; i < 1000; i++)
+    {
+      memset(NSZoneMalloc(arena, 100), i, 100);
+    }
+  PASS(NSZoneCheck(arena), "the arena is consistent");
+
+  stats = NSZoneStats(arena);
+  PASS(stats.chunks_used == 1004, "the arena counts allocations");
+  PASS(stats.bytes_used >= 100000 + 1000 * 100
+    && stats.bytes_total >= stats.bytes_used,
+    "the arena counts bytes");
+  total = stats.bytes_total;
+
+  GSResetArenaZone(arena);
+  stats = NSZoneStats(arena);
+  PASS(stats.chunks_used == 0 && stats.bytes_used == 0,
+    "GSResetArenaZone() empties the arena");
+  PASS(stats.bytes_total >= 1000 * 100 && stats.bytes_total <= total - 100000,
+    "GSResetArenaZone() keeps chunks but not big blocks");
+  PASS(NSZoneMalloc(arena, 10) == a, "memory is reused after a reset");
+  PASS(NSZoneCheck(arena), "the arena is consistent after a reset");
+  GSResetArenaZone(arena);
+
+  START_SET("objects in an arena")
+    t = [Temp allocWithZone: arena];
+    if ((char*)t < a || (char*)t >= a + 4096)
+      {
+	RELEASE([t init]);
+	SKIP("objects are not allocated in zones with this runtime")
+      }
+    t = [t init];
+    t->value = 42;
+    RELEASE(t);
+
+    GSPushAllocationZone(arena);
+    t = [Temp new];
+    GSPushAllocationZone(NULL);
+    o = [NSObject new];
+    ok = ((char*)o < a || (char*)o >= a + 4096);
+    RELEASE(o);
+    GSPopAllocationZone();
+    PASS(ok, "pushing NULL uses the default zone again");
+    o = [[NSObject allocWithZone: NSDefaultMallocZone()] init];
+    ok = ((char*)o < a || (char*)o >= a + 4096);
+    RELEASE(o);
+    PASS(ok, "an explicit default zone allocation is not redirected");
+    o = [NSAutoreleasePool new];
+    ok = ((char*)o < a || (char*)o >= a + 4096);
+    [o release];
+    PASS(ok, "autorelease pools are not allocated in a pushed zone");
+    PASS((char*)t > a && (char*)t < a + 4096,
+      "a pushed zone is used by +new");
+    ok = YES;
+    for (i = 0; i < 10000; i++)
+      {
+	Temp	*tmp = [Temp new];
+
+	tmp->value = i;
+	if (tmp->value != i)
+	  {
+	    ok = NO;
+	  }
+	RELEASE(tmp);
+      }
+    GSPopAllocationZone();
+    PASS(ok, "many objects can be created and released in an arena");
+    RELEASE(t);
+    t = [Temp new];
+    PASS((char*)t < a || (char*)t >= a + 4096,
+      "popping the zone restores the default");
+    RELEASE(t);
+    GSResetArenaZone(arena);
+  END_SET("objects in an arena")
+
+  PASS_EXCEPTION(GSPopAllocationZone(), NSInternalInconsistencyException,
+    "an unmatched pop raises");
+  PASS_EXCEPTION(GSResetArenaZone(NSDefaultMallocZone()),
+    NSInvalidArgumentException, "only an arena can be reset");
+
+  NSRecycleZone(arena);
+  PASS(1, "an arena can be recycled");
+
+  [pool release]; pool = nil;
+  return 0;
+}
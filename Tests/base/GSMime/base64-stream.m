@@ -0,0 +1,121 @@
+#if	defined(GNUSTEP_BASE_LIBRARY)
+#import <Foundation/Foundation.h>
+#import <GNUstepBase/GSMime.h>
+#import "Testing.h"
+
+int main()
+{
+  START_SET("GSMime base64 coding contexts")
+
+  NSMutableData			*src = [NSMutableData data];
+  NSMutableData			*out = [NSMutableData data];
+  NSMutableData			*dec = [NSMutableData data];
+  GSMimeBase64EncoderContext	*enc;
+  GSMimeBase64DecoderContext	*ctx;
+  NSInputStream			*is;
+  NSOutputStream		*os;
+  NSData			*ref;
+  NSData			*d;
+  NSUInteger			offset;
+  NSUInteger			chunk;
+  unsigned			i;
+
+  srandom(1);
+  for (i = 0; i < 100003; i++)
+    {
+      uint8_t	b = (uint8_t)random();
+
+      [src appendBytes: &b length: 1];
+    }
+
+  /* Long data goes through the vector kernels where available.
+   */
+  d = [src base64EncodedDataWithOptions: 0];
+  PASS_EQUAL([GSMimeDocument decodeBase64: d], src,
+    "large data round trips through +decodeBase64:")
+  PASS_EQUAL(AUTORELEASE([[NSData alloc] initWithBase64EncodedData: d
+    options: 0]), src, "large data round trips through NSData")
+  PASS_EQUAL([GSMimeDocument encodeBase64: src], d,
+    "+encodeBase64: matches NSData")
+
+  ref = [src base64EncodedDataWithOptions:
+    NSDataBase64Encoding76CharacterLineLength];
+  PASS_EQUAL(AUTORELEASE([[NSData alloc] initWithBase64EncodedData: ref
+    options: NSDataBase64DecodingIgnoreUnknownCharacters]), src,
+    "data with line breaks round trips through NSData")
+  PASS_EQUAL([GSMimeDocument decodeBase64: ref], src,
+    "data with line breaks round trips through +decodeBase64:")
+
+  /* Encode in irregular chunks and check we get the same as NSData.
+   */
+  enc = AUTORELEASE([[GSMimeBase64EncoderContext alloc]
+    initWithOptions: NSDataBase64Encoding76CharacterLineLength]);
+  offset = 0;
+  chunk = 1;
+  while (offset < [src length])
+    {
+      if (offset + chunk > [src length])
+	{
+	  chunk = [src length] - offset;
+	}
+      [enc encodeData: [src bytes] + offset length: chunk intoData: out];
+      offset += chunk;
+      chunk = (chunk * 7) % 1000 + 1;
+    }
+  [enc setAtEnd: YES];
+  [enc encodeData: 0 length: 0 intoData: out];
+  PASS_EQUAL(out, ref, "chunked encoding matches NSData")
+
+  /* Decode in irregular chunks.
+   */
+  ctx = AUTORELEASE([GSMimeBase64DecoderContext new]);
+  offset = 0;
+  chunk = 3;
+  while (offset < [ref length])
+    {
+      if (offset + chunk > [ref length])
+	{
+	  chunk = [ref length] - offset;
+	}
+      [ctx decodeData: [ref bytes] + offset length: chunk intoData: dec];
+      offset += chunk;
+      chunk = (chunk * 5) % 777 + 1;
+    }
+  [ctx setAtEnd: YES];
+  [ctx decodeData: 0 length: 0 intoData: dec];
+  PASS_EQUAL(dec, src, "chunked decoding restores the data")
+
+  /* Stream to stream.
+   */
+  is = [NSInputStream inputStreamWithData: src];
+  os = [NSOutputStream outputStreamToMemory];
+  [is open];
+  [os open];
+  enc = AUTORELEASE([[GSMimeBase64EncoderContext alloc]
+    initWithOptions: NSDataBase64Encoding76CharacterLineLength]);
+  PASS([enc encodeStream: is toStream: os], "encoding a stream succeeds")
+  [is close];
+  [os close];
+  d = [os propertyForKey: NSStreamDataWrittenToMemoryStreamKey];
+  PASS_EQUAL(d, ref, "stream encoding matches NSData")
+
+  is = [NSInputStream inputStreamWithData: d];
+  os = [NSOutputStream outputStreamToMemory];
+  [is open];
+  [os open];
+  ctx = AUTORELEASE([GSMimeBase64DecoderContext new]);
+  PASS([ctx decodeStream: is toStream: os], "decoding a stream succeeds")
+  [is close];
+  [os close];
+  PASS_EQUAL([os propertyForKey: NSStreamDataWrittenToMemoryStreamKey], src,
+    "stream decoding restores the data")
+
+  END_SET("GSMime base64 coding contexts")
+  return 0;
+}
+#else
+int main(void)
+{
+  return 0;
+}
+#endif
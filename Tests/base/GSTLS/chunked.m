@@ -0,0 +1,119 @@
+#import "ObjectTesting.h"
+#import "../../../Headers/GNUstepBase/config.h"
+#import "../../../Headers/Foundation/Foundation.h"
+#import "../../../Headers/GNUstepBase/GSTLS.h"
+
+#if GS_USE_GNUTLS
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static ssize_t
+pullFunc(gnutls_transport_ptr_t t, void *buf, size_t len)
+{
+  return read((int)(intptr_t)t, buf, len);
+}
+
+static ssize_t
+pushFunc(gnutls_transport_ptr_t t, const void *buf, size_t len)
+{
+  return write((int)(intptr_t)t, buf, len);
+}
+
+static NSMutableData	*received = nil;
+static volatile BOOL	finished = NO;
+
+/* Accepts one connection on a descriptor and decrypts everything sent
+ * until the other end closes it.
+ */
+@interface Server : NSObject
+- (void) serve: (NSNumber*)fd;
+@end
+
+@implementation Server
+- (void) serve: (NSNumber*)fd
+{
+  ENTER_POOL
+  NSDictionary	*opts;
+  GSTLSSession	*s;
+  char		buf[4096];
+  NSInteger	n;
+
+  opts = [NSDictionary dictionaryWithObjectsAndKeys:
+    @"test.crt", GSTLSCertificateFile,
+    @"test.key", GSTLSCertificateKeyFile,
+    @"asdf", GSTLSCertificateKeyPassword,
+    @"NO", GSTLSVerify,
+    nil];
+  s = [GSTLSSession sessionWithOptions: opts
+			     direction: NO
+			     transport: (void*)(intptr_t)[fd intValue]
+				  push: pushFunc
+				  pull: pullFunc];
+  while (NO == [s handshake])
+    ;
+  while ([s active] && (n = [s read: buf length: sizeof(buf)]) > 0)
+    {
+      [received appendBytes: buf length: n];
+    }
+  [s disconnect: NO];
+  close([fd intValue]);
+  finished = YES;
+  LEAVE_POOL
+}
+@end
+#endif
+
+int
+main()
+{
+  START_SET("chunked data through a TLS file handle")
+#if GS_USE_GNUTLS
+  NSFileHandle	*h;
+  NSMutableData	*d;
+  NSDate	*limit;
+  BOOL		ok = NO;
+  int		sv[2];
+  unsigned	i;
+
+#ifndef HAVE_GNUTLS_X509_PRIVKEY_IMPORT2
+  testHopeful = YES;
+#endif
+  signal(SIGPIPE, SIG_IGN);
+  received = [NSMutableData new];
+  socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+  [NSThread detachNewThreadSelector: @selector(serve:)
+			   toTarget: AUTORELEASE([Server new])
+			 withObject: [NSNumber numberWithInt: sv[1]]];
+
+  h = AUTORELEASE([[[NSFileHandle sslClass] alloc]
+    initWithFileDescriptor: sv[0] closeOnDealloc: NO]);
+  [h sslSetOptions: [NSDictionary dictionaryWithObject: @"NO"
+						forKey: GSTLSVerify]];
+  while (NO == [h sslHandshakeEstablished: &ok outgoing: YES])
+    ;
+  PASS(YES == ok, "handshake completes");
+
+  d = [NSMutableData chunkedDataWithCapacity: 0];
+  for (i = 0; i < 100000; i++)
+    {
+      [d appendBytes: &i length: sizeof(i)];
+    }
+  [h writeData: d];
+  [h sslDisconnect];
+  close(sv[0]);
+
+  limit = [NSDate dateWithTimeIntervalSinceNow: 10.0];
+  while (NO == finished && [limit timeIntervalSinceNow] > 0.0)
+    {
+      [NSThread sleepForTimeInterval: 0.01];
+    }
+  PASS([received isEqualToData: d],
+    "chunked data written to a TLS handle is encrypted")
+  DESTROY(received);
+#else
+  SKIP("TLS support disabled")
+#endif
+  END_SET("chunked data through a TLS file handle")
+  return 0;
+}
@@ -0,0 +1,133 @@
+#import "ObjectTesting.h"
+#import "../../../Headers/GNUstepBase/config.h"
+#import "../../../Headers/Foundation/Foundation.h"
+#import "../../../Headers/GNUstepBase/GSTLS.h"
+
+#if GS_USE_GNUTLS
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static ssize_t
+pullFunc(gnutls_transport_ptr_t t, void *buf, size_t len)
+{
+  return read((int)(intptr_t)t, buf, len);
+}
+
+static ssize_t
+pushFunc(gnutls_transport_ptr_t t, const void *buf, size_t len)
+{
+  return write((int)(intptr_t)t, buf, len);
+}
+
+/* Accepts one connection on a descriptor, sends a byte and waits for one.
+ */
+@interface Server : NSObject
+- (void) serve: (NSNumber*)fd;
+@end
+
+@implementation Server
+- (void) serve: (NSNumber*)fd
+{
+  ENTER_POOL
+  NSDictionary	*opts;
+  GSTLSSession	*s;
+  char		c = 'x';
+
+  opts = [NSDictionary dictionaryWithObjectsAndKeys:
+    @"test.crt", GSTLSCertificateFile,
+    @"test.key", GSTLSCertificateKeyFile,
+    @"asdf", GSTLSCertificateKeyPassword,
+    @"NO", GSTLSVerify,
+    nil];
+  s = [GSTLSSession sessionWithOptions: opts
+			     direction: NO
+			     transport: (void*)(intptr_t)[fd intValue]
+				  push: pushFunc
+				  pull: pullFunc];
+  while (NO == [s handshake])
+    ;
+  [s write: &c length: 1];
+  [s read: &c length: 1];
+  [s disconnect: NO];
+  close([fd intValue]);
+  LEAVE_POOL
+}
+@end
+
+/* Makes a connection to a new server thread, with any extra options, and
+ * returns YES if the session was resumed.
+ */
+static BOOL
+connectWith(NSString *cacheKey, NSDictionary *extra, BOOL *ok)
+{
+  NSMutableDictionary	*opts;
+  GSTLSSession		*s;
+  int			sv[2];
+  char			c = 'y';
+  BOOL			resumed;
+
+  socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+  [NSThread detachNewThreadSelector: @selector(serve:)
+			   toTarget: AUTORELEASE([Server new])
+			 withObject: [NSNumber numberWithInt: sv[1]]];
+  opts = [NSMutableDictionary dictionaryWithObject: @"NO" forKey: GSTLSVerify];
+  [opts addEntriesFromDictionary: extra];
+  if (nil != cacheKey)
+    {
+      [opts setObject: cacheKey forKey: GSTLSSessionCacheKey];
+    }
+  s = [GSTLSSession sessionWithOptions: opts
+			     direction: YES
+			     transport: (void*)(intptr_t)sv[0]
+				  push: pushFunc
+				  pull: pullFunc];
+  while (NO == [s handshake])
+    ;
+  *ok = [s active];
+  resumed = [s resumed];
+  [s read: &c length: 1];	// Lets a TLS 1.3 session ticket arrive
+  [s write: &c length: 1];
+  [s disconnect: NO];
+  close(sv[0]);
+  return resumed;
+}
+
+static BOOL
+connectOnce(NSString *cacheKey, BOOL *ok)
+{
+  return connectWith(cacheKey, nil, ok);
+}
+#endif
+
+int
+main()
+{
+  START_SET("TLS session resumption")
+#if GS_USE_GNUTLS
+  BOOL	ok = NO;
+
+#ifndef HAVE_GNUTLS_X509_PRIVKEY_IMPORT2
+  testHopeful = YES;
+#endif
+  signal(SIGPIPE, SIG_IGN);
+  PASS(NO == connectOnce(@"server:1", &ok) && YES == ok,
+    "first connection performs a full handshake")
+  PASS(YES == connectOnce(@"server:1", &ok) && YES == ok,
+    "second connection with the same key resumes the session")
+  PASS(NO == connectOnce(@"server:2", &ok) && YES == ok,
+    "connection with a different key does not resume")
+  PASS(NO == connectOnce(nil, &ok) && YES == ok,
+    "connection without a key does not resume")
+  PASS(NO == connectWith(@"server:1", [NSDictionary dictionaryWithObject:
+    @"other.example" forKey: GSTLSRemoteHosts], &ok) && YES == ok,
+    "connection with different verification settings does not resume")
+  [GSTLSSession flushSessionCache];
+  PASS(NO == connectOnce(@"server:1", &ok) && YES == ok,
+    "flushing the cache stops resumption")
+#else
+  SKIP("TLS support disabled")
+#endif
+  END_SET("TLS session resumption")
+  return 0;
+}
@@ -0,0 +1,223 @@
+/*
+ * collection_operators.m - tests that -valueForKey: and the @sum, @avg,
+ * @max and @min operators of NSArray and NSSet give the same results as
+ * sending -valueForKey: to each element, whatever the mix of element
+ * classes and of scalar and object values.
+ */
+
+#import <Foundation/Foundation.h>
+#import "ObjectTesting.h"
+
+@interface Item : NSObject
+{
+@public
+  int			count;		// Read from the instance variable
+  unsigned short	small;
+  double		price;
+  NSString		*name;
+}
+- (long long) total;
+- (float) weight;
+@end
+
+@implementation Item
+- (void) dealloc
+{
+  DESTROY(name);
+  DEALLOC
+}
+- (long long) total
+{
+  return (long long)count * 1000000000LL;
+}
+- (float) weight
+{
+  return count / 4.0f;
+}
+@end
+
+/* A subclass which answers some keys itself, so must still be sent
+ * -valueForKey: by the collection.
+ */
+@interface SpecialItem : Item
+@end
+
+@implementation SpecialItem
+- (id) valueForKey: (NSString*)key
+{
+  if ([key isEqualToString: @"count"])
+    {
+      return [NSNumber numberWithInt: -count];
+    }
+  return [super valueForKey: key];
+}
+@end
+
+static Item *
+item(Class c, int count, double price, NSString *name)
+{
+  Item	*i = AUTORELEASE([c new]);
+
+  i->count = count;
+  i->small = (unsigned short)(count * 3);
+  i->price = price;
+  ASSIGN(i->name, name);
+  return i;
+}
+
+/* What the operators give when every value is fetched with -valueForKey:.
+ */
+static id
+expected(NSArray *a, NSString *op, NSString *key)
+{
+  NSEnumerator	*e = [a objectEnumerator];
+  id		o;
+  id		result = nil;
+  double	d = 0;
+
+  while ((o = [e nextObject]) != nil)
+    {
+      o = [o valueForKey: key];
+      if ([op isEqualToString: @"@max"] || [op isEqualToString: @"@min"])
+	{
+	  NSComparisonResult	replace = [op isEqualToString: @"@max"]
+	    ? NSOrderedAscending : NSOrderedDescending;
+
+	  if (result == nil || [result compare: o] == replace)
+	    {
+	      result = o;
+	    }
+	}
+      else
+	{
+	  d += [o doubleValue];
+	}
+    }
+  if ([op isEqualToString: @"@avg"])
+    {
+      return [NSNumber numberWithDouble: [a count] ? d / [a count] : 0];
+    }
+  if ([op isEqualToString: @"@sum"])
+    {
+      return [NSNumber numberWithDouble: d];
+    }
+  return result;
+}
+
+static void
+check(NSArray *a, NSString *what)
+{
+  NSArray	*keys;
+  NSArray	*ops;
+  NSSet		*s = [NSSet setWithArray: a];
+  NSUInteger	i;
+  NSUInteger	j;
+
+  keys = [NSArray arrayWithObjects:
+    @"count", @"small", @"price", @"total", @"weight", @"name", nil];
+  ops = [NSArray arrayWithObjects: @"@sum", @"@avg", @"@max", @"@min", nil];
+  for (i = 0; i < [keys count]; i++)
+    {
+      NSString	*key = [keys objectAtIndex: i];
+
+      for (j = 0; j < [ops count]; j++)
+	{
+	  NSString	*op = [ops objectAtIndex: j];
+	  NSString	*path = [NSString stringWithFormat: @"%@.%@", op, key];
+	  id		want;
+
+	  if ([key isEqualToString: @"name"] && ![op hasPrefix: @"@m"])
+	    {
+	      continue;
+	    }
+	  want = expected(a, op, key);
+	  PASS_EQUAL([a valueForKeyPath: path], want, "%s array %s",
+	    [what UTF8String], [path UTF8String]);
+	  PASS_EQUAL([s valueForKeyPath: path], want, "%s set %s",
+	    [what UTF8String], [path UTF8String]);
+	}
+    }
+}
+
+int main()
+{
+  START_SET("collection operators")
+    NSMutableArray	*a = [NSMutableArray array];
+    NSMutableArray	*mixed;
+    NSMutableArray	*values;
+    id			m;
+    int			i;
+
+    PASS_EQUAL([a valueForKeyPath: @"@sum.count"],
+      [NSNumber numberWithDouble: 0], "@sum of an empty array is zero");
+    PASS_EQUAL([a valueForKeyPath: @"@avg.count"],
+      [NSNumber numberWithDouble: 0], "@avg of an empty array is zero");
+    PASS([a valueForKeyPath: @"@max.count"] == nil,
+      "@max of an empty array is nil");
+    PASS([[NSSet set] valueForKeyPath: @"@min.count"] == nil,
+      "@min of an empty set is nil");
+
+    for (i = 0; i < 100; i++)
+      {
+	[a addObject: item([Item class], (i * 37) % 101 - 50, i * 1.25,
+	  [NSString stringWithFormat: @"item%03d", (i * 17) % 100])];
+      }
+    check(a, @"one class");
+
+    m = [a valueForKeyPath: @"@max.count"];
+    PASS([m isKindOfClass: [NSNumber class]]
+      && strcmp([m objCType], @encode(int)) == 0,
+      "@max of an int is an int NSNumber");
+    m = [a valueForKeyPath: @"@min.total"];
+    PASS_EQUAL(m, [NSNumber numberWithLongLong: -50000000000LL],
+      "@min of a long long keeps every digit");
+
+    /* Elements of several classes, including one which implements its own
+     * -valueForKey: and dictionaries which return objects.
+     */
+    mixed = [NSMutableArray array];
+    for (i = 0; i < 60; i++)
+      {
+	Class	c = (i % 3 == 0) ? [SpecialItem class] : [Item class];
+
+	[mixed addObject: item(c, i - 30, 100.0 - i, [NSString
+	  stringWithFormat: @"mixed%02d", i])];
+	if (i % 10 == 5)
+	  {
+	    [mixed addObject: [NSDictionary dictionaryWithObjectsAndKeys:
+	      [NSNumber numberWithInt: i * 2], @"count",
+	      [NSNumber numberWithInt: i], @"small",
+	      [NSNumber numberWithDouble: i / 4.0], @"price",
+	      [NSNumber numberWithLongLong: i], @"total",
+	      [NSNumber numberWithFloat: i], @"weight",
+	      @"dict", @"name",
+	      nil]];
+	  }
+      }
+    check(mixed, @"mixed classes");
+
+    /* -valueForKey: on the collection.
+     */
+    values = [NSMutableArray array];
+    for (i = 0; i < [mixed count]; i++)
+      {
+	id	v = [[mixed objectAtIndex: i] valueForKey: @"count"];
+
+	[values addObject: v == nil ? (id)[NSNull null] : v];
+      }
+    PASS_EQUAL([mixed valueForKey: @"count"], values,
+      "-[NSArray valueForKey:] matches sending it to each element");
+    PASS_EQUAL([[NSSet setWithArray: mixed] valueForKey: @"count"],
+      [NSSet setWithArray: values],
+      "-[NSSet valueForKey:] matches sending it to each element");
+
+    [a addObject: [NSDictionary dictionary]];
+    m = [a valueForKey: @"name"];
+    PASS([m count] == [a count] && [m lastObject] == [NSNull null],
+      "-[NSArray valueForKey:] substitutes NSNull for nil");
+    PASS([[[NSSet setWithArray: a] valueForKey: @"name"] count] == 100,
+      "-[NSSet valueForKey:] leaves out nil");
+  END_SET("collection operators")
+
+  return 0;
+}
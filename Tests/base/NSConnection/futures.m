@@ -0,0 +1,136 @@
+#import "Testing.h"
+#import <Foundation/Foundation.h>
+
+/* Test sending messages to a remote object asynchronously, with futures
+ * receiving the replies.
+ */
+
+@protocol Adder
+- (int) add: (int)a to: (int)b;
+- (void) fail;
+- (oneway void) ping;
+@end
+
+@interface Server : NSObject <Adder>
++ (void) serveWithPorts: (NSArray*)ports;
+@end
+
+@implementation Server
++ (void) serveWithPorts: (NSArray*)ports
+{
+  ENTER_POOL
+  NSConnection	*c;
+
+  c = [[NSConnection alloc] initWithReceivePort: [ports objectAtIndex: 0]
+				       sendPort: [ports objectAtIndex: 1]];
+  [c setRootObject: AUTORELEASE([self new])];
+  [[NSRunLoop currentRunLoop] run];
+  RELEASE(c);
+  LEAVE_POOL
+}
+- (int) add: (int)a to: (int)b
+{
+  return a + b;
+}
+- (void) fail
+{
+  [NSException raise: @"TestException" format: @"failed"];
+}
+- (oneway void) ping
+{
+}
+@end
+
+static NSInvocation *
+addInvocation(id proxy, int a, int b)
+{
+  SEL		sel = @selector(add:to:);
+  NSInvocation	*inv;
+
+  inv = [NSInvocation invocationWithMethodSignature:
+    [proxy methodSignatureForSelector: sel]];
+  [inv setSelector: sel];
+  [inv setArgument: &a atIndex: 2];
+  [inv setArgument: &b atIndex: 3];
+  return inv;
+}
+
+int
+main()
+{
+  ENTER_POOL
+  NSConnection		*conn;
+  NSDistantObject	*proxy;
+  NSMutableArray	*futures;
+  GSDistantFuture	*f;
+  NSInvocation		*inv;
+  NSPort		*port1 = [NSPort port];
+  NSPort		*port2 = [NSPort port];
+  int			i;
+  int			r;
+  BOOL			ok;
+
+  [NSThread detachNewThreadSelector: @selector(serveWithPorts:)
+			   toTarget: [Server class]
+			 withObject: [NSArray arrayWithObjects: port1, port2, nil]];
+  conn = AUTORELEASE([[NSConnection alloc] initWithReceivePort: port2
+						      sendPort: port1]);
+  [conn setReplyTimeout: 10.0];
+  proxy = [conn rootProxy];
+  [proxy setProtocolForProxy: @protocol(Adder)];
+
+  futures = [NSMutableArray array];
+  for (i = 0; i < 100; i++)
+    {
+      [futures addObject: [proxy sendInvocation: addInvocation(proxy, i, i)]];
+    }
+  PASS([futures count] == 100, "many requests can be in flight at once")
+
+  ok = YES;
+  for (i = 0; i < 100; i++)
+    {
+      f = [futures objectAtIndex: i];
+      [f waitUntilDone];
+      [[f invocation] getReturnValue: &r];
+      if (NO == [f isDone] || r != i + i)
+	{
+	  ok = NO;
+	}
+    }
+  PASS(ok, "futures receive the replies to their own requests")
+
+  inv = [NSInvocation invocationWithMethodSignature:
+    [proxy methodSignatureForSelector: @selector(fail)]];
+  [inv setSelector: @selector(fail)];
+  f = [proxy sendInvocation: inv];
+  PASS_EXCEPTION([f waitUntilDone], @"TestException",
+    "waiting raises the exception from the remote end")
+  PASS([[[f exception] name] isEqual: @"TestException"],
+    "future records the exception from the remote end")
+
+  inv = [NSInvocation invocationWithMethodSignature:
+    [proxy methodSignatureForSelector: @selector(ping)]];
+  [inv setSelector: @selector(ping)];
+  f = [proxy sendInvocation: inv];
+  PASS([f isDone], "future for a oneway message is done at once")
+
+#if __has_feature(blocks)
+  {
+    __block int	sum = 0;
+
+    f = [proxy sendInvocation: addInvocation(proxy, 20, 22)];
+    [f setCompletionHandler: ^(GSDistantFuture *done) {
+      int	v;
+
+      [[done invocation] getReturnValue: &v];
+      sum = v;
+    }];
+    [f waitUntilDone];
+    PASS(sum == 42, "completion handler is called with the reply")
+  }
+#endif
+
+  [conn invalidate];
+  LEAVE_POOL
+  return 0;
+}
@@ -56,6 +56,29 @@ int main()
   last = length;
   PASS_EQUAL([data gunzipped], ref, "gunzipped 9 matches reference");
 
+  {
+    NSMutableData       *big = [NSMutableData data];
+    NSData              *serial;
+    int                 i;
+
+    for (i = 0; i < 100; i++)
+      {
+        [big appendData: ref];
+        [big appendData: [[NSString stringWithFormat: @"%d", i]
+          dataUsingEncoding: NSASCIIStringEncoding]];
+      }
+    serial = [big gzipped: 6];
+    data = [big gzipped: 6 threads: 4];
+    PASS(YES == [data isGzipped], "We can gzip in parallel");
+    PASS_EQUAL([data gunzipped], big, "parallel gunzipped matches reference");
+    PASS([data length] < [serial length] * 11 / 10,
+      "parallel gzip compresses almost as well as serial");
+    data = [big gzipped: 6 threads: 0];
+    PASS_EQUAL([data gunzipped], big, "gzip using all processors works");
+    PASS_EQUAL([[ref gzipped: 6 threads: 4] gunzipped], ref,
+      "parallel gzip of small data works");
+  }
+
   data = [NSData data];
   PASS(NO == [data isGzipped], "An empty data is not gzipped");
 
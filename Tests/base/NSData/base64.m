@@ -138,6 +138,16 @@ int main()
   PASS_EQUAL(data, ref, "base64 decoding empty string")
   [data release];
 
+  data = [NSMutableData dataWithLength: 48];
+  strEnc = [data base64EncodedStringWithOptions:
+    NSDataBase64Encoding64CharacterLineLength];
+  PASS([strEnc length] == 64, "no line ending after a final full line")
+  data = [NSMutableData dataWithLength: 47];
+  strEnc = [data base64EncodedStringWithOptions:
+    NSDataBase64Encoding64CharacterLineLength];
+  PASS([strEnc hasSuffix: @"="] && [strEnc length] == 64,
+    "padding is kept at the end of a full line")
+
   [arp release]; arp = nil;
   return 0;
 }
@@ -0,0 +1,153 @@
+/*
+ * iso8601fast.m - test the fixed layout formatting and parsing of
+ * NSISO8601DateFormatter against the equivalent NSDateFormatter.
+ */
+
+#import <Foundation/Foundation.h>
+#import "Testing.h"
+
+#if	defined(GS_USE_ICU)
+#define	IS_SUPPORTED	GS_USE_ICU
+#else
+#define	IS_SUPPORTED	0
+#endif
+
+int
+main(int argc, char *argv[])
+{
+  ENTER_POOL
+  NSISO8601DateFormatter	*iso;
+  NSDateFormatter		*ref;
+  NSArray			*zones;
+  NSMutableArray		*dates;
+  NSArray			*a;
+  NSDate			*d;
+  BOOL				same;
+  BOOL				back;
+  NSUInteger			i;
+
+  START_SET("NSISO8601DateFormatter fixed layouts")
+  if (!IS_SUPPORTED)
+    SKIP("NSISO8601DateFormatter not supported\nThe ICU library was not available when GNUstep-base was built")
+
+  iso = AUTORELEASE([NSISO8601DateFormatter new]);
+  ref = AUTORELEASE([NSDateFormatter new]);
+  zones = [NSArray arrayWithObjects:
+    [NSTimeZone timeZoneForSecondsFromGMT: 0],
+    [NSTimeZone timeZoneForSecondsFromGMT: -(5 * 3600 + 30 * 60)],
+    [NSTimeZone timeZoneWithName: @"Europe/London"],
+    [NSTimeZone timeZoneWithName: @"America/New_York"],
+    [NSTimeZone timeZoneWithName: @"Australia/Adelaide"],
+    nil];
+  dates = [NSMutableArray array];
+  for (i = 0; i < 500; i++)
+    {
+      /* Spread over 1950 to 2100, with fractional seconds.
+       */
+      [dates addObject: [NSDate dateWithTimeIntervalSince1970:
+	-631152000.0 + i * 9467280.123]];
+    }
+
+  [ref setDateFormat: @"yyyy-MM-dd'T'HH:mm:ss.SSSZZZZZ"];
+  [iso setFormatOptions: NSISO8601DateFormatWithInternetDateTime
+    | NSISO8601DateFormatWithFractionalSeconds];
+  same = YES;
+  back = YES;
+  GS_FOR_IN(NSTimeZone*, tz, zones)
+    [ref setTimeZone: tz];
+    [iso setTimeZone: tz];
+    for (i = 0; i < [dates count]; i++)
+      {
+	NSString	*s = [iso stringFromDate: [dates objectAtIndex: i]];
+
+	if (NO == [s isEqual: [ref stringFromDate: [dates objectAtIndex: i]]])
+	  {
+	    same = NO;
+	  }
+	d = [iso dateFromString: s];
+	if (NO == [[ref dateFromString: s] isEqual: d])
+	  {
+	    back = NO;
+	  }
+      }
+  GS_END_FOR(zones)
+  PASS(same, "internet date time matches the date formatter")
+  PASS(back, "internet date time parses as the date formatter does")
+
+  [ref setDateFormat: @"yyyyMMdd HHmmssZZZ"];
+  [iso setFormatOptions: NSISO8601DateFormatWithYear
+    | NSISO8601DateFormatWithMonth | NSISO8601DateFormatWithDay
+    | NSISO8601DateFormatWithSpaceBetweenDateAndTime
+    | NSISO8601DateFormatWithTime | NSISO8601DateFormatWithTimeZone];
+  same = YES;
+  back = YES;
+  GS_FOR_IN(NSTimeZone*, tz, zones)
+    [ref setTimeZone: tz];
+    [iso setTimeZone: tz];
+    for (i = 0; i < [dates count]; i++)
+      {
+	NSString	*s = [iso stringFromDate: [dates objectAtIndex: i]];
+
+	if (NO == [s isEqual: [ref stringFromDate: [dates objectAtIndex: i]]])
+	  {
+	    same = NO;
+	  }
+	d = [iso dateFromString: s];
+	if (NO == [[ref dateFromString: s] isEqual: d])
+	  {
+	    back = NO;
+	  }
+      }
+  GS_END_FOR(zones)
+  PASS(same, "basic format matches the date formatter")
+  PASS(back, "basic format parses as the date formatter does")
+
+  [ref setDateFormat: @"yyyy-MM-dd'T'HH:mm:ss"];
+  [iso setFormatOptions: NSISO8601DateFormatWithFullDate
+    | NSISO8601DateFormatWithTime | NSISO8601DateFormatWithColonSeparatorInTime];
+  same = YES;
+  GS_FOR_IN(NSTimeZone*, tz, zones)
+    [ref setTimeZone: tz];
+    [iso setTimeZone: tz];
+    for (i = 0; i < [dates count]; i++)
+      {
+	NSString	*s = [ref stringFromDate: [dates objectAtIndex: i]];
+
+	if (NO == [[iso dateFromString: s] isEqual: [ref dateFromString: s]])
+	  {
+	    same = NO;
+	  }
+      }
+  GS_END_FOR(zones)
+  PASS(same, "local times without a zone parse as the date formatter does")
+
+  [iso setTimeZone: [NSTimeZone timeZoneForSecondsFromGMT: 0]];
+  [iso setFormatOptions: NSISO8601DateFormatWithInternetDateTime];
+  d = [iso dateFromString: @"2024-02-29T12:00:00+01:00"];
+  PASS_EQUAL([iso stringFromDate: d], @"2024-02-29T11:00:00Z",
+    "a leap day with an offset is parsed")
+  PASS([iso dateFromString: @"2023-02-29T12:00:00Z"]
+    == [ref dateFromString: @"2023-02-29T12:00:00Z"]
+    || [[iso dateFromString: @"2023-02-29T12:00:00Z"]
+      isEqual: [ref dateFromString: @"2023-02-29T12:00:00Z"]],
+    "an invalid day is handled as the date formatter does")
+  PASS([iso dateFromString: @"not a date"] == nil,
+    "a string which is not a date is not parsed")
+
+  a = [iso stringsFromDates: [NSArray arrayWithObjects:
+    [NSDate dateWithTimeIntervalSince1970: 0],
+    [NSDate dateWithTimeIntervalSince1970: 86400], nil]];
+  PASS_EQUAL(a, ([NSArray arrayWithObjects:
+    @"1970-01-01T00:00:00Z", @"1970-01-02T00:00:00Z", nil]),
+    "-stringsFromDates: formats each date")
+  a = [iso datesFromStrings: [NSArray arrayWithObjects:
+    @"1970-01-01T00:00:00Z", @"garbage", nil]];
+  PASS([a count] == 2
+    && [[a objectAtIndex: 0] isEqual: [NSDate dateWithTimeIntervalSince1970: 0]]
+    && [a objectAtIndex: 1] == [NSNull null],
+    "-datesFromStrings: parses each string and marks failures")
+
+  END_SET("NSISO8601DateFormatter fixed layouts")
+  LEAVE_POOL
+  return 0;
+}
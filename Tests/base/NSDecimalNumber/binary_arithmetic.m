@@ -0,0 +1,143 @@
+/*
+ * binary_arithmetic.m - tests for the binary integer arithmetic used by
+ * the NSDecimal functions where results are exact, and for the batch
+ * functions NSDecimalSum() and NSDecimalDotProduct().
+ *
+ * Every result is checked against the same operation done step by step,
+ * so these also hold when GNUSTEP_DECIMAL_DIGITS=YES forces the digit by
+ * digit code.
+ */
+
+#import <Foundation/Foundation.h>
+#import <Foundation/NSDecimal.h>
+#import "ObjectTesting.h"
+
+static NSString *
+dstr(NSDecimal d)
+{
+  return NSDecimalString(&d, nil);
+}
+
+static NSDecimal
+dfs(const char *s)
+{
+  NSDecimal d;
+
+  NSDecimalFromString(&d, [NSString stringWithUTF8String: s], nil);
+  return d;
+}
+
+int main(void)
+{
+  START_SET("exact arithmetic")
+    NSDecimal		a, b, r;
+    NSCalculationError	e;
+
+    a = dfs("19.99"); b = dfs("0.01");
+    NSDecimalAdd(&r, &a, &b, NSRoundPlain);
+    PASS_EQUAL(dstr(r), @"20", "trailing zeros of a sum are removed");
+    PASS(r.exponent == 1 && r.length == 1, "a sum is compacted");
+
+    a = dfs("123456789012345678"); b = dfs("0.000000000000000001");
+    NSDecimalAdd(&r, &a, &b, NSRoundPlain);
+    PASS_EQUAL(dstr(r), @"123456789012345678.000000000000000001",
+      "a sum wider than 64 bits is exact");
+
+    a = dfs("1.25"); b = dfs("3.5");
+    NSDecimalSubtract(&r, &a, &b, NSRoundPlain);
+    PASS_EQUAL(dstr(r), @"-2.25", "subtraction changes sign");
+    NSDecimalSubtract(&r, &a, &a, NSRoundPlain);
+    PASS(NSDecimalIsNotANumber(&r) == NO && r.length == 0,
+      "a number minus itself is zero");
+
+    a = dfs("12345678901234567890"); b = dfs("98765432109876543");
+    e = NSDecimalMultiply(&r, &a, &b, NSRoundPlain);
+    PASS(e == NSCalculationNoError, "a 37 digit product is exact");
+    PASS_EQUAL(dstr(r), @"1219326311370217949644871231852004270",
+      "a 37 digit product has every digit");
+
+    a = dfs("-0.5"); b = dfs("0.25");
+    NSDecimalMultiply(&r, &a, &b, NSRoundPlain);
+    PASS_EQUAL(dstr(r), @"-0.125", "a product has the right sign and scale");
+  END_SET("exact arithmetic")
+
+  START_SET("division")
+    NSDecimal		a, b, r, x;
+
+    a = dfs("1"); b = dfs("8");
+    NSDecimalDivide(&r, &a, &b, NSRoundPlain);
+    PASS_EQUAL(dstr(r), @"0.125", "1 / 8 terminates");
+
+    a = dfs("21"); b = dfs("0.6");
+    NSDecimalDivide(&r, &a, &b, NSRoundPlain);
+    PASS_EQUAL(dstr(r), @"35", "a divisor with other factors may divide exactly");
+
+    a = dfs("9.99"); b = dfs("37");
+    NSDecimalDivide(&r, &a, &b, NSRoundPlain);
+    PASS_EQUAL(dstr(r), @"0.27", "division by a factor of the dividend is exact");
+
+    a = dfs("1"); b = dfs("3");
+    NSDecimalDivide(&r, &a, &b, NSRoundPlain);
+    NSDecimalMultiply(&x, &r, &b, NSRoundPlain);
+    PASS(NSDecimalCompare(&x, &a) == NSOrderedAscending,
+      "1 / 3 is rounded");
+    PASS([dstr(r) hasPrefix: @"0.3333333333333333"],
+      "1 / 3 is calculated to many digits");
+  END_SET("division")
+
+  START_SET("batch functions")
+    NSDecimal		values[100];
+    NSDecimal		prices[100];
+    NSDecimal		sum, dot, step, t;
+    NSCalculationError	e;
+    int			i;
+
+    for (i = 0; i < 100; i++)
+      {
+	NSDecimalFromComponents(&values[i], i * 37 + 1, -2, i % 3 == 0);
+	NSDecimalFromComponents(&prices[i], 1999 + i, -2, NO);
+      }
+
+    NSDecimalSum(&sum, values, 0, NSRoundPlain);
+    PASS(sum.length == 0 && sum.validNumber, "the sum of nothing is zero");
+
+    step = values[0];
+    for (i = 1; i < 100; i++)
+      {
+	NSDecimalAdd(&step, &step, &values[i], NSRoundPlain);
+      }
+    e = NSDecimalSum(&sum, values, 100, NSRoundPlain);
+    PASS(e == NSCalculationNoError, "NSDecimalSum reports no error");
+    PASS(NSDecimalCompare(&sum, &step) == NSOrderedSame,
+      "NSDecimalSum matches repeated NSDecimalAdd");
+    PASS_EQUAL(dstr(sum), dstr(step), "NSDecimalSum has the same form");
+
+    NSDecimalMultiply(&step, &values[0], &prices[0], NSRoundPlain);
+    for (i = 1; i < 100; i++)
+      {
+	NSDecimalMultiply(&t, &values[i], &prices[i], NSRoundPlain);
+	NSDecimalAdd(&step, &step, &t, NSRoundPlain);
+      }
+    e = NSDecimalDotProduct(&dot, values, prices, 100, NSRoundPlain);
+    PASS(e == NSCalculationNoError, "NSDecimalDotProduct reports no error");
+    PASS_EQUAL(dstr(dot), dstr(step),
+      "NSDecimalDotProduct matches multiplying and adding");
+
+    /* Terms too large to add exactly fall back to rounding.
+     */
+    values[0] = dfs("99999999999999999999999999999999999999");
+    values[1] = dfs("0.5");
+    values[2] = dfs("1");
+    step = values[0];
+    NSDecimalAdd(&step, &step, &values[1], NSRoundPlain);
+    NSDecimalAdd(&step, &step, &values[2], NSRoundPlain);
+    NSDecimalSum(&sum, values, 3, NSRoundPlain);
+    PASS_EQUAL(dstr(sum), dstr(step), "an inexact sum is rounded as NSDecimalAdd does");
+
+    values[1] = dfs("abc");
+    NSDecimalSum(&sum, values, 3, NSRoundPlain);
+    PASS(NSDecimalIsNotANumber(&sum), "a sum including NaN is NaN");
+  END_SET("batch functions")
+
+  return 0;
+}
@@ -0,0 +1,86 @@
+#import <Foundation/Foundation.h>
+#import "ObjectTesting.h"
+
+/* Objects which are not (or are no longer) observed must keep working
+ * when observed instances of the same class have observers, and must
+ * have no observation information.
+ */
+
+@interface Item : NSObject
+{
+@public
+  NSInteger	value;
+}
+- (void) setValue: (NSInteger)v;
+@end
+
+@implementation Item
+- (void) setValue: (NSInteger)v
+{
+  value = v;
+}
+@end
+
+@interface Watcher : NSObject
+{
+@public
+  NSInteger	calls;
+}
+@end
+
+@implementation Watcher
+- (void) observeValueForKeyPath: (NSString*)path
+		       ofObject: (id)object
+			 change: (NSDictionary*)change
+			context: (void*)context
+{
+  calls++;
+}
+@end
+
+int
+main(int argc, char *argv[])
+{
+  ENTER_POOL
+  Watcher	*w = AUTORELEASE([Watcher new]);
+  Item		*a = AUTORELEASE([Item new]);
+  Item		*b = AUTORELEASE([Item new]);
+  int		i;
+
+  PASS([a observationInfo] == 0, "new object has no observation info")
+
+  [a addObserver: w forKeyPath: @"value" options: 0 context: 0];
+  PASS([a observationInfo] != 0, "observed object has observation info")
+  PASS([b observationInfo] == 0,
+    "unobserved instance of an observed class has no observation info")
+
+  for (i = 0; i < 10; i++)
+    {
+      [a setValue: i];
+      [b setValue: i];
+    }
+  PASS(w->calls == 10, "only the observed instance sends notifications")
+  PASS(a->value == 9 && b->value == 9, "setters work on both instances")
+
+  [b willChangeValueForKey: @"value"];
+  [b didChangeValueForKey: @"value"];
+  PASS(w->calls == 10, "manual notification of unobserved object is ignored")
+
+  [a removeObserver: w forKeyPath: @"value"];
+  PASS([a observationInfo] == 0, "observation info is gone after removal")
+  [a setValue: 42];
+  PASS(w->calls == 10 && a->value == 42,
+    "setter works without notifying once the observer is removed")
+
+  for (i = 0; i < 3; i++)
+    {
+      [a addObserver: w forKeyPath: @"value" options: 0 context: 0];
+      [a setValue: i];
+      [a removeObserver: w forKeyPath: @"value"];
+      [a setValue: i];
+    }
+  PASS(w->calls == 13, "repeated observation cycles notify correctly")
+
+  LEAVE_POOL
+  return 0;
+}
@@ -0,0 +1,143 @@
+#import <Foundation/Foundation.h>
+#import "ObjectTesting.h"
+
+/* Several threads copying the same unchanged mutable collections at once.
+ * Copying is read-only, so this must be safe, and since a copy of a large
+ * collection shares its storage, the threads must all get the same copy.
+ * This covers mutable dictionaries and sets as well as arrays.
+ */
+
+#define	THREADS		4
+#define	COLLECTIONS	200
+
+static NSArray		*originals = nil;
+static NSMutableArray	*results[THREADS];
+static NSCondition	*finished = nil;
+static int		 running = 0;
+static volatile BOOL	 go = NO;
+
+@interface      Copier : NSObject
++ (void) copyAll: (NSNumber*)slot;
+@end
+
+@implementation Copier
++ (void) copyAll: (NSNumber*)slot
+{
+  NSAutoreleasePool	*pool = [NSAutoreleasePool new];
+  NSMutableArray	*a = results[[slot intValue]];
+  NSUInteger		 count = [originals count];
+  NSUInteger		 i;
+
+  while (NO == go)
+    ;
+  for (i = 0; i < count; i++)
+    {
+      id	c = [[originals objectAtIndex: i] copy];
+
+      [a addObject: c];
+      [c release];
+    }
+  [pool release];
+
+  [finished lock];
+  running--;
+  [finished signal];
+  [finished unlock];
+}
+@end
+
+static void
+copyConcurrently(NSArray *mutables, const char *kind)
+{
+  NSUInteger	i;
+  int		t;
+  BOOL		same = YES;
+  BOOL		equal = YES;
+
+  originals = mutables;
+  go = NO;
+  running = THREADS;
+  for (t = 0; t < THREADS; t++)
+    {
+      results[t] = [NSMutableArray new];
+      [NSThread detachNewThreadSelector: @selector(copyAll:)
+			       toTarget: [Copier class]
+			     withObject: [NSNumber numberWithInt: t]];
+    }
+  go = YES;
+  [finished lock];
+  while (running > 0)
+    {
+      [finished wait];
+    }
+  [finished unlock];
+
+  for (i = 0; i < [mutables count]; i++)
+    {
+      id	c = [results[0] objectAtIndex: i];
+
+      if (NO == [c isEqual: [mutables objectAtIndex: i]])
+	{
+	  equal = NO;
+	}
+      for (t = 1; t < THREADS; t++)
+	{
+	  if ([results[t] objectAtIndex: i] != c)
+	    {
+	      same = NO;
+	    }
+	}
+    }
+  PASS(equal, "%s: concurrent copies have the contents", kind)
+  PASS(same, "%s: concurrent copies of one collection are the same object",
+    kind)
+
+  /* Releasing everything would over-release the contents or free the
+   * storage twice if more than one copy had taken it.
+   */
+  for (t = 0; t < THREADS; t++)
+    {
+      DESTROY(results[t]);
+    }
+  PASS_RUNS([mutables makeObjectsPerformSelector: @selector(removeAllObjects)],
+    "%s: collections can be changed after concurrent copies", kind)
+}
+
+int
+main(int argc, char **argv)
+{
+  NSAutoreleasePool	*arp = [NSAutoreleasePool new];
+  NSMutableArray	*arrays = [NSMutableArray array];
+  NSMutableArray	*dictionaries = [NSMutableArray array];
+  NSMutableArray	*sets = [NSMutableArray array];
+  int			 i;
+  int			 j;
+
+  finished = [NSCondition new];
+  for (i = 0; i < COLLECTIONS; i++)
+    {
+      NSMutableArray		*a = [NSMutableArray array];
+      NSMutableDictionary	*d = [NSMutableDictionary dictionary];
+      NSMutableSet		*s = [NSMutableSet set];
+
+      for (j = 0; j < 50; j++)
+	{
+	  NSString	*o = [NSString stringWithFormat: @"%d-%d", i, j];
+
+	  [a addObject: o];
+	  [d setObject: o forKey: o];
+	  [s addObject: o];
+	}
+      [arrays addObject: a];
+      [dictionaries addObject: d];
+      [sets addObject: s];
+    }
+
+  copyConcurrently(arrays, "arrays");
+  copyConcurrently(dictionaries, "dictionaries");
+  copyConcurrently(sets, "sets");
+
+  DESTROY(finished);
+  [arp release]; arp = nil;
+  return 0;
+}
@@ -0,0 +1,62 @@
+#import "ObjectTesting.h"
+#import <Foundation/Foundation.h>
+
+int main()
+{
+  NSAutoreleasePool	*arp = [NSAutoreleasePool new];
+  NSMutableArray	*m = [NSMutableArray array];
+  NSArray		*c1;
+  NSArray		*c2;
+  NSArray		*ref;
+  unsigned		i;
+
+  for (i = 0; i < 100; i++)
+    {
+      [m addObject: [NSString stringWithFormat: @"%u", i]];
+    }
+  ref = [NSArray arrayWithArray: m];
+
+  c1 = AUTORELEASE([m copy]);
+  PASS_EQUAL(c1, ref, "a copy has the contents");
+  PASS(NO == [c1 isKindOfClass: [NSMutableArray class]],
+    "a copy is immutable");
+  c2 = AUTORELEASE([m copy]);
+  PASS(c1 == c2, "copies of an unchanged array are the same object");
+
+  [m addObject: @"new"];
+  PASS_EQUAL(c1, ref, "adding to the array leaves a copy unchanged");
+  PASS([m count] == 101 && [[m lastObject] isEqual: @"new"],
+    "the array is changed");
+  c2 = AUTORELEASE([m copy]);
+  PASS(c1 != c2 && [c2 count] == 101, "a later copy has the change");
+
+  [m replaceObjectAtIndex: 0 withObject: @"first"];
+  [m removeObjectAtIndex: 1];
+  [m insertObject: @"second" atIndex: 1];
+  [m exchangeObjectAtIndex: 2 withObjectAtIndex: 3];
+  [m removeLastObject];
+  [m sortUsingSelector: @selector(compare:)];
+  PASS([c2 count] == 101 && [[c2 objectAtIndex: 0] isEqual: @"0"]
+    && [[c2 lastObject] isEqual: @"new"],
+    "changing the array leaves a copy unchanged");
+
+  c1 = AUTORELEASE([m copy]);
+  ref = [NSArray arrayWithArray: m];
+  [m removeAllObjects];
+  PASS([m count] == 0 && [c1 isEqual: ref],
+    "-removeAllObjects leaves a copy unchanged");
+
+  m = [[NSMutableArray alloc] initWithArray: ref];
+  c1 = [m copy];
+  RELEASE(m);
+  PASS_EQUAL(c1, ref, "a copy outlives the array");
+  RELEASE(c1);
+
+  m = [NSMutableArray arrayWithArray: ref];
+  c1 = AUTORELEASE([m copy]);
+  [m makeImmutable];
+  PASS_EQUAL(m, c1, "-makeImmutable works after a copy");
+
+  [arp release]; arp = nil;
+  return 0;
+}
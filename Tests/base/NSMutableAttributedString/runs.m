@@ -0,0 +1,141 @@
+#import "Testing.h"
+#import <Foundation/Foundation.h>
+
+/* get rid of compiler warnings */
+@interface NSMutableAttributedString(evil)
+-(void) _sanity;
+@end
+#if	!defined(GNUSTEP_BASE_LIBRARY)
+@implementation NSMutableAttributedString(evil)
+- (void) _sanity
+{
+}
+@end
+#endif
+
+/* Checks every character of the attributed string against a model holding
+ * the attributes of each character, and checks that the effective range
+ * reported covers only characters with those attributes.
+ */
+static BOOL
+matches(NSAttributedString *s, NSArray *model)
+{
+  NSUInteger	len = [model count];
+  NSUInteger	i = 0;
+
+  if ([s length] != len)
+    {
+      return NO;
+    }
+  while (i < len)
+    {
+      NSRange		r;
+      NSDictionary	*d = [s attributesAtIndex: i effectiveRange: &r];
+      NSUInteger	j;
+
+      if (r.location > i || NSMaxRange(r) <= i || NSMaxRange(r) > len)
+	{
+	  return NO;
+	}
+      for (j = r.location; j < NSMaxRange(r); j++)
+	{
+	  if (NO == [d isEqual: [model objectAtIndex: j]])
+	    {
+	      return NO;
+	    }
+	}
+      i = NSMaxRange(r);
+    }
+  return YES;
+}
+
+int main()
+{
+  ENTER_POOL
+  NSMutableAttributedString	*s;
+  NSMutableArray		*model;
+  NSMutableArray		*attrs;
+  NSAttributedString		*copy;
+  NSUInteger			i;
+  BOOL				ok = YES;
+
+  attrs = [NSMutableArray array];
+  for (i = 0; i < 5; i++)
+    {
+      [attrs addObject: [NSDictionary dictionaryWithObject:
+	[NSNumber numberWithUnsignedInteger: i] forKey: @"Key"]];
+    }
+  s = AUTORELEASE([[NSMutableAttributedString alloc]
+    initWithString: @"0123456789" attributes: [attrs objectAtIndex: 0]]);
+  model = [NSMutableArray array];
+  for (i = 0; i < 10; i++)
+    {
+      [model addObject: [attrs objectAtIndex: 0]];
+    }
+
+  srandom(42);
+  for (i = 0; i < 2000 && YES == ok; i++)
+    {
+      NSUInteger	len = [model count];
+      NSUInteger	loc = (len > 0) ? random() % (len + 1) : 0;
+      NSUInteger	n = (len > loc) ? random() % (len - loc + 1) : 0;
+      NSDictionary	*d = [attrs objectAtIndex: random() % 5];
+
+      if (random() % 2 && n > 0)
+	{
+	  NSUInteger	j;
+
+	  [s setAttributes: d range: NSMakeRange(loc, n)];
+	  for (j = loc; j < loc + n; j++)
+	    {
+	      [model replaceObjectAtIndex: j withObject: d];
+	    }
+	}
+      else
+	{
+	  NSUInteger	add = (len > 200) ? random() % 4 : random() % 20;
+	  NSUInteger	j;
+
+	  if (len > 0)
+	    {
+	      d = [model objectAtIndex:
+		(n == 0 && loc > 0) ? loc - 1 : (loc < len ? loc : len - 1)];
+	    }
+	  else
+	    {
+	      d = [s attributesAtIndex: 0 effectiveRange: NULL];
+	    }
+	  [s replaceCharactersInRange: NSMakeRange(loc, n)
+			   withString: [@"abcdefghijklmnopqrst"
+					 substringToIndex: add]];
+	  [model removeObjectsInRange: NSMakeRange(loc, n)];
+	  for (j = 0; j < add; j++)
+	    {
+	      [model insertObject: d atIndex: loc];
+	    }
+	}
+      [s _sanity];
+      ok = matches(s, model);
+    }
+  PASS(ok, "random edits give the same attributes as a simple model")
+
+  copy = AUTORELEASE([s copy]);
+  PASS(matches(copy, model), "an immutable copy has the same attributes")
+
+  s = AUTORELEASE([[NSMutableAttributedString alloc] initWithString: @""]);
+  for (i = 0; i < 10000; i++)
+    {
+      [s appendAttributedString: AUTORELEASE([[NSAttributedString alloc]
+	initWithString: @"xy" attributes: [attrs objectAtIndex: i % 2]])];
+    }
+  [s _sanity];
+  PASS([s length] == 20000, "appending many runs gives the right length")
+  PASS_EQUAL([s attributesAtIndex: 19999 effectiveRange: NULL],
+    [attrs objectAtIndex: 1], "appended runs have the right attributes")
+  [s deleteCharactersInRange: NSMakeRange(0, 20000)];
+  [s _sanity];
+  PASS([s length] == 0, "deleting all characters leaves an empty string")
+
+  LEAVE_POOL
+  return 0;
+}
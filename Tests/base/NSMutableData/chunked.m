@@ -0,0 +1,80 @@
+#import "ObjectTesting.h"
+#import <Foundation/Foundation.h>
+
+int main()
+{
+  NSAutoreleasePool	*arp = [NSAutoreleasePool new];
+  NSMutableData		*ref = [NSMutableData data];
+  NSMutableData		*d;
+  NSFileHandle		*fh;
+  NSString		*path;
+  NSData		*c;
+  char			buf[100];
+  unsigned		i;
+
+  d = [NSMutableData chunkedDataWithCapacity: 16];
+  PASS(d != nil && [d length] == 0, "+chunkedDataWithCapacity: works");
+
+  for (i = 0; i < 20000; i++)
+    {
+      unsigned	len = i % 97;
+      unsigned	j;
+
+      for (j = 0; j < len; j++)
+	{
+	  buf[j] = (char)(i + j);
+	}
+      [d appendBytes: buf length: len];
+      [ref appendBytes: buf length: len];
+    }
+  PASS([d length] == [ref length], "appending keeps the length");
+  PASS([d capacity] >= [d length], "capacity covers the length");
+
+  [d getBytes: buf range: NSMakeRange(12345, 100)];
+  PASS(memcmp(buf, [ref bytes] + 12345, 100) == 0,
+    "-getBytes:range: reads across chunks");
+
+  c = AUTORELEASE([d copy]);
+  PASS_EQUAL(c, ref, "a copy has the appended contents");
+  PASS([d isEqualToData: ref], "flattened contents are correct");
+
+  [d appendData: ref];
+  [ref appendData: ref];
+  PASS([d isEqualToData: ref], "appending after flattening works");
+
+  [d setLength: 1000];
+  [ref setLength: 1000];
+  [d setLength: 2000];
+  [ref setLength: 2000];
+  PASS([d isEqualToData: ref], "-setLength: truncates and extends");
+
+  [d replaceBytesInRange: NSMakeRange(10, 5) withBytes: "abc" length: 3];
+  [ref replaceBytesInRange: NSMakeRange(10, 5) withBytes: "abc" length: 3];
+  PASS([d isEqualToData: ref], "bytes can be replaced");
+
+  [d appendBytes: [d bytes] length: 100];
+  [ref appendBytes: [ref bytes] length: 100];
+  PASS([d isEqualToData: ref], "data can be appended to itself");
+
+  path = [NSTemporaryDirectory()
+    stringByAppendingPathComponent: @"chunked.dat"];
+  [[NSFileManager defaultManager] createFileAtPath: path
+					  contents: nil
+					attributes: nil];
+  fh = [NSFileHandle fileHandleForWritingAtPath: path];
+  d = [NSMutableData chunkedDataWithCapacity: 0];
+  for (i = 0; i < 100000; i++)
+    {
+      [d appendBytes: &i length: sizeof(i)];
+    }
+  [fh writeData: d];
+  [fh closeFile];
+  c = [NSData dataWithContentsOfFile: path];
+  PASS([c length] == [d length]
+    && memcmp([c bytes], [d bytes], [c length]) == 0,
+    "chunked data is written to a file handle");
+  [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+
+  [arp release]; arp = nil;
+  return 0;
+}
@@ -0,0 +1,59 @@
+#import "ObjectTesting.h"
+#import <Foundation/Foundation.h>
+
+int main()
+{
+  NSAutoreleasePool	*arp = [NSAutoreleasePool new];
+  NSMutableDictionary	*m = [NSMutableDictionary dictionary];
+  NSDictionary		*c1;
+  NSDictionary		*c2;
+  NSDictionary		*ref;
+  NSEnumerator		*e;
+  unsigned		i;
+
+  for (i = 0; i < 100; i++)
+    {
+      [m setObject: [NSNumber numberWithUnsignedInt: i]
+	    forKey: [NSString stringWithFormat: @"%u", i]];
+    }
+  ref = [NSDictionary dictionaryWithDictionary: m];
+
+  c1 = AUTORELEASE([m copy]);
+  PASS_EQUAL(c1, ref, "a copy has the contents");
+  PASS(NO == [c1 isKindOfClass: [NSMutableDictionary class]],
+    "a copy is immutable");
+  c2 = AUTORELEASE([m copy]);
+  PASS(c1 == c2, "copies of an unchanged dictionary are the same object");
+
+  e = [m keyEnumerator];
+  [m setObject: @"new" forKey: @"new"];
+  [m setObject: @"zero" forKey: @"0"];
+  [m removeObjectForKey: @"1"];
+  PASS_EQUAL(c1, ref, "changing the dictionary leaves a copy unchanged");
+  PASS([m count] == 100 && [[m objectForKey: @"0"] isEqual: @"zero"]
+    && [m objectForKey: @"1"] == nil, "the dictionary is changed");
+  PASS([[e allObjects] count] == 100,
+    "an enumerator sees the contents from when it was created");
+  c2 = AUTORELEASE([m copy]);
+  PASS(c1 != c2 && [[c2 objectForKey: @"new"] isEqual: @"new"],
+    "a later copy has the change");
+
+  ref = [NSDictionary dictionaryWithDictionary: m];
+  [m removeAllObjects];
+  PASS([m count] == 0 && [c2 isEqual: ref],
+    "-removeAllObjects leaves a copy unchanged");
+
+  m = [[NSMutableDictionary alloc] initWithDictionary: ref];
+  c1 = [m copy];
+  RELEASE(m);
+  PASS_EQUAL(c1, ref, "a copy outlives the dictionary");
+  RELEASE(c1);
+
+  m = [NSMutableDictionary dictionaryWithDictionary: ref];
+  c1 = AUTORELEASE([m copy]);
+  [m makeImmutable];
+  PASS_EQUAL(m, c1, "-makeImmutable works after a copy");
+
+  [arp release]; arp = nil;
+  return 0;
+}
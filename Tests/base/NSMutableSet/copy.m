@@ -0,0 +1,64 @@
+#import "ObjectTesting.h"
+#import <Foundation/Foundation.h>
+
+int main()
+{
+  NSAutoreleasePool	*arp = [NSAutoreleasePool new];
+  NSMutableSet		*m = [NSMutableSet set];
+  NSSet			*c1;
+  NSSet			*c2;
+  NSSet			*ref;
+  NSEnumerator		*e;
+  unsigned		i;
+
+  for (i = 0; i < 100; i++)
+    {
+      [m addObject: [NSString stringWithFormat: @"%u", i]];
+    }
+  ref = [NSSet setWithSet: m];
+
+  c1 = AUTORELEASE([m copy]);
+  PASS_EQUAL(c1, ref, "a copy has the contents");
+  PASS(NO == [c1 isKindOfClass: [NSMutableSet class]],
+    "a copy is immutable");
+  c2 = AUTORELEASE([m copy]);
+  PASS(c1 == c2, "copies of an unchanged set are the same object");
+
+  e = [m objectEnumerator];
+  [m addObject: @"new"];
+  [m removeObject: @"0"];
+  PASS_EQUAL(c1, ref, "changing the set leaves a copy unchanged");
+  PASS([m count] == 100 && [m member: @"new"] != nil
+    && [m member: @"0"] == nil, "the set is changed");
+  PASS([[e allObjects] count] == 100,
+    "an enumerator sees the contents from when it was created");
+
+  c2 = AUTORELEASE([m copy]);
+  [m minusSet: c2];
+  PASS([m count] == 0 && [c2 count] == 100,
+    "-minusSet: with a copy leaves the copy unchanged");
+  [m unionSet: c1];
+  c2 = AUTORELEASE([m copy]);
+  [m intersectSet: [NSSet setWithObject: @"5"]];
+  PASS([m count] == 1 && [c2 isEqual: ref],
+    "-intersectSet: leaves a copy unchanged");
+
+  c2 = AUTORELEASE([m copy]);
+  [m removeAllObjects];
+  PASS([m count] == 0 && [c2 count] == 1,
+    "-removeAllObjects leaves a copy unchanged");
+
+  m = [[NSMutableSet alloc] initWithSet: ref];
+  c1 = [m copy];
+  RELEASE(m);
+  PASS_EQUAL(c1, ref, "a copy outlives the set");
+  RELEASE(c1);
+
+  m = [NSMutableSet setWithSet: ref];
+  c1 = AUTORELEASE([m copy]);
+  [m makeImmutable];
+  PASS_EQUAL(m, c1, "-makeImmutable works after a copy");
+
+  [arp release]; arp = nil;
+  return 0;
+}
@@ -0,0 +1,63 @@
+#import "ObjectTesting.h"
+#import <Foundation/Foundation.h>
+
+int main()
+{
+  NSAutoreleasePool	*arp = [NSAutoreleasePool new];
+  NSMutableString	*ref = [NSMutableString string];
+  NSMutableString	*s;
+  NSString		*pieces[4];
+  NSData		*d;
+  unsigned		i;
+
+  s = [NSMutableString chunkedStringWithCapacity: 0];
+  PASS(s != nil && [s length] == 0, "+chunkedStringWithCapacity: works");
+
+  pieces[0] = @"<item>";
+  pieces[1] = [NSString stringWithFormat: @"%C%C", (unichar)0xe9,
+    (unichar)0x20ac];
+  pieces[2] = [NSString stringWithFormat: @"%C%C", (unichar)0xd83d,
+    (unichar)0xde00];
+  pieces[3] = [NSMutableString stringWithString: @"</item>\n"];
+  for (i = 0; i < 5000; i++)
+    {
+      [s appendString: pieces[i % 4]];
+      [ref appendString: pieces[i % 4]];
+      [s appendFormat: @"%u", i];
+      [ref appendFormat: @"%u", i];
+    }
+  PASS([s length] == [ref length], "appending keeps the length");
+  PASS_EQUAL(s, ref, "appended contents are correct");
+  PASS(strcmp([s UTF8String], [ref UTF8String]) == 0,
+    "-UTF8String works");
+  d = [s dataUsingEncoding: NSUTF8StringEncoding];
+  PASS_EQUAL(d, [ref dataUsingEncoding: NSUTF8StringEncoding],
+    "-dataUsingEncoding: works for UTF-8");
+  PASS([s lengthOfBytesUsingEncoding: NSUTF8StringEncoding] == [d length],
+    "-lengthOfBytesUsingEncoding: works for UTF-8");
+  PASS([s characterAtIndex: 7] == [ref characterAtIndex: 7],
+    "-characterAtIndex: works");
+
+  [s replaceCharactersInRange: NSMakeRange(3, 10) withString: @"xyz"];
+  [ref replaceCharactersInRange: NSMakeRange(3, 10) withString: @"xyz"];
+  PASS_EQUAL(s, ref, "characters can be replaced");
+  [s appendString: @"tail"];
+  [ref appendString: @"tail"];
+  PASS_EQUAL(s, ref, "appending after a replacement works");
+
+  [s appendString: s];
+  [ref appendString: AUTORELEASE([ref copy])];
+  PASS_EQUAL(s, ref, "a string can be appended to itself");
+
+  [s setString: @"abc"];
+  PASS_EQUAL(s, @"abc", "-setString: works");
+  PASS_EQUAL(AUTORELEASE([s copy]), @"abc", "-copy works");
+  PASS_EQUAL(AUTORELEASE([s mutableCopy]), @"abc", "-mutableCopy works");
+
+  s = [NSMutableString chunkedStringWithCapacity: 0];
+  [s appendFormat: @"%C", (unichar)0xd800];
+  PASS([s length] == 1, "a lone surrogate keeps the length");
+
+  [arp release]; arp = nil;
+  return 0;
+}
@@ -0,0 +1,194 @@
+#import <Foundation/Foundation.h>
+#import "ObjectTesting.h"
+
+@interface Counter : NSObject
+{
+@public
+  NSMutableArray	*seen;
+}
+- (void) note: (NSNotification*)n;
+@end
+
+@implementation Counter
+- (id) init
+{
+  if ((self = [super init]) != nil)
+    {
+      seen = [NSMutableArray new];
+    }
+  return self;
+}
+- (void) dealloc
+{
+  [seen release];
+  [super dealloc];
+}
+- (void) note: (NSNotification*)n
+{
+  [seen addObject: n];
+}
+@end
+
+/* Dequeues a notification from the queue when it sees the first one.
+ */
+@interface Dequeuer : NSObject
+{
+@public
+  NSNotificationQueue	*queue;
+}
+- (void) note: (NSNotification*)n;
+@end
+
+@implementation Dequeuer
+- (void) note: (NSNotification*)n
+{
+  [queue dequeueNotificationsMatching: [NSNotification
+    notificationWithName: @"Last" object: nil]
+			 coalesceMask: NSNotificationCoalescingOnName];
+}
+@end
+
+int main()
+{
+  ENTER_POOL
+  NSNotificationCenter	*nc = AUTORELEASE([NSNotificationCenter new]);
+  NSNotificationQueue	*q;
+  Counter		*c = AUTORELEASE([Counter new]);
+  Dequeuer		*d;
+  NSString		*a = @"a";
+  NSString		*b = @"b";
+  NSArray		*modes;
+  int			i;
+
+  q = AUTORELEASE([[NSNotificationQueue alloc] initWithNotificationCenter: nc]);
+  [nc addObserver: c selector: @selector(note:) name: nil object: nil];
+
+  for (i = 0; i < 1000; i++)
+    {
+      [q enqueueNotification: [NSNotification
+	notificationWithName: @"N" object: (i % 2 ? a : b)]
+		postingStyle: NSPostASAP];
+    }
+  [[NSRunLoop currentRunLoop] runUntilDate:
+    [NSDate dateWithTimeIntervalSinceNow: 0.1]];
+  PASS([c->seen count] == 2, "coalescing on name and sender leaves one each")
+  [c->seen removeAllObjects];
+
+  for (i = 0; i < 1000; i++)
+    {
+      [q enqueueNotification: [NSNotification
+	notificationWithName: [NSString stringWithFormat: @"N%d", i % 10]
+		      object: (i % 2 ? a : b)]
+		postingStyle: NSPostASAP
+		coalesceMask: NSNotificationCoalescingOnName
+		    forModes: nil];
+    }
+  [[NSRunLoop currentRunLoop] runUntilDate:
+    [NSDate dateWithTimeIntervalSinceNow: 0.1]];
+  PASS([c->seen count] == 10, "coalescing on name leaves one per name")
+  [c->seen removeAllObjects];
+
+  for (i = 0; i < 1000; i++)
+    {
+      [q enqueueNotification: [NSNotification
+	notificationWithName: [NSString stringWithFormat: @"N%d", i]
+		      object: (i % 2 ? a : b)]
+		postingStyle: NSPostASAP
+		coalesceMask: NSNotificationCoalescingOnSender
+		    forModes: nil];
+    }
+  [[NSRunLoop currentRunLoop] runUntilDate:
+    [NSDate dateWithTimeIntervalSinceNow: 0.1]];
+  PASS([c->seen count] == 2
+    && [[[c->seen objectAtIndex: 0] name] isEqual: @"N998"]
+    && [[[c->seen objectAtIndex: 1] name] isEqual: @"N999"],
+    "coalescing on sender leaves the most recent for each sender")
+  [c->seen removeAllObjects];
+
+  for (i = 0; i < 200; i++)
+    {
+      [q enqueueNotification: [NSNotification
+	notificationWithName: [NSString stringWithFormat: @"N%d", i]
+		      object: nil]
+		postingStyle: NSPostASAP
+		coalesceMask: NSNotificationNoCoalescing
+		    forModes: nil];
+    }
+  [q dequeueNotificationsMatching: [NSNotification
+    notificationWithName: @"N7" object: nil]
+		     coalesceMask: NSNotificationCoalescingOnName];
+  [[NSRunLoop currentRunLoop] runUntilDate:
+    [NSDate dateWithTimeIntervalSinceNow: 0.1]];
+  PASS([c->seen count] == 199, "dequeue removes only the match")
+  for (i = 0; i < 199; i++)
+    {
+      if (NO == [[[c->seen objectAtIndex: i] name] isEqual:
+	[NSString stringWithFormat: @"N%d", (i < 7 ? i : i + 1)]])
+	{
+	  break;
+	}
+    }
+  PASS(i == 199, "notifications are posted in the order queued")
+  [c->seen removeAllObjects];
+
+  /* Everything ready to post is taken from the queue before any of it
+   * is posted, so an observer dequeuing a later notification is too late
+   * to stop it, however far down the queue it is.
+   */
+  d = AUTORELEASE([Dequeuer new]);
+  d->queue = q;
+  [nc addObserver: d selector: @selector(note:) name: @"First" object: nil];
+  [q enqueueNotification: [NSNotification notificationWithName: @"First"
+							object: nil]
+	    postingStyle: NSPostASAP
+	    coalesceMask: NSNotificationNoCoalescing
+		forModes: nil];
+  for (i = 0; i < 200; i++)
+    {
+      [q enqueueNotification: [NSNotification
+	notificationWithName: [NSString stringWithFormat: @"N%d", i]
+		      object: nil]
+		postingStyle: NSPostASAP
+		coalesceMask: NSNotificationNoCoalescing
+		    forModes: nil];
+    }
+  [q enqueueNotification: [NSNotification notificationWithName: @"Last"
+							object: nil]
+	    postingStyle: NSPostASAP
+	    coalesceMask: NSNotificationNoCoalescing
+		forModes: nil];
+  [[NSRunLoop currentRunLoop] runUntilDate:
+    [NSDate dateWithTimeIntervalSinceNow: 0.1]];
+  PASS([c->seen count] == 202
+    && [[[c->seen lastObject] name] isEqual: @"Last"],
+    "a notification dequeued by an observer during posting is still posted")
+  [nc removeObserver: d];
+  [c->seen removeAllObjects];
+
+  modes = [NSArray arrayWithObject: @"OtherMode"];
+  [q enqueueNotification: [NSNotification notificationWithName: @"M"
+							object: nil]
+	    postingStyle: NSPostASAP
+	    coalesceMask: NSNotificationNoCoalescing
+		forModes: modes];
+  [q enqueueNotification: [NSNotification notificationWithName: @"D"
+							object: nil]
+	    postingStyle: NSPostASAP
+	    coalesceMask: NSNotificationNoCoalescing
+		forModes: nil];
+  [[NSRunLoop currentRunLoop] runUntilDate:
+    [NSDate dateWithTimeIntervalSinceNow: 0.1]];
+  PASS([c->seen count] == 1
+    && [[[c->seen lastObject] name] isEqual: @"D"],
+    "only notifications for the current mode are posted")
+  [c->seen removeAllObjects];
+  [[NSRunLoop currentRunLoop] runMode: @"OtherMode"
+			   beforeDate: [NSDate dateWithTimeIntervalSinceNow: 0.1]];
+  PASS([c->seen count] == 1
+    && [[[c->seen lastObject] name] isEqual: @"M"],
+    "notification for another mode is posted in that mode")
+
+  [nc removeObserver: c];
+  LEAVE_POOL
+  return 0;
+}
@@ -0,0 +1,159 @@
+/*
+ * magazines.m - tests for the size class allocator which NSAllocateObject()
+ * uses for small objects when GNUSTEP_OBJECT_MAGAZINES=YES.
+ */
+
+#import <Foundation/Foundation.h>
+#import "ObjectTesting.h"
+#include <stdlib.h>
+
+@interface Small : NSObject
+{
+@public
+  int	value;
+}
+@end
+
+@implementation Small
+@end
+
+@interface Large : NSObject
+{
+  char	bytes[1024];
+}
+@end
+
+@implementation Large
+@end
+
+/* Allocates objects in one thread for another to release.
+ */
+@interface Producer : NSObject
+{
+@public
+  NSMutableArray	*made;
+  NSCondition		*cond;
+  BOOL			done;
+}
+- (void) run;
+@end
+
+@implementation Producer
+- (void) run
+{
+  ENTER_POOL
+  NSUInteger	i;
+
+  for (i = 0; i < 10000; i++)
+    {
+      Small	*s = [Small new];
+
+      s->value = (int)i;
+      [cond lock];
+      [made addObject: s];
+      [cond unlock];
+      RELEASE(s);
+    }
+  [cond lock];
+  done = YES;
+  [cond signal];
+  [cond unlock];
+  LEAVE_POOL
+}
+@end
+
+int main()
+{
+  /* Must be set before the runtime initialises NSObject.
+   */
+  setenv("GNUSTEP_OBJECT_MAGAZINES", "YES", 1);
+
+  START_SET("magazines")
+    struct NSZoneStats	before;
+    struct NSZoneStats	after;
+    NSMutableArray	*a;
+    Producer		*p;
+    Small		*s;
+    id			o;
+    NSUInteger		i;
+    BOOL		ok;
+
+    if (GSObjectMagazineZone() == NULL)
+      SKIP("the magazine allocator is not available with this runtime")
+
+    PASS_EXCEPTION(NSZoneMalloc(GSObjectMagazineZone(), 16), nil,
+      "the magazine zone can not be used with NSZoneMalloc()");
+
+    a = [NSMutableArray arrayWithCapacity: 1000];
+    before = NSZoneStats(GSObjectMagazineZone());
+    for (i = 0; i < 1000; i++)
+      {
+	s = [Small new];
+	s->value = (int)i;
+	[a addObject: s];
+	RELEASE(s);
+      }
+    after = NSZoneStats(GSObjectMagazineZone());
+    PASS(after.chunks_used >= before.chunks_used + 1000,
+      "small objects come from the magazines");
+
+    o = [Large new];
+    PASS(NSZoneStats(GSObjectMagazineZone()).chunks_used
+      == after.chunks_used, "large objects do not");
+    RELEASE(o);
+
+    ok = YES;
+    for (i = 0; i < 1000; i++)
+      {
+	if (((Small*)[a objectAtIndex: i])->value != (int)i)
+	  {
+	    ok = NO;
+	  }
+      }
+    PASS(ok, "objects from the magazines do not overlap");
+
+    [a removeAllObjects];
+    after = NSZoneStats(GSObjectMagazineZone());
+    PASS(after.chunks_used <= before.chunks_used,
+      "deallocated objects are returned to the magazines");
+    PASS(after.chunks_free >= 1000, "freed blocks are cached");
+
+    s = [Small new];
+    PASS(s != nil && s->value == 0, "a reused block is cleared");
+    RELEASE(s);
+
+    /* Objects made in one thread and released in another.
+     */
+    p = AUTORELEASE([Producer new]);
+    p->made = [NSMutableArray array];
+    p->cond = AUTORELEASE([NSCondition new]);
+    [NSThread detachNewThreadSelector: @selector(run)
+			     toTarget: p
+			   withObject: nil];
+    i = 0;
+    ok = YES;
+    [p->cond lock];
+    while (NO == p->done || [p->made count] > 0)
+      {
+	while ([p->made count] > 0)
+	  {
+	    if (((Small*)[p->made objectAtIndex: 0])->value != (int)i++)
+	      {
+		ok = NO;
+	      }
+	    [p->made removeObjectAtIndex: 0];
+	  }
+	if (NO == p->done)
+	  {
+	    [p->cond waitUntilDate: [NSDate dateWithTimeIntervalSinceNow: 0.1]];
+	  }
+      }
+    [p->cond unlock];
+    PASS(ok && 10000 == i, "objects can be released by another thread");
+
+    o = [NSString stringWithFormat: @"%d", 42];
+    PASS_EQUAL(o, @"42", "Foundation objects work with magazines");
+  END_SET("magazines")
+
+  return 0;
+}
@@ -0,0 +1,135 @@
+/*
+ * compiled.m - tests for repeated evaluation of predicates, where patterns
+ * for MATCHES and LIKE are compiled once and key paths are split once, and
+ * for filtering arrays in batches and concurrently.
+ */
+
+#import <Foundation/Foundation.h>
+#import "ObjectTesting.h"
+
+#if	defined(GS_USE_ICU)
+#define	IS_SUPPORTED	GS_USE_ICU
+#else
+#define	IS_SUPPORTED	0
+#endif
+
+@interface Person : NSObject
+{
+  NSString	*name;
+  Person	*parent;
+  NSArray	*children;
+}
+- (id) initWithName: (NSString*)n parent: (Person*)p;
+@end
+
+@implementation Person
+- (id) initWithName: (NSString*)n parent: (Person*)p
+{
+  if ((self = [super init]) != nil)
+    {
+      name = [n copy];
+      parent = RETAIN(p);
+      children = [[NSArray alloc] initWithObjects: @"a", @"b", nil];
+    }
+  return self;
+}
+- (void) dealloc
+{
+  RELEASE(name);
+  RELEASE(parent);
+  RELEASE(children);
+  [super dealloc];
+}
+@end
+
+int main(void)
+{
+  ENTER_POOL
+  NSMutableArray	*people = [NSMutableArray array];
+  NSArray		*serial;
+  NSArray		*concurrent;
+  NSPredicate		*p;
+  Person		*root;
+  BOOL			ok;
+  int			i;
+
+  root = AUTORELEASE([[Person alloc] initWithName: @"Root" parent: nil]);
+  for (i = 0; i < 5000; i++)
+    {
+      [people addObject: AUTORELEASE([[Person alloc]
+	initWithName: [NSString stringWithFormat: @"Person %d", i]
+	      parent: root])];
+    }
+
+  START_SET("MATCHES and LIKE")
+  if (!IS_SUPPORTED)
+    SKIP("regular expressions are not supported\nThe ICU library was not available when GNUstep-base was built")
+    p = [NSPredicate predicateWithFormat: @"name LIKE 'Person 1*'"];
+    ok = YES;
+    for (i = 0; i < 3; i++)
+      {
+	if (NO == [p evaluateWithObject: [people objectAtIndex: 12]]
+	  || YES == [p evaluateWithObject: [people objectAtIndex: 21]])
+	  {
+	    ok = NO;
+	  }
+      }
+    PASS(ok, "LIKE gives the same result on repeated evaluation")
+
+    p = [NSPredicate predicateWithFormat: @"name LIKE[c] 'person 4?'"];
+    PASS([p evaluateWithObject: [people objectAtIndex: 42]],
+      "case insensitive LIKE matches")
+    p = [p copy];
+    PASS([p evaluateWithObject: [people objectAtIndex: 42]],
+      "a copied LIKE predicate matches")
+    RELEASE(p);
+
+    p = [NSPredicate predicateWithFormat: @"name MATCHES 'Person [0-9]+'"];
+    PASS([p evaluateWithObject: [people objectAtIndex: 7]]
+      && [p evaluateWithObject: [people objectAtIndex: 4999]],
+      "MATCHES matches the whole string")
+    p = [NSPredicate predicateWithFormat: @"name MATCHES 'Person'"];
+    PASS(NO == [p evaluateWithObject: [people objectAtIndex: 7]],
+      "MATCHES does not match part of the string")
+    p = [NSPredicate predicateWithFormat: @"name MATCHES '(unclosed'"];
+    PASS(NO == [p evaluateWithObject: [people objectAtIndex: 7]],
+      "MATCHES with an invalid pattern matches nothing")
+    p = [NSPredicate predicateWithFormat: @"name MATCHES $pattern"];
+    p = [p predicateWithSubstitutionVariables: [NSDictionary
+      dictionaryWithObject: @"Person 9+" forKey: @"pattern"]];
+    PASS([p evaluateWithObject: [people objectAtIndex: 99]],
+      "MATCHES with a substituted pattern matches")
+  END_SET("MATCHES and LIKE")
+
+  p = [NSPredicate predicateWithFormat: @"parent.name == 'Root'"];
+  PASS([p evaluateWithObject: [people objectAtIndex: 0]],
+    "a key path is followed through objects")
+  PASS(NO == [p evaluateWithObject: root],
+    "a key path reaching nil gives nil")
+  p = [NSPredicate predicateWithFormat: @"children.@count == 2"];
+  PASS([p evaluateWithObject: root], "a key path with an operator works")
+  p = [NSPredicate predicateWithFormat: @"info.size == 3"];
+  PASS([p evaluateWithObject: [NSDictionary dictionaryWithObject:
+    [NSDictionary dictionaryWithObject: [NSNumber numberWithInt: 3]
+				forKey: @"size"] forKey: @"info"]],
+    "a key path is followed through dictionaries")
+
+  p = [NSPredicate predicateWithFormat: @"name ENDSWITH '7'"];
+  serial = [people filteredArrayUsingPredicate: p];
+  concurrent = [people filteredArrayUsingPredicate: p
+					   options: NSEnumerationConcurrent];
+  PASS([serial count] == 500, "filtering finds every match")
+  PASS_EQUAL(concurrent, serial,
+    "concurrent filtering gives the same objects in the same order")
+  PASS([[people filteredArrayUsingPredicate: [NSPredicate
+    predicateWithValue: NO]] count] == 0, "filtering can find nothing")
+
+  p = [NSPredicate predicateWithFormat: @"noSuchKey == 1"];
+  PASS_EXCEPTION([people filteredArrayUsingPredicate: p
+					     options: NSEnumerationConcurrent],
+    NSUndefinedKeyException,
+    "an exception in concurrent filtering is raised to the caller")
+
+  LEAVE_POOL
+  return 0;
+}
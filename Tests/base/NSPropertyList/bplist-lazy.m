@@ -0,0 +1,165 @@
+/*
+ * bplist-lazy.m - test lazy decoding of binary property lists.
+ *
+ * With GSPropertyListLazyDecoding the parser returns proxy collections
+ * which decode their members on first access.  They must compare equal
+ * to the eagerly decoded property list and behave as immutable
+ * collections.
+ */
+
+#import <Foundation/Foundation.h>
+#import "Testing.h"
+
+/* Build a bplist with one-byte offsets and indexes from the bytes of the
+ * objects (starting at offset 8) and the offset of each of them, with
+ * object 0 as the root.
+ */
+static NSData *
+craft(const unsigned char *objects, unsigned length,
+  const unsigned char *offsets, unsigned count)
+{
+  NSMutableData	*d = [NSMutableData dataWithBytes: "bplist00" length: 8];
+  unsigned char	trailer[32];
+
+  [d appendBytes: objects length: length];
+  [d appendBytes: offsets length: count];
+  memset(trailer, 0, sizeof(trailer));
+  trailer[6] = 1;
+  trailer[7] = 1;
+  trailer[15] = count;
+  trailer[31] = 8 + length;
+  [d appendBytes: trailer length: sizeof(trailer)];
+  return d;
+}
+
+int
+main(int argc, char *argv[])
+{
+  ENTER_POOL
+  NSMutableDictionary	*big = [NSMutableDictionary dictionary];
+  NSMutableArray	*arr = [NSMutableArray array];
+  NSDictionary		*plist;
+  NSData		*d;
+  NSData		*blob;
+  NSError		*err = nil;
+  id			eager;
+  id			lazy;
+  id			bigLazy;
+  id			o;
+  NSUInteger		n;
+  int			i;
+
+  blob = [@"some binary data for the property list"
+    dataUsingEncoding: NSASCIIStringEncoding];
+  for (i = 0; i < 100; i++)
+    {
+      [big setObject: [NSNumber numberWithInt: i]
+	      forKey: [NSString stringWithFormat: @"key number %d", i]];
+      [arr addObject: [NSString stringWithFormat: @"element %d", i]];
+    }
+  plist = [NSDictionary dictionaryWithObjectsAndKeys:
+    big, @"big",
+    arr, @"array",
+    blob, @"data",
+    @"a string which is much too long to be a tiny string", @"ascii",
+    [NSString stringWithFormat: @"unicode %C", (unichar)0x20ac], @"unicode",
+    [NSDate dateWithTimeIntervalSinceReferenceDate: 1234.5], @"date",
+    [NSNumber numberWithBool: YES], @"yes",
+    [NSNumber numberWithDouble: 1.5], @"double",
+    nil];
+
+  d = [NSPropertyListSerialization dataWithPropertyList: plist
+    format: NSPropertyListBinaryFormat_v1_0 options: 0 error: &err];
+  PASS(d != nil, "binary property list written")
+
+  eager = [NSPropertyListSerialization propertyListWithData: d
+    options: NSPropertyListImmutable format: NULL error: &err];
+  lazy = [NSPropertyListSerialization propertyListWithData: d
+    options: NSPropertyListImmutable | GSPropertyListLazyDecoding
+    format: NULL error: &err];
+  PASS(lazy != nil && [lazy isKindOfClass: [NSDictionary class]],
+    "lazy decoding returns a dictionary")
+  PASS([lazy count] == [plist count], "lazy dictionary has the right count")
+  PASS_EQUAL([lazy objectForKey: @"ascii"], [plist objectForKey: @"ascii"],
+    "lazy decoding finds a key in a small dictionary")
+  PASS_EQUAL([[lazy objectForKey: @"big"] objectForKey: @"key number 42"],
+    [NSNumber numberWithInt: 42],
+    "lazy decoding finds a key in a large dictionary")
+  PASS([[lazy objectForKey: @"big"] objectForKey: @"missing"] == nil,
+    "lazy decoding does not find a missing key")
+  PASS_EQUAL([[lazy objectForKey: @"array"] objectAtIndex: 99],
+    @"element 99", "lazy array decodes an element")
+  PASS_EQUAL([lazy objectForKey: @"data"], blob,
+    "lazy data has the right contents")
+  PASS_EQUAL([lazy objectForKey: @"unicode"], [plist objectForKey: @"unicode"],
+    "lazy decoding handles non-ASCII strings")
+  PASS_EQUAL(lazy, eager, "lazy property list equals eager one")
+  PASS_EQUAL(lazy, plist, "lazy property list equals the original")
+
+  n = 0;
+  bigLazy = [lazy objectForKey: @"big"];
+  GS_FOR_IN(id, key, bigLazy)
+    if ([bigLazy objectForKey: key] != nil)
+      {
+	n++;
+      }
+  GS_END_FOR(bigLazy)
+  PASS(n == 100, "fast enumeration of a lazy dictionary sees every key")
+
+  o = [[lazy objectForKey: @"array"] copy];
+  PASS(o == [lazy objectForKey: @"array"], "copy of lazy array is itself")
+  RELEASE(o);
+  o = [[lazy objectForKey: @"array"] mutableCopy];
+  [o addObject: @"extra"];
+  PASS([o count] == 101, "mutable copy of lazy array can be modified")
+  RELEASE(o);
+
+  o = [NSKeyedArchiver archivedDataWithRootObject: lazy];
+  o = [NSKeyedUnarchiver unarchiveObjectWithData: o];
+  PASS_EQUAL(o, plist, "lazy property list can be archived")
+
+  o = [NSPropertyListSerialization propertyListWithData: d
+    options: NSPropertyListMutableContainers | GSPropertyListLazyDecoding
+    format: NULL error: &err];
+  PASS([o isKindOfClass: [NSMutableDictionary class]],
+    "lazy decoding is ignored for mutable containers")
+
+  /* An array holding a dictionary whose value is the array.
+   */
+  {
+    const unsigned char	objects[] = {
+      0xA1, 0x01,		// 8: array [1]
+      0xD1, 0x02, 0x00,		// 10: dictionary {2: 0}
+      0x51, 'k'			// 13: "k"
+    };
+    const unsigned char	offsets[] = { 8, 10, 13 };
+
+    d = craft(objects, sizeof(objects), offsets, sizeof(offsets));
+    err = nil;
+    o = [NSPropertyListSerialization propertyListWithData: d
+      options: NSPropertyListImmutable | GSPropertyListLazyDecoding
+      format: NULL error: &err];
+    PASS(o == nil && err != nil,
+      "lazy decoding rejects containers which contain themselves")
+  }
+
+  /* An array holding the same empty array twice is not a cycle.
+   */
+  {
+    const unsigned char	objects[] = {
+      0xA2, 0x01, 0x01,		// 8: array [1, 1]
+      0xA0			// 11: array []
+    };
+    const unsigned char	offsets[] = { 8, 11 };
+
+    d = craft(objects, sizeof(objects), offsets, sizeof(offsets));
+    o = [NSPropertyListSerialization propertyListWithData: d
+      options: NSPropertyListImmutable | GSPropertyListLazyDecoding
+      format: NULL error: &err];
+    PASS([o count] == 2 && [[o objectAtIndex: 1] count] == 0,
+      "lazy decoding accepts an object referred to twice")
+  }
+
+  LEAVE_POOL
+  return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * bplist-stream.m - test generation of binary property lists.
+ *
+ * Binary property lists written to a stream must be identical to those
+ * written to memory, equal values must be stored only once, and large
+ * property lists (needing wide object indexes) must survive a round trip.
+ */
+
+#import <Foundation/Foundation.h>
+#import "Testing.h"
+
+int
+main(int argc, char *argv[])
+{
+  ENTER_POOL
+  NSMutableArray	*arr = [NSMutableArray array];
+  NSMutableArray	*dup = [NSMutableArray array];
+  NSMutableDictionary	*dict = [NSMutableDictionary dictionary];
+  NSDictionary		*plist;
+  NSOutputStream	*os;
+  NSData		*d;
+  NSData		*s;
+  NSError		*err = nil;
+  NSInteger		written;
+  id			o;
+  int			i;
+
+  for (i = 0; i < 70000; i++)
+    {
+      [arr addObject: [NSString stringWithFormat: @"item %d", i]];
+    }
+  for (i = 0; i < 20; i++)
+    {
+      [dict setObject: [NSNumber numberWithInt: i]
+	       forKey: [NSString stringWithFormat: @"key %d", i]];
+    }
+  plist = [NSDictionary dictionaryWithObjectsAndKeys:
+    arr, @"array",
+    dict, @"dict",
+    [NSString stringWithFormat: @"unicode %C", (unichar)0x20ac], @"unicode",
+    [NSDate dateWithTimeIntervalSinceReferenceDate: 1234.5], @"date",
+    [NSNumber numberWithBool: YES], @"yes",
+    [NSNumber numberWithInt: 1], @"one",
+    [NSNumber numberWithDouble: 1.5], @"double",
+    [NSNumber numberWithLongLong: -5], @"negative",
+    nil];
+
+  d = [NSPropertyListSerialization dataWithPropertyList: plist
+    format: NSPropertyListBinaryFormat_v1_0 options: 0 error: &err];
+  PASS(d != nil, "large binary property list written to data")
+  o = [NSPropertyListSerialization propertyListWithData: d
+    options: NSPropertyListImmutable format: NULL error: &err];
+  PASS_EQUAL(o, plist, "large binary property list round trips")
+  PASS_EQUAL([o objectForKey: @"yes"], [NSNumber numberWithBool: YES],
+    "boolean survives alongside an equal integer")
+
+  os = [NSOutputStream outputStreamToMemory];
+  [os open];
+  written = [NSPropertyListSerialization writePropertyList: plist
+						 toStream: os
+						   format: NSPropertyListBinaryFormat_v1_0
+						  options: 0
+						    error: &err];
+  [os close];
+  s = [os propertyForKey: NSStreamDataWrittenToMemoryStreamKey];
+  PASS(written == (NSInteger)[d length],
+    "writing to a stream reports the number of bytes written")
+  PASS_EQUAL(s, d, "stream and data output are identical")
+
+  for (i = 0; i < 1000; i++)
+    {
+      [dup addObject: [NSString stringWithFormat: @"same string %d", i % 2]];
+    }
+  d = [NSPropertyListSerialization dataWithPropertyList: dup
+    format: NSPropertyListBinaryFormat_v1_0 options: 0 error: &err];
+  PASS([d length] < 2200, "equal strings are stored once")
+  o = [NSPropertyListSerialization propertyListWithData: d
+    options: NSPropertyListImmutable format: NULL error: &err];
+  PASS_EQUAL(o, dup, "uniqued property list round trips")
+
+  o = [NSKeyedArchiver archivedDataWithRootObject: plist];
+  PASS_EQUAL([NSKeyedUnarchiver unarchiveObjectWithData: o], plist,
+    "keyed archive written in binary format round trips")
+
+  LEAVE_POOL
+  return 0;
+}
@@ -0,0 +1,95 @@
+#import <Foundation/Foundation.h>
+#import "ObjectTesting.h"
+
+static void
+progress(void *context, NSTextCheckingResult *match,
+  NSMatchingFlags flags, BOOL *stop)
+{
+  if (flags & NSMatchingProgress)
+    {
+      (*(NSInteger*)context)++;
+    }
+}
+
+int main(void)
+{
+  START_SET("NSRegularExpression reuse")
+
+#if !(__APPLE__ || GS_USE_ICU)
+    SKIP("NSRegularExpression not built, please install libicu")
+#else
+  NSRegularExpression	*re;
+  NSRegularExpression	*copy;
+  NSString		*latin1;
+  NSString		*wide;
+  NSMutableString	*mutable;
+  NSArray		*m;
+  NSUInteger		i;
+  NSInteger		calls;
+  BOOL			ok;
+
+  re = [NSRegularExpression regularExpressionWithPattern: @"b(\\w)"
+						 options: 0
+						   error: NULL];
+  latin1 = [NSString stringWithFormat: @"%@%C", @"ab1 ab2 ab3 ", 0xe9];
+  wide = [NSString stringWithFormat: @"%C%@", 0x20ac, @"ab1 ab2 ab3 "];
+  mutable = [NSMutableString stringWithString: @"xb1 yb2 zb3"];
+
+  ok = YES;
+  for (i = 0; i < 100; i++)
+    {
+      if ([re numberOfMatchesInString: latin1 options: 0
+	range: NSMakeRange(0, [latin1 length])] != 3
+	|| [re numberOfMatchesInString: wide options: 0
+	range: NSMakeRange(0, [wide length])] != 3
+	|| [re numberOfMatchesInString: mutable options: 0
+	range: NSMakeRange(0, [mutable length])] != 3)
+	{
+	  ok = NO;
+	  break;
+	}
+    }
+  PASS(ok, "repeated matching finds the same matches in any string")
+
+  m = [re matchesInString: wide options: 0
+		    range: NSMakeRange(0, [wide length])];
+  PASS([m count] == 3 && NSEqualRanges([[m lastObject] rangeAtIndex: 1],
+    NSMakeRange(11, 1)), "match ranges in a UTF-16 string are right")
+  m = [re matchesInString: latin1 options: 0
+		    range: NSMakeRange(4, 7)];
+  PASS([m count] == 2 && NSEqualRanges([[m objectAtIndex: 0] range],
+    NSMakeRange(5, 2)), "match ranges in a subrange are right")
+
+  PASS_EQUAL([re stringByReplacingMatchesInString: wide options: 0
+    range: NSMakeRange(0, [wide length]) withTemplate: @"<$1>"],
+    ([NSString stringWithFormat: @"%Ca<1> a<2> a<3> ", 0x20ac]),
+    "replacement in a UTF-16 string works")
+
+  PASS([re numberOfMatchesInString: @"b1b2" options: NSMatchingAnchored
+    range: NSMakeRange(0, 4)] == 1, "anchored matching finds one match")
+  PASS([re numberOfMatchesInString: @"b1b2" options: 0
+    range: NSMakeRange(0, 4)] == 2,
+    "options of an earlier call do not stick to the expression")
+
+  calls = 0;
+  [re enumerateMatchesInString: wide
+		       options: NSMatchingReportProgress
+			 range: NSMakeRange(0, [wide length])
+		      callback: progress
+		       context: &calls];
+  calls = 0;
+  [re enumerateMatchesInString: wide
+		       options: 0
+			 range: NSMakeRange(0, [wide length])
+		      callback: progress
+		       context: &calls];
+  PASS(0 == calls, "progress reporting of an earlier call does not stick")
+
+  copy = AUTORELEASE([re copy]);
+  PASS([copy numberOfMatchesInString: wide options: 0
+    range: NSMakeRange(0, [wide length])] == 3, "a copy matches too")
+#endif
+
+  END_SET("NSRegularExpression reuse")
+  return 0;
+}
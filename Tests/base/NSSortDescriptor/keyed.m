@@ -0,0 +1,139 @@
+/*
+ * keyed.m - tests for sorting with several descriptors, where the key
+ * values are extracted once and numbers, dates and strings are compared
+ * directly.  The result must be the order -compareObject:toObject: gives,
+ * with objects which compare equal left in their original order.
+ */
+
+#import <Foundation/Foundation.h>
+#import "ObjectTesting.h"
+
+@interface ReverseDescriptor : NSSortDescriptor
+@end
+
+@implementation ReverseDescriptor
+- (NSComparisonResult) compareObject: (id)a toObject: (id)b
+{
+  return [super compareObject: b toObject: a];
+}
+@end
+
+static NSDictionary *
+row(id a, id b, NSUInteger i)
+{
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+    a, @"a", b, @"b", [NSNumber numberWithUnsignedInteger: i], @"i", nil];
+}
+
+/* Check that the array is in the order the descriptors give, with ties
+ * broken by the original position recorded under the key "i".
+ */
+static BOOL
+ordered(NSArray *sorted, NSArray *descriptors)
+{
+  NSUInteger	i;
+
+  for (i = 1; i < [sorted count]; i++)
+    {
+      id		x = [sorted objectAtIndex: i - 1];
+      id		y = [sorted objectAtIndex: i];
+      NSComparisonResult	r = NSOrderedSame;
+      NSUInteger	j;
+
+      for (j = 0; j < [descriptors count] && NSOrderedSame == r; j++)
+	{
+	  r = [[descriptors objectAtIndex: j] compareObject: x toObject: y];
+	}
+      if (NSOrderedDescending == r)
+	{
+	  return NO;
+	}
+      if (NSOrderedSame == r && [[x objectForKey: @"i"]
+	compare: [y objectForKey: @"i"]] != NSOrderedAscending)
+	{
+	  return NO;
+	}
+    }
+  return YES;
+}
+
+int main(void)
+{
+  START_SET("NSSortDescriptor keyed sorting")
+    NSMutableArray	*rows = [NSMutableArray array];
+    NSArray		*sds;
+    NSArray		*sorted;
+    NSUInteger		i;
+
+    for (i = 0; i < 1000; i++)
+      {
+	[rows addObject: row([NSNumber numberWithInt: (int)(i * 7919 % 13)],
+	  [NSString stringWithFormat: @"s%u", (unsigned)(i * 104729 % 17)], i)];
+      }
+    sds = [NSArray arrayWithObjects:
+      [NSSortDescriptor sortDescriptorWithKey: @"a" ascending: YES],
+      [NSSortDescriptor sortDescriptorWithKey: @"b" ascending: NO], nil];
+    sorted = [rows sortedArrayUsingDescriptors: sds];
+    PASS([sorted count] == 1000 && ordered(sorted, sds),
+      "integers then strings sort in order, keeping ties stable")
+
+    [rows removeAllObjects];
+    for (i = 0; i < 500; i++)
+      {
+	[rows addObject: row([NSNumber numberWithDouble: (i % 10) / 4.0],
+	  [NSDate dateWithTimeIntervalSinceReferenceDate: (i * 31) % 50], i)];
+      }
+    sds = [NSArray arrayWithObjects:
+      [NSSortDescriptor sortDescriptorWithKey: @"a" ascending: NO],
+      [NSSortDescriptor sortDescriptorWithKey: @"b" ascending: YES], nil];
+    sorted = [rows sortedArrayUsingDescriptors: sds];
+    PASS(ordered(sorted, sds), "doubles then dates sort in order")
+
+    [rows removeAllObjects];
+    for (i = 0; i < 300; i++)
+      {
+	id	a;
+
+	switch (i % 3)
+	  {
+	    case 0: a = [NSNumber numberWithInt: (int)(i % 7)]; break;
+	    case 1: a = [NSNumber numberWithDouble: (i % 7) + 0.5]; break;
+	    default: a = [NSNumber numberWithUnsignedLongLong:
+	      0xffffffffffffff00ULL + i % 5]; break;
+	  }
+	[rows addObject: row(a, @"x", i)];
+      }
+    sds = [NSArray arrayWithObject:
+      [NSSortDescriptor sortDescriptorWithKey: @"a" ascending: YES]];
+    sorted = [rows sortedArrayUsingDescriptors: sds];
+    PASS(ordered(sorted, sds), "mixed integer and floating point numbers sort")
+
+    sds = [NSArray arrayWithObject:
+      [NSSortDescriptor sortDescriptorWithKey: @"b" ascending: YES
+	selector: @selector(caseInsensitiveCompare:)]];
+    [rows removeAllObjects];
+    for (i = 0; i < 100; i++)
+      {
+	[rows addObject: row(@"", (i % 2) ? @"ABC" : @"abc", i)];
+      }
+    sorted = [rows sortedArrayUsingDescriptors: sds];
+    PASS(ordered(sorted, sds), "a custom selector keeps equal objects stable")
+
+    sds = [NSArray arrayWithObject: AUTORELEASE([[ReverseDescriptor alloc]
+      initWithKey: @"i" ascending: YES])];
+    sorted = [rows sortedArrayUsingDescriptors: sds];
+    PASS([[[sorted objectAtIndex: 0] objectForKey: @"i"] intValue] == 99,
+      "a subclass overriding -compareObject:toObject: is used")
+
+    [rows removeAllObjects];
+    [rows addObject: [NSDictionary dictionaryWithObject: @"b" forKey: @"a"]];
+    [rows addObject: [NSDictionary dictionary]];
+    [rows addObject: [NSDictionary dictionaryWithObject: @"a" forKey: @"a"]];
+    sds = [NSArray arrayWithObject:
+      [NSSortDescriptor sortDescriptorWithKey: @"a" ascending: YES]];
+    [rows sortUsingDescriptors: sds];
+    PASS([rows count] == 3, "sorting with a missing key value does not crash")
+  END_SET("NSSortDescriptor keyed sorting")
+
+  return 0;
+}
@@ -0,0 +1,108 @@
+/**
+ * This test tests compressing and decompressing through stacked streams
+ */
+#import "ObjectTesting.h"
+#import <Foundation/Foundation.h>
+#import "GNUstepBase/GSConfig.h"
+#import <GNUstepBase/NSData+GNUstepBase.h>
+#import <GNUstepBase/NSStream+GNUstepBase.h>
+
+#if USE_ZLIB
+static NSData *
+deflated(NSData *d, int windowBits)
+{
+  NSOutputStream        *mem = [NSOutputStream outputStreamToMemory];
+  NSOutputStream        *out;
+  const uint8_t         *p = [d bytes];
+  NSUInteger            len = [d length];
+
+  out = AUTORELEASE([[GSDeflateOutputStream alloc]
+    initToStream: mem level: 6 windowBits: windowBits]);
+  [out open];
+  while (len > 0)
+    {
+      NSInteger n = [out write: p maxLength: (len > 1000 ? 1000 : len)];
+
+      if (n <= 0)
+        {
+          return nil;
+        }
+      p += n;
+      len -= n;
+    }
+  [out close];
+  return [mem propertyForKey: NSStreamDataWrittenToMemoryStreamKey];
+}
+
+static NSData *
+inflated(NSData *d, int windowBits)
+{
+  NSInputStream         *in;
+  NSMutableData         *m = [NSMutableData data];
+  uint8_t               buf[777];
+  NSInteger             n;
+
+  in = AUTORELEASE([[GSInflateInputStream alloc]
+    initWithStream: [NSInputStream inputStreamWithData: d]
+        windowBits: windowBits]);
+  [in open];
+  while ((n = [in read: buf maxLength: sizeof(buf)]) > 0)
+    {
+      [m appendBytes: buf length: n];
+    }
+  if (n < 0 || [in streamStatus] != NSStreamStatusAtEnd)
+    {
+      return nil;
+    }
+  [in close];
+  return m;
+}
+#endif
+
+int main()
+{
+  START_SET("zlib streams")
+#if USE_ZLIB
+  NSMutableData *ref = [NSMutableData data];
+  NSMutableData *two;
+  NSData        *gz;
+  int           i;
+
+  for (i = 0; i < 50000; i++)
+    {
+      [ref appendData: [[NSString stringWithFormat: @"line %d of %d\n",
+        i, i % 97] dataUsingEncoding: NSASCIIStringEncoding]];
+    }
+
+  gz = deflated(ref, 15 + 16);
+  PASS(YES == [gz isGzipped], "deflate stream writes gzip data")
+  PASS([gz length] < [ref length] / 4, "deflate stream compresses")
+  PASS_EQUAL([gz gunzipped], ref, "deflate stream output can be gunzipped")
+  PASS_EQUAL(inflated(gz, 15 + 32), ref, "inflate stream reads gzip data")
+  PASS_EQUAL(inflated([ref gzipped: 9], 15 + 32), ref,
+    "inflate stream reads data from -gzipped:")
+
+  gz = deflated(ref, 15);
+  PASS_EQUAL(inflated(gz, 15 + 32), ref, "inflate stream reads zlib data")
+  gz = deflated(ref, -15);
+  PASS_EQUAL(inflated(gz, -15), ref, "inflate stream reads raw deflate data")
+
+  two = [NSMutableData dataWithData: [ref gzipped: 1]];
+  [two appendData: [[NSData dataWithBytes: "tail" length: 4] gzipped: 1]];
+  gz = inflated(two, 15 + 32);
+  PASS([gz length] == [ref length] + 4
+    && [[gz subdataWithRange: NSMakeRange(0, [ref length])] isEqual: ref],
+    "inflate stream reads concatenated gzip members")
+
+  gz = [ref gzipped: 6];
+  gz = [gz subdataWithRange: NSMakeRange(0, [gz length] / 2)];
+  PASS(inflated(gz, 15 + 32) == nil, "inflate stream fails on truncated data")
+
+  PASS_EQUAL(inflated(deflated([NSData data], 15 + 16), 15 + 32),
+    [NSData data], "empty data round trips")
+#else
+  SKIP("zlib support disabled")
+#endif
+  END_SET("zlib streams")
+  return 0;
+}
@@ -0,0 +1,73 @@
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSString.h>
+
+/* The parsed form of a constant format string is cached and reused, and
+   ASCII text is copied without widening.  Check that repeated use of the
+   same format gives the same results as a format which is not cached.  */
+int main()
+{
+  NSAutoreleasePool	*arp = [NSAutoreleasePool new];
+  NSMutableString	*m;
+  NSString		*dyn;
+  NSString		*s;
+  BOOL			ok;
+  int			i;
+
+  ok = YES;
+  for (i = 0; i < 100; i++)
+    {
+      NSString	*want;
+
+      s = [NSString stringWithFormat: @"%d: %s %@ %.2f", i, "str", @"obj", 1.5];
+      want = [NSString stringWithFormat: [NSString stringWithFormat: @"%@",
+	@"%d: %s %@ %.2f"], i, "str", @"obj", 1.5];
+      if (NO == [s isEqual: want]
+	|| NO == [s isEqual: [NSString stringWithFormat: @"%d: str obj 1.50", i]])
+	{
+	  ok = NO;
+	}
+    }
+  PASS(ok, "a constant format gives the same result each time it is used")
+
+  s = [NSString stringWithFormat: @"[%*d]", 5, 1];
+  PASS_EQUAL(s, @"[    1]", "width taken from an argument is used")
+  s = [NSString stringWithFormat: @"[%*d]", -5, 1];
+  PASS_EQUAL(s, @"[1    ]", "negative width from an argument left justifies")
+  s = [NSString stringWithFormat: @"[%*d]", 3, 1];
+  PASS_EQUAL(s, @"[  1]", "width from an argument is not kept between uses")
+  s = [NSString stringWithFormat: @"%2$@ %1$@", @"world", @"hello"];
+  PASS_EQUAL(s, @"hello world", "positional arguments work")
+
+  s = [NSString stringWithFormat: @"%d%d%d%d%d%d%d%d%d%d"
+    @"%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d",
+    1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0,
+    1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1, 2, 3, 4, 5];
+  PASS_EQUAL(s, @"12345678901234567890123456789012345",
+    "a format with many specs works")
+
+  s = [NSString stringWithFormat: @"<%-6s><%6s><%.2s>", "ab", "cd", "efgh"];
+  PASS_EQUAL(s, @"<ab    ><    cd><ef>", "ASCII C strings are padded and cut")
+
+  dyn = [NSString stringWithFormat: @"%@%C", @"abc", (unichar)0x20ac];
+  s = [NSString stringWithFormat: @"<%-6@><%6@><%.2@>", dyn, @"x", dyn];
+  PASS_EQUAL(s, @"<abc\u20AC  ><     x><ab>", "objects are padded and cut")
+  s = [NSString stringWithFormat: @"<%@>", [dyn substringToIndex: 3]];
+  PASS_EQUAL(s, @"<abc>", "8-bit string objects are copied")
+
+  s = [NSString stringWithFormat: @"\u20AC%d", 42];
+  PASS_EQUAL(s, @"\u20AC42", "a non-ASCII format works")
+  s = [NSString stringWithFormat: @"%@ %5.1f %e", @"x", 2.25, 100.0];
+  PASS_EQUAL(s, @"x   2.2 1.000000e+02", "floating point output is copied")
+
+  m = [NSMutableString stringWithString: @"\u20AC"];
+  [m appendFormat: @"%s-%d", "abc", 7];
+  PASS_EQUAL(m, @"\u20ACabc-7", "appending 8-bit output to a wide string")
+  m = [NSMutableString string];
+  [m appendFormat: @"%s", "abc"];
+  [m appendFormat: @"%C", (unichar)0x20ac];
+  PASS_EQUAL(m, @"abc\u20AC", "appending wide output to an 8-bit string")
+
+  [arp release]; arp = nil;
+  return 0;
+}
@@ -644,6 +644,57 @@ testDataTransferWithRelativeRedirect(NSURL *baseURL)
   [task resume];
 }
 
+/* Transfers with a session of its own which uses the process-wide
+ * connection pool, leaving the other sessions on their own caches. */
+static void
+testSharedConnectionPool(NSURL *baseURL)
+{
+  NSURLSession              *session;
+  NSURLSessionConfiguration *configuration;
+  NSURLSessionDataTask      *task;
+  NSURL                     *url;
+  URLManager                *mgr;
+  URLManagerCheck           *check;
+  const char                *prefix = "<SharedConnectionPool>";
+
+  configuration = [NSURLSessionConfiguration defaultSessionConfiguration];
+  PASS(NO == [configuration sharesConnectionPool],
+       "%s connection pool is not shared by default", prefix);
+  PASS(YES == [configuration HTTPShouldUseMultiplexing],
+       "%s multiplexing is used by default", prefix);
+  [configuration setSharesConnectionPool:YES];
+  [configuration setHTTPShouldUseMultiplexing:NO];
+  PASS(YES == [AUTORELEASE([configuration copy]) sharesConnectionPool],
+       "%s copy of configuration shares the connection pool", prefix);
+  PASS(NO == [AUTORELEASE([configuration copy]) HTTPShouldUseMultiplexing],
+       "%s copy of configuration does not use multiplexing", prefix);
+  PASS(NO == [[NSURLSessionConfiguration defaultSessionConfiguration]
+    sharesConnectionPool],
+       "%s default configuration is unchanged", prefix);
+  [configuration setHTTPShouldUseMultiplexing:YES];
+
+  /* URL Delegate Setup */
+  mgr = [URLManager new];
+  mgr->numberOfExpectedTasksBeforeCheck = 1;
+  expectedCountOfTasksToComplete += 1;
+
+  url = [baseURL URLByAppendingPathComponent:@"contentOK"];
+  session = [NSURLSession sessionWithConfiguration:configuration
+                                          delegate:mgr
+                                     delegateQueue:serialDelegateQueue];
+
+  task = [session dataTaskWithURL:url];
+  PASS(nil != task, "%s Session created a valid data task", prefix);
+
+  /* Setup Check */
+  check = [URLManagerCheck checkWithPrefix:prefix
+                                   session:session
+                                      task:task];
+  [mgr setCheckTarget:check selector:@selector(checkData:)];
+
+  [task resume];
+}
+
 /* Tests the completion handler API, so it needs a compiler with
  * blocks.  The same transfer is covered without one above. */
 #if __has_feature(blocks)
@@ -991,6 +1042,7 @@ main(int argc, char *argv[])
     NSFileManager *fm;
     HTTPServer    *server;
     NSDate        *deadline;
+    NSDictionary  *hostStats;
 
     Class httpServerClass;
     Class routeClass;
@@ -1012,6 +1064,7 @@ main(int argc, char *argv[])
 
     serialDelegateQueue = [[NSOperationQueue alloc] init];
     [serialDelegateQueue setMaxConcurrentOperationCount: 1];
+    [NSURLSession resetConnectionStatistics];
     sharedTestSession = [NSURLSession
       sessionWithConfiguration: [NSURLSessionConfiguration
                                   defaultSessionConfiguration]
@@ -1069,6 +1122,9 @@ main(int argc, char *argv[])
     testDataTransferWithCanceledRedirect(baseURL);
     testDataTransferWithRelativeRedirect(baseURL);
 
+    /* Process-wide connection pool */
+    testSharedConnectionPool(baseURL);
+
     /* Abort in Delegate */
     testAbortAfterDidReceiveResponse(baseURL);
 
@@ -1085,6 +1141,13 @@ main(int argc, char *argv[])
     PASS(expectedCountOfTasksToComplete == currentCountOfCompletedTasks,
          "All transfers were completed before a timeout occurred");
 
+    hostStats =
+      [[NSURLSession connectionStatistics] objectForKey:@"127.0.0.1"];
+    PASS([[hostStats objectForKey:@"Transfers"] integerValue] > 0,
+         "connection statistics count transfers to the test server");
+    PASS([[hostStats objectForKey:@"NewConnections"] integerValue] > 0,
+         "connection statistics count new connections");
+
     [server release];
     [countLock release];
   DESTROY(arp);
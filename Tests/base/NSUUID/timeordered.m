@@ -0,0 +1,83 @@
+/*
+ * timeordered.m - test time-ordered UUIDs and the random byte generator.
+ *
+ * Version 7 UUIDs must carry the version and variant bits, the current
+ * time in their first 48 bits, and sort in the order they were made.
+ */
+
+#import <Foundation/Foundation.h>
+#import <GNUstepBase/NSData+GNUstepBase.h>
+#import "Testing.h"
+
+int
+main(int argc, char *argv[])
+{
+  ENTER_POOL
+  gsuuid_t		prev;
+  gsuuid_t		bytes;
+  uint64_t		ms;
+  double		now;
+  NSUUID		*u;
+  NSData		*d1;
+  NSData		*d2;
+  uint8_t		buf[4096];
+  BOOL			versionOK = YES;
+  BOOL			ordered = YES;
+  int			i;
+
+  u = [NSUUID UUID];
+  [u getUUIDBytes: bytes];
+  PASS((bytes[6] >> 4) == 4 && (bytes[8] >> 6) == 2,
+    "+UUID has version 4 and the RFC variant")
+
+  u = [NSUUID timeOrderedUUID];
+  PASS(u != nil, "+timeOrderedUUID returns a UUID")
+  [u getUUIDBytes: prev];
+  ms = 0;
+  for (i = 0; i < 6; i++)
+    {
+      ms = (ms << 8) | prev[i];
+    }
+  now = ([NSDate timeIntervalSinceReferenceDate] + NSTimeIntervalSince1970)
+    * 1000.0;
+  PASS(ms <= now && ms > now - 10000.0,
+    "time-ordered UUID holds the current time in milliseconds")
+  PASS_EQUAL(AUTORELEASE([[NSUUID alloc] initWithUUIDString: [u UUIDString]]), u,
+    "time-ordered UUID survives conversion to a string")
+
+  for (i = 0; i < 1000; i++)
+    {
+      [[NSUUID timeOrderedUUID] getUUIDBytes: bytes];
+      if ((bytes[6] >> 4) != 7 || (bytes[8] >> 6) != 2)
+	{
+	  versionOK = NO;
+	}
+      if (memcmp(prev, bytes, sizeof(bytes)) >= 0)
+	{
+	  ordered = NO;
+	}
+      memcpy(prev, bytes, sizeof(bytes));
+    }
+  PASS(versionOK, "time-ordered UUIDs have version 7 and the RFC variant")
+  PASS(ordered, "time-ordered UUIDs are strictly increasing")
+
+  d1 = [NSData dataWithRandomBytesOfLength: 32];
+  d2 = [NSData dataWithRandomBytesOfLength: 32];
+  PASS(d1 != nil && [d1 length] == 32, "random data has the requested length")
+  PASS(NO == [d1 isEqual: d2], "successive random data differ")
+
+  memset(buf, 0, sizeof(buf));
+  PASS([NSData randomBytes: buf ofLength: sizeof(buf)],
+    "random bytes can fill a buffer larger than the internal one")
+  for (i = 0; i < 256; i++)
+    {
+      if (buf[sizeof(buf) - 1 - i] != 0)
+	{
+	  break;
+	}
+    }
+  PASS(i < 256, "the end of a large random buffer is filled")
+
+  LEAVE_POOL
+  return 0;
+}
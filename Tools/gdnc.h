@@ -27,6 +27,12 @@
 			    userInfo: (NSData*)info
 			    selector: (NSString*)aSelector
 				  to: (uint64_t)observer;
+
+/* Deliver several notifications in one message.  The batch is an archived
+ * array with an entry for each notification, holding the name, object
+ * (or NSNull), archived user info, selector and observer (as an NSNumber).
+ */
+- (oneway void) postNotificationBatch: (NSData*)batch;
 @end
 
 @protocol	GDNCProtocol
@@ -45,6 +51,11 @@
 
 - (void) registerClient: (id<GDNCClient>)client;
 
+/* As -registerClient: for a client which accepts batches of notifications
+ * with -postNotificationBatch:
+ */
+- (void) registerBatchingClient: (id<GDNCClient>)client;
+
 - (void) removeObserver: (uint64_t)anObserver
 		   name: (NSString*)notificationname
 		 object: (NSString*)anObject
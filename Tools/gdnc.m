@@ -24,6 +24,7 @@
 #include <io.h>
 #endif
 
+#import	"Foundation/NSArchiver.h"
 #import	"Foundation/NSArray.h"
 #import	"Foundation/NSAutoreleasePool.h"
 #import	"Foundation/NSBundle.h"
@@ -35,6 +36,7 @@
 #import	"Foundation/NSHashTable.h"
 #import	"Foundation/NSHost.h"
 #import	"Foundation/NSNotification.h"
+#import	"Foundation/NSNull.h"
 #import	"Foundation/NSPort.h"
 #import	"Foundation/NSPortNameServer.h"
 #import	"Foundation/NSProcessInfo.h"
@@ -42,6 +44,7 @@
 #import	"Foundation/NSTask.h"
 #import	"Foundation/NSTimer.h"
 #import	"Foundation/NSUserDefaults.h"
+#import	"Foundation/NSValue.h"
 
 
 #if	defined(__MINGW__)
@@ -75,6 +78,10 @@ static BOOL	auto_stop = NO;		/* Should we shut down when unused? */
 
 static NSTimer  *timer = nil;           /* When to shut down. */
 
+/* The largest number of notifications sent to a client in one message.
+ */
+#define	GDNC_BATCH_MAX	256
+
 #if defined(HAVE_SYSLOG) || defined(HAVE_SLOGF)
 #  if defined(HAVE_SLOGF)
 #    include <sys/slogcodes.h>
@@ -208,6 +215,7 @@ ihandler(int sig)
                             userInfo: (NSData*)info
                             selector: (NSString*)aSelector
                                   to: (uint64_t)observer;
+- (oneway void) postNotificationBatch: (NSData*)batch;
 @end
 @implementation	NSDistributedNotificationCenterGDNCDummy
 - (oneway void) postNotificationName: (NSString*)name
@@ -218,6 +226,10 @@ ihandler(int sig)
 {
   return;
 }
+- (oneway void) postNotificationBatch: (NSData*)batch
+{
+  return;
+}
 @end
 
 @interface	GDNCNotification : NSObject
@@ -266,8 +278,10 @@ ihandler(int sig)
 {
 @public
   BOOL			suspended;
+  BOOL			batching;	/* Accepts batches of notifications. */
   id <GDNCClient>	client;
   NSMutableArray	*observers;
+  NSMutableArray	*pending;	/* Observer/notification pairs.	*/
 }
 @end
 
@@ -275,6 +289,7 @@ ihandler(int sig)
 - (void) dealloc
 {
   RELEASE(observers);
+  RELEASE(pending);
   [super dealloc];
 }
 
@@ -328,6 +343,14 @@ ihandler(int sig)
 @end
 
 
+/*
+ * Observers with a notification name are kept in observersForNames, which
+ * maps each name to a dictionary mapping the notification object (or NSNull
+ * for any object) to the array of observers.  Observers of any name for a
+ * particular object are kept in observersForObjects.  So the observers for
+ * a notification are found with at most three lookups, and each observer
+ * appears in only one of those arrays.
+ */
 @interface	GDNCServer : NSObject <GDNCProtocol>
 {
   NSConnection		*conn;
@@ -335,6 +358,7 @@ ihandler(int sig)
   NSHashTable		*allObservers;
   NSMutableDictionary	*observersForNames;
   NSMutableDictionary	*observersForObjects;
+  NSMutableArray	*pendingClients;	/* Clients with batches.  */
 }
 
 - (void) addObserver: (uint64_t)anObserver
@@ -349,6 +373,8 @@ ihandler(int sig)
 
 - (id) connectionBecameInvalid: (NSNotification*)notification;
 
+- (void) flushBatches;
+
 - (oneway void) postNotificationName: (NSString*)notificationName
 			      object: (NSString*)notificationObject
 			    userInfo: (NSData*)d
@@ -425,6 +451,7 @@ ihandler(int sig)
    */
   RELEASE(observersForNames);
   RELEASE(observersForObjects);
+  RELEASE(pendingClients);
   [super dealloc];
 }
 
@@ -447,6 +474,7 @@ ihandler(int sig)
   allObservers = NSCreateHashTable(NSNonOwnedPointerHashCallBacks, 0);
   observersForNames = [NSMutableDictionary new];
   observersForObjects = [NSMutableDictionary new];
+  pendingClients = [NSMutableArray new];
 
   defs = [NSUserDefaults standardUserDefaults];
   hostname = [defs stringForKey: @"NSHost"];
@@ -604,57 +632,76 @@ ihandler(int sig)
   NSHashInsert(allObservers, obs);
 
   /*
-   *	Now add the observer to the lists of observers interested in it's
-   *	particular notification names and objects.
+   *	Now add the observer to the list of observers interested in it's
+   *	particular combination of notification name and object.
    */
-  if (anObject)
+  if (notificationName)
     {
-      NSMutableArray	*objList;
+      NSMutableDictionary	*byObject;
+      NSMutableArray		*list;
+      id			key = anObject;
 
-      objList = [observersForObjects objectForKey: anObject];
-      if (objList == nil)
+      byObject = [observersForNames objectForKey: notificationName];
+      if (byObject == nil)
 	{
-	  objList = [NSMutableArray new];
-	  [observersForObjects setObject: objList forKey: anObject];
-	  RELEASE(objList);
+	  byObject = [NSMutableDictionary new];
+	  [observersForNames setObject: byObject forKey: notificationName];
+	  RELEASE(byObject);
 	}
-      /*
-       *	If possible use an existing string as the key.
-       */
-      if ([objList count] > 0)
+      else
 	{
-	  GDNCObserver	*tmp = [objList objectAtIndex: 0];
+	  GDNCObserver	*tmp;
+
+	  /*
+	   *	If possible use an existing string as the name.
+	   */
+	  tmp = [[[byObject objectEnumerator] nextObject] objectAtIndex: 0];
+	  notificationName = tmp->notificationName;
+	}
+      if (key == nil)
+	{
+	  key = [NSNull null];
+	}
+      list = [byObject objectForKey: key];
+      if (list == nil)
+	{
+	  list = [NSMutableArray new];
+	  [byObject setObject: list forKey: key];
+	  RELEASE(list);
+	}
+      else if (anObject != nil)
+	{
+	  GDNCObserver	*tmp = [list objectAtIndex: 0];
 
 	  anObject = tmp->notificationObject;
 	}
+      obs->notificationName = RETAIN(notificationName);
       obs->notificationObject = RETAIN(anObject);
-      [objList addObject: obs];
+      [list addObject: obs];
     }
-
-  if (notificationName)
+  else if (anObject)
     {
-      NSMutableArray	*namList;
+      NSMutableArray	*objList;
 
-      namList = [observersForNames objectForKey: notificationName];
-      if (namList == nil)
+      objList = [observersForObjects objectForKey: anObject];
+      if (objList == nil)
 	{
-	  namList = [NSMutableArray new];
-	  [observersForNames setObject: namList forKey: notificationName];
-	  RELEASE(namList);
+	  objList = [NSMutableArray new];
+	  [observersForObjects setObject: objList forKey: anObject];
+	  RELEASE(objList);
 	}
-      /*
-       *	If possible use an existing string as the key.
-       */
-      if ([namList count] > 0)
+      else
 	{
-	  GDNCObserver	*tmp = [namList objectAtIndex: 0];
+	  GDNCObserver	*tmp = [objList objectAtIndex: 0];
 
-	  notificationName = tmp->notificationName;
+	  /*
+	   *	If possible use an existing string as the key.
+	   */
+	  anObject = tmp->notificationObject;
 	}
-      obs->notificationName = RETAIN(notificationName);
-      [namList addObject: obs];
+      obs->notificationObject = RETAIN(anObject);
+      [objList addObject: obs];
     }
-
 }
 
 - (BOOL) connection: (NSConnection*)ancestor
@@ -734,6 +781,18 @@ ihandler(int sig)
   return nil;
 }
 
+- (void) registerBatchingClient: (id<GDNCClient>)client
+{
+  NSMapTable	*table;
+  GDNCClient	*info;
+
+  [self registerClient: client];
+  table = NSMapGet(connections, [(NSDistantObject*)client connectionForProxy]);
+  info = (GDNCClient*)NSMapGet(table, client);
+  info->batching = YES;
+  info->pending = [NSMutableArray new];
+}
+
 - (void) registerClient: (id<GDNCClient>)client
 {
   NSMapTable	*table;
@@ -762,6 +821,65 @@ ihandler(int sig)
   RELEASE(info);
 }
 
+- (void) flushBatches
+{
+  NSNull	*null = [NSNull null];
+  NSArray	*clients;
+  NSUInteger	index;
+
+  clients = AUTORELEASE([pendingClients copy]);
+  [pendingClients removeAllObjects];
+  for (index = 0; index < [clients count]; index++)
+    {
+      GDNCClient	*info = [clients objectAtIndex: index];
+      NSMutableArray	*batch;
+      NSUInteger	count = [info->pending count];
+      NSUInteger	pos;
+
+      /*
+       *	Build the batch from the observer and notification pairs,
+       *	skipping observers removed since the notification was queued.
+       */
+      batch = [NSMutableArray arrayWithCapacity: count / 2];
+      for (pos = 0; pos < count; pos += 2)
+	{
+	  GDNCObserver		*obs = [info->pending objectAtIndex: pos];
+	  GDNCNotification	*n = [info->pending objectAtIndex: pos + 1];
+
+	  if (NSHashGet(allObservers, obs) == 0)
+	    {
+	      continue;
+	    }
+	  [batch addObject: [NSArray arrayWithObjects:
+	    n->name,
+	    (n->object ? (id)n->object : (id)null),
+	    (n->info ? (id)n->info : (id)null),
+	    obs->selector,
+	    [NSNumber numberWithUnsignedLongLong: obs->observer],
+	    nil]];
+	}
+      [info->pending removeAllObjects];
+      if ([batch count] == 0)
+	{
+	  continue;
+	}
+      if (debugging)
+	NSLog(@"Posting batch of %"PRIuPTR" to client %@",
+	  [batch count], info->client);
+      NS_DURING
+	{
+	  [info->client postNotificationBatch:
+	    [NSArchiver archivedDataWithRootObject: batch]];
+	}
+      NS_HANDLER
+	{
+	  NSLog(@"Problem posting notifications to client: %@",
+	    localException);
+	}
+      NS_ENDHANDLER
+    }
+}
+
 - (oneway void) postNotificationName: (NSString*)notificationName
 			      object: (NSString*)notificationObject
 			    userInfo: (NSData*)d
@@ -769,37 +887,38 @@ ihandler(int sig)
 				 for: (id<GDNCClient>)client
 {
   NSMutableArray	*observers = [NSMutableArray array];
-  NSMutableArray	*byName;
-  NSMutableArray	*byObject;
+  NSDictionary		*byObject;
+  NSArray		*list;
   unsigned		pos;
   GDNCNotification	*notification;
 
-  byName = [observersForNames objectForKey: notificationName];
-  byObject = [observersForObjects objectForKey: notificationObject];
   /*
-   *	Build up a list of all those observers that should get sent this.
+   *	Collect the observers for this name and object, for this name and
+   *	any object, and for any name and this object.
    */
-  for (pos = [byName count]; pos > 0; pos--)
+  byObject = [observersForNames objectForKey: notificationName];
+  if (byObject != nil)
     {
-      GDNCObserver	*obs = [byName objectAtIndex: pos - 1];
-
-      if (obs->notificationObject == nil
-	|| [obs->notificationObject isEqual: notificationObject])
+      if (notificationObject != nil)
 	{
-	  [observers addObject: obs];
+	  list = [byObject objectForKey: notificationObject];
+	  if (list != nil)
+	    {
+	      [observers addObjectsFromArray: list];
+	    }
+	}
+      list = [byObject objectForKey: [NSNull null]];
+      if (list != nil)
+	{
+	  [observers addObjectsFromArray: list];
 	}
     }
-  for (pos = [byObject count]; pos > 0; pos--)
+  if (notificationObject != nil)
     {
-      GDNCObserver	*obs = [byObject objectAtIndex: pos - 1];
-
-      if (obs->notificationName == nil
-	|| [obs->notificationName isEqual: notificationName])
+      list = [observersForObjects objectForKey: notificationObject];
+      if (list != nil)
 	{
-	  if ([observers indexOfObjectIdenticalTo: obs] == NSNotFound)
-	    {
-	      [observers addObject: obs];
-	    }
+	  [observers addObjectsFromArray: list];
 	}
     }
 
@@ -855,7 +974,43 @@ ihandler(int sig)
     {
       GDNCObserver	*obs = [observers objectAtIndex: pos - 1];
 
-      if (obs->client->suspended == NO || deliverImmediately == YES)
+      if (obs->client->batching == YES
+	&& (obs->client->suspended == NO || deliverImmediately == YES))
+	{
+	  GDNCClient	*info = obs->client;
+	  NSUInteger	count = [obs->queue count];
+	  NSUInteger	index;
+
+	  /*
+	   *	Add the notifications to the batch for the client, to be sent
+	   *	along with any others posted before we return to the run loop.
+	   */
+	  if (count > 0 && [info->pending count] == 0)
+	    {
+	      if ([pendingClients count] == 0)
+		{
+		  [[NSRunLoop currentRunLoop]
+		    performSelector: @selector(flushBatches)
+			     target: self
+			   argument: nil
+			      order: 0
+			      modes: [NSArray arrayWithObject:
+				NSDefaultRunLoopMode]];
+		}
+	      [pendingClients addObject: info];
+	    }
+	  for (index = 0; index < count; index++)
+	    {
+	      [info->pending addObject: obs];
+	      [info->pending addObject: [obs->queue objectAtIndex: index]];
+	    }
+	  [obs->queue removeAllObjects];
+	  if ([info->pending count] >= 2 * GDNC_BATCH_MAX)
+	    {
+	      [self flushBatches];
+	    }
+	}
+      else if (obs->client->suspended == NO || deliverImmediately == YES)
 	{
 	  /*
 	   *	Post notifications to the observer until:
@@ -899,24 +1054,46 @@ ihandler(int sig)
       (unsigned long long)observer->observer, observer->notificationName,
       observer->notificationObject);
 
-  if (observer->notificationObject)
+  if (observer->notificationName)
     {
-      NSMutableArray	*objList;
+      NSMutableDictionary	*byObject;
+      NSMutableArray		*list;
+      id			key = observer->notificationObject;
 
-      objList= [observersForObjects objectForKey: observer->notificationObject];
-      if (objList != nil)
+      if (key == nil)
 	{
-	  [objList removeObjectIdenticalTo: observer];
+	  key = [NSNull null];
+	}
+      byObject = [observersForNames objectForKey: observer->notificationName];
+      list = [byObject objectForKey: key];
+      if (list != nil)
+	{
+	  [list removeObjectIdenticalTo: observer];
+	  if ([list count] == 0)
+	    {
+	      [byObject removeObjectForKey: key];
+	      if ([byObject count] == 0)
+		{
+		  [observersForNames removeObjectForKey:
+		    observer->notificationName];
+		}
+	    }
 	}
     }
-  if (observer->notificationName)
+  else if (observer->notificationObject)
     {
-      NSMutableArray	*namList;
+      NSMutableArray	*objList;
 
-      namList = [observersForNames objectForKey: observer->notificationName];
-      if (namList != nil)
+      objList = [observersForObjects objectForKey:
+	observer->notificationObject];
+      if (objList != nil)
 	{
-	  [namList removeObjectIdenticalTo: observer];
+	  [objList removeObjectIdenticalTo: observer];
+	  if ([objList count] == 0)
+	    {
+	      [observersForObjects removeObjectForKey:
+		observer->notificationObject];
+	    }
 	}
     }
   NSHashRemove(allObservers, observer);
@@ -937,6 +1114,7 @@ ihandler(int sig)
 	{
 	  [self removeObserver: [info->observers objectAtIndex: 0]];
 	}
+      [info->pending removeAllObjects];
     }
 }
 
@@ -947,69 +1125,34 @@ ihandler(int sig)
 {
   if (anObserver == 0)
     {
-      if (notificationName == nil)
-	{
-	  NSMutableArray	*observers;
-
-	  /*
-	   *	No notification name - so remove all with matching object.
-	   */
-	  observers = [observersForObjects objectForKey: notificationObject];
-	  while ([observers count] > 0)
-	    {
-	      GDNCObserver	*obs;
+      NSHashEnumerator	enumerator;
+      NSMutableArray	*matches = [NSMutableArray array];
+      GDNCObserver	*obs;
+      NSUInteger	pos;
 
-	      obs = [observers objectAtIndex: 0];
-	      [self removeObserver: obs];
-	    }
+      /*
+       *	No observer - so remove all those with matching name and/or
+       *	object.  This is rare, so simply check every observer.
+       */
+      if (notificationName == nil && notificationObject == nil)
+	{
+	  return;
 	}
-      else if (notificationObject == nil)
+      enumerator = NSEnumerateHashTable(allObservers);
+      while ((obs = (GDNCObserver*)NSNextHashEnumeratorItem(&enumerator)) != nil)
 	{
-	  NSMutableArray	*observers;
-
-	  /*
-	   *	No notification object - so remove all with matching name.
-	   */
-	  observers = [observersForObjects objectForKey: notificationName];
-	  while ([observers count] > 0)
+	  if ((notificationName == nil
+	    || [notificationName isEqual: obs->notificationName])
+	    && (notificationObject == nil
+	    || [notificationObject isEqual: obs->notificationObject]))
 	    {
-	      GDNCObserver	*obs;
-
-	      obs = [observers objectAtIndex: 0];
-	      [self removeObserver: obs];
+	      [matches addObject: obs];
 	    }
 	}
-      else
+      NSEndHashTableEnumeration(&enumerator);
+      for (pos = 0; pos < [matches count]; pos++)
 	{
-	  NSMutableArray	*byName;
-	  NSMutableArray	*byObject;
-	  unsigned		pos;
-
-	  /*
-	   *	Remove observers that match both name and object.
-	   */
-	  byName = [observersForObjects objectForKey: notificationName];
-	  byObject = [observersForObjects objectForKey: notificationName];
-	  for (pos = [byName count]; pos > 0; pos--)
-	    {
-	      GDNCObserver	*obs;
-
-	      obs = [byName objectAtIndex: pos - 1];
-	      if ([byObject indexOfObjectIdenticalTo: obs] != NSNotFound)
-		{
-		  [self removeObserver: obs];
-		}
-	    }
-	  for (pos = [byObject count]; pos > 0; pos--)
-	    {
-	      GDNCObserver	*obs;
-
-	      obs = [byObject objectAtIndex: pos - 1];
-	      if ([byName indexOfObjectIdenticalTo: obs] != NSNotFound)
-		{
-		  [self removeObserver: obs];
-		}
-	    }
+	  [self removeObserver: [matches objectAtIndex: pos]];
 	}
     }
   else
@@ -1097,6 +1240,7 @@ ihandler(int sig)
     {
       [self removeObserver: [info->observers objectAtIndex: 0]];
     }
+  [info->pending removeAllObjects];
   NSMapRemove(table, client);
 }
 